@@ -0,0 +1,268 @@
+#include "SyntheticTree.hpp"
+#include "models/FamilyTree.hpp"
+#include "utils/JsonFormatter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    SyntheticTreeOptions tree;
+    size_t iterations = 500;
+    size_t batchSize = 1000;
+    std::string dbPath = "family_tree_bench.db";
+    std::string jsonPath;       // empty: no JSON, "-": stdout
+    bool cache = true;
+    bool keepDatabase = false;
+};
+
+struct Summary {
+    size_t count = 0;
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;  // microseconds
+    double opsPerSecond = 0;
+};
+
+// Latency samples per operation, in microseconds
+class Recorder {
+private:
+    std::map<std::string, std::vector<double>> samples;
+    std::vector<std::string> order;
+
+public:
+    void add(const std::string& operation, double micros) {
+        auto& values = samples[operation];
+        if (values.empty()) order.push_back(operation);
+        values.push_back(micros);
+    }
+
+    template <typename Fn>
+    auto time(const std::string& operation, Fn fn) -> decltype(fn()) {
+        auto start = Clock::now();
+        auto result = fn();
+        add(operation, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        return result;
+    }
+
+    const std::vector<std::string>& operations() const { return order; }
+
+    Summary summarize(const std::string& operation) const {
+        std::vector<double> values = samples.at(operation);
+        std::sort(values.begin(), values.end());
+        auto percentile = [&](double p) {
+            size_t rank = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+            return values[std::min(rank, values.size() - 1)];
+        };
+        Summary summary;
+        summary.count = values.size();
+        double total = 0;
+        for (double value : values) total += value;
+        summary.mean = total / values.size();
+        summary.p50 = percentile(50);
+        summary.p90 = percentile(90);
+        summary.p99 = percentile(99);
+        summary.max = values.back();
+        summary.opsPerSecond = total > 0 ? values.size() / (total / 1e6) : 0;
+        return summary;
+    }
+};
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --people N         people to generate (default 10000)\n"
+              << "  --generations N    pedigree depth (default 8)\n"
+              << "  --branching X      mean children per couple (default 2.5)\n"
+              << "  --collapse X       share of marriages between relatives (default 0.05)\n"
+              << "  --seed N           generator seed (default 42)\n"
+              << "  --iterations N     samples per query benchmark (default 500)\n"
+              << "  --batch-size N     inserts per transaction (default 1000)\n"
+              << "  --db PATH          scratch database (default family_tree_bench.db)\n"
+              << "  --keep-db          keep the scratch database afterwards\n"
+              << "  --no-cache         disable the query result cache\n"
+              << "  --json FILE|-      also write the results as JSON\n";
+}
+
+bool parseArgs(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--people" && hasValue) {
+            options.tree.people = std::stoul(argv[++i]);
+        } else if (arg == "--generations" && hasValue) {
+            options.tree.generations = std::stoi(argv[++i]);
+        } else if (arg == "--branching" && hasValue) {
+            options.tree.branching = std::stod(argv[++i]);
+        } else if (arg == "--collapse" && hasValue) {
+            options.tree.collapseRate = std::stod(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.tree.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--iterations" && hasValue) {
+            options.iterations = std::stoul(argv[++i]);
+        } else if (arg == "--batch-size" && hasValue) {
+            options.batchSize = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else if (arg == "--db" && hasValue) {
+            options.dbPath = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--keep-db") {
+            options.keepDatabase = true;
+        } else if (arg == "--no-cache") {
+            options.cache = false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void removeDatabase(const std::string& path) {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+}
+
+void writeJson(std::ostream& out, const BenchOptions& options, const SyntheticTree& tree,
+               const Recorder& recorder) {
+    out << std::setprecision(6)
+        << "{\"config\":{\"people\":" << options.tree.people
+        << ",\"generations\":" << options.tree.generations
+        << ",\"branching\":" << options.tree.branching
+        << ",\"collapse_rate\":" << options.tree.collapseRate
+        << ",\"seed\":" << options.tree.seed
+        << ",\"iterations\":" << options.iterations
+        << ",\"batch_size\":" << options.batchSize
+        << ",\"cache\":" << (options.cache ? "true" : "false") << "}"
+        << ",\"tree\":{\"people\":" << tree.people.size()
+        << ",\"relationships\":" << tree.relationships.size()
+        << ",\"pedigrees\":" << tree.pedigrees.size() << "}"
+        << ",\"results\":{";
+    bool first = true;
+    for (const auto& operation : recorder.operations()) {
+        Summary s = recorder.summarize(operation);
+        out << (first ? "" : ",") << JsonFormatter::quote(operation)
+            << ":{\"count\":" << s.count
+            << ",\"mean_us\":" << s.mean
+            << ",\"p50_us\":" << s.p50
+            << ",\"p90_us\":" << s.p90
+            << ",\"p99_us\":" << s.p99
+            << ",\"max_us\":" << s.max
+            << ",\"ops_per_sec\":" << s.opsPerSecond << "}";
+        first = false;
+    }
+    out << "}}\n";
+}
+
+void printTable(const Recorder& recorder) {
+    std::cout << std::left << std::setw(24) << "operation" << std::right
+              << std::setw(8) << "count" << std::setw(12) << "mean_us"
+              << std::setw(12) << "p50_us" << std::setw(12) << "p90_us"
+              << std::setw(12) << "p99_us" << std::setw(12) << "max_us"
+              << std::setw(14) << "ops/s" << "\n" << std::fixed << std::setprecision(1);
+    for (const auto& operation : recorder.operations()) {
+        Summary s = recorder.summarize(operation);
+        std::cout << std::left << std::setw(24) << operation << std::right
+                  << std::setw(8) << s.count << std::setw(12) << s.mean
+                  << std::setw(12) << s.p50 << std::setw(12) << s.p90
+                  << std::setw(12) << s.p99 << std::setw(12) << s.max
+                  << std::setw(14) << s.opsPerSecond << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    SyntheticTree synthetic = SyntheticTree::generate(options.tree);
+    std::cerr << "Generated " << synthetic.people.size() << " people, "
+              << synthetic.relationships.size() << " relationships in "
+              << synthetic.pedigrees.size() << " pedigrees\n";
+
+    removeDatabase(options.dbPath);
+    Recorder recorder;
+    {
+        FamilyTree tree(options.dbPath);
+        if (!options.cache) {
+            tree.setCacheBudget(0);
+        }
+
+        synthetic.load(tree, options.batchSize, [&](bool isPerson, double micros) {
+            recorder.add(isPerson ? "insert_person" : "insert_relationship", micros);
+        });
+
+        std::mt19937 random(options.tree.seed);
+        auto pickIndex = [&](size_t size) {
+            return std::uniform_int_distribution<size_t>(0, size - 1)(random);
+        };
+        auto pickPedigree = [&]() -> const std::vector<std::vector<std::string>>& {
+            return synthetic.pedigrees[pickIndex(synthetic.pedigrees.size())];
+        };
+        auto pickFrom = [&](const std::vector<std::vector<std::string>>& pedigree, size_t generation) {
+            const auto& members = pedigree[std::min(generation, pedigree.size() - 1)];
+            return members[pickIndex(members.size())];
+        };
+
+        for (size_t i = 0; i < options.iterations; i++) {
+            const auto& pedigree = pickPedigree();
+            std::string deepest = pickFrom(pedigree, pedigree.size() - 1);
+            std::string middle = pickFrom(pedigree, pedigree.size() / 2);
+            std::string cousin = pickFrom(pedigree, pedigree.size() - 1);
+            const std::string& surname = synthetic.surnames[pickIndex(synthetic.surnames.size())];
+
+            recorder.time("getAncestors", [&]() { return tree.getAncestors(deepest).size(); });
+            recorder.time("getDescendants", [&]() { return tree.getDescendants(middle).size(); });
+            recorder.time("getSiblings", [&]() { return tree.getSiblings(deepest).size(); });
+            recorder.time("calculateGenerationGap", [&]() {
+                return tree.calculateGenerationGap(deepest, cousin);
+            });
+            recorder.time("searchByName", [&]() { return tree.searchByName(surname).size(); });
+            recorder.time("searchByName_phonetic", [&]() {
+                return tree.searchByName(surname, NameSearchMode::PHONETIC).size();
+            });
+        }
+
+        // Deletes last: they change the tree the queries ran against
+        for (size_t i = 0; i < options.iterations; i++) {
+            const auto& pedigree = pickPedigree();
+            std::string leaf = pickFrom(pedigree, pedigree.size() - 1);
+            recorder.time("deletePerson", [&]() { return tree.deletePerson(leaf); });
+        }
+        size_t branches = std::max<size_t>(options.iterations / 10, 1);
+        for (size_t i = 0; i < branches; i++) {
+            const auto& pedigree = pickPedigree();
+            std::string top = pickFrom(pedigree, pedigree.size() >= 3 ? pedigree.size() - 3 : 0);
+            recorder.time("deleteBranch", [&]() { return tree.deleteBranch(top); });
+        }
+    }
+    if (!options.keepDatabase) {
+        removeDatabase(options.dbPath);
+    }
+
+    printTable(recorder);
+    if (options.jsonPath == "-") {
+        writeJson(std::cout, options, synthetic, recorder);
+    } else if (!options.jsonPath.empty()) {
+        std::ofstream json(options.jsonPath);
+        if (!json) {
+            std::cerr << "Cannot write " << options.jsonPath << "\n";
+            return 1;
+        }
+        writeJson(json, options, synthetic, recorder);
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include "SyntheticTree.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+
+namespace {
+
+// Groups of spelling variants, so phonetic search has something to find
+const std::vector<std::vector<std::string>> SURNAME_GROUPS = {
+    {"Meyer", "Maier", "Mayer", "Meier"}, {"Schmidt", "Schmitt", "Schmid"},
+    {"Smith", "Smyth"}, {"Fischer", "Fisher"}, {"Weber"}, {"Wagner", "Waggoner"},
+    {"Becker", "Baecker"}, {"Schulz", "Schultz", "Schulze"}, {"Hoffmann", "Hofmann"},
+    {"Koch"}, {"Richter"}, {"Klein", "Kline"}, {"Wolf", "Wolff"}, {"Neumann", "Newman"},
+    {"Schwarz", "Schwartz"}, {"Zimmermann", "Zimmerman"}, {"Braun", "Brown"},
+    {"Krueger", "Kruger"}, {"Hartmann"}, {"Lange"}, {"Werner"}, {"Peters", "Petersen"},
+    {"Jones"}, {"Taylor", "Tailor"}, {"Williams"}, {"Davies", "Davis"}, {"Evans"},
+    {"Thomas"}, {"Johnson", "Johnston"}, {"Roberts", "Robertson"}, {"Walker"},
+    {"Wright"}, {"Thompson", "Thomson"}, {"White"}, {"Hughes"}, {"Edwards"},
+    {"Green", "Greene"}, {"Hall"}, {"Wood", "Woods"}, {"Harris"}, {"Lewis"}
+};
+const std::vector<std::string> MALE_NAMES = {
+    "Johann", "John", "Karl", "Carl", "Friedrich", "Wilhelm", "William", "Heinrich",
+    "Henry", "Georg", "George", "Thomas", "James", "Peter", "Paul", "Hans", "Otto",
+    "Robert", "Richard", "Michael", "Jakob", "Jacob", "Ludwig", "Ernst", "Franz"
+};
+const std::vector<std::string> FEMALE_NAMES = {
+    "Anna", "Maria", "Mary", "Elisabeth", "Elizabeth", "Katharina", "Catherine",
+    "Margaretha", "Margaret", "Sophie", "Sophia", "Christina", "Johanna", "Emma",
+    "Louise", "Sarah", "Martha", "Helene", "Helen", "Barbara", "Dorothea", "Agnes"
+};
+const std::vector<std::string> PLACES = {
+    "Berlin", "Hamburg", "Bremen", "Leipzig", "Dresden", "Munich", "Cologne",
+    "London", "Leeds", "York", "Bristol", "Boston", "New York", "Chicago"
+};
+
+const int FIRST_BIRTH_YEAR = 1700;
+
+class Builder {
+private:
+    SyntheticTree& tree;
+    std::mt19937 random;
+    size_t nextId = 1;
+
+public:
+    Builder(SyntheticTree& tree, uint32_t seed) : tree(tree), random(seed) {}
+
+    template <typename T>
+    const T& pick(const std::vector<T>& values) {
+        return values[std::uniform_int_distribution<size_t>(0, values.size() - 1)(random)];
+    }
+
+    bool chance(double probability) {
+        return std::bernoulli_distribution(probability)(random);
+    }
+
+    int children(double mean) {
+        return std::poisson_distribution<int>(mean)(random);
+    }
+
+    std::string surname() {
+        return pick(pick(SURNAME_GROUPS));
+    }
+
+    // Descendants keep their family's surname, occasionally respelled
+    std::string respell(const std::string& name) {
+        if (!chance(0.1)) return name;
+        for (const auto& group : SURNAME_GROUPS) {
+            if (std::find(group.begin(), group.end(), name) != group.end()) {
+                return pick(group);
+            }
+        }
+        return name;
+    }
+
+    const Person& person(char gender, const std::string& lastName, int birthYear) {
+        char date[16];
+        std::snprintf(date, sizeof(date), "%04d-%02d-%02d", birthYear,
+                      std::uniform_int_distribution<int>(1, 12)(random),
+                      std::uniform_int_distribution<int>(1, 28)(random));
+        Person created("P" + std::to_string(nextId++),
+                       pick(gender == 'M' ? MALE_NAMES : FEMALE_NAMES),
+                       lastName, std::string(1, gender), date);
+        created.setBirthPlace(pick(PLACES));
+        tree.people.push_back(created);
+        return tree.people.back();
+    }
+
+    void relate(const std::string& a, const std::string& b, RelationType type) {
+        tree.relationships.push_back({a, b, type});
+    }
+};
+
+struct Couple {
+    std::string husband;
+    std::string wife;
+    std::string surname;
+    int birthYear;
+};
+
+} // namespace
+
+SyntheticTree SyntheticTree::generate(const SyntheticTreeOptions& options) {
+    SyntheticTree tree;
+    Builder builder(tree, options.seed);
+    tree.people.reserve(options.people + 64);
+
+    while (tree.people.size() < options.people) {
+        std::vector<std::vector<std::string>> generations(1);
+        int birthYear = FIRST_BIRTH_YEAR + builder.children(50.0);
+
+        const Person& husband = builder.person('M', builder.surname(), birthYear);
+        std::string husbandId = husband.getId();
+        std::string surname = husband.getLastName();
+        const Person& wife = builder.person('F', builder.surname(), birthYear + 2);
+        builder.relate(husbandId, wife.getId(), RelationType::SPOUSE);
+        generations[0] = {husbandId, wife.getId()};
+        std::vector<Couple> couples = {{husbandId, wife.getId(), surname, birthYear}};
+
+        for (int generation = 1; generation < options.generations && !couples.empty() &&
+                                 tree.people.size() < options.people; generation++) {
+            generations.emplace_back();
+            std::vector<std::string>& members = generations.back();
+            // Children born into this generation, with the couple they descend from
+            struct Child { std::string id; char gender; size_t family; std::string surname; int birthYear; };
+            std::vector<Child> children;
+
+            for (size_t family = 0; family < couples.size(); family++) {
+                const Couple& couple = couples[family];
+                int count = builder.children(options.branching);
+                for (int i = 0; i < count && tree.people.size() < options.people; i++) {
+                    char gender = builder.chance(0.5) ? 'M' : 'F';
+                    int year = couple.birthYear + 22 + builder.children(6.0) + 2 * i;
+                    const Person& child = builder.person(gender, builder.respell(couple.surname), year);
+                    builder.relate(couple.husband, child.getId(), RelationType::PARENT_CHILD);
+                    builder.relate(couple.wife, child.getId(), RelationType::PARENT_CHILD);
+                    children.push_back({child.getId(), gender, family, child.getLastName(), year});
+                    members.push_back(child.getId());
+                }
+            }
+
+            if (children.empty()) {
+                generations.pop_back();
+                break;
+            }
+
+            // Marry every child: to a relative (pedigree collapse) or to a newcomer
+            std::vector<Couple> nextCouples;
+            std::set<size_t> married;
+            for (size_t i = 0; i < children.size() && tree.people.size() < options.people; i++) {
+                if (married.count(i)) continue;
+                const Child& child = children[i];
+                married.insert(i);
+
+                std::string spouseId;
+                std::string spouseSurname;
+                if (builder.chance(options.collapseRate)) {
+                    for (size_t j = i + 1; j < children.size(); j++) {
+                        if (!married.count(j) && children[j].gender != child.gender &&
+                            children[j].family != child.family) {
+                            married.insert(j);
+                            spouseId = children[j].id;
+                            spouseSurname = children[j].surname;
+                            break;
+                        }
+                    }
+                }
+                if (spouseId.empty()) {
+                    const Person& spouse = builder.person(child.gender == 'M' ? 'F' : 'M',
+                                                          builder.surname(), child.birthYear);
+                    spouseId = spouse.getId();
+                    spouseSurname = spouse.getLastName();
+                    members.push_back(spouseId);
+                }
+                builder.relate(child.id, spouseId, RelationType::SPOUSE);
+
+                if (child.gender == 'M') {
+                    nextCouples.push_back({child.id, spouseId, child.surname, child.birthYear});
+                } else {
+                    nextCouples.push_back({spouseId, child.id, spouseSurname, child.birthYear});
+                }
+            }
+            couples = std::move(nextCouples);
+        }
+        tree.pedigrees.push_back(std::move(generations));
+    }
+
+    std::set<std::string> surnames;
+    for (const auto& person : tree.people) {
+        surnames.insert(person.getLastName());
+    }
+    tree.surnames.assign(surnames.begin(), surnames.end());
+    return tree;
+}
+
+void SyntheticTree::load(FamilyTree& tree, size_t batchSize,
+                         const std::function<void(bool isPerson, double micros)>& observe) const {
+    using Clock = std::chrono::steady_clock;
+    size_t inTransaction = 0;
+    auto step = [&](bool isPerson, const std::function<bool()>& insert) {
+        if (inTransaction == 0) {
+            tree.beginTransaction();
+        }
+        auto start = Clock::now();
+        insert();
+        if (observe) {
+            observe(isPerson, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        if (++inTransaction >= batchSize) {
+            tree.commit();
+            inTransaction = 0;
+        }
+    };
+
+    for (const auto& person : people) {
+        step(true, [&]() { return tree.addPerson(person); });
+    }
+    for (const auto& relationship : relationships) {
+        step(false, [&]() {
+            return tree.addRelationship(relationship.person1Id, relationship.person2Id, relationship.type);
+        });
+    }
+    if (inTransaction > 0) {
+        tree.commit();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef SYNTHETIC_TREE_HPP
+#define SYNTHETIC_TREE_HPP
+
+#include "models/FamilyTree.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct SyntheticTreeOptions {
+    size_t people = 10000;       // pedigrees are generated until this many people exist
+    int generations = 8;         // depth of each pedigree, founders included
+    double branching = 2.5;      // mean children per couple (Poisson)
+    double collapseRate = 0.05;  // share of marriages between relatives of one pedigree
+    uint32_t seed = 42;
+};
+
+struct SyntheticRelationship {
+    std::string person1Id;
+    std::string person2Id;
+    RelationType type;
+};
+
+// A generated family tree, held in memory until loaded. Each pedigree
+// starts from one founding couple; every child marries either someone
+// from outside (a new person of the same generation) or, with
+// collapseRate, an unmarried relative of its generation in the same
+// pedigree, which makes ancestors reachable along several paths.
+struct SyntheticTree {
+    std::vector<Person> people;
+    std::vector<SyntheticRelationship> relationships;
+    // Person IDs by generation (0 = founders and their spouses' generation),
+    // one entry per pedigree
+    std::vector<std::vector<std::vector<std::string>>> pedigrees;
+    std::vector<std::string> surnames;  // surnames in use, spelling variants included
+
+    // Same seed and options give the same tree
+    static SyntheticTree generate(const SyntheticTreeOptions& options);
+
+    // Inserts everything, committing every batchSize operations. observe,
+    // when set, receives the latency of each insert in microseconds.
+    void load(FamilyTree& tree, size_t batchSize = 1000,
+              const std::function<void(bool isPerson, double micros)>& observe = {}) const;
+};
+
+#endif // SYNTHETIC_TREE_HPP
@@ -4,12 +4,119 @@
 #include "database/SQLiteConnector.hpp"
 #include "models/Person.hpp"
 #include "models/Relationship.hpp"
+#include "utils/PhoneticEncoder.hpp"
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 
+// How incoming people are matched to existing ones by mergeDatabase
+struct MergeOptions {
+    // Incoming person ID -> existing person ID, for people known to be the same
+    std::map<std::string, std::string> identityMap;
+    // Also match people with the same first name, last name (ignoring case)
+    // and date of birth
+    bool matchByIdentity = true;
+    // Incoming IDs already used by a different person get this prefix
+    std::string conflictPrefix = "merged_";
+};
+
+struct MergeConflict {
+    std::string incomingId;
+    std::string assignedId;  // empty when the person was not merged
+    std::string reason;
+};
+
+struct MergeSummary {
+    int incomingPeople = 0;
+    int peopleAdded = 0;
+    int peopleMatched = 0;
+    int incomingRelationships = 0;
+    int relationshipsAdded = 0;
+    int relationshipsSkipped = 0;  // already present, or endpoints not merged
+    std::vector<MergeConflict> conflicts;
+};
+
+// One database file holding part of the tree
+struct ShardInfo {
+    int id = 0;               // 0 is the main database file
+    std::string path;
+    std::string surnameFrom;  // new people with last names in [from, to)
+    std::string surnameTo;    // (ignoring case) go here; empty = unbounded
+};
+
+// One page of a longer person list
+struct PersonPage {
+    std::vector<Person> people;
+    std::vector<int> generations;  // lineage pages: generations from the start person
+    bool hasMore = false;          // at least one more person follows this page
+};
+
+// Which of a person's siblings: all children of their parents, those
+// with the same parents, or those sharing only one
+enum class SiblingKind {
+    ALL,
+    FULL,
+    HALF
+};
+
+// A couple, or a single parent, and their children
+struct FamilyUnit {
+    std::string partner1Id;
+    std::string partner2Id;  // empty for a single parent
+    bool married = false;
+    std::vector<std::string> childIds;  // by ID
+};
+
+// A line of descent through fathers only or mothers only
+enum class DirectLine {
+    PATERNAL,
+    MATERNAL
+};
+
+// What a generation number in a slice counts from: the person's own
+// generation (their parents are -1) or the root's
+enum class GenerationOrigin {
+    PERSON,
+    ROOT
+};
+
+// Births and deaths recorded in one place during one decade, counting
+// everyone in places within it ("Salem, Essex" counts towards "Essex")
+struct PlaceCount {
+    std::string place;   // full name, innermost first: "Salem, Essex, Massachusetts"
+    int decade = 0;      // first year of the decade
+    int births = 0;
+    int deaths = 0;
+};
+
+// Storage can be partitioned across several SQLite files ("shards"). The
+// main file is shard 0: it holds the shard list, the routing table mapping
+// each person stored elsewhere to their shard, and everyone not routed
+// away. Every shard has the full schema, so each can be opened, vacuumed
+// or backed up on its own. A relationship is stored in the shards of both
+// endpoints, so the relationships of a person are always found in that
+// person's shard and traversals cross shards without extra lookups.
+// Lists and searches query all shards. Without extra shards every call
+// goes straight to the main file.
+//
+// Transactions span all shards, but each file commits on its own: a crash
+// during commit can leave a cross-shard change applied in some files only.
 class DatabaseManager {
 private:
-    std::unique_ptr<SQLiteConnector> connector;
+    struct Shard {
+        ShardInfo info;
+        std::unique_ptr<SQLiteConnector> connector;
+    };
+
+    std::unique_ptr<SQLiteConnector> connector;  // main file, shard 0
+    std::string mainPath;
+    std::vector<Shard> shards;                   // additional shards
+    // The root person as last read or written in this process; dropped
+    // on rollback
+    std::mutex rootMutex;
+    std::optional<std::string> rootPerson;
 
 public:
     explicit DatabaseManager(const std::string& dbPath);
@@ -17,27 +124,205 @@ public:
     // Person operations
     bool addPerson(const Person& person);
     bool updatePerson(const Person& person);
+    // Removes the person with their relationships
     bool deletePerson(const std::string& personId);
+    // Removes personId and all descendants (and, optionally, their
+    // spouses) with their relationships; returns the removed IDs
+    std::vector<std::string> deleteBranch(const std::string& personId, bool includeSpouses);
     std::optional<Person> getPerson(const std::string& personId);
+    // Whether every one of personIds is stored; one query outside shards
+    bool hasPeople(const std::vector<std::string>& personIds);
     std::vector<Person> getAllPeople();
     std::vector<Person> searchPeople(const std::string& searchTerm);
+    // Every word of searchTerm must match a first or last name key
+    // under at least one of the given algorithms
+    std::vector<Person> searchPeoplePhonetic(const std::string& searchTerm,
+                                             const std::vector<PhoneticAlgorithm>& algorithms);
+
+    // Pages of the searches above, ordered by last name, first name and ID.
+    // Only the requested rows (plus one, to set hasMore) are read.
+    PersonPage searchPeoplePage(const std::string& searchTerm, size_t offset, size_t limit);
+    PersonPage searchPeoplePhoneticPage(const std::string& searchTerm,
+                                        const std::vector<PhoneticAlgorithm>& algorithms,
+                                        size_t offset, size_t limit);
+    // A page of the ancestors or descendants of personId, nearest
+    // generation first (at most `generations` deep; -1 for all). The
+    // traversal stops as soon as the page is full. A person reached at
+    // several depths is listed once per depth.
+    PersonPage getLineagePage(const std::string& personId, bool ancestors, int generations,
+                              size_t offset, size_t limit);
+
+    // Computes phonetic keys for people stored before the index existed
+    int backfillPhoneticKeys();
+
+    // Direct lines. Each person's father and mother (the male and female
+    // parent with the lowest ID) are stored with the founder of each of
+    // their lines, and updated whenever a parent-child link or a parent's
+    // gender changes; only the person and their descendants along that
+    // line are touched. A line walk reads one row per generation and a
+    // line's members are read from an index.
+    // Father, father's father, ... (or the mothers), nearest first
+    std::vector<Person> getLineAncestors(const std::string& personId, DirectLine line);
+    // Everyone descending from personId along the line, by generation
+    std::vector<Person> getLineDescendants(const std::string& personId, DirectLine line);
+    // Everyone on personId's line: the founder, then the others by ID
+    std::vector<Person> getLineMembers(const std::string& personId, DirectLine line);
+    // Recomputes all lines from the relationships; returns the number of
+    // people with a father or mother
+    int rebuildDirectLines();
+
+    // Family units. Parent-child links are stored as families: a child
+    // belongs to the family of the parents they were linked to, and
+    // spouse changes update the couple's family. Parent-Child
+    // relationships are read back from the families, with the IDs
+    // FamilyTree gives them.
+    // Everyone personId has a family with (married or not), by ID
+    std::vector<Person> getPartners(const std::string& personId);
+    // Families with personId as a partner, and the one they are a child of
+    // (the first by partners, for a child of more than two parents)
+    std::vector<FamilyUnit> getFamilies(const std::string& personId);
+    std::optional<FamilyUnit> getParentFamily(const std::string& personId);
+    // Relatives, one query each: parents and children by ID, the partner
+    // of a marriage that has not ended (the first by ID), and the children
+    // of the person's parents by ID, FULL ones sharing a family with them
+    std::vector<Person> getParents(const std::string& personId);
+    std::vector<Person> getChildren(const std::string& personId);
+    std::optional<Person> getSpouse(const std::string& personId);
+    std::vector<Person> getSiblings(const std::string& personId, SiblingKind kind);
+
+    // Generations. The root person is stored with the tree. Each person's
+    // depth (longest run of parents above them) and generation relative
+    // to the root are stored, indexed, and updated with every change to
+    // relationships: a new link relabels only people it brings closer to
+    // the root, a removed one only people who were reached through it.
+    // An empty ID clears the root
+    bool setRootPerson(const std::string& personId);
+    std::string getRootPerson();
+    // Parents are one generation less, children one more, spouses and
+    // siblings the same, counted along the fewest links from the root
+    // (the lowest generation among equally short ones); none when not
+    // connected to the root
+    std::optional<int> getGeneration(const std::string& personId);
+    int getDepth(const std::string& personId);  // -1 for an unknown person
+    // Everyone in a generation or at a depth, by ID
+    std::vector<Person> getPeopleInGeneration(int generation);
+    std::vector<Person> getPeopleAtDepth(int depth);
+    // personId's ancestors (or descendants) in a stored generation,
+    // counted from origin, by ID; none without a root or when personId
+    // has no generation
+    std::vector<Person> getLineageInGeneration(const std::string& personId, bool ancestors, int generation,
+                                               GenerationOrigin origin);
+    // Recomputes all depths and generations; returns the number of people
+    // in generations
+    int rebuildGenerations();
+
+    // Places are kept in a dictionary per database file: a person stores
+    // place IDs, and "Salem, Essex, Massachusetts" becomes Salem inside
+    // Essex inside Massachusetts. Counters per place and decade follow
+    // every change to people, so these reports read no people at all.
+    // Returns the counts for place and every place within it (all places
+    // when place is empty), ordered by place name and decade. Births and
+    // deaths count only when their date starts with a year.
+    std::vector<PlaceCount> getPlaceCounts(const std::string& place = "");
+    // Moves place text stored before the dictionary existed into it;
+    // returns the number of distinct place names moved
+    int backfillPlaces();
 
     // Relationship operations
     bool addRelationship(const Relationship& relationship);
+    // Stores the relationship's dates; its people and type stay as added
     bool updateRelationship(const Relationship& relationship);
     bool deleteRelationship(const std::string& relationshipId);
     std::optional<Relationship> getRelationship(const std::string& relationshipId);
     std::vector<Relationship> getRelationshipsForPerson(const std::string& personId);
+    std::vector<Relationship> getAllRelationships();
+
+    // Sharding. addShard registers a new file and moves people already in
+    // its surname range out of the main file; moveBranchToShard moves a
+    // person, all descendants and optionally their spouses. Both return
+    // the number of people moved.
+    int addShard(const std::string& path, const std::string& surnameFrom,
+                 const std::string& surnameTo);
+    int moveBranchToShard(const std::string& personId, int shardId, bool includeSpouses);
+    std::vector<ShardInfo> getShards() const;
+    int countPeople(int shardId);
 
-    // Transaction management
+    // Grafts the tree stored in another database file into this one with
+    // set-based statements, in one transaction. Must not be called inside
+    // a transaction (SQLite cannot attach a database there). Only
+    // supported while the tree is not sharded.
+    MergeSummary mergeDatabase(const std::string& otherDbPath, const MergeOptions& options);
+
+    // Transaction management. Transactions nest; see SQLiteConnector.
     void beginTransaction();
     void commit();
     void rollback();
 
+    // Runs operation in a (possibly nested) transaction, committing when it
+    // returns true and rolling back when it returns false or throws
+    bool runAtomically(const std::function<bool()>& operation);
+
 private:
+    // Shard routing
+    bool isSharded() const { return !shards.empty(); }
+    int shardOf(const std::string& personId);
+    int shardForSurname(const std::string& lastName) const;
+    SQLiteConnector& shardConnector(int shardId);
+    SQLiteConnector& connectorFor(const std::string& personId);
+    std::vector<SQLiteConnector*> allConnectors();
+    void openShard(const ShardInfo& info);
+    bool movePerson(const std::string& personId, int shardId);
+    std::vector<std::string> collectBranch(const std::string& personId, bool includeSpouses);
+    PersonPage queryPersonPage(const std::string& sql, std::vector<std::string> params,
+                               size_t offset, size_t limit);
+    PersonPage traverseLineagePage(const std::string& personId, bool ancestors, int generations,
+                                   size_t offset, size_t limit);
+    static std::string phoneticSearchSql(const std::string& searchTerm,
+                                         const std::vector<PhoneticAlgorithm>& algorithms,
+                                         std::vector<std::string>& params);
+
     // Helper methods
     Person createPersonFromRow(const std::map<std::string, std::string>& row);
     Relationship createRelationshipFromRow(const std::map<std::string, std::string>& row);
+    bool insertPerson(SQLiteConnector& target, const Person& person);
+    bool insertRelationship(SQLiteConnector& target, const Relationship& relationship, bool ignoreExisting);
+    bool detachPerson(const std::string& personId, bool& hadParents);
+    bool writePhoneticKeys(SQLiteConnector& target,
+                           const std::string& personId,
+                           const std::string& firstName,
+                           const std::string& lastName);
+    // Brings personId's father, mother and lines up to date after their
+    // parents or a parent's gender changed in a sharded tree; triggers do
+    // this (and keep depths) otherwise
+    bool refreshDirectLines(const std::string& personId);
+    std::vector<Person> queryLine(const std::string& lineSql, const std::vector<std::string>& params);
+    int backfillDirectLines();
+    // Couple upkeep after a spouse link changed; families of children
+    // follow ParentLink writes in the database itself
+    bool refreshCouple(const std::string& person1Id, const std::string& person2Id);
+    bool setCouple(const std::string& person1Id, const std::string& person2Id, bool married, bool ended);
+    std::vector<FamilyUnit> queryFamilies(const std::string& whereSql, const std::vector<std::string>& params);
+    // One-off conversions of files written by earlier versions, recorded
+    // in TreeSettings so each runs once
+    bool isMigrated(const std::string& step);
+    bool markMigrated(const std::string& step);
+    int migrateParentLinks();
+    // Generation upkeep around an added or removed link
+    struct GenerationUpdate;
+    struct GenerationLink {
+        std::string person1Id;
+        std::string person2Id;
+        int difference;  // person2's generation minus person1's
+    };
+    bool linkGenerations(const std::string& person1Id, const std::string& person2Id, int difference);
+    bool linkGenerations(const std::vector<GenerationLink>& links);
+    bool unlinkGenerations(const std::vector<std::string>& people);
+    void forgetRootPerson();
+    int backfillGenerations();
+    // ID of the place named `place` in target's dictionary, adding it
+    // and the places containing it when missing; "" for no place
+    std::string placeId(SQLiteConnector& target, const std::string& place);
+    int normalizePlaces(SQLiteConnector& target);
 };
 
 #endif // DATABASE_MANAGER_HPP
\ No newline at end of file
@@ -2,15 +2,58 @@
 #define SQLITE_CONNECTOR_HPP
 
 #include <sqlite3.h>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
+// Thread safety: one writer connection serves commands and transactions;
+// a transaction belongs to the thread that began it and other threads'
+// commands wait until it ends. Queries from threads that do not own the
+// open transaction run on per-thread read-only connections (WAL mode), so
+// they proceed in parallel and see the last committed state. In-memory
+// databases cannot be shared between connections and use the writer
+// connection for everything. A thread's read-only connection is closed
+// when the thread exits.
+//
+// Prepared statements are cached per connection by SQL text, so repeated
+// statements skip parsing and planning.
 class SQLiteConnector {
 private:
-    sqlite3* db;
+    struct Connection {
+        sqlite3* handle = nullptr;
+        std::unordered_map<std::string, sqlite3_stmt*> statements;
+    };
+
+    Connection writer;
+    sqlite3* db;  // writer.handle
     std::string dbPath;
+    bool useReaderConnections;
+
+    std::recursive_mutex writerMutex;
+    std::atomic<std::thread::id> transactionOwner;
+    std::atomic<int> transactionDepth;
+
+    // Read-only connections by thread. The pool is shared with the threads
+    // using it, so a thread that exits can close its connection whether or
+    // not the connector is still around.
+    struct ReaderPool {
+        std::mutex mutex;
+        std::map<std::thread::id, std::unique_ptr<Connection>> connections;
+        ~ReaderPool();
+    };
+    // The pools holding a connection for the current thread; closes those
+    // connections when the thread exits
+    struct ThreadReaders {
+        std::vector<std::weak_ptr<ReaderPool>> pools;
+        ~ThreadReaders();
+    };
+    static thread_local ThreadReaders threadReaders;
+    std::shared_ptr<ReaderPool> readers;
 
 public:
     // Constructor and destructor
@@ -23,19 +66,38 @@ public:
         const std::string& sql, 
         const std::vector<std::string>& params = {}
     );
+    // Rows inserted, updated or deleted by the last command
+    int changes();
 
-    // Transaction methods
+    // Transaction methods. Transactions nest: inner levels become
+    // savepoints, so a failed step can roll back without aborting the
+    // enclosing transaction. commit() throws std::runtime_error when the
+    // commit fails, after rolling back that level.
     void beginTransaction();
     void commit();
     void rollback();
+    bool inTransaction() const;
 
     // Database initialization
     bool initializeDatabase();
 
 private:
     // Helper methods
+    static sqlite3* openConnection(const std::string& path, int flags);
+    static void closeConnection(Connection& connection);
+    Connection& connectionForRead();
+    sqlite3_stmt* prepare(Connection& connection,
+                          const std::string& sql,
+                          const std::vector<std::string>& params,
+                          bool* cached = nullptr);
+    std::vector<std::map<std::string, std::string>> runQuery(
+        Connection& connection,
+        const std::string& sql,
+        const std::vector<std::string>& params
+    );
+    static std::vector<std::string> explainQueryPlan(sqlite3* handle, const std::string& sql);
     static int callback(void* data, int argc, char** argv, char** azColName);
-    void checkError(int result, const std::string& operation);
+    void checkError(sqlite3* handle, int result, const std::string& operation);
 };
 
-#endif // SQLITE_CONNECTOR_HPP
\ No newline at end of file
+#endif // SQLITE_CONNECTOR_HPP
@@ -0,0 +1,51 @@
+#ifndef SLOW_QUERY_LOG_HPP
+#define SLOW_QUERY_LOG_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SlowQueryLogOptions {
+    std::string path = "family_tree_slow.log";
+    double thresholdMillis = 100.0;
+    size_t maxBytes = 10 * 1024 * 1024;  // rotate when the log grows past this
+    int keepFiles = 5;                   // rotated files kept as PATH.1 .. PATH.N
+};
+
+// One query that took longer than the threshold
+struct SlowQuery {
+    std::string sql;
+    std::vector<std::string> params;
+    uint64_t elapsedNanos = 0;
+    size_t rows = 0;
+    std::vector<std::string> plan;  // EXPLAIN QUERY PLAN, indented by depth
+};
+
+// Process-wide log of slow queries, off by default. SQLiteConnector
+// reports every query whose execution exceeds the threshold together
+// with its query plan; full scans of Person or Relationship are flagged
+// with a warning since they usually mean a missing index. When disabled
+// the check costs one relaxed atomic load per query.
+class SlowQueryLog {
+public:
+    static bool enabled() { return enabledFlag.load(std::memory_order_relaxed); }
+    static uint64_t thresholdNanos() { return threshold.load(std::memory_order_relaxed); }
+
+    // Starts logging to options.path (appending); throws if it cannot be opened
+    static void enable(const SlowQueryLogOptions& options);
+    static void disable();
+    static SlowQueryLogOptions options();
+
+    static void record(const SlowQuery& query);
+
+    // Person/Relationship tables the plan reads with a full scan
+    static std::vector<std::string> fullScans(const std::string& sql, const std::vector<std::string>& plan);
+
+private:
+    static std::atomic<bool> enabledFlag;
+    static std::atomic<uint64_t> threshold;
+};
+
+#endif // SLOW_QUERY_LOG_HPP
@@ -4,15 +4,38 @@
 #include "models/Person.hpp"
 #include "models/Relationship.hpp"
 #include "database/DatabaseManager.hpp"
+#include "utils/QueryCache.hpp"
+#include "utils/ReentrantSharedMutex.hpp"
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
 
+enum class NameSearchMode {
+    SUBSTRING,          // LIKE match on first, last and full name
+    SOUNDEX,
+    DAITCH_MOKOTOFF,
+    DOUBLE_METAPHONE,
+    PHONETIC            // any of the phonetic algorithms
+};
+
+// Thread safety: every public member may be called from any thread.
+// Queries hold a shared lock and run concurrently; mutations hold an
+// exclusive lock, and multi-step mutations (delete with cascade, add with
+// validation) run in a single transaction, so readers never observe them
+// half-applied. Members may call each other while a lock is held.
 class FamilyTree {
 private:
     std::unique_ptr<DatabaseManager> dbManager;
-    std::string rootPersonId;  // ID of the main person in the family tree
+    mutable ReentrantSharedMutex treeMutex;
+    QueryCache cache;  // navigation and traversal results
+    std::atomic<uint64_t> revision{0};
+
+    using ReadLock = std::shared_lock<ReentrantSharedMutex>;
+    using WriteLock = std::unique_lock<ReentrantSharedMutex>;
 
 public:
     explicit FamilyTree(const std::string& dbPath);
@@ -21,19 +44,62 @@ public:
     bool addPerson(const Person& person);
     bool updatePerson(const Person& person);
     bool deletePerson(const std::string& personId);
+    // Deletes a person with all descendants (optionally with their spouses)
+    // in one transaction; returns the number of people removed
+    int deleteBranch(const std::string& personId, bool includeSpouses = false);
     std::optional<Person> getPerson(const std::string& personId);
+    std::vector<Person> getAllPeople();
     
     // Relationship management
+    // Dates apply to spouse relationships only (the marriage and its end);
+    // see Relationship::setStartDate. Invalid dates throw
+    // std::invalid_argument. The new relationship's ID, stored in
+    // relationshipId when given, is "<person1>_<person2>_<type>", with
+    // "_2", "_3"... for a couple's later marriages.
     bool addRelationship(const std::string& person1Id, 
                         const std::string& person2Id, 
-                        RelationType type);
+                        RelationType type,
+                        const std::string& startDate = "",
+                        const std::string& endDate = "",
+                        std::string* relationshipId = nullptr);
+    bool setRelationshipDates(const std::string& relationshipId,
+                              const std::string& startDate,
+                              const std::string& endDate);
     bool removeRelationship(const std::string& relationshipId);
+    std::vector<Relationship> getAllRelationships();
+
+    // Storage sharding; see DatabaseManager. Moving people between shards
+    // keeps their IDs and data, so cached results stay valid.
+    int addShard(const std::string& path, const std::string& surnameFrom = "",
+                 const std::string& surnameTo = "");
+    int moveBranchToShard(const std::string& personId, int shardId, bool includeSpouses = false);
+    std::vector<ShardInfo> getShards();
+    int countPeople(int shardId);
+
+    // Births and deaths per place and decade; see DatabaseManager::getPlaceCounts
+    std::vector<PlaceCount> getPlaceCounts(const std::string& place = "");
+
+    // Direct paternal or maternal lines; see DatabaseManager::getLineAncestors
+    std::vector<Person> getLineAncestors(const std::string& personId, DirectLine line);
+    std::vector<Person> getLineDescendants(const std::string& personId, DirectLine line);
+    std::vector<Person> getLineMembers(const std::string& personId, DirectLine line);
+
+    // Grafts another family tree database into this one; see
+    // DatabaseManager::mergeDatabase
+    MergeSummary mergeDatabase(const std::string& otherDbPath,
+                               const MergeOptions& options = MergeOptions());
     
     // Tree navigation
     std::vector<Person> getParents(const std::string& personId);
     std::vector<Person> getChildren(const std::string& personId);
     std::optional<Person> getSpouse(const std::string& personId);
-    std::vector<Person> getSiblings(const std::string& personId);
+    // Children of the person's parents, by ID; FULL keeps those born into
+    // the same family unit, HALF the others
+    std::vector<Person> getSiblings(const std::string& personId, SiblingKind kind = SiblingKind::ALL);
+    // Family units; see DatabaseManager::getFamilies
+    std::vector<Person> getPartners(const std::string& personId);
+    std::vector<FamilyUnit> getFamilies(const std::string& personId);
+    std::optional<FamilyUnit> getParentFamily(const std::string& personId);
     
     // Tree queries
     std::vector<Person> getAncestors(const std::string& personId, int generations = -1);
@@ -42,25 +108,72 @@ public:
                                           const std::string& person2Id);
     int calculateGenerationGap(const std::string& person1Id, 
                              const std::string& person2Id);
+    // One page of ancestors or descendants, nearest generation first. Only
+    // the part of the tree needed for the page is read.
+    PersonPage getAncestorsPage(const std::string& personId, int generations,
+                                size_t offset, size_t limit);
+    PersonPage getDescendantsPage(const std::string& personId, int generations,
+                                  size_t offset, size_t limit);
     
     // Search functionality
-    std::vector<Person> searchByName(const std::string& name);
+    std::vector<Person> searchByName(const std::string& name,
+                                     NameSearchMode mode = NameSearchMode::SUBSTRING);
+    // One page of matches, ordered by last name, first name and ID
+    PersonPage searchByNamePage(const std::string& name, NameSearchMode mode,
+                                size_t offset, size_t limit);
     std::vector<Person> searchByDateRange(const std::string& startDate, 
                                         const std::string& endDate);
 
-    // Tree validation
+    // Tree validation. A marriage must not be in force (see
+    // RelationshipTimeline::marriageSpan) while either partner is married.
     bool validateRelationship(const std::string& person1Id, 
                             const std::string& person2Id, 
-                            RelationType type);
+                            RelationType type,
+                            const std::string& startDate = "",
+                            const std::string& endDate = "");
+    // The main person of the tree, stored with it; generations count from
+    // here. Throws std::invalid_argument for an unknown person.
     void setRootPerson(const std::string& personId);
     std::string getRootPerson() const;
 
+    // Stored generations and depths; see DatabaseManager::getGeneration
+    std::optional<int> getGeneration(const std::string& personId);
+    int getDepth(const std::string& personId);
+    std::vector<Person> getPeopleInGeneration(int generation);
+    std::vector<Person> getPeopleAtDepth(int depth);
+    // Ancestors or descendants in one stored generation, by ID: -2 is the
+    // grandparents' generation when counted from the person
+    std::vector<Person> getAncestorsInGeneration(const std::string& personId, int generation,
+                                                 GenerationOrigin origin = GenerationOrigin::PERSON);
+    std::vector<Person> getDescendantsInGeneration(const std::string& personId, int generation,
+                                                   GenerationOrigin origin = GenerationOrigin::PERSON);
+
+    // Groups many operations into one transaction. The calling thread holds
+    // the tree exclusively from beginTransaction until the matching
+    // commit/rollback; calls nest.
+    void beginTransaction();
+    void commit();
+    void rollback();
+
+    // Result cache for parents/children/spouse/siblings/ancestors/descendants
+    QueryCacheStats getCacheStats() const;
+    void setCacheBudget(size_t bytes);  // 0 disables the cache
+
+    // Changes whenever people or relationships may have changed (including
+    // rollbacks), so snapshots of the tree can tell when they are stale
+    uint64_t getRevision() const { return revision.load(); }
+
 private:
     // Helper methods
     bool isAncestor(const std::string& ancestorId, const std::string& descendantId);
     bool isSibling(const std::string& person1Id, const std::string& person2Id);
+    // Whether no other marriage of either partner is in force at the same
+    // time; the IDs of person1's relationships are added to person1Ids
+    bool isFreeToMarry(const Relationship& marriage, std::vector<std::string>* person1Ids = nullptr);
     std::vector<Person> getRelatives(const std::string& personId, 
                                    RelationType type);
+    static std::vector<std::string> dependenciesOf(const std::string& personId,
+                                                   const std::vector<Person>& people);
     void getAncestorsRecursive(const std::string& personId, 
                               std::vector<Person>& ancestors, 
                               int currentGen, 
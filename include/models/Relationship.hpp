@@ -46,6 +46,8 @@ public:
     // Static methods for relationship validation
     static bool isValidRelationType(RelationType type);
     static std::string relationTypeToString(RelationType type);
+    // Accepts the stored form ("Parent-Child") and the enum name ("PARENT_CHILD")
+    static RelationType relationTypeFromString(const std::string& type);
 };
 
 #endif // RELATIONSHIP_HPP
\ No newline at end of file
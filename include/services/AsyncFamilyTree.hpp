@@ -0,0 +1,97 @@
+#ifndef ASYNC_FAMILY_TREE_HPP
+#define ASYNC_FAMILY_TREE_HPP
+
+#include "models/FamilyTree.hpp"
+#include "utils/CancellationToken.hpp"
+#include "utils/ThreadPool.hpp"
+#include <future>
+#include <memory>
+
+// Non-blocking facade over a FamilyTree. Every call is queued on a worker
+// pool and returns a future. A token passed with a call is checked before
+// the call starts and while deep traversals run; a cancelled or expired
+// call completes its future with OperationCancelled.
+//
+// The FamilyTree must outlive this object. Destruction waits for queued
+// calls to finish.
+class AsyncFamilyTree {
+private:
+    FamilyTree& tree;
+    ThreadPool pool;
+
+public:
+    // threadCount == 0 uses the hardware concurrency
+    explicit AsyncFamilyTree(FamilyTree& tree, size_t threadCount = 0);
+
+    // Person management
+    std::future<bool> addPerson(const Person& person, CancellationToken token = {});
+    std::future<bool> updatePerson(const Person& person, CancellationToken token = {});
+    std::future<bool> deletePerson(const std::string& personId, CancellationToken token = {});
+    std::future<std::optional<Person>> getPerson(const std::string& personId,
+                                                 CancellationToken token = {});
+
+    // Relationship management
+    std::future<bool> addRelationship(const std::string& person1Id,
+                                      const std::string& person2Id,
+                                      RelationType type,
+                                      const std::string& startDate = "",
+                                      const std::string& endDate = "",
+                                      CancellationToken token = {});
+    std::future<bool> removeRelationship(const std::string& relationshipId,
+                                         CancellationToken token = {});
+
+    // Tree navigation
+    std::future<std::vector<Person>> getParents(const std::string& personId,
+                                                CancellationToken token = {});
+    std::future<std::vector<Person>> getChildren(const std::string& personId,
+                                                 CancellationToken token = {});
+    std::future<std::optional<Person>> getSpouse(const std::string& personId,
+                                                 CancellationToken token = {});
+    std::future<std::vector<Person>> getSiblings(const std::string& personId,
+                                                 CancellationToken token = {});
+
+    // Tree queries
+    std::future<std::vector<Person>> getAncestors(const std::string& personId,
+                                                  int generations = -1,
+                                                  CancellationToken token = {});
+    std::future<std::vector<Person>> getDescendants(const std::string& personId,
+                                                    int generations = -1,
+                                                    CancellationToken token = {});
+    std::future<std::vector<Person>> findCommonAncestors(const std::string& person1Id,
+                                                         const std::string& person2Id,
+                                                         CancellationToken token = {});
+    std::future<int> calculateGenerationGap(const std::string& person1Id,
+                                            const std::string& person2Id,
+                                            CancellationToken token = {});
+
+    // Search functionality
+    std::future<std::vector<Person>> searchByName(const std::string& name,
+                                                  NameSearchMode mode = NameSearchMode::SUBSTRING,
+                                                  CancellationToken token = {});
+    std::future<std::vector<Person>> searchByDateRange(const std::string& startDate,
+                                                       const std::string& endDate,
+                                                       CancellationToken token = {});
+
+    // Queues any callable taking the tree
+    template <typename Fn>
+    auto submit(Fn operation, CancellationToken token = {})
+        -> std::future<decltype(operation(std::declval<FamilyTree&>()))>;
+};
+
+template <typename Fn>
+auto AsyncFamilyTree::submit(Fn operation, CancellationToken token)
+    -> std::future<decltype(operation(std::declval<FamilyTree&>()))> {
+    using Result = decltype(operation(std::declval<FamilyTree&>()));
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        [this, operation = std::move(operation), token]() mutable {
+            token.throwIfCancelled();
+            CancellationToken::Scope scope(token);
+            return operation(tree);
+        });
+    auto future = task->get_future();
+    pool.submit([task]() { (*task)(); });
+    return future;
+}
+
+#endif // ASYNC_FAMILY_TREE_HPP
@@ -0,0 +1,71 @@
+#ifndef CHART_EXPORTER_HPP
+#define CHART_EXPORTER_HPP
+
+#include "models/FamilyTree.hpp"
+#include "utils/CancellationToken.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class ChartType {
+    PEDIGREE,     // ancestors above the root person
+    DESCENDANTS,  // descendants below the root person
+    HOURGLASS     // both
+};
+
+enum class ChartFormat {
+    SVG,
+    DOT           // Graphviz, with positions pinned (render with neato -n2)
+};
+
+struct ChartOptions {
+    ChartType type = ChartType::DESCENDANTS;
+    ChartFormat format = ChartFormat::SVG;
+    int generations = -1;         // per direction; -1 for all
+    bool includeSpouses = true;   // name spouses in descendant boxes
+};
+
+struct ChartSummary {
+    size_t boxes = 0;             // a person reached twice is drawn twice
+    size_t people = 0;
+    int ancestorGenerations = 0;
+    int descendantGenerations = 0;
+    double width = 0;             // drawing size in SVG user units
+    double height = 0;
+};
+
+// Draws pedigree, descendant and hourglass charts.
+//
+// Works on an in-memory snapshot of the tree. Each chart is laid out as
+// an ordered tree with the Buchheim-Walker tidy-tree algorithm, which is
+// linear in the number of boxes. Output is written box by box as the
+// laid-out tree is walked. A person reached again through pedigree
+// collapse or a marriage between relatives is drawn as a dashed reference
+// box that is not expanded further, so charts never grow exponentially.
+class ChartExporter {
+private:
+    struct Graph;
+    struct Layout;
+
+    FamilyTree& tree;
+
+    static void buildLayout(const Graph& graph, uint32_t root, bool ancestors, int generations,
+                            Layout& layout, const CancellationToken& token);
+    static void writeSvg(const Graph& graph, const std::vector<const Layout*>& layouts,
+                         const ChartOptions& options, ChartSummary& summary, std::ostream& out);
+    static void writeDot(const Graph& graph, const std::vector<const Layout*>& layouts,
+                         const ChartOptions& options, std::ostream& out);
+
+public:
+    explicit ChartExporter(FamilyTree& tree);
+
+    // Throws std::invalid_argument when the root person does not exist
+    ChartSummary write(const std::string& rootId, const ChartOptions& options, std::ostream& out,
+                       CancellationToken token = {});
+
+    static ChartType parseType(const std::string& type);
+    static ChartFormat parseFormat(const std::string& format);
+};
+
+#endif // CHART_EXPORTER_HPP
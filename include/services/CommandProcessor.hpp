@@ -0,0 +1,110 @@
+#ifndef COMMAND_PROCESSOR_HPP
+#define COMMAND_PROCESSOR_HPP
+
+#include "models/FamilyTree.hpp"
+#include "services/LifespanIndex.hpp"
+#include "services/RelationshipCalculator.hpp"
+#include "services/RelationshipTimeline.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+struct CommandResult {
+    std::string command;
+    bool ok = false;
+    bool mutating = false;
+    std::string payload;    // JSON value, "null" when the command returns nothing
+    std::string error;
+};
+
+// Text command language shared by the batch runner and the query server.
+// One command per line, arguments separated by whitespace; arguments with
+// spaces are double-quoted ("" is an empty argument). Lines starting with
+// '#' are comments. See help() for the command list.
+class CommandProcessor {
+private:
+    using Handler = std::string (CommandProcessor::*)(const std::vector<std::string>& args);
+
+    struct CommandSpec {
+        Handler handler;
+        size_t minArgs;
+        size_t maxArgs;
+        bool mutating;
+        const char* usage;
+    };
+
+    FamilyTree& tree;
+    RelationshipCalculator relationshipCalculator;  // keeps its graph snapshot between commands
+    LifespanIndex lifespanIndex;
+    RelationshipTimeline relationshipTimeline;
+
+    static const std::map<std::string, CommandSpec>& commands();
+
+    // Command handlers
+    std::string addPerson(const std::vector<std::string>& args);
+    std::string updatePerson(const std::vector<std::string>& args);
+    std::string deletePerson(const std::vector<std::string>& args);
+    std::string deleteBranch(const std::vector<std::string>& args);
+    std::string link(const std::vector<std::string>& args);
+    std::string linkDates(const std::vector<std::string>& args);
+    std::string unlink(const std::vector<std::string>& args);
+    std::string get(const std::vector<std::string>& args);
+    std::string parents(const std::vector<std::string>& args);
+    std::string children(const std::vector<std::string>& args);
+    std::string spouse(const std::vector<std::string>& args);
+    std::string siblings(const std::vector<std::string>& args);
+    std::string family(const std::vector<std::string>& args);
+    std::string ancestors(const std::vector<std::string>& args);
+    std::string descendants(const std::vector<std::string>& args);
+    std::string commonAncestors(const std::vector<std::string>& args);
+    std::string generationGap(const std::vector<std::string>& args);
+    std::string path(const std::vector<std::string>& args);
+    std::string alive(const std::vector<std::string>& args);
+    std::string contemporaries(const std::vector<std::string>& args);
+    std::string livingFamily(const std::vector<std::string>& args);
+    std::string household(const std::vector<std::string>& args);
+    std::string marriages(const std::vector<std::string>& args);
+    std::string directLine(const std::vector<std::string>& args);
+    std::string root(const std::vector<std::string>& args);
+    std::string generation(const std::vector<std::string>& args);
+    std::string generationList(const std::vector<std::string>& args);
+    std::string generationSlice(const std::vector<std::string>& args);
+    std::string search(const std::vector<std::string>& args);
+    std::string exportTree(const std::vector<std::string>& args);
+    std::string chart(const std::vector<std::string>& args);
+    std::string cacheStats(const std::vector<std::string>& args);
+    std::string stats(const std::vector<std::string>& args);
+    std::string slowLog(const std::vector<std::string>& args);
+    std::string merge(const std::vector<std::string>& args);
+    std::string duplicates(const std::vector<std::string>& args);
+    std::string placeStats(const std::vector<std::string>& args);
+    std::string inbreeding(const std::vector<std::string>& args);
+    std::string kinship(const std::vector<std::string>& args);
+    std::string kinshipMatrix(const std::vector<std::string>& args);
+    std::string listShards(const std::vector<std::string>& args);
+    std::string addShard(const std::vector<std::string>& args);
+    std::string moveBranchToShard(const std::vector<std::string>& args);
+
+    // Helper methods
+    static Person personFromArgs(const std::vector<std::string>& args);
+    static RelationType parseRelationType(const std::string& type);
+    static NameSearchMode parseSearchMode(const std::string& mode);
+    static DirectLine parseDirectLine(const std::string& line);
+    static int parseInt(const std::string& value);
+    static double parseDouble(const std::string& value);
+
+public:
+    explicit CommandProcessor(FamilyTree& tree);
+
+    // Never throws: failures are reported in the result
+    CommandResult execute(const std::string& line);
+    CommandResult execute(const std::vector<std::string>& tokens);
+
+    static std::vector<std::string> tokenize(const std::string& line);
+    static bool isMutating(const std::string& command);
+    // Commands that manage their own transaction and fail inside another
+    static bool runsOutsideTransaction(const std::string& command);
+    static std::string help();
+};
+
+#endif // COMMAND_PROCESSOR_HPP
@@ -0,0 +1,63 @@
+#ifndef DUPLICATE_DETECTOR_HPP
+#define DUPLICATE_DETECTOR_HPP
+
+#include "models/FamilyTree.hpp"
+#include "utils/CancellationToken.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct DuplicateOptions {
+    double minScore = 0.80;         // candidates scoring lower are dropped
+    size_t maxResults = 1000;       // 0 keeps every candidate
+    int birthYearBucket = 10;       // width of the birth-year blocking bucket
+    // Blocks larger than this are compared with a sliding window over
+    // members sorted by first name instead of all pairs
+    size_t maxBlockSize = 64;
+    size_t window = 16;
+    size_t threads = 0;             // 0 uses the hardware concurrency
+};
+
+struct DuplicateCandidate {
+    std::string person1Id;
+    std::string person2Id;
+    double score = 0.0;             // weighted total in [0, 1]
+    double nameScore = 0.0;
+    double dateScore = 0.0;
+    double placeScore = 0.0;
+    double relativeScore = 0.0;
+};
+
+// Finds people recorded more than once (typically after merging trees).
+//
+// Works on an in-memory snapshot of the tree. People are grouped by
+// blocking keys (Soundex of the surname with a birth-year bucket, and with
+// the birth place), and only people sharing a block are compared, so the
+// work grows with the number of people rather than its square. Candidate
+// pairs are scored in parallel on names (Jaro-Winkler), dates, places and
+// relatives in common, and returned best first. People directly related
+// to each other are never reported.
+class DuplicateDetector {
+private:
+    struct Record;
+
+    FamilyTree& tree;
+
+    static std::vector<std::pair<uint32_t, uint32_t>> candidatePairs(
+        const std::vector<Record>& records,
+        const DuplicateOptions& options,
+        const CancellationToken& token);
+    static DuplicateCandidate score(const Record& a, const Record& b,
+                                    const std::vector<Record>& records);
+
+public:
+    explicit DuplicateDetector(FamilyTree& tree);
+
+    std::vector<DuplicateCandidate> findDuplicates(const DuplicateOptions& options = DuplicateOptions(),
+                                                   CancellationToken token = {});
+
+    // Jaro-Winkler similarity in [0, 1], ignoring case
+    static double jaroWinkler(const std::string& a, const std::string& b);
+};
+
+#endif // DUPLICATE_DETECTOR_HPP
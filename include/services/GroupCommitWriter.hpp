@@ -0,0 +1,91 @@
+#ifndef GROUP_COMMIT_WRITER_HPP
+#define GROUP_COMMIT_WRITER_HPP
+
+#include "models/FamilyTree.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+enum class CommitDurability {
+    ON_RETURN,      // a future completes once its mutation is committed
+    WITHIN_WINDOW   // a future completes once applied; the commit follows within the window
+};
+
+struct GroupCommitOptions {
+    // How long a batch stays open waiting for more mutations. With 0 a batch
+    // commits as soon as the queue drains, and whatever arrives during that
+    // commit forms the next batch.
+    std::chrono::milliseconds window{0};
+    size_t maxBatchSize = 512;
+    CommitDurability durability = CommitDurability::ON_RETURN;
+};
+
+struct GroupCommitStats {
+    uint64_t mutations = 0;
+    uint64_t failed = 0;
+    uint64_t batches = 0;
+};
+
+// Coalesces single mutations from many callers into shared transactions,
+// so N concurrent writers pay for one commit (and one fsync) instead of N.
+//
+// Mutations are queued and applied in order by a committer thread. Each
+// runs in its own savepoint, so a failing mutation does not affect the
+// others in its batch. A batch is committed when it reaches maxBatchSize
+// or its window has elapsed. While a batch is open the committer holds
+// the tree exclusively, so readers may wait up to one window.
+//
+// If the commit fails the whole batch is rolled back: ON_RETURN futures of
+// that batch throw the commit error. With WITHIN_WINDOW a mutation reported
+// as successful can still be lost, by a failed commit or if the process
+// dies before its batch commits.
+class GroupCommitWriter {
+private:
+    struct PendingMutation {
+        std::function<bool(FamilyTree&)> apply;
+        std::promise<bool> done;
+        bool waitForCommit;
+    };
+
+    FamilyTree& tree;
+    GroupCommitOptions options;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<PendingMutation> queue;
+    bool stopping;
+    GroupCommitStats stats;
+    std::thread committer;
+
+    void commitLoop();
+    void applyBatch(std::unique_lock<std::mutex>& lock);
+
+public:
+    GroupCommitWriter(FamilyTree& tree, GroupCommitOptions options = GroupCommitOptions());
+    // Commits everything still queued
+    ~GroupCommitWriter();
+
+    GroupCommitWriter(const GroupCommitWriter&) = delete;
+    GroupCommitWriter& operator=(const GroupCommitWriter&) = delete;
+
+    std::future<bool> addPerson(const Person& person);
+    std::future<bool> updatePerson(const Person& person);
+    std::future<bool> deletePerson(const std::string& personId);
+    std::future<bool> addRelationship(const std::string& person1Id,
+                                      const std::string& person2Id,
+                                      RelationType type);
+    std::future<bool> removeRelationship(const std::string& relationshipId);
+    std::future<bool> submit(std::function<bool(FamilyTree&)> mutation);
+
+    // Blocks until every mutation queued so far is committed
+    void flush();
+
+    GroupCommitStats getStats();
+};
+
+#endif // GROUP_COMMIT_WRITER_HPP
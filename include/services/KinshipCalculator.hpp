@@ -0,0 +1,72 @@
+#ifndef KINSHIP_CALCULATOR_HPP
+#define KINSHIP_CALCULATOR_HPP
+
+#include "models/FamilyTree.hpp"
+#include "utils/CancellationToken.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct KinshipOptions {
+    size_t threads = 0;             // 0 uses the hardware concurrency
+};
+
+// Kinship coefficients of every pair in a cohort
+struct KinshipMatrix {
+    std::vector<std::string> ids;   // cohort order, duplicates removed
+    std::vector<double> values;     // row-major, ids.size() x ids.size()
+
+    double at(size_t row, size_t column) const { return values[row * ids.size() + column]; }
+};
+
+// Wright's inbreeding coefficient (F) and the kinship coefficient (the
+// probability that alleles drawn at random from two people are identical
+// by descent; half the additive relationship).
+//
+// Works on an in-memory snapshot of the Parent-Child relationships, with
+// people in topological order (parents first) and at most two parents
+// each. Only the ancestors of the people asked about are used.
+//
+// Inbreeding follows Meuwissen & Luo (1992): each person's ancestors are
+// walked once in reverse topological order with a sparse list, and people
+// of the same pedigree depth are processed in parallel. Kinship uses
+// Colleau's (2002) indirect method: one backward and one forward pass over
+// the pedigree yields a whole column of the relationship matrix. Columns
+// are computed in blocks that are stored interleaved, so each pass updates
+// contiguous rows the compiler can vectorize, and blocks run in parallel.
+// A cohort of m people drawn from a pedigree of n costs O(m * n), with
+// O(n) memory per thread besides the result.
+class KinshipCalculator {
+private:
+    struct Pedigree;
+
+    FamilyTree& tree;
+    KinshipOptions options;
+
+    // The given people and all their ancestors; everyone when ids is empty
+    Pedigree snapshot(const std::vector<std::string>& ids, const CancellationToken& token);
+    std::vector<double> inbreeding(const Pedigree& pedigree, const CancellationToken& token) const;
+    // result[r * columns.size() + c] receives the kinship of rows[r] with
+    // columns[c] (pedigree indexes)
+    void kinshipColumns(const Pedigree& pedigree, const std::vector<double>& inbreeding,
+                        const std::vector<uint32_t>& columns, const std::vector<uint32_t>& rows,
+                        std::vector<double>& result, const CancellationToken& token) const;
+
+public:
+    explicit KinshipCalculator(FamilyTree& tree, const KinshipOptions& options = KinshipOptions());
+
+    // Inbreeding coefficient of everyone in the tree
+    std::unordered_map<std::string, double> inbreedingCoefficients(CancellationToken token = {});
+    // Throws std::invalid_argument for an unknown ID
+    double inbreedingCoefficient(const std::string& personId, CancellationToken token = {});
+
+    // One coefficient per pair, in order; throws std::invalid_argument for
+    // an unknown ID
+    std::vector<double> kinship(const std::vector<std::pair<std::string, std::string>>& pairs,
+                                CancellationToken token = {});
+    KinshipMatrix kinshipMatrix(const std::vector<std::string>& cohort, CancellationToken token = {});
+};
+
+#endif // KINSHIP_CALCULATOR_HPP
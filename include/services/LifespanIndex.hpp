@@ -0,0 +1,54 @@
+#ifndef LIFESPAN_INDEX_HPP
+#define LIFESPAN_INDEX_HPP
+
+#include "models/FamilyTree.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct LifespanOptions {
+    // People without a date of death are taken to live at most this long
+    int maxLifespanYears = 110;
+};
+
+// Answers "who was alive when" over the lifespans of everyone in the tree.
+//
+// Lifespans run from the first possible day of birth to the last possible
+// day of death, so a partial date ("1850" or "1850-06") widens the span to
+// the whole year or month. People whose birth date cannot be read are left
+// out.
+//
+// Works on an in-memory snapshot, built on first use and rebuilt when the
+// tree's revision changes. The snapshot is a static centered interval tree
+// (see IntervalTree), so a query visits O(log n) nodes and reads only
+// matching lifespans beyond that. Results are ordered by birth. Safe to
+// call from several threads.
+class LifespanIndex {
+private:
+    struct Snapshot;
+
+    FamilyTree& tree;
+    LifespanOptions options;
+    std::mutex snapshotMutex;
+    std::shared_ptr<const Snapshot> snapshot;
+
+    std::shared_ptr<const Snapshot> currentSnapshot();
+
+public:
+    explicit LifespanIndex(FamilyTree& tree, const LifespanOptions& options = LifespanOptions());
+    ~LifespanIndex();
+
+    // Everyone alive at some time between from and to (inclusive); throws
+    // std::invalid_argument for an unreadable date
+    std::vector<Person> aliveDuring(const std::string& from, const std::string& to);
+    std::vector<Person> aliveOn(const std::string& date) { return aliveDuring(date, date); }
+
+    // Everyone whose lifetime overlapped personId's, optionally only among
+    // their ancestors, descendants, siblings and spouse. Throws
+    // std::invalid_argument when the person does not exist or has no
+    // readable birth date.
+    std::vector<Person> contemporaries(const std::string& personId, bool relativesOnly = false);
+};
+
+#endif // LIFESPAN_INDEX_HPP
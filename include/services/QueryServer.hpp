@@ -0,0 +1,124 @@
+#ifndef QUERY_SERVER_HPP
+#define QUERY_SERVER_HPP
+
+#include "models/FamilyTree.hpp"
+#include "services/CommandProcessor.hpp"
+#include "services/GroupCommitWriter.hpp"
+#include "utils/ThreadPool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ServerOptions {
+    std::string socketPath;
+    size_t workerThreads = 0;             // 0 = hardware concurrency
+    size_t maxLineBytes = 1 << 20;        // longer requests close the connection
+    size_t maxOutputBytes = 16 << 20;     // connections this far behind are not read until they catch up
+    std::chrono::milliseconds commitWindow{0};  // see GroupCommitOptions::window
+};
+
+// Long-running server keeping one FamilyTree open and answering requests
+// over a Unix domain socket.
+//
+// Protocol: newline-terminated request lines "ID COMMAND ARGS..." using
+// the CommandProcessor command language. Each request gets exactly one
+// response line, "ID ok JSON" or "ID err \"message\"", in request order
+// per connection. Clients may pipeline any number of requests. "ID ping"
+// and "ID quit" are handled by the server itself.
+//
+// A single poll() loop owns all sockets and never waits for a query.
+// Requests are queued in stages: runs of read-only requests are
+// de-duplicated across connections (identical lookups execute once) and
+// executed in parallel on a worker pool; runs of mutations are applied in
+// arrival order through a GroupCommitWriter and answered once their
+// shared commit is done. Stages run one at a time, so reads see exactly
+// the mutations queued before them; a stage's workers wake the loop
+// through the wake pipe when it is done.
+class QueryServer {
+private:
+    struct Request {
+        std::string id;
+        std::vector<std::string> tokens;
+        std::string response;
+        bool done = false;
+    };
+
+    struct Connection {
+        int fd;
+        std::string input;
+        std::string output;
+        bool closeAfterFlush = false;
+        std::deque<std::shared_ptr<Request>> pending;  // answered in this order
+    };
+
+    enum class StageKind { READS, WRITES, OUTSIDE_TRANSACTION };
+
+    struct Stage {
+        StageKind kind;
+        std::vector<std::shared_ptr<Request>> requests;
+        std::vector<size_t> slots;              // request -> result
+        std::vector<CommandResult> results;
+        bool started = false;
+        size_t running = 0;                     // tasks left, guarded by stageMutex
+    };
+
+    FamilyTree& tree;
+    CommandProcessor processor;
+    ServerOptions options;
+    // Outlives the workers, which take it to finish a stage
+    std::mutex stageMutex;
+    ThreadPool pool;
+    GroupCommitWriter writer;
+
+    int listenFd;
+    int wakeFds[2];
+    std::atomic<bool> running;
+    std::map<int, Connection> connections;
+    std::deque<std::unique_ptr<Stage>> stages;
+
+    std::atomic<uint64_t> requestsServed;
+    std::atomic<uint64_t> requestsCoalesced;
+
+    void openSocket();
+    void acceptConnections();
+    void readRequests(Connection& connection);
+    void parseRequests(Connection& connection);
+    bool isBacklogged(const Connection& connection) const;
+    bool dispatch(Connection& connection, std::shared_ptr<Request> request);
+    void enqueue(StageKind kind, std::shared_ptr<Request> request);
+    void runStages();
+    void startStage(Stage& stage);
+    void executeReads(Stage& stage);
+    void executeWrites(Stage& stage);
+    void finishTask(Stage& stage);
+    bool isFinished(Stage& stage);
+    void awaitStage();
+    void drainWakePipe();
+    void deliverResponses(Connection& connection);
+    void flushOutput(Connection& connection);
+    void closeConnection(int fd);
+    static std::string formatResponse(const std::string& id, const CommandResult& result);
+
+public:
+    QueryServer(FamilyTree& tree, ServerOptions options);
+    ~QueryServer();
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    // Serves until stop() is called
+    void run();
+
+    // Safe to call from other threads and from signal handlers
+    void stop();
+
+    uint64_t getRequestsServed() const { return requestsServed.load(); }
+    uint64_t getRequestsCoalesced() const { return requestsCoalesced.load(); }
+};
+
+#endif // QUERY_SERVER_HPP
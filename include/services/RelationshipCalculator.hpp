@@ -0,0 +1,70 @@
+#ifndef RELATIONSHIP_CALCULATOR_HPP
+#define RELATIONSHIP_CALCULATOR_HPP
+
+#include "models/FamilyTree.hpp"
+#include "utils/CancellationToken.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One step along a relationship path, seen from the person it starts at
+enum class PathEdge : uint8_t {
+    PARENT,    // the next person is this person's parent
+    CHILD,
+    SPOUSE,
+    SIBLING
+};
+
+struct PathOptions {
+    // Cost of each step; a negative weight leaves that kind of step out
+    double parentWeight = 1.0;
+    double childWeight = 1.0;
+    double spouseWeight = 1.0;
+    double siblingWeight = 1.0;
+    // Neither search front goes further than this many steps; -1 for no limit
+    int maxHops = -1;
+};
+
+struct RelationshipPath {
+    std::vector<std::string> people;  // start to target; empty when not connected
+    std::vector<PathEdge> edges;      // edges[i] leads from people[i] to people[i + 1]
+    double cost = 0.0;
+
+    bool found() const { return !people.empty(); }
+};
+
+// Finds how two people are connected through parent, child, spouse and
+// sibling links.
+//
+// Works on an in-memory adjacency snapshot of all relationships (compact
+// arrays indexed by person), built on first use and rebuilt when the
+// tree's revision changes. A query is a bidirectional Dijkstra search that
+// grows a front from each end and stops once the fronts can no longer
+// improve on the best meeting point, so it only touches the neighbourhood
+// of the two people. Among equally cheap paths the one with fewest steps
+// wins. Safe to call from several threads.
+class RelationshipCalculator {
+private:
+    struct Graph;
+
+    FamilyTree& tree;
+    std::mutex graphMutex;
+    std::shared_ptr<const Graph> graph;
+
+    std::shared_ptr<const Graph> currentGraph();
+
+public:
+    explicit RelationshipCalculator(FamilyTree& tree);
+    ~RelationshipCalculator();
+
+    // Throws std::invalid_argument when either person does not exist
+    RelationshipPath shortestPath(const std::string& fromId, const std::string& toId,
+                                  const PathOptions& options = PathOptions(),
+                                  CancellationToken token = {});
+
+    static std::string edgeToString(PathEdge edge);
+};
+
+#endif // RELATIONSHIP_CALCULATOR_HPP
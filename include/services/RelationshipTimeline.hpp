@@ -0,0 +1,75 @@
+#ifndef RELATIONSHIP_TIMELINE_HPP
+#define RELATIONSHIP_TIMELINE_HPP
+
+#include "models/FamilyTree.hpp"
+#include "services/LifespanIndex.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The tree as it stood on a date: who was married to whom, which relatives
+// were alive, and who lived in a household.
+//
+// A marriage runs from its start date to its end date, and never before
+// both partners were born or after either died. Without a start date it
+// runs from the partners' births; without an end date until one of them
+// dies. A person is alive from the first possible day of birth to the last
+// possible day of death, or LifespanOptions::maxLifespanYears without a
+// date of death; without a readable birth date they count as alive until
+// their death. Dates may be partial ("1850" is the whole year): anything
+// in force at some time in it counts.
+//
+// Works on an in-memory snapshot, built on first use and rebuilt when the
+// tree's revision changes. Marriages are kept in a centered interval tree
+// (see IntervalTree) and indexed by partner, so no query reads the
+// relationships of people it does not return. Safe to call from several
+// threads.
+//
+// Every query throws std::invalid_argument for an unreadable date or a
+// person who does not exist.
+class RelationshipTimeline {
+private:
+    struct Snapshot;
+
+    FamilyTree& tree;
+    LifespanOptions options;
+    std::mutex snapshotMutex;
+    std::shared_ptr<const Snapshot> snapshot;
+
+    std::shared_ptr<const Snapshot> currentSnapshot();
+
+public:
+    explicit RelationshipTimeline(FamilyTree& tree, const LifespanOptions& options = LifespanOptions());
+    ~RelationshipTimeline();
+
+    // The spouse married to personId on date; with several, the most
+    // recently married
+    std::optional<Person> spouseOn(const std::string& personId, const std::string& date);
+
+    // Ancestors, descendants, siblings and the spouse of personId alive on
+    // date, by birth (people without a birth date last)
+    std::vector<Person> livingFamilyOn(const std::string& personId, const std::string& date);
+
+    // personId's household on a census date: the person, their spouse, and
+    // the living children of either who had not yet married (by a dated
+    // marriage), children by birth. Empty when personId was not alive.
+    std::vector<Person> householdOn(const std::string& personId, const std::string& date);
+
+    // Spouse relationships in force on date, by start and then ID
+    std::vector<Relationship> marriagesOn(const std::string& date);
+
+    // First and last day (see DateFormatter::toDayNumber) a marriage
+    // between these partners is in force, by the rules above, without a
+    // snapshot; nullopt when it never is. Unreadable dates count as
+    // missing.
+    static std::optional<std::pair<int32_t, int32_t>> marriageSpan(const Relationship& marriage,
+                                                                   const Person& partner1,
+                                                                   const Person& partner2,
+                                                                   const LifespanOptions& options = LifespanOptions());
+};
+
+#endif // RELATIONSHIP_TIMELINE_HPP
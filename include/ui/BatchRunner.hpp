@@ -0,0 +1,37 @@
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+#include "models/FamilyTree.hpp"
+#include "services/CommandProcessor.hpp"
+#include <iostream>
+
+struct BatchOptions {
+    size_t transactionSize = 1000;  // commands per committed transaction
+    bool stopOnError = false;       // roll back the open transaction and stop
+};
+
+// Non-interactive front end: executes a command script (see
+// CommandProcessor) and writes one JSON object per command, followed by
+// a summary object. Commands are grouped into transactions of
+// transactionSize so bulk loads do not pay one commit per command.
+//
+// With stopOnError a failed command rolls back its whole transaction;
+// the commands before it in that transaction were already reported ok,
+// so a {"rolled_back":{...}} record names their lines before the summary.
+// A transaction whose commit fails is reported the same way, with the
+// commit error; its commands count as failed, and the run goes on unless
+// stopOnError is set.
+class BatchRunner {
+private:
+    FamilyTree& tree;
+    CommandProcessor processor;
+    BatchOptions options;
+
+public:
+    BatchRunner(FamilyTree& tree, BatchOptions options = BatchOptions());
+
+    // Returns the number of failed commands
+    size_t run(std::istream& input, std::ostream& output);
+};
+
+#endif // BATCH_RUNNER_HPP
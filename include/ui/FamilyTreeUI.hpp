@@ -2,24 +2,36 @@
 #define FAMILY_TREE_UI_HPP
 
 #include "models/FamilyTree.hpp"
+#include "services/AsyncFamilyTree.hpp"
+#include "services/LifespanIndex.hpp"
+#include "services/RelationshipCalculator.hpp"
+#include <functional>
+#include <iostream>
 #include <memory>
 
 class FamilyTreeUI {
 private:
     std::unique_ptr<FamilyTree> tree;
+    std::unique_ptr<AsyncFamilyTree> asyncTree;
+    std::unique_ptr<RelationshipCalculator> relationshipCalculator;
+    std::unique_ptr<LifespanIndex> lifespanIndex;
     
     // Menu methods
     void showMainMenu();
     void handlePersonOperations();
     void handleRelationshipOperations();
     void handleTreeQueries();
+    void mergeDatabase();
+    void showStatistics();
     
     // Person operations
     void addPerson();
     void updatePerson();
     void deletePerson();
+    void deleteBranch();
+    void findDuplicates();
     void searchPerson();
-    void displayPerson(const Person& person);
+    void displayPerson(const Person& person, std::ostream& out = std::cout);
     
     // Relationship operations
     void addRelationship();
@@ -30,6 +42,9 @@ private:
     void viewAncestors();
     void viewDescendants();
     void viewFamilyMembers();
+    void exportChart();
+    void findConnection();
+    void viewAliveOn();
     
     // Utility methods
     std::string getInput(const std::string& prompt);
@@ -38,9 +53,13 @@ private:
     void clearScreen();
     void waitForEnter();
     void displayError(const std::string& message);
+    // Pages through a person list; fetchPage(offset, limit) reads one page
+    using PageSource = std::function<PersonPage(size_t offset, size_t limit)>;
+    void browsePeople(const std::string& title, const std::string& emptyMessage,
+                      const PageSource& fetchPage);
 
 public:
-    FamilyTreeUI();
+    explicit FamilyTreeUI(const std::string& dbPath = "family_tree.db");
     void start();
 };
 
@@ -0,0 +1,54 @@
+#ifndef CANCELLATION_TOKEN_HPP
+#define CANCELLATION_TOKEN_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+class OperationCancelled : public std::runtime_error {
+public:
+    explicit OperationCancelled(const std::string& message) : std::runtime_error(message) {}
+};
+
+// Shared cancellation flag with an optional deadline. Copies observe the
+// same state. A default-constructed token can never be cancelled.
+//
+// Long-running operations poll the token installed for the current thread
+// (see Scope) through checkCurrent(), so deep traversals can be abandoned
+// without threading a token through every call.
+class CancellationToken {
+private:
+    struct State {
+        std::atomic<bool> cancelled{false};
+        bool hasDeadline = false;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    std::shared_ptr<State> state;
+
+public:
+    CancellationToken() = default;
+
+    static CancellationToken create();
+    static CancellationToken withTimeout(std::chrono::milliseconds timeout);
+    static CancellationToken withDeadline(std::chrono::steady_clock::time_point deadline);
+
+    void cancel();
+    bool isCancelled() const;
+    void throwIfCancelled() const;
+
+    // Installs a token as the current thread's token for its lifetime
+    class Scope {
+    private:
+        const CancellationToken* previous;
+    public:
+        explicit Scope(const CancellationToken& token);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static void checkCurrent();
+};
+
+#endif // CANCELLATION_TOKEN_HPP
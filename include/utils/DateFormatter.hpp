@@ -0,0 +1,21 @@
+#ifndef DATE_FORMATTER_HPP
+#define DATE_FORMATTER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Conversions between ISO dates ("YYYY-MM-DD") and day numbers, for
+// comparing and indexing dates. Genealogical dates are often partial:
+// "YYYY-MM" and "YYYY" stand for the whole month or year.
+class DateFormatter {
+public:
+    // Days since 1970-01-01 (negative before). A partial date gives its
+    // first day, or its last with roundUp. nullopt when not a valid date.
+    static std::optional<int32_t> toDayNumber(const std::string& date, bool roundUp = false);
+
+    // "YYYY-MM-DD"
+    static std::string fromDayNumber(int32_t day);
+};
+
+#endif // DATE_FORMATTER_HPP
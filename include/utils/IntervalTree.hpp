@@ -0,0 +1,47 @@
+#ifndef INTERVAL_TREE_HPP
+#define INTERVAL_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Static centered interval tree over closed intervals [start, end] of day
+// numbers (or any other integers).
+//
+// Each node keeps the intervals containing its center sorted by start and
+// by end, so a query visits O(log n) nodes and reads only matching
+// intervals beyond that. Built once; build a new tree when the intervals
+// change.
+class IntervalTree {
+private:
+    struct Node {
+        int32_t center = 0;
+        int32_t left = -1;          // intervals ending before center
+        int32_t right = -1;         // intervals starting after center
+        uint32_t begin = 0;         // intervals containing center:
+        uint32_t count = 0;         // byStart/byEnd[begin, begin + count)
+    };
+
+    std::vector<int32_t> starts;
+    std::vector<int32_t> ends;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> byStart;  // ascending start within each node
+    std::vector<uint32_t> byEnd;    // descending end within each node
+    int32_t root = -1;
+
+    int32_t build(const std::vector<uint32_t>& members);
+
+public:
+    IntervalTree() = default;
+    // Interval i is [starts[i], ends[i]], with ends[i] >= starts[i]
+    IntervalTree(std::vector<int32_t> starts, std::vector<int32_t> ends);
+
+    size_t size() const { return starts.size(); }
+    int32_t start(uint32_t interval) const { return starts[interval]; }
+    int32_t end(uint32_t interval) const { return ends[interval]; }
+
+    // Appends the intervals overlapping [from, to], in no particular order
+    void query(int32_t from, int32_t to, std::vector<uint32_t>& matches) const;
+};
+
+#endif // INTERVAL_TREE_HPP
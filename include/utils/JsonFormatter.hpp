@@ -0,0 +1,23 @@
+#ifndef JSON_FORMATTER_HPP
+#define JSON_FORMATTER_HPP
+
+#include "models/Person.hpp"
+#include "models/Relationship.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+// Compact JSON encodings of the model types for machine-readable output
+class JsonFormatter {
+public:
+    static std::string escape(const std::string& value);
+    static std::string quote(const std::string& value);
+
+    static std::string person(const Person& person);
+    static std::string person(const std::optional<Person>& person);
+    static std::string people(const std::vector<Person>& people);
+    static std::string relationship(const Relationship& relationship);
+    static std::string relationships(const std::vector<Relationship>& relationships);
+};
+
+#endif // JSON_FORMATTER_HPP
@@ -0,0 +1,114 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Latency histogram with log-linear buckets (HDR style): exact below 32ns,
+// then 16 buckets per power of two, so any recorded value is known to
+// within about 6%. Recording is one relaxed atomic increment.
+class LatencyHistogram {
+public:
+    static const size_t BUCKETS = 32 + 59 * 16;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts;
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sumNanos{0};
+    std::atomic<uint64_t> maxNanos{0};
+
+    static size_t bucketOf(uint64_t nanos);
+    static uint64_t bucketMidpoint(size_t bucket);
+
+public:
+    LatencyHistogram();
+
+    void record(uint64_t nanos);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    double meanNanos() const;
+    uint64_t max() const { return maxNanos.load(std::memory_order_relaxed); }
+    // Value at the given percentile (0-100), in nanoseconds
+    uint64_t percentile(double percent) const;
+};
+
+// Calls, SQL work and latency of one API (a FamilyTree or DatabaseManager
+// member function)
+struct ApiMetrics {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> statements{0};
+    std::atomic<uint64_t> rows{0};
+    std::atomic<uint64_t> prepareNanos{0};
+    std::atomic<uint64_t> stepNanos{0};
+    LatencyHistogram latency;
+};
+
+// Process-wide instrumentation, off by default. When disabled every hook
+// costs one relaxed atomic load.
+//
+// Operations are attributed per layer: a Scope opened while another Scope
+// of the same layer is active on the thread is ignored, so a FamilyTree
+// query that calls other FamilyTree members is measured once, and SQL
+// statements count towards the outermost FamilyTree and DatabaseManager
+// operations running on the thread.
+class Metrics {
+public:
+    enum class Layer { TREE, DATABASE };
+
+    // Measures one API call for its lifetime. name must be a string
+    // literal (it is cached by address).
+    class Scope {
+    private:
+        ApiMetrics* metrics = nullptr;
+        Layer layer;
+        std::chrono::steady_clock::time_point start;
+        uint64_t statements = 0;
+        uint64_t rows = 0;
+        uint64_t prepareNanos = 0;
+        uint64_t stepNanos = 0;
+
+        friend class Metrics;
+
+    public:
+        Scope(Layer layer, const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    struct SqlTotals {
+        uint64_t statements = 0;
+        uint64_t rows = 0;
+        uint64_t prepareNanos = 0;
+        uint64_t stepNanos = 0;
+        uint64_t statementCacheHits = 0;
+        uint64_t statementCacheMisses = 0;
+    };
+
+    static bool enabled() { return enabledFlag.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static void reset();
+
+    // Called by SQLiteConnector for every executed statement
+    static void recordStatement(uint64_t prepareNanos, uint64_t stepNanos, uint64_t rows, bool cached);
+
+    static SqlTotals sqlTotals();
+    // API name -> metrics; names are prefixed with "tree." or "db."
+    static std::map<std::string, const ApiMetrics*> apis();
+
+    // Everything above as one JSON object
+    static std::string toJson();
+
+private:
+    static std::atomic<bool> enabledFlag;
+    static ApiMetrics& api(Layer layer, const char* name);
+};
+
+#endif // METRICS_HPP
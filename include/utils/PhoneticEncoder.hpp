@@ -0,0 +1,38 @@
+#ifndef PHONETIC_ENCODER_HPP
+#define PHONETIC_ENCODER_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+enum class PhoneticAlgorithm {
+    SOUNDEX,
+    DAITCH_MOKOTOFF,
+    DOUBLE_METAPHONE
+};
+
+// Phonetic keys used to match spelling variants of the same name
+// (Meyer / Maier / Mayer). All encoders ignore case and non-letters.
+class PhoneticEncoder {
+public:
+    // American Soundex, always 4 characters (e.g. "M600")
+    static std::string soundex(const std::string& name);
+
+    // Daitch-Mokotoff Soundex. Ambiguous letter groups branch, so a
+    // name can yield several 6-digit codes.
+    static std::vector<std::string> daitchMokotoff(const std::string& name);
+
+    // Double Metaphone primary and alternate keys (up to 4 characters each)
+    static std::pair<std::string, std::string> doubleMetaphone(const std::string& name);
+
+    // Distinct, non-empty keys for one algorithm
+    static std::vector<std::string> encode(const std::string& name, PhoneticAlgorithm algorithm);
+
+    static std::string algorithmToString(PhoneticAlgorithm algorithm);
+    static const std::vector<PhoneticAlgorithm>& allAlgorithms();
+
+private:
+    static std::string normalize(const std::string& name, bool keepSpaces);
+};
+
+#endif // PHONETIC_ENCODER_HPP
\ No newline at end of file
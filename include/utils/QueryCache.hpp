@@ -0,0 +1,95 @@
+#ifndef QUERY_CACHE_HPP
+#define QUERY_CACHE_HPP
+
+#include "models/Person.hpp"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+enum class CachedQuery {
+    PARENTS,
+    CHILDREN,
+    SPOUSE,
+    SIBLINGS,
+    ANCESTORS,
+    DESCENDANTS
+};
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budgetBytes = 0;
+
+    double hitRate() const {
+        uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+};
+
+// LRU cache of query results keyed on (operation, person, generation
+// limit), bounded by an approximate memory budget.
+//
+// Each entry records the people its result depends on: the queried person,
+// every person in the result and any intermediate people the query walked
+// through. A mutation touching a person invalidates exactly the entries
+// that depend on that person. Because a traversal result contains the
+// whole ancestor/descendant chain it walked, adding or removing a
+// parent-child link invalidates the cached ancestry of everyone below it
+// and the cached descendancy of everyone above it.
+//
+// All members are thread-safe.
+class QueryCache {
+private:
+    struct Entry {
+        std::string key;
+        std::vector<Person> result;
+        std::vector<std::string> dependencies;
+        size_t bytes;
+    };
+
+    mutable std::mutex cacheMutex;
+    std::list<Entry> lru;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::unordered_map<std::string, std::unordered_set<std::string>> dependents;
+    size_t budgetBytes;
+    size_t usedBytes;
+    QueryCacheStats stats;
+
+    static std::string makeKey(CachedQuery query, const std::string& personId, int generations);
+    static size_t estimateBytes(const Entry& entry);
+    void erase(std::list<Entry>::iterator entry);
+    void evictToBudget();
+
+public:
+    static const size_t DEFAULT_BUDGET_BYTES = 64 * 1024 * 1024;
+
+    explicit QueryCache(size_t budgetBytes = DEFAULT_BUDGET_BYTES);
+
+    std::optional<std::vector<Person>> lookup(CachedQuery query,
+                                              const std::string& personId,
+                                              int generations = 0);
+    void store(CachedQuery query,
+               const std::string& personId,
+               int generations,
+               const std::vector<Person>& result,
+               const std::vector<std::string>& dependencies);
+
+    // Drops every entry depending on any of the given people
+    void invalidate(const std::vector<std::string>& personIds);
+    void clear();
+
+    // A budget of 0 disables caching
+    void setBudget(size_t bytes);
+    QueryCacheStats getStats() const;
+};
+
+#endif // QUERY_CACHE_HPP
@@ -0,0 +1,37 @@
+#ifndef REENTRANT_SHARED_MUTEX_HPP
+#define REENTRANT_SHARED_MUTEX_HPP
+
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
+
+// Reader-writer lock that tolerates re-entry from the same thread, so a
+// public operation can call other public operations while holding it.
+// Usable with std::shared_lock and std::unique_lock.
+//
+// - The exclusive owner may re-lock exclusively or shared at any depth.
+// - A thread may nest shared locks.
+// - Upgrading a held shared lock to exclusive throws std::logic_error
+//   instead of deadlocking.
+class ReentrantSharedMutex {
+private:
+    std::shared_mutex mutex;
+    std::atomic<std::thread::id> owner;
+    int ownerDepth;
+
+    int& readDepth();
+
+public:
+    ReentrantSharedMutex();
+    ReentrantSharedMutex(const ReentrantSharedMutex&) = delete;
+    ReentrantSharedMutex& operator=(const ReentrantSharedMutex&) = delete;
+
+    void lock();
+    void unlock();
+    void lock_shared();
+    void unlock_shared();
+
+    bool ownedByCurrentThread() const;
+};
+
+#endif // REENTRANT_SHARED_MUTEX_HPP
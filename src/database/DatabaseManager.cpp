@@ -1,15 +1,157 @@
 #include "database/DatabaseManager.hpp"
+#include "utils/Metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <fstream>
+#include <queue>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+std::string lower(const std::string& text) {
+    std::string result = text;
+    for (auto& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+bool inSurnameRange(const std::string& lastName, const ShardInfo& shard) {
+    std::string name = lower(lastName);
+    return (shard.surnameFrom.empty() || name >= lower(shard.surnameFrom)) &&
+           (shard.surnameTo.empty() || name < lower(shard.surnameTo));
+}
+
+// "Salem ,Essex, Massachusetts" -> {"Salem", "Essex", "Massachusetts"}
+std::vector<std::string> placeParts(const std::string& place) {
+    std::vector<std::string> parts;
+    std::istringstream stream(place);
+    std::string part;
+    while (std::getline(stream, part, ',')) {
+        size_t first = part.find_first_not_of(" \t");
+        if (first != std::string::npos) {
+            parts.push_back(part.substr(first, part.find_last_not_of(" \t") - first + 1));
+        }
+    }
+    return parts;
+}
+
+// PersonLine columns of a line
+const char* parentColumn(DirectLine line) {
+    return line == DirectLine::PATERNAL ? "father_id" : "mother_id";
+}
+
+const char* lineColumn(DirectLine line) {
+    return line == DirectLine::PATERNAL ? "paternal_line" : "maternal_line";
+}
+
+const std::string RELATIONSHIP_COLUMNS =
+    "relationship_id, person1_id, person2_id, relationship_type, start_date, end_date";
+
+// Parent-child links (see ParentLink) as Relationship rows, with the IDs
+// FamilyTree gives them
+std::string parentLinkRows(const std::string& whereSql) {
+    const std::string type = Relationship::relationTypeToString(RelationType::PARENT_CHILD);
+    return "SELECT parent_id || '_' || child_id || '_" + type + "' AS relationship_id, "
+           "parent_id AS person1_id, child_id AS person2_id, '" + type + "' AS relationship_type, "
+           "NULL AS start_date, NULL AS end_date FROM ParentLink WHERE " + whereSql;
+}
+
+// The recursive steps of a walk from the people in `walk` (as w) to their
+// parents, or their children: rows of the person ID followed by
+// `columns`, for walk rows meeting `condition`. One step per partner
+// column on the family tables; joined in a recursion, the ParentLink view
+// would be rebuilt at every step.
+std::string parentLinkSteps(const std::string& walk, bool ancestors, const std::string& columns = "",
+                            const std::string& condition = "") {
+    std::string steps;
+    for (const std::string partner : {"f.partner1_id", "f.partner2_id"}) {
+        steps += steps.empty() ? "" : "\n            UNION\n            ";
+        steps += ancestors
+            ? "SELECT " + partner + columns + " FROM " + walk + R"( w
+              JOIN FamilyChild c ON c.child_id = w.person_id
+              JOIN Family f ON f.family_id = c.family_id
+              WHERE )" + partner + " <> ''" + (condition.empty() ? "" : " AND (" + condition + ")")
+            : "SELECT c.child_id" + columns + " FROM " + walk + R"( w
+              JOIN Family f ON )" + partner + " = w.person_id AND " + partner + R"( <> ''
+              JOIN FamilyChild c ON c.family_id = f.family_id)" +
+              (condition.empty() ? "" : "\n              WHERE " + condition);
+    }
+    return steps;
+}
+
+std::string placeholders(size_t count) {
+    std::string list;
+    for (size_t i = 0; i < count; i++) {
+        list += i == 0 ? "?" : ", ?";
+    }
+    return list;
+}
+
+std::string joinPlaceParts(std::vector<std::string>::const_iterator first,
+                           std::vector<std::string>::const_iterator last) {
+    std::string name;
+    for (auto part = first; part != last; ++part) {
+        name += (name.empty() ? "" : ", ") + *part;
+    }
+    return name;
+}
+
+} // namespace
 
 DatabaseManager::DatabaseManager(const std::string& dbPath)
-    : connector(std::make_unique<SQLiteConnector>(dbPath)) {}
+    : connector(std::make_unique<SQLiteConnector>(dbPath)),
+      mainPath(dbPath) {
+    for (const auto& row : connector->executeQuery("SELECT * FROM Shard ORDER BY shard_id")) {
+        ShardInfo info;
+        info.id = std::stoi(row.at("shard_id"));
+        info.path = row.at("path");
+        info.surnameFrom = row.at("surname_from");
+        info.surnameTo = row.at("surname_to");
+        openShard(info);
+    }
+    migrateParentLinks();
+    backfillPhoneticKeys();
+    backfillPlaces();
+    backfillDirectLines();
+    backfillGenerations();
+}
 
 bool DatabaseManager::addPerson(const Person& person) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "addPerson");
+    int shardId = shardForSurname(person.getLastName());
+    if (isSharded()) {
+        // IDs are unique across shards
+        bool inMain = !connector->executeQuery("SELECT 1 FROM Person WHERE person_id = ?",
+                                               {person.getId()}).empty();
+        if (shardOf(person.getId()) != 0 || (shardId != 0 && inMain)) {
+            return false;
+        }
+    }
+
+    SQLiteConnector& target = shardConnector(shardId);
+    return runAtomically([&]() {
+        if (!insertPerson(target, person) ||
+            !connector->executeCommand("INSERT OR REPLACE INTO PersonGeneration (person_id) VALUES (?)",
+                                       {person.getId()})) {
+            return false;
+        }
+        return shardId == 0 ||
+               connector->executeCommand("INSERT INTO PersonShard (person_id, shard_id) VALUES (?, ?)",
+                                         {person.getId(), std::to_string(shardId)});
+    });
+}
+
+bool DatabaseManager::insertPerson(SQLiteConnector& target, const Person& person) {
     const std::string sql = R"(
         INSERT INTO Person (
             person_id, first_name, last_name, gender, 
-            date_of_birth, date_of_death, birth_place, death_place
-        ) VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+            date_of_birth, date_of_death, birth_place_id, death_place_id
+        ) VALUES (?, ?, ?, ?, ?, ?, NULLIF(?, ''), NULLIF(?, ''))
     )";
 
     std::vector<std::string> params = {
@@ -19,16 +161,18 @@ bool DatabaseManager::addPerson(const Person& person) {
         person.getGender(),
         person.getDateOfBirth(),
         person.getDateOfDeath(),
-        person.getBirthPlace(),
-        person.getDeathPlace()
+        placeId(target, person.getBirthPlace()),
+        placeId(target, person.getDeathPlace())
     };
 
-    return connector->executeCommand(sql, params);
+    return target.executeCommand(sql, params) &&
+           writePhoneticKeys(target, person.getId(), person.getFirstName(), person.getLastName());
 }
 
 std::optional<Person> DatabaseManager::getPerson(const std::string& personId) {
-    const std::string sql = "SELECT * FROM Person WHERE person_id = ?";
-    auto results = connector->executeQuery(sql, {personId});
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getPerson");
+    const std::string sql = "SELECT * FROM PersonView WHERE person_id = ?";
+    auto results = connectorFor(personId).executeQuery(sql, {personId});
 
     if (results.empty()) {
         return std::nullopt;
@@ -37,6 +181,18 @@ std::optional<Person> DatabaseManager::getPerson(const std::string& personId) {
     return createPersonFromRow(results[0]);
 }
 
+bool DatabaseManager::hasPeople(const std::vector<std::string>& personIds) {
+    std::set<std::string> distinct(personIds.begin(), personIds.end());
+    if (isSharded()) {
+        return std::all_of(distinct.begin(), distinct.end(),
+                           [this](const std::string& id) { return getPerson(id).has_value(); });
+    }
+    std::vector<std::string> params(distinct.begin(), distinct.end());
+    auto rows = connector->executeQuery(
+        "SELECT COUNT(*) AS n FROM Person WHERE person_id IN (" + placeholders(params.size()) + ")", params);
+    return !rows.empty() && std::stoul(rows[0].at("n")) == params.size();
+}
+
 Person DatabaseManager::createPersonFromRow(const std::map<std::string, std::string>& row) {
     Person person(
         row.at("person_id"),
@@ -64,20 +220,75 @@ Person DatabaseManager::createPersonFromRow(const std::map<std::string, std::str
 // Add similar implementations for other methods...
 
 void DatabaseManager::beginTransaction() {
+    // Always in shard order, so concurrent transactions cannot deadlock
     connector->beginTransaction();
+    for (size_t i = 0; i < shards.size(); i++) {
+        try {
+            shards[i].connector->beginTransaction();
+        } catch (...) {
+            while (i-- > 0) {
+                shards[i].connector->rollback();
+            }
+            connector->rollback();
+            throw;
+        }
+    }
 }
 
 void DatabaseManager::commit() {
-    connector->commit();
+    // The main file holds the routing table and commits last
+    for (size_t i = 0; i < shards.size(); i++) {
+        try {
+            shards[i].connector->commit();
+        } catch (...) {
+            // The failed shard has rolled back; end the others the same way
+            while (++i < shards.size()) {
+                shards[i].connector->rollback();
+            }
+            connector->rollback();
+            forgetRootPerson();
+            throw;
+        }
+    }
+    try {
+        connector->commit();
+    } catch (...) {
+        forgetRootPerson();
+        throw;
+    }
 }
 
 void DatabaseManager::rollback() {
+    for (auto& shard : shards) {
+        shard.connector->rollback();
+    }
     connector->rollback();
+    forgetRootPerson();
+}
+
+bool DatabaseManager::runAtomically(const std::function<bool()>& operation) {
+    beginTransaction();
+    bool succeeded;
+    try {
+        succeeded = operation();
+    }
+    catch (...) {
+        rollback();
+        throw;
+    }
+    if (!succeeded) {
+        rollback();
+        return false;
+    }
+    // A failed commit has already rolled back
+    commit();
+    return true;
 }
 
 
 
 bool DatabaseManager::updatePerson(const Person& person) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "updatePerson");
     const std::string sql = R"(
         UPDATE Person 
         SET first_name = ?, 
@@ -85,33 +296,130 @@ bool DatabaseManager::updatePerson(const Person& person) {
             gender = ?,
             date_of_birth = ?,
             date_of_death = ?,
-            birth_place = ?,
-            death_place = ?
+            birth_place = NULL,
+            death_place = NULL,
+            birth_place_id = NULLIF(?, ''),
+            death_place_id = NULLIF(?, '')
         WHERE person_id = ?
     )";
 
-    std::vector<std::string> params = {
-        person.getFirstName(),
-        person.getLastName(),
-        person.getGender(),
-        person.getDateOfBirth(),
-        person.getDateOfDeath(),
-        person.getBirthPlace(),
-        person.getDeathPlace(),
-        person.getId()
-    };
-
-    return connector->executeCommand(sql, params);
+    SQLiteConnector& target = connectorFor(person.getId());
+    return runAtomically([&]() {
+        bool genderChanged = false;
+        if (isSharded()) {
+            auto before = target.executeQuery("SELECT gender FROM Person WHERE person_id = ?", {person.getId()});
+            genderChanged = !before.empty() && before[0].at("gender") != person.getGender();
+        }
+        std::vector<std::string> params = {
+            person.getFirstName(),
+            person.getLastName(),
+            person.getGender(),
+            person.getDateOfBirth(),
+            person.getDateOfDeath(),
+            placeId(target, person.getBirthPlace()),
+            placeId(target, person.getDeathPlace()),
+            person.getId()
+        };
+        // No row changed: unknown person, so no keys to write
+        if (!target.executeCommand(sql, params) || target.changes() == 0 ||
+            !writePhoneticKeys(target, person.getId(), person.getFirstName(), person.getLastName())) {
+            return false;
+        }
+        // A father who becomes a mother moves their children to other
+        // lines; outside shards a trigger does this
+        if (genderChanged) {
+            for (const auto& relationship : getRelationshipsForPerson(person.getId())) {
+                if (relationship.getType() == RelationType::PARENT_CHILD &&
+                    relationship.getPerson1Id() == person.getId() &&
+                    !refreshDirectLines(relationship.getPerson2Id())) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    });
 }
 
 bool DatabaseManager::deletePerson(const std::string& personId) {
-    const std::string sql = "DELETE FROM Person WHERE person_id = ?";
-    return connector->executeCommand(sql, {personId});
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "deletePerson");
+    if (!isSharded()) {
+        // Links, families, lines and depth go with the Person row (see the
+        // person_delete trigger); with a root, the relatives' generations
+        // are repaired once the person is gone
+        std::string root = getRootPerson();
+        std::vector<std::string> relatives;
+        if (!root.empty() && root != personId) {
+            for (const auto& relationship : getRelationshipsForPerson(personId)) {
+                relatives.push_back(relationship.getPerson1Id() == personId ? relationship.getPerson2Id()
+                                                                            : relationship.getPerson1Id());
+            }
+        }
+        return runAtomically([&]() {
+            return connector->executeCommand("DELETE FROM Relationship WHERE person1_id = ?1 OR person2_id = ?1",
+                                             {personId}) &&
+                   connector->executeCommand("DELETE FROM PersonPhonetic WHERE person_id = ?", {personId}) &&
+                   connector->executeCommand("DELETE FROM Person WHERE person_id = ?", {personId}) &&
+                   (root != personId || setRootPerson("")) &&
+                   unlinkGenerations(relatives);
+        });
+    }
+
+    SQLiteConnector& target = connectorFor(personId);
+    bool hadParents = false;
+    return runAtomically([&]() {
+        if (!detachPerson(personId, hadParents)) {
+            return false;
+        }
+        target.executeCommand("DELETE FROM PersonPhonetic WHERE person_id = ?", {personId});
+        const std::string sql = "DELETE FROM Person WHERE person_id = ?";
+        // Only someone with parents has a line row
+        return target.executeCommand(sql, {personId}) &&
+               connector->executeCommand("DELETE FROM PersonGeneration WHERE person_id = ?", {personId}) &&
+               (!hadParents || connector->executeCommand("DELETE FROM PersonLine WHERE person_id = ?", {personId})) &&
+               (!isSharded() ||
+                connector->executeCommand("DELETE FROM PersonShard WHERE person_id = ?", {personId})) &&
+               (getRootPerson() != personId || setRootPerson(""));
+    });
 }
 
 bool DatabaseManager::addRelationship(const Relationship& relationship) {
-    const std::string sql = R"(
-        INSERT INTO Relationship (
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "addRelationship");
+    bool parentChild = relationship.getType() == RelationType::PARENT_CHILD;
+    bool spouse = relationship.getType() == RelationType::SPOUSE;
+    // Without a root or shards the database keeps the derived tables, so
+    // a parent or sibling link is a single statement
+    if (!isSharded() && !spouse && getRootPerson().empty()) {
+        return parentChild
+            ? connector->executeCommand("INSERT INTO ParentLink (parent_id, child_id) VALUES (?, ?)",
+                                        {relationship.getPerson1Id(), relationship.getPerson2Id()})
+            : insertRelationship(*connector, relationship, false);
+    }
+    return runAtomically([&]() {
+        bool ok;
+        if (parentChild) {
+            // Filed in the main file's families; fails if already linked
+            ok = connector->executeCommand("INSERT INTO ParentLink (parent_id, child_id) VALUES (?, ?)",
+                                           {relationship.getPerson1Id(), relationship.getPerson2Id()});
+        } else if (!isSharded()) {
+            ok = insertRelationship(*connector, relationship, false);
+        } else {
+            // Stored with both endpoints
+            int first = shardOf(relationship.getPerson1Id());
+            int second = shardOf(relationship.getPerson2Id());
+            ok = insertRelationship(shardConnector(first), relationship, false) &&
+                 (first == second || insertRelationship(shardConnector(second), relationship, false));
+        }
+        return ok &&
+               (!parentChild || !isSharded() || refreshDirectLines(relationship.getPerson2Id())) &&
+               (!spouse || setCouple(relationship.getPerson1Id(), relationship.getPerson2Id(), true,
+                                     !relationship.getEndDate().empty())) &&
+               linkGenerations(relationship.getPerson1Id(), relationship.getPerson2Id(), parentChild ? 1 : 0);
+    });
+}
+
+bool DatabaseManager::insertRelationship(SQLiteConnector& target, const Relationship& relationship,
+                                         bool ignoreExisting) {
+    const std::string sql = std::string(ignoreExisting ? "INSERT OR IGNORE" : "INSERT") + R"( INTO Relationship (
             relationship_id, person1_id, person2_id, 
             relationship_type, start_date, end_date
         ) VALUES (?, ?, ?, ?, ?, ?)
@@ -126,21 +434,566 @@ bool DatabaseManager::addRelationship(const Relationship& relationship) {
         relationship.getEndDate()
     };
 
-    return connector->executeCommand(sql, params);
+    return target.executeCommand(sql, params);
+}
+
+bool DatabaseManager::updateRelationship(const Relationship& relationship) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "updateRelationship");
+    const std::string sql = "UPDATE Relationship SET start_date = ?, end_date = ? WHERE relationship_id = ?";
+    return runAtomically([&]() {
+        bool ok = true;
+        for (auto* shard : allConnectors()) {
+            ok = shard->executeCommand(sql, {relationship.getStartDate(), relationship.getEndDate(),
+                                             relationship.getId()}) && ok;
+        }
+        // An end date may end the couple's current marriage
+        return ok && (relationship.getType() != RelationType::SPOUSE ||
+                      refreshCouple(relationship.getPerson1Id(), relationship.getPerson2Id()));
+    });
 }
 
 bool DatabaseManager::deleteRelationship(const std::string& relationshipId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "deleteRelationship");
     const std::string sql = "DELETE FROM Relationship WHERE relationship_id = ?";
-    return connector->executeCommand(sql, {relationshipId});
+    auto relationship = getRelationship(relationshipId);
+    return runAtomically([&]() {
+        bool ok = true;
+        if (relationship && relationship->getType() == RelationType::PARENT_CHILD) {
+            ok = connector->executeCommand("DELETE FROM ParentLink WHERE parent_id = ? AND child_id = ?",
+                                           {relationship->getPerson1Id(), relationship->getPerson2Id()});
+        } else {
+            for (auto* shard : allConnectors()) {
+                ok = shard->executeCommand(sql, {relationshipId}) && ok;
+            }
+        }
+        if (!ok || !relationship) {
+            return ok;
+        }
+        if (relationship->getType() == RelationType::PARENT_CHILD && isSharded() &&
+            !refreshDirectLines(relationship->getPerson2Id())) {
+            return false;
+        }
+        if (relationship->getType() == RelationType::SPOUSE &&
+            !refreshCouple(relationship->getPerson1Id(), relationship->getPerson2Id())) {
+            return false;
+        }
+        return unlinkGenerations({relationship->getPerson1Id(), relationship->getPerson2Id()});
+    });
+}
+
+// Deletes personId's relationships in a sharded tree and brings their
+// relatives' lines, families and generations up to date; the person's
+// own rows are left for deletePerson to remove
+bool DatabaseManager::detachPerson(const std::string& personId, bool& hadParents) {
+    const std::string sql = "DELETE FROM Relationship WHERE person1_id = ? OR person2_id = ?";
+    std::vector<std::string> children;
+    std::vector<std::string> spouses;
+    std::vector<std::string> relatives = {personId};
+    hadParents = false;
+    for (const auto& relationship : getRelationshipsForPerson(personId)) {
+        const std::string& other = relationship.getPerson1Id() == personId ? relationship.getPerson2Id()
+                                                                           : relationship.getPerson1Id();
+        if (relationship.getType() == RelationType::PARENT_CHILD && relationship.getPerson1Id() == personId) {
+            children.push_back(other);
+        } else if (relationship.getType() == RelationType::PARENT_CHILD) {
+            hadParents = true;
+        } else if (relationship.getType() == RelationType::SPOUSE) {
+            spouses.push_back(other);
+        }
+        relatives.push_back(other);
+    }
+    bool ok = true;
+    for (auto* shard : allConnectors()) {
+        ok = shard->executeCommand(sql, {personId, personId}) && ok;
+    }
+    // A couple's children stay in the family of the other parent
+    ok = ok && (children.empty() ||
+                connector->executeCommand("DELETE FROM ParentLink WHERE parent_id = ?", {personId})) &&
+         (!hadParents || connector->executeCommand("DELETE FROM ParentLink WHERE child_id = ?", {personId}));
+    // Children found their own lines
+    for (const auto& id : children) {
+        ok = ok && refreshDirectLines(id);
+    }
+    for (const auto& id : spouses) {
+        ok = ok && setCouple(personId, id, false, false);
+    }
+    return ok && unlinkGenerations(relatives);
+}
+
+std::vector<std::string> DatabaseManager::deleteBranch(const std::string& personId, bool includeSpouses) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "deleteBranch");
+    std::vector<std::string> removed;
+    if (isSharded()) {
+        // The branch spans shards: walk it, then delete person by person
+        removed = collectBranch(personId, includeSpouses);
+        bool ok = !removed.empty() && runAtomically([&]() {
+            for (const auto& id : removed) {
+                if (!deletePerson(id)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        if (!ok) {
+            removed.clear();
+        }
+        return removed;
+    }
+
+    bool ok = runAtomically([&]() {
+        // Collect the branch once, then delete with one statement per table
+        connector->executeCommand("CREATE TEMP TABLE IF NOT EXISTS BranchMember (person_id TEXT PRIMARY KEY)");
+        connector->executeCommand("DELETE FROM BranchMember");
+        connector->executeCommand(R"(
+            INSERT INTO BranchMember (person_id)
+            WITH RECURSIVE branch(person_id) AS (
+                SELECT person_id FROM Person WHERE person_id = ?
+                UNION
+                )" + parentLinkSteps("branch", false) + R"(
+            )
+            SELECT person_id FROM branch
+        )", {personId});
+
+        if (includeSpouses) {
+            connector->executeCommand(R"(
+                INSERT OR IGNORE INTO BranchMember (person_id)
+                SELECT CASE WHEN r.person1_id = m.person_id THEN r.person2_id ELSE r.person1_id END
+                FROM Relationship r
+                JOIN BranchMember m ON r.person1_id = m.person_id OR r.person2_id = m.person_id
+                WHERE r.relationship_type = ?
+            )", {Relationship::relationTypeToString(RelationType::SPOUSE)});
+        }
+
+        for (const auto& row : connector->executeQuery("SELECT person_id FROM BranchMember")) {
+            removed.push_back(row.at("person_id"));
+        }
+        if (removed.empty()) {
+            return false;
+        }
+
+        // Everyone linked to the branch from outside may change generation
+        std::vector<std::string> boundary;
+        for (const auto& row : connector->executeQuery(R"(
+                 WITH link(person1_id, person2_id) AS (
+                     SELECT person1_id, person2_id FROM Relationship
+                     UNION ALL
+                     SELECT parent_id, child_id FROM ParentLink
+                 )
+                 SELECT DISTINCT CASE WHEN person1_id IN (SELECT person_id FROM BranchMember)
+                                      THEN person2_id ELSE person1_id END AS person_id
+                 FROM link
+                 WHERE (person1_id IN (SELECT person_id FROM BranchMember)) <>
+                       (person2_id IN (SELECT person_id FROM BranchMember))
+             )")) {
+            boundary.push_back(row.at("person_id"));
+        }
+
+        bool ok = connector->executeCommand(R"(
+            DELETE FROM Relationship
+            WHERE person1_id IN (SELECT person_id FROM BranchMember)
+               OR person2_id IN (SELECT person_id FROM BranchMember)
+        )");
+        ok = ok && connector->executeCommand(
+            "DELETE FROM PersonPhonetic WHERE person_id IN (SELECT person_id FROM BranchMember)");
+        // Links, families, lines and depths follow (see the person_delete
+        // trigger); children outside the branch stay with their other parent
+        ok = ok && connector->executeCommand(
+            "DELETE FROM Person WHERE person_id IN (SELECT person_id FROM BranchMember)");
+        if (std::find(removed.begin(), removed.end(), getRootPerson()) != removed.end()) {
+            ok = ok && setRootPerson("");
+        } else {
+            ok = ok && unlinkGenerations(boundary);
+        }
+        connector->executeCommand("DELETE FROM BranchMember");
+        return ok;
+    });
+    if (!ok) {
+        removed.clear();
+    }
+    return removed;
+}
+
+MergeSummary DatabaseManager::mergeDatabase(const std::string& otherDbPath, const MergeOptions& options) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "mergeDatabase");
+    if (isSharded()) {
+        throw std::logic_error("Merging into a sharded tree is not supported");
+    }
+    if (connector->inTransaction()) {
+        throw std::logic_error("Cannot merge a database inside a transaction");
+    }
+    // ATTACH would silently create a missing file
+    if (!std::ifstream(otherDbPath).good()) {
+        throw std::runtime_error("Cannot open database: " + otherDbPath);
+    }
+    if (!connector->executeCommand("ATTACH DATABASE ? AS merge_source", {otherDbPath})) {
+        throw std::runtime_error("Cannot attach database: " + otherDbPath);
+    }
+
+    auto run = [&](const std::string& step, const std::string& sql,
+                   const std::vector<std::string>& params = {}) {
+        if (!connector->executeCommand(sql, params)) {
+            throw std::runtime_error("Merge failed while " + step);
+        }
+    };
+    auto count = [&](const std::string& sql) {
+        auto rows = connector->executeQuery(sql);
+        return rows.empty() ? 0 : std::stoi(rows[0].begin()->second);
+    };
+
+    MergeSummary summary;
+    bool merged;
+    try {
+        merged = runAtomically([&]() {
+            // Inside the transaction queries run on the writer connection,
+            // the only one that sees the attached database
+            int tables = count(R"(
+                SELECT COUNT(*) FROM merge_source.sqlite_master
+                WHERE type = 'table' AND name IN ('Person', 'Relationship')
+            )");
+            if (tables != 2) {
+                throw std::runtime_error("Not a family tree database: " + otherDbPath);
+            }
+
+            // incoming_id -> target_id. Matched rows point at existing
+            // people; the others are inserted under target_id, which the
+            // partial index keeps unique.
+            run("creating the ID map", R"(
+                CREATE TEMP TABLE IF NOT EXISTS MergeIdMap (
+                    incoming_id TEXT PRIMARY KEY,
+                    target_id TEXT NOT NULL,
+                    matched INTEGER NOT NULL,
+                    candidates INTEGER NOT NULL DEFAULT 1
+                )
+            )");
+            run("creating the ID map", R"(
+                CREATE UNIQUE INDEX IF NOT EXISTS temp.idx_merge_target
+                ON MergeIdMap(target_id) WHERE matched = 0
+            )");
+            run("clearing the ID map", "DELETE FROM MergeIdMap");
+
+            for (const auto& entry : options.identityMap) {
+                run("applying the identity map", R"(
+                    INSERT OR REPLACE INTO MergeIdMap (incoming_id, target_id, matched)
+                    SELECT i.person_id, e.person_id, 1
+                    FROM merge_source.Person i, main.Person e
+                    WHERE i.person_id = ? AND e.person_id = ?
+                )", {entry.first, entry.second});
+                if (connector->changes() == 0) {
+                    summary.conflicts.push_back({entry.first, "",
+                        "identity map entry refers to a missing person"});
+                }
+            }
+
+            if (options.matchByIdentity) {
+                run("matching people", R"(
+                    INSERT OR IGNORE INTO MergeIdMap (incoming_id, target_id, matched, candidates)
+                    SELECT i.person_id, MIN(e.person_id), 1, COUNT(*)
+                    FROM merge_source.Person i
+                    JOIN main.Person e
+                      ON e.last_name = i.last_name COLLATE NOCASE
+                     AND e.first_name = i.first_name COLLATE NOCASE
+                     AND e.date_of_birth = i.date_of_birth
+                    GROUP BY i.person_id
+                )");
+                for (const auto& row : connector->executeQuery(
+                         "SELECT incoming_id, target_id, candidates FROM MergeIdMap WHERE candidates > 1")) {
+                    summary.conflicts.push_back({row.at("incoming_id"), row.at("target_id"),
+                        "matched " + row.at("candidates") + " existing people; merged into the first"});
+                }
+            }
+
+            // Unmatched people whose ID is taken get a prefixed ID
+            run("renaming clashing IDs", R"(
+                INSERT OR IGNORE INTO MergeIdMap (incoming_id, target_id, matched)
+                SELECT i.person_id, ? || i.person_id, 0
+                FROM merge_source.Person i
+                JOIN main.Person e ON e.person_id = i.person_id
+                WHERE NOT EXISTS (SELECT 1 FROM MergeIdMap m WHERE m.incoming_id = i.person_id)
+            )", {options.conflictPrefix});
+            run("renaming clashing IDs", R"(
+                DELETE FROM MergeIdMap
+                WHERE matched = 0 AND target_id IN (SELECT person_id FROM main.Person)
+            )");
+            for (const auto& row : connector->executeQuery(
+                     "SELECT incoming_id, target_id FROM MergeIdMap WHERE matched = 0")) {
+                summary.conflicts.push_back({row.at("incoming_id"), row.at("target_id"),
+                    "ID used by a different person"});
+            }
+
+            // Everyone else keeps their ID, unless it is taken and so was
+            // its prefixed form
+            run("mapping IDs", R"(
+                INSERT OR IGNORE INTO MergeIdMap (incoming_id, target_id, matched)
+                SELECT person_id, person_id, 0 FROM merge_source.Person
+                WHERE person_id NOT IN (SELECT person_id FROM main.Person)
+            )");
+            for (const auto& row : connector->executeQuery(R"(
+                     SELECT person_id FROM merge_source.Person i
+                     WHERE NOT EXISTS (SELECT 1 FROM MergeIdMap m WHERE m.incoming_id = i.person_id)
+                 )")) {
+                summary.conflicts.push_back({row.at("person_id"), "", "no free ID for this person"});
+            }
+
+            // Place names come over as text and join this tree's
+            // dictionary below; older files keep them in Person itself
+            int placeViews = count(R"(
+                SELECT COUNT(*) FROM merge_source.sqlite_master
+                WHERE type = 'view' AND name = 'PersonView'
+            )");
+            run("copying people", std::string(R"(
+                INSERT INTO main.Person (
+                    person_id, first_name, last_name, gender,
+                    date_of_birth, date_of_death, birth_place, death_place
+                )
+                SELECT m.target_id, i.first_name, i.last_name, i.gender,
+                       i.date_of_birth, i.date_of_death, i.birth_place, i.death_place
+                FROM MergeIdMap m
+                JOIN merge_source.)") + (placeViews == 1 ? "PersonView" : "Person") + R"( i
+                  ON i.person_id = m.incoming_id
+                WHERE m.matched = 0
+            )");
+            summary.peopleAdded = connector->changes();
+            // Their depths and lines follow the links copied below
+            run("copying people", R"(
+                INSERT OR IGNORE INTO main.PersonGeneration (person_id)
+                SELECT target_id FROM MergeIdMap WHERE matched = 0
+            )");
+            normalizePlaces(*connector);
+            summary.peopleMatched = count("SELECT COUNT(*) FROM MergeIdMap WHERE matched = 1");
+            summary.incomingPeople = count("SELECT COUNT(*) FROM merge_source.Person");
+
+            // Reuse the incoming tree's phonetic keys; encode only people
+            // it has none for (databases written before the index existed)
+            int phoneticTables = count(R"(
+                SELECT COUNT(*) FROM merge_source.sqlite_master
+                WHERE type = 'table' AND name = 'PersonPhonetic'
+            )");
+            if (phoneticTables == 1) {
+                run("copying phonetic keys", R"(
+                    INSERT OR IGNORE INTO main.PersonPhonetic (algorithm, code, person_id, name_part)
+                    SELECT k.algorithm, k.code, m.target_id, k.name_part
+                    FROM MergeIdMap m
+                    JOIN merge_source.PersonPhonetic k ON k.person_id = m.incoming_id
+                    WHERE m.matched = 0
+                )");
+            }
+            for (const auto& row : connector->executeQuery(R"(
+                     SELECT p.person_id, p.first_name, p.last_name
+                     FROM MergeIdMap m JOIN main.Person p ON p.person_id = m.target_id
+                     WHERE m.matched = 0
+                       AND NOT EXISTS (SELECT 1 FROM main.PersonPhonetic k WHERE k.person_id = p.person_id)
+                 )")) {
+                writePhoneticKeys(*connector, row.at("person_id"), row.at("first_name"), row.at("last_name"));
+            }
+
+            // New relationships and parent links are staged first so the
+            // couples they join can be brought up to date afterwards
+            run("staging relationships", R"(
+                CREATE TEMP TABLE IF NOT EXISTS MergeRelationship (
+                    relationship_id TEXT PRIMARY KEY,
+                    person1_id TEXT NOT NULL,
+                    person2_id TEXT NOT NULL,
+                    relationship_type TEXT NOT NULL,
+                    start_date TEXT,
+                    end_date TEXT
+                )
+            )");
+            run("staging relationships", R"(
+                CREATE TEMP TABLE IF NOT EXISTS MergeLink (
+                    parent_id TEXT NOT NULL,
+                    child_id TEXT NOT NULL,
+                    PRIMARY KEY (parent_id, child_id)
+                )
+            )");
+            run("staging relationships", "DELETE FROM MergeRelationship");
+            run("staging relationships", "DELETE FROM MergeLink");
+
+            // Relationships get IDs in this tree's format; ones already
+            // present (in either direction, all stored types are symmetric)
+            // are skipped
+            const std::string parentChild = Relationship::relationTypeToString(RelationType::PARENT_CHILD);
+            run("copying relationships", R"(
+                INSERT OR IGNORE INTO MergeRelationship (
+                    relationship_id, person1_id, person2_id,
+                    relationship_type, start_date, end_date
+                )
+                SELECT m1.target_id || '_' || m2.target_id || '_' || r.relationship_type,
+                       m1.target_id, m2.target_id, r.relationship_type, r.start_date, r.end_date
+                FROM merge_source.Relationship r
+                JOIN MergeIdMap m1 ON m1.incoming_id = r.person1_id
+                JOIN MergeIdMap m2 ON m2.incoming_id = r.person2_id
+                WHERE r.relationship_type <> ? AND m1.target_id <> m2.target_id
+                  AND NOT EXISTS (
+                      SELECT 1 FROM main.Relationship x
+                      WHERE ((x.person1_id = m1.target_id AND x.person2_id = m2.target_id)
+                             OR (x.person1_id = m2.target_id AND x.person2_id = m1.target_id))
+                        AND x.relationship_type = r.relationship_type)
+            )", {parentChild});
+            summary.relationshipsAdded = connector->changes();
+
+            // Parent links come from the incoming families, or from
+            // Parent-Child rows in files written before families stored them
+            std::string incomingLinks = R"(
+                SELECT person1_id AS parent_id, person2_id AS child_id
+                FROM merge_source.Relationship WHERE relationship_type = ?
+            )";
+            int linkViews = count(R"(
+                SELECT COUNT(*) FROM merge_source.sqlite_master
+                WHERE type = 'view' AND name = 'ParentLink'
+            )");
+            if (linkViews == 1) {
+                incomingLinks += " UNION ALL SELECT parent_id, child_id FROM merge_source.ParentLink";
+            }
+            run("copying parent links", R"(
+                INSERT OR IGNORE INTO MergeLink (parent_id, child_id)
+                SELECT m1.target_id, m2.target_id
+                FROM ()" + incomingLinks + R"() r
+                JOIN MergeIdMap m1 ON m1.incoming_id = r.parent_id
+                JOIN MergeIdMap m2 ON m2.incoming_id = r.child_id
+                WHERE m1.target_id <> m2.target_id
+                  AND NOT EXISTS (
+                      SELECT 1 FROM main.ParentLink x
+                      WHERE x.parent_id = m1.target_id AND x.child_id = m2.target_id)
+            )", {parentChild});
+            summary.relationshipsAdded += connector->changes();
+
+            run("copying relationships", R"(
+                INSERT INTO main.Relationship (
+                    relationship_id, person1_id, person2_id,
+                    relationship_type, start_date, end_date
+                )
+                SELECT relationship_id, person1_id, person2_id, relationship_type, start_date, end_date
+                FROM MergeRelationship
+            )");
+            run("copying parent links", R"(
+                INSERT INTO main.ParentLink (parent_id, child_id)
+                SELECT parent_id, child_id FROM MergeLink
+            )");
+            for (const auto& row : connector->executeQuery(
+                     "SELECT DISTINCT person1_id, person2_id FROM MergeRelationship WHERE relationship_type = ?",
+                     {Relationship::relationTypeToString(RelationType::SPOUSE)})) {
+                if (!refreshCouple(row.at("person1_id"), row.at("person2_id"))) {
+                    return false;
+                }
+            }
+
+            // Links only join people, so generations spread from the
+            // labelled end of each new one; the copied links have already
+            // passed depths and lines on
+            if (summary.relationshipsAdded > 0) {
+                std::vector<GenerationLink> links;
+                for (const auto& row : connector->executeQuery(R"(
+                         SELECT person1_id, person2_id, 0 AS difference FROM MergeRelationship
+                         UNION ALL
+                         SELECT parent_id, child_id, 1 FROM MergeLink
+                     )")) {
+                    links.push_back({row.at("person1_id"), row.at("person2_id"), std::stoi(row.at("difference"))});
+                }
+                if (!linkGenerations(links)) {
+                    return false;
+                }
+            }
+            summary.incomingRelationships = count("SELECT COUNT(*) FROM merge_source.Relationship") +
+                                            (linkViews == 1 ? count("SELECT COUNT(*) FROM merge_source.ParentLink") : 0);
+            summary.relationshipsSkipped = summary.incomingRelationships - summary.relationshipsAdded;
+
+            run("clearing the ID map", "DELETE FROM MergeIdMap");
+            return true;
+        });
+    } catch (...) {
+        connector->executeCommand("DETACH DATABASE merge_source");
+        throw;
+    }
+    connector->executeCommand("DETACH DATABASE merge_source");
+    if (!merged) {
+        throw std::runtime_error("Merge failed while linking the merged people");
+    }
+    return summary;
+}
+
+std::optional<Relationship> DatabaseManager::getRelationship(const std::string& relationshipId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getRelationship");
+    const std::string sql = "SELECT * FROM Relationship WHERE relationship_id = ?";
+    for (auto* shard : allConnectors()) {
+        auto results = shard->executeQuery(sql, {relationshipId});
+        if (!results.empty()) {
+            return createRelationshipFromRow(results[0]);
+        }
+    }
+    // A parent link, "<parent>_<child>_Parent-Child"; IDs may contain '_'
+    // themselves, so try every split
+    const std::string suffix = "_" + Relationship::relationTypeToString(RelationType::PARENT_CHILD);
+    if (relationshipId.size() <= suffix.size() ||
+        relationshipId.compare(relationshipId.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return std::nullopt;
+    }
+    const std::string ids = relationshipId.substr(0, relationshipId.size() - suffix.size());
+    for (size_t split = ids.find('_'); split != std::string::npos; split = ids.find('_', split + 1)) {
+        auto results = connector->executeQuery(parentLinkRows("parent_id = ? AND child_id = ?"),
+                                               {ids.substr(0, split), ids.substr(split + 1)});
+        if (!results.empty()) {
+            return createRelationshipFromRow(results[0]);
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<Person> DatabaseManager::getAllPeople() {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getAllPeople");
+    std::vector<Person> people;
+    for (auto* shard : allConnectors()) {
+        for (const auto& row : shard->executeQuery("SELECT * FROM PersonView ORDER BY person_id")) {
+            people.push_back(createPersonFromRow(row));
+        }
+    }
+    if (isSharded()) {
+        std::sort(people.begin(), people.end(), [](const Person& a, const Person& b) {
+            return a.getId() < b.getId();
+        });
+    }
+    return people;
+}
+
+std::vector<Relationship> DatabaseManager::getAllRelationships() {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getAllRelationships");
+    std::vector<Relationship> relationships;
+    for (auto* shard : allConnectors()) {
+        std::string sql = "SELECT * FROM Relationship";
+        if (shard == connector.get()) {
+            sql = "SELECT * FROM (SELECT " + RELATIONSHIP_COLUMNS + " FROM Relationship UNION ALL " +
+                  parentLinkRows("1") + ")";
+        }
+        for (const auto& row : shard->executeQuery(sql + " ORDER BY relationship_id")) {
+            relationships.push_back(createRelationshipFromRow(row));
+        }
+    }
+    if (isSharded()) {
+        // Cross-shard relationships are stored twice
+        auto byId = [](const Relationship& a, const Relationship& b) { return a.getId() < b.getId(); };
+        auto sameId = [](const Relationship& a, const Relationship& b) { return a.getId() == b.getId(); };
+        std::sort(relationships.begin(), relationships.end(), byId);
+        relationships.erase(std::unique(relationships.begin(), relationships.end(), sameId),
+                            relationships.end());
+    }
+    return relationships;
 }
 
 std::vector<Relationship> DatabaseManager::getRelationshipsForPerson(const std::string& personId) {
-    const std::string sql = R"(
-        SELECT * FROM Relationship 
-        WHERE person1_id = ? OR person2_id = ?
-    )";
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getRelationshipsForPerson");
+    std::string sql = "SELECT " + RELATIONSHIP_COLUMNS + " FROM Relationship WHERE person1_id = ?1 OR person2_id = ?1";
+    // One branch per column, so each is an index lookup
+    const std::string links =
+        parentLinkRows("parent_id = ?1") + " UNION ALL " + parentLinkRows("child_id = ?1 AND parent_id <> ?1");
 
-    auto results = connector->executeQuery(sql, {personId, personId});
+    std::vector<std::map<std::string, std::string>> results;
+    if (!isSharded()) {
+        results = connector->executeQuery(sql + " UNION ALL " + links, {personId});
+    } else {
+        // Parent links live in the main file
+        results = connectorFor(personId).executeQuery(sql, {personId});
+        auto linked = connector->executeQuery(links, {personId});
+        results.insert(results.end(), linked.begin(), linked.end());
+    }
     std::vector<Relationship> relationships;
 
     for (const auto& row : results) {
@@ -151,12 +1004,7 @@ std::vector<Relationship> DatabaseManager::getRelationshipsForPerson(const std::
 }
 
 Relationship DatabaseManager::createRelationshipFromRow(const std::map<std::string, std::string>& row) {
-    RelationType type;
-    std::string typeStr = row.at("relationship_type");
-    
-    if (typeStr == "PARENT_CHILD") type = RelationType::PARENT_CHILD;
-    else if (typeStr == "SPOUSE") type = RelationType::SPOUSE;
-    else type = RelationType::SIBLING;
+    RelationType type = Relationship::relationTypeFromString(row.at("relationship_type"));
 
     Relationship rel(
         row.at("relationship_id"),
@@ -176,20 +1024,1411 @@ Relationship DatabaseManager::createRelationshipFromRow(const std::map<std::stri
 }
 
 std::vector<Person> DatabaseManager::searchPeople(const std::string& searchTerm) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "searchPeople");
     const std::string sql = R"(
-        SELECT * FROM Person 
+        SELECT * FROM PersonView
         WHERE first_name LIKE ? OR last_name LIKE ?
         OR first_name || ' ' || last_name LIKE ?
     )";
 
     std::string searchPattern = "%" + searchTerm + "%";
-    auto results = connector->executeQuery(sql, 
-        {searchPattern, searchPattern, searchPattern});
-
     std::vector<Person> people;
-    for (const auto& row : results) {
-        people.push_back(createPersonFromRow(row));
+    for (auto* shard : allConnectors()) {
+        auto results = shard->executeQuery(sql,
+            {searchPattern, searchPattern, searchPattern});
+        for (const auto& row : results) {
+            people.push_back(createPersonFromRow(row));
+        }
     }
     
     return people;
-}
\ No newline at end of file
+}
+
+std::vector<Person> DatabaseManager::searchPeoplePhonetic(const std::string& searchTerm,
+                                                          const std::vector<PhoneticAlgorithm>& algorithms) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "searchPeoplePhonetic");
+    std::vector<std::string> params;
+    std::string sql = phoneticSearchSql(searchTerm, algorithms, params);
+    if (params.empty()) {
+        return {};
+    }
+    sql += " ORDER BY last_name, first_name";
+
+    std::vector<Person> people;
+    for (auto* shard : allConnectors()) {
+        for (const auto& row : shard->executeQuery(sql, params)) {
+            people.push_back(createPersonFromRow(row));
+        }
+    }
+    if (isSharded()) {
+        std::sort(people.begin(), people.end(), [](const Person& a, const Person& b) {
+            if (a.getLastName() != b.getLastName()) return a.getLastName() < b.getLastName();
+            return a.getFirstName() < b.getFirstName();
+        });
+    }
+    return people;
+}
+
+std::string DatabaseManager::phoneticSearchSql(const std::string& searchTerm,
+                                               const std::vector<PhoneticAlgorithm>& algorithms,
+                                               std::vector<std::string>& params) {
+    std::istringstream words(searchTerm);
+    std::string word;
+    std::string sql = "SELECT * FROM PersonView WHERE 1";
+
+    // One index probe per word: (algorithm, code) is the table's primary key
+    while (words >> word) {
+        std::string keyFilter;
+        for (auto algorithm : algorithms) {
+            auto codes = PhoneticEncoder::encode(word, algorithm);
+            if (codes.empty()) continue;
+
+            if (!keyFilter.empty()) keyFilter += " OR ";
+            keyFilter += "(algorithm = ? AND code IN (";
+            params.push_back(PhoneticEncoder::algorithmToString(algorithm));
+            for (size_t i = 0; i < codes.size(); i++) {
+                keyFilter += (i == 0) ? "?" : ", ?";
+                params.push_back(codes[i]);
+            }
+            keyFilter += "))";
+        }
+        if (keyFilter.empty()) continue;
+        sql += " AND person_id IN (SELECT person_id FROM PersonPhonetic WHERE " + keyFilter + ")";
+    }
+    return sql;
+}
+
+PersonPage DatabaseManager::searchPeoplePage(const std::string& searchTerm, size_t offset, size_t limit) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "searchPeoplePage");
+    const std::string sql = R"(
+        SELECT * FROM PersonView
+        WHERE first_name LIKE ? OR last_name LIKE ?
+        OR first_name || ' ' || last_name LIKE ?
+        ORDER BY last_name, first_name, person_id
+    )";
+
+    std::string searchPattern = "%" + searchTerm + "%";
+    return queryPersonPage(sql, {searchPattern, searchPattern, searchPattern}, offset, limit);
+}
+
+PersonPage DatabaseManager::searchPeoplePhoneticPage(const std::string& searchTerm,
+                                                     const std::vector<PhoneticAlgorithm>& algorithms,
+                                                     size_t offset, size_t limit) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "searchPeoplePhoneticPage");
+    std::vector<std::string> params;
+    std::string sql = phoneticSearchSql(searchTerm, algorithms, params);
+    if (params.empty()) {
+        return {};
+    }
+    sql += " ORDER BY last_name, first_name, person_id";
+    return queryPersonPage(sql, std::move(params), offset, limit);
+}
+
+PersonPage DatabaseManager::queryPersonPage(const std::string& sql, std::vector<std::string> params,
+                                            size_t offset, size_t limit) {
+    // A single file skips to the page itself. With shards, each returns its
+    // first offset + limit + 1 rows and the merged list is cut to the page.
+    params.push_back(std::to_string(isSharded() ? offset + limit + 1 : limit + 1));
+    params.push_back(std::to_string(isSharded() ? 0 : offset));
+    const std::string pagedSql = sql + " LIMIT ? OFFSET ?";
+
+    PersonPage page;
+    for (auto* shard : allConnectors()) {
+        for (const auto& row : shard->executeQuery(pagedSql, params)) {
+            page.people.push_back(createPersonFromRow(row));
+        }
+    }
+    if (isSharded()) {
+        std::sort(page.people.begin(), page.people.end(), [](const Person& a, const Person& b) {
+            if (a.getLastName() != b.getLastName()) return a.getLastName() < b.getLastName();
+            if (a.getFirstName() != b.getFirstName()) return a.getFirstName() < b.getFirstName();
+            return a.getId() < b.getId();
+        });
+        page.people.erase(page.people.begin(),
+                          page.people.begin() + std::min(offset, page.people.size()));
+    }
+    if (page.people.size() > limit) {
+        page.hasMore = true;
+        page.people.erase(page.people.begin() + limit, page.people.end());
+    }
+    return page;
+}
+
+PersonPage DatabaseManager::getLineagePage(const std::string& personId, bool ancestors, int generations,
+                                           size_t offset, size_t limit) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getLineagePage");
+    if (isSharded()) {
+        return traverseLineagePage(personId, ancestors, generations, offset, limit);
+    }
+
+    // ORDER BY inside the recursive CTE makes it breadth-first, and without
+    // an outer ORDER BY the LIMIT ends the recursion once the page is read
+    const std::string sql = R"(
+        WITH RECURSIVE lineage(person_id, generation) AS (
+            SELECT ?1, 0
+            UNION
+            )" + parentLinkSteps("lineage", ancestors, ", w.generation + 1",
+                                 "CAST(?2 AS INTEGER) < 0 OR w.generation < CAST(?2 AS INTEGER)") + R"(
+            ORDER BY 2
+        )
+        SELECT p.*, l.generation FROM lineage l
+        CROSS JOIN PersonView p ON p.person_id = l.person_id
+        WHERE l.generation > 0
+        LIMIT ?3 OFFSET ?4
+    )";
+
+    PersonPage page;
+    for (const auto& row : connector->executeQuery(sql, {
+            personId, std::to_string(generations), std::to_string(limit + 1), std::to_string(offset)})) {
+        if (page.people.size() == limit) {
+            page.hasMore = true;
+            break;
+        }
+        page.people.push_back(createPersonFromRow(row));
+        page.generations.push_back(std::stoi(row.at("generation")));
+    }
+    return page;
+}
+
+// Sharded trees: the same breadth-first walk, one generation at a time,
+// through getRelationshipsForPerson (which finds each person's shard)
+PersonPage DatabaseManager::traverseLineagePage(const std::string& personId, bool ancestors,
+                                                int generations, size_t offset, size_t limit) {
+    PersonPage page;
+    std::vector<std::string> current = {personId};
+    size_t skipped = 0;
+    for (int generation = 1; !current.empty() && (generations < 0 || generation <= generations);
+         generation++) {
+        std::vector<std::string> next;
+        std::set<std::string> seen;
+        for (const auto& id : current) {
+            for (const auto& relationship : getRelationshipsForPerson(id)) {
+                if (relationship.getType() != RelationType::PARENT_CHILD) continue;
+                const std::string& self = ancestors ? relationship.getPerson2Id() : relationship.getPerson1Id();
+                const std::string& other = ancestors ? relationship.getPerson1Id() : relationship.getPerson2Id();
+                if (self != id || !seen.insert(other).second) continue;
+                next.push_back(other);
+
+                if (skipped < offset) {
+                    skipped++;
+                    continue;
+                }
+                if (page.people.size() == limit) {
+                    page.hasMore = true;
+                    return page;
+                }
+                if (auto person = getPerson(other)) {
+                    page.people.push_back(*person);
+                    page.generations.push_back(generation);
+                }
+            }
+        }
+        current = std::move(next);
+    }
+    return page;
+}
+
+bool DatabaseManager::writePhoneticKeys(SQLiteConnector& target,
+                                        const std::string& personId,
+                                        const std::string& firstName,
+                                        const std::string& lastName) {
+    target.executeCommand("DELETE FROM PersonPhonetic WHERE person_id = ?", {personId});
+
+    std::string sql = "INSERT OR IGNORE INTO PersonPhonetic (algorithm, code, person_id, name_part) VALUES ";
+    std::vector<std::string> params;
+    const std::pair<const std::string*, const char*> parts[] = {
+        {&firstName, "F"},
+        {&lastName, "L"}
+    };
+
+    for (const auto& part : parts) {
+        for (auto algorithm : PhoneticEncoder::allAlgorithms()) {
+            for (const auto& code : PhoneticEncoder::encode(*part.first, algorithm)) {
+                sql += params.empty() ? "(?, ?, ?, ?)" : ", (?, ?, ?, ?)";
+                params.push_back(PhoneticEncoder::algorithmToString(algorithm));
+                params.push_back(code);
+                params.push_back(personId);
+                params.push_back(part.second);
+            }
+        }
+    }
+
+    // Names that encode to nothing get an empty marker key, which no search
+    // matches, so the backfill does not pick the person up again
+    if (params.empty()) {
+        sql += "(?, ?, ?, ?)";
+        params = {"", "", personId, "F"};
+    }
+    return target.executeCommand(sql, params);
+}
+
+int DatabaseManager::backfillPhoneticKeys() {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "backfillPhoneticKeys");
+    const std::string sql = R"(
+        SELECT person_id, first_name, last_name FROM Person p
+        WHERE NOT EXISTS (SELECT 1 FROM PersonPhonetic k WHERE k.person_id = p.person_id)
+    )";
+
+    int written = 0;
+    for (auto* shard : allConnectors()) {
+        auto results = shard->executeQuery(sql);
+        if (results.empty()) {
+            continue;
+        }
+
+        shard->beginTransaction();
+        try {
+            for (const auto& row : results) {
+                writePhoneticKeys(*shard, row.at("person_id"), row.at("first_name"), row.at("last_name"));
+            }
+        } catch (...) {
+            shard->rollback();
+            throw;
+        }
+        shard->commit();
+        written += static_cast<int>(results.size());
+    }
+    return written;
+}
+
+std::vector<Person> DatabaseManager::getLineAncestors(const std::string& personId, DirectLine line) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getLineAncestors");
+    const std::string parent = parentColumn(line);
+    return queryLine(R"(
+        WITH RECURSIVE line(person_id, step) AS (
+            SELECT )" + parent + R"(, 1 FROM PersonLine
+            WHERE person_id = ? AND )" + parent + R"( IS NOT NULL
+            UNION ALL
+            SELECT l.)" + parent + R"(, line.step + 1 FROM line
+            JOIN PersonLine l ON l.person_id = line.person_id
+            WHERE l.)" + parent + R"( IS NOT NULL
+        )
+    )", {personId});
+}
+
+std::vector<Person> DatabaseManager::getLineDescendants(const std::string& personId, DirectLine line) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getLineDescendants");
+    const std::string parent = parentColumn(line);
+    return queryLine(R"(
+        WITH RECURSIVE line(person_id, step) AS (
+            SELECT person_id, 1 FROM PersonLine WHERE )" + parent + R"( = ?
+            UNION ALL
+            SELECT l.person_id, line.step + 1 FROM line
+            JOIN PersonLine l ON l.)" + parent + R"( = line.person_id
+        )
+    )", {personId});
+}
+
+std::vector<Person> DatabaseManager::getLineMembers(const std::string& personId, DirectLine line) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getLineMembers");
+    if (!getPerson(personId)) {
+        return {};
+    }
+    const std::string column = lineColumn(line);
+    return queryLine(R"(
+        WITH founder(person_id) AS (
+            SELECT COALESCE((SELECT )" + column + R"( FROM PersonLine WHERE person_id = ?), ?)
+        ),
+        line(person_id, step) AS (
+            SELECT person_id, 0 FROM founder
+            UNION ALL
+            SELECT l.person_id, 1 FROM founder f
+            JOIN PersonLine l ON l.)" + column + R"( = f.person_id
+            WHERE l.person_id <> f.person_id
+        )
+    )", {personId, personId});
+}
+
+// lineSql defines line(person_id, step) over the main file's tables
+// (PersonLine, the families, PersonGeneration); people come out by step,
+// then ID
+std::vector<Person> DatabaseManager::queryLine(const std::string& lineSql,
+                                               const std::vector<std::string>& params) {
+    std::vector<Person> people;
+    if (!isSharded()) {
+        for (const auto& row : connector->executeQuery(lineSql + R"(
+                 SELECT p.* FROM line l CROSS JOIN PersonView p ON p.person_id = l.person_id
+                 ORDER BY l.step, l.person_id
+             )", params)) {
+            people.push_back(createPersonFromRow(row));
+        }
+        return people;
+    }
+    for (const auto& row : connector->executeQuery(lineSql + " SELECT person_id FROM line ORDER BY step, person_id",
+                                                   params)) {
+        if (auto person = getPerson(row.at("person_id"))) {
+            people.push_back(*person);
+        }
+    }
+    return people;
+}
+
+// Sharded trees keep PersonLine here, as the parents' genders are in the
+// shard files: personId's row from their current parents, with the
+// PersonLine triggers passing a changed line on to descendants. The
+// father is the male parent with the lowest ID, the mother the female one.
+bool DatabaseManager::refreshDirectLines(const std::string& personId) {
+    std::string father, mother;
+    for (const auto& relationship : getRelationshipsForPerson(personId)) {
+        if (relationship.getType() != RelationType::PARENT_CHILD || relationship.getPerson2Id() != personId) {
+            continue;
+        }
+        const std::string& id = relationship.getPerson1Id();
+        auto parent = getPerson(id);
+        std::string* slot = !parent ? nullptr
+                            : parent->getGender() == "M" ? &father
+                            : parent->getGender() == "F" ? &mother : nullptr;
+        if (slot && (slot->empty() || id < *slot)) {
+            *slot = id;
+        }
+    }
+    if (father.empty() && mother.empty()) {
+        return connector->executeCommand("DELETE FROM PersonLine WHERE person_id = ?", {personId});
+    }
+    return connector->executeCommand(R"(
+        INSERT INTO PersonLine (person_id, father_id, mother_id, paternal_line, maternal_line)
+        VALUES (?1, NULLIF(?2, ''), NULLIF(?3, ''),
+                COALESCE((SELECT paternal_line FROM PersonLine WHERE person_id = ?2), NULLIF(?2, ''), ?1),
+                COALESCE((SELECT maternal_line FROM PersonLine WHERE person_id = ?3), NULLIF(?3, ''), ?1))
+        ON CONFLICT (person_id) DO UPDATE SET
+            father_id = excluded.father_id, mother_id = excluded.mother_id,
+            paternal_line = excluded.paternal_line, maternal_line = excluded.maternal_line
+        WHERE father_id IS NOT excluded.father_id OR mother_id IS NOT excluded.mother_id
+    )", {personId, father, mother});
+}
+
+int DatabaseManager::rebuildDirectLines() {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "rebuildDirectLines");
+    int people = 0;
+    runAtomically([&]() {
+        // Worked out in a scratch table and copied over where different,
+        // so the PersonLine triggers only pass on real changes
+        connector->executeCommand(R"(
+            CREATE TEMP TABLE IF NOT EXISTS LineRow (
+                person_id TEXT PRIMARY KEY,
+                father_id TEXT,
+                mother_id TEXT,
+                paternal_line TEXT NOT NULL,
+                maternal_line TEXT NOT NULL
+            ) WITHOUT ROWID
+        )");
+        connector->executeCommand("CREATE INDEX IF NOT EXISTS temp.idx_line_row_father ON LineRow(father_id)");
+        connector->executeCommand("CREATE INDEX IF NOT EXISTS temp.idx_line_row_mother ON LineRow(mother_id)");
+        connector->executeCommand("DELETE FROM LineRow");
+        const std::string insert = R"(
+            INSERT INTO LineRow (person_id, father_id, mother_id, paternal_line, maternal_line)
+            VALUES (?, NULLIF(?, ''), NULLIF(?, ''), ?, ?)
+        )";
+        if (!isSharded()) {
+            connector->executeCommand(R"(
+                INSERT INTO LineRow (person_id, father_id, mother_id, paternal_line, maternal_line)
+                SELECT child, father, mother, child, child FROM (
+                    SELECT r.child_id AS child,
+                           MIN(CASE WHEN p.gender = 'M' THEN p.person_id END) AS father,
+                           MIN(CASE WHEN p.gender = 'F' THEN p.person_id END) AS mother
+                    FROM ParentLink r JOIN Person p ON p.person_id = r.parent_id
+                    GROUP BY r.child_id
+                )
+                WHERE father IS NOT NULL OR mother IS NOT NULL
+            )");
+        } else {
+            std::map<std::string, std::string> genders;
+            for (const auto& person : getAllPeople()) {
+                genders[person.getId()] = person.getGender();
+            }
+            std::map<std::string, std::pair<std::string, std::string>> parents;
+            for (const auto& relationship : getAllRelationships()) {
+                if (relationship.getType() != RelationType::PARENT_CHILD) continue;
+                auto gender = genders.find(relationship.getPerson1Id());
+                if (gender == genders.end() || (gender->second != "M" && gender->second != "F")) continue;
+                auto& entry = parents[relationship.getPerson2Id()];
+                std::string& slot = gender->second == "M" ? entry.first : entry.second;
+                if (slot.empty() || relationship.getPerson1Id() < slot) {
+                    slot = relationship.getPerson1Id();
+                }
+            }
+            for (const auto& entry : parents) {
+                connector->executeCommand(insert, {entry.first, entry.second.first, entry.second.second,
+                                                   entry.first, entry.first});
+            }
+        }
+
+        // Each line from its founders down: founders are parents without
+        // a parent of their own on that line
+        connector->executeCommand(
+            "CREATE TEMP TABLE IF NOT EXISTS LineFounder (person_id TEXT PRIMARY KEY, founder TEXT NOT NULL)");
+        for (DirectLine line : {DirectLine::PATERNAL, DirectLine::MATERNAL}) {
+            const std::string parent = parentColumn(line);
+            const std::string column = lineColumn(line);
+            connector->executeCommand("DELETE FROM LineFounder");
+            connector->executeCommand(R"(
+                INSERT INTO LineFounder (person_id, founder)
+                WITH RECURSIVE line(person_id, founder) AS (
+                    SELECT DISTINCT f.)" + parent + ", f." + parent + R"( FROM LineRow f
+                    WHERE f.)" + parent + R"( IS NOT NULL AND NOT EXISTS (
+                        SELECT 1 FROM LineRow x
+                        WHERE x.person_id = f.)" + parent + " AND x." + parent + R"( IS NOT NULL)
+                    UNION
+                    SELECT l.person_id, line.founder FROM line
+                    JOIN LineRow l ON l.)" + parent + R"( = line.person_id
+                )
+                SELECT person_id, founder FROM line
+            )");
+            connector->executeCommand(R"(
+                UPDATE LineRow SET )" + column + R"( = f.founder
+                FROM LineFounder f WHERE f.person_id = LineRow.person_id
+            )");
+        }
+        connector->executeCommand("DELETE FROM LineFounder");
+
+        connector->executeCommand("DELETE FROM PersonLine WHERE person_id NOT IN (SELECT person_id FROM LineRow)");
+        connector->executeCommand(R"(
+            INSERT INTO PersonLine (person_id, father_id, mother_id, paternal_line, maternal_line)
+            SELECT person_id, father_id, mother_id, paternal_line, maternal_line FROM LineRow WHERE 1
+            ON CONFLICT (person_id) DO UPDATE SET
+                father_id = excluded.father_id, mother_id = excluded.mother_id,
+                paternal_line = excluded.paternal_line, maternal_line = excluded.maternal_line
+            WHERE father_id IS NOT excluded.father_id OR mother_id IS NOT excluded.mother_id
+               OR paternal_line IS NOT excluded.paternal_line OR maternal_line IS NOT excluded.maternal_line
+        )");
+        connector->executeCommand("DELETE FROM LineRow");
+
+        auto rows = connector->executeQuery("SELECT COUNT(*) AS n FROM PersonLine");
+        people = rows.empty() ? 0 : std::stoi(rows[0].at("n"));
+        return true;
+    });
+    return people;
+}
+
+// Trees stored before direct lines were kept get theirs on first open
+int DatabaseManager::backfillDirectLines() {
+    const std::string step = "direct_lines";
+    if (isMigrated(step)) {
+        return 0;
+    }
+    int lines = connector->executeQuery("SELECT 1 FROM ParentLink LIMIT 1").empty() ? 0 : rebuildDirectLines();
+    return lines >= 0 && markMigrated(step) ? lines : -1;
+}
+
+std::vector<Person> DatabaseManager::getPartners(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getPartners");
+    return queryLine(R"(
+        WITH line(person_id, step) AS (
+            SELECT partner2_id, 0 FROM Family WHERE partner1_id = ?1 AND partner2_id <> ''
+            UNION
+            SELECT partner1_id, 0 FROM Family WHERE partner2_id = ?1 AND partner2_id <> ''
+        )
+    )", {personId});
+}
+
+std::vector<FamilyUnit> DatabaseManager::getFamilies(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getFamilies");
+    // The partial partner2 index needs its condition spelled out
+    return queryFamilies("f.partner1_id = ?1 OR (f.partner2_id = ?1 AND f.partner2_id <> '')", {personId});
+}
+
+std::optional<FamilyUnit> DatabaseManager::getParentFamily(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getParentFamily");
+    auto families = queryFamilies("f.family_id = (SELECT family_id FROM FamilyChild WHERE child_id = ?1)",
+                                  {personId});
+    if (families.empty()) {
+        return std::nullopt;
+    }
+    return families.front();
+}
+
+// Families matching whereSql over Family f, by partners
+std::vector<FamilyUnit> DatabaseManager::queryFamilies(const std::string& whereSql,
+                                                       const std::vector<std::string>& params) {
+    std::vector<FamilyUnit> families;
+    std::string current;
+    for (const auto& row : connector->executeQuery(R"(
+             SELECT f.family_id, f.partner1_id, f.partner2_id, f.married, c.child_id
+             FROM Family f LEFT JOIN FamilyChild c ON c.family_id = f.family_id
+             WHERE )" + whereSql + R"(
+             ORDER BY f.partner1_id, f.partner2_id, c.child_id
+         )", params)) {
+        if (families.empty() || row.at("family_id") != current) {
+            current = row.at("family_id");
+            FamilyUnit family;
+            family.partner1Id = row.at("partner1_id");
+            family.partner2Id = row.at("partner2_id");
+            family.married = row.at("married") == "1";
+            families.push_back(family);
+        }
+        if (!row.at("child_id").empty()) {
+            families.back().childIds.push_back(row.at("child_id"));
+        }
+    }
+    return families;
+}
+
+bool DatabaseManager::refreshCouple(const std::string& person1Id, const std::string& person2Id) {
+    // Either partner's file holds every relationship between them
+    auto rows = connectorFor(person1Id).executeQuery(R"(
+        SELECT COUNT(*) AS marriages, COALESCE(MIN(COALESCE(end_date, '') <> ''), 0) AS ended
+        FROM Relationship
+        WHERE relationship_type = ?3
+          AND ((person1_id = ?1 AND person2_id = ?2) OR (person1_id = ?2 AND person2_id = ?1))
+    )", {person1Id, person2Id, Relationship::relationTypeToString(RelationType::SPOUSE)});
+    bool married = !rows.empty() && rows[0].at("marriages") != "0";
+    return setCouple(person1Id, person2Id, married, married && rows[0].at("ended") == "1");
+}
+
+// Marks the couple's family married, adding it when missing, or
+// unmarried, dropping it when they have no children together. A married
+// couple's family has ended once every marriage between them has.
+bool DatabaseManager::setCouple(const std::string& person1Id, const std::string& person2Id, bool married,
+                                bool ended) {
+    if (person1Id == person2Id) {
+        return true;
+    }
+    const auto& partners = std::minmax(person1Id, person2Id);
+    if (married) {
+        return connector->executeCommand(R"(
+            INSERT INTO Family (partner1_id, partner2_id, married, ended) VALUES (?1, ?2, 1, ?3)
+            ON CONFLICT (partner1_id, partner2_id) DO UPDATE
+            SET ended = CASE WHEN married = 1 THEN ended AND excluded.ended ELSE excluded.ended END,
+                married = 1
+        )", {partners.first, partners.second, ended ? "1" : "0"});
+    }
+    return connector->executeCommand(
+               "UPDATE Family SET married = 0, ended = 0 WHERE partner1_id = ? AND partner2_id = ?",
+               {partners.first, partners.second}) &&
+           connector->executeCommand(R"(
+               DELETE FROM Family
+               WHERE partner1_id = ? AND partner2_id = ?
+                 AND NOT EXISTS (SELECT 1 FROM FamilyChild c WHERE c.family_id = Family.family_id)
+           )", {partners.first, partners.second});
+}
+
+bool DatabaseManager::isMigrated(const std::string& step) {
+    return !connector->executeQuery("SELECT 1 FROM TreeSettings WHERE key = ?", {"migrated:" + step}).empty();
+}
+
+bool DatabaseManager::markMigrated(const std::string& step) {
+    return connector->executeCommand("INSERT OR REPLACE INTO TreeSettings (key, value) VALUES (?, '1')",
+                                     {"migrated:" + step});
+}
+
+// Files written before families stored parent links keep them as
+// Parent-Child relationships, with families derived from them; the links
+// move into the families, and the couples are recomputed, once
+int DatabaseManager::migrateParentLinks() {
+    const std::string step = "parent_links";
+    if (isMigrated(step)) {
+        return 0;
+    }
+    const std::string parentChild = Relationship::relationTypeToString(RelationType::PARENT_CHILD);
+    std::vector<std::pair<std::string, std::string>> links;
+    std::set<std::pair<std::string, std::string>> seen;
+    std::set<std::pair<std::string, std::string>> couples;
+    for (auto* shard : allConnectors()) {
+        for (const auto& row : shard->executeQuery(R"(
+                 SELECT person1_id, person2_id, relationship_type FROM Relationship
+                 WHERE relationship_type IN (?, ?) ORDER BY rowid
+             )", {parentChild, Relationship::relationTypeToString(RelationType::SPOUSE)})) {
+            std::pair<std::string, std::string> pair = {row.at("person1_id"), row.at("person2_id")};
+            if (row.at("relationship_type") != parentChild) {
+                couples.insert(std::minmax(pair.first, pair.second));
+            } else if (seen.insert(pair).second) {
+                links.push_back(pair);
+            }
+        }
+    }
+
+    bool ok = runAtomically([&]() {
+        if (!links.empty() || !couples.empty()) {
+            if (!connector->executeCommand("DELETE FROM FamilyChild") ||
+                !connector->executeCommand("DELETE FROM Family")) {
+                return false;
+            }
+            for (const auto& link : links) {
+                if (!connector->executeCommand("INSERT INTO ParentLink (parent_id, child_id) VALUES (?, ?)",
+                                               {link.first, link.second})) {
+                    return false;
+                }
+            }
+            for (const auto& couple : couples) {
+                if (!refreshCouple(couple.first, couple.second)) {
+                    return false;
+                }
+            }
+            for (auto* shard : allConnectors()) {
+                if (!shard->executeCommand("DELETE FROM Relationship WHERE relationship_type = ?", {parentChild})) {
+                    return false;
+                }
+            }
+        }
+        return markMigrated(step);
+    });
+    return ok ? static_cast<int>(links.size()) : -1;
+}
+
+std::vector<Person> DatabaseManager::getParents(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getParents");
+    return queryLine("WITH line(person_id, step) AS (SELECT parent_id, 0 FROM ParentLink WHERE child_id = ?)",
+                     {personId});
+}
+
+std::vector<Person> DatabaseManager::getChildren(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getChildren");
+    return queryLine("WITH line(person_id, step) AS (SELECT child_id, 0 FROM ParentLink WHERE parent_id = ?)",
+                     {personId});
+}
+
+std::optional<Person> DatabaseManager::getSpouse(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getSpouse");
+    auto spouses = queryLine(R"(
+        WITH line(person_id, step) AS (
+            SELECT partner2_id, 0 FROM Family
+            WHERE partner1_id = ?1 AND partner2_id <> '' AND married = 1 AND ended = 0
+            UNION
+            SELECT partner1_id, 0 FROM Family
+            WHERE partner2_id = ?1 AND partner2_id <> '' AND married = 1 AND ended = 0
+        )
+    )", {personId});
+    if (spouses.empty()) {
+        return std::nullopt;
+    }
+    return spouses.front();
+}
+
+std::vector<Person> DatabaseManager::getSiblings(const std::string& personId, SiblingKind kind) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getSiblings");
+    // Children in any family of one of the person's parents; full siblings
+    // are in one of the person's own families. Each partner test is its
+    // own term so each is an index lookup.
+    const char* having = kind == SiblingKind::FULL ? " HAVING MAX(c.family_id = own.family_id) = 1"
+                       : kind == SiblingKind::HALF ? " HAVING MAX(c.family_id = own.family_id) = 0"
+                       : "";
+    return queryLine(std::string(R"(
+        WITH line(person_id, step) AS (
+            SELECT c.child_id, 0 FROM FamilyChild own
+            JOIN Family p ON p.family_id = own.family_id
+            JOIN Family f ON f.partner1_id = p.partner1_id OR f.partner1_id = p.partner2_id
+                          OR (f.partner2_id = p.partner1_id AND f.partner2_id <> '')
+                          OR (f.partner2_id = p.partner2_id AND f.partner2_id <> '')
+            JOIN FamilyChild c ON c.family_id = f.family_id
+            WHERE own.child_id = ?1 AND c.child_id <> ?1
+            GROUP BY c.child_id)") + having + R"(
+        )
+    )", {personId});
+}
+
+// Generation labels are compared as (hops, generation): fewest links from
+// the root first, then the lowest generation. Links are read lazily and
+// labels cached, so an update touches only the people it relabels and
+// their relatives.
+struct DatabaseManager::GenerationUpdate {
+    using Label = std::pair<int, int>;
+    using Step = std::pair<std::string, int>;  // relative, their generation minus ours
+    using Entry = std::pair<Label, std::string>;
+
+    DatabaseManager& db;
+    std::string root;
+    bool stored = true;  // labels not yet seen are read from PersonGeneration
+    std::unordered_map<std::string, std::vector<Step>> steps;
+    std::unordered_map<std::string, std::optional<Label>> labels;
+    std::set<std::string> changed;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pending;
+
+    explicit GenerationUpdate(DatabaseManager& db) : db(db), root(db.getRootPerson()) {}
+
+    void load(const std::vector<Step>& people) {
+        std::vector<std::string> missing;
+        for (const auto& step : people) {
+            if (labels.emplace(step.first, std::nullopt).second) {
+                missing.push_back(step.first);
+            }
+        }
+        if (missing.empty() || !stored) {
+            return;
+        }
+        // In batches, within SQLite's limit on bound parameters
+        const size_t batch = 500;
+        for (size_t from = 0; from < missing.size(); from += batch) {
+            std::vector<std::string> ids(missing.begin() + from,
+                                         missing.begin() + std::min(missing.size(), from + batch));
+            for (const auto& row : db.connector->executeQuery(
+                     "SELECT person_id, hops, generation FROM PersonGeneration WHERE hops IS NOT NULL AND person_id IN (" +
+                     placeholders(ids.size()) + ")", ids)) {
+                labels[row.at("person_id")] = Label(std::stoi(row.at("hops")), std::stoi(row.at("generation")));
+            }
+        }
+    }
+
+    std::optional<Label> labelOf(const std::string& id) {
+        load({{id, 0}});
+        return labels[id];
+    }
+
+    const std::vector<Step>& stepsOf(const std::string& id) {
+        auto found = steps.find(id);
+        if (found != steps.end()) {
+            return found->second;
+        }
+        std::vector<Step>& relatives = steps[id];
+        for (const auto& relationship : db.getRelationshipsForPerson(id)) {
+            bool first = relationship.getPerson1Id() == id;
+            const std::string& other = first ? relationship.getPerson2Id() : relationship.getPerson1Id();
+            if (other != id) {
+                int difference = relationship.getType() != RelationType::PARENT_CHILD ? 0 : first ? 1 : -1;
+                relatives.emplace_back(other, difference);
+            }
+        }
+        load(relatives);
+        return relatives;
+    }
+
+    void set(const std::string& id, const std::optional<Label>& label) {
+        labels[id] = label;
+        changed.insert(id);
+    }
+
+    void offer(const std::string& id, const Label& label) {
+        if (id == root) {
+            return;
+        }
+        auto current = labelOf(id);
+        if (!current || label < *current) {
+            set(id, label);
+            pending.push({label, id});
+        }
+    }
+
+    // Dijkstra from the offered labels
+    void propagate() {
+        while (!pending.empty()) {
+            Entry entry = pending.top();
+            pending.pop();
+            if (labels[entry.second] != entry.first) {
+                continue;  // superseded
+            }
+            for (const auto& step : stepsOf(entry.second)) {
+                offer(step.first, {entry.first.first + 1, entry.first.second + step.second});
+            }
+        }
+    }
+
+    // After links of these people were removed: people whose label no
+    // longer comes from a relative lose it, and so do those whose label
+    // came only through them (in label order, so every possible source
+    // is settled first); the lost are then labelled from their relatives
+    // that kept theirs
+    void repair(const std::vector<std::string>& people) {
+        std::set<std::string> lost;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> suspects;
+        std::vector<Step> start;
+        for (const auto& id : people) {
+            start.emplace_back(id, 0);
+        }
+        load(start);
+        for (const auto& id : people) {
+            if (auto label = labels[id]) {
+                suspects.push({*label, id});
+            }
+        }
+        while (!suspects.empty()) {
+            Entry entry = suspects.top();
+            suspects.pop();
+            if (entry.second == root || lost.count(entry.second)) {
+                continue;
+            }
+            const auto& relatives = stepsOf(entry.second);
+            bool supported = std::any_of(relatives.begin(), relatives.end(), [&](const Step& step) {
+                auto from = labels[step.first];
+                return !lost.count(step.first) && from &&
+                       Label(from->first + 1, from->second - step.second) == entry.first;
+            });
+            if (supported) {
+                continue;
+            }
+            lost.insert(entry.second);
+            for (const auto& step : relatives) {
+                auto to = labels[step.first];
+                if (to && *to == Label(entry.first.first + 1, entry.first.second + step.second)) {
+                    suspects.push({*to, step.first});
+                }
+            }
+        }
+
+        for (const auto& id : lost) {
+            set(id, std::nullopt);
+        }
+        for (const auto& id : lost) {
+            for (const auto& step : stepsOf(id)) {
+                auto from = labels[step.first];
+                if (from && !lost.count(step.first)) {
+                    offer(id, {from->first + 1, from->second - step.second});
+                }
+            }
+        }
+        propagate();
+    }
+
+    bool write() {
+        for (const auto& id : changed) {
+            const auto& label = labels[id];
+            if (!db.connector->executeCommand(
+                    "UPDATE PersonGeneration SET hops = NULLIF(?, ''), generation = NULLIF(?, '') WHERE person_id = ?",
+                    {label ? std::to_string(label->first) : "", label ? std::to_string(label->second) : "", id})) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+bool DatabaseManager::setRootPerson(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "setRootPerson");
+    return runAtomically([&]() {
+        bool ok = personId.empty()
+            ? connector->executeCommand("DELETE FROM TreeSettings WHERE key = 'root_person'")
+            : connector->executeCommand(R"(
+                  INSERT INTO TreeSettings (key, value) VALUES ('root_person', ?)
+                  ON CONFLICT (key) DO UPDATE SET value = excluded.value
+              )", {personId});
+        {
+            std::lock_guard<std::mutex> lock(rootMutex);
+            rootPerson = personId;
+        }
+        // Everyone connected to either root is relabelled
+        return ok && rebuildGenerations() >= 0;
+    });
+}
+
+// Read once and kept, since every relationship change needs it
+std::string DatabaseManager::getRootPerson() {
+    std::lock_guard<std::mutex> lock(rootMutex);
+    if (!rootPerson) {
+        auto rows = connector->executeQuery("SELECT value FROM TreeSettings WHERE key = 'root_person'");
+        rootPerson = rows.empty() ? "" : rows[0].at("value");
+    }
+    return *rootPerson;
+}
+
+void DatabaseManager::forgetRootPerson() {
+    std::lock_guard<std::mutex> lock(rootMutex);
+    rootPerson.reset();
+}
+
+std::optional<int> DatabaseManager::getGeneration(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getGeneration");
+    auto rows = connector->executeQuery("SELECT generation FROM PersonGeneration WHERE person_id = ?", {personId});
+    if (rows.empty() || rows[0].at("generation").empty()) {
+        return std::nullopt;
+    }
+    return std::stoi(rows[0].at("generation"));
+}
+
+int DatabaseManager::getDepth(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getDepth");
+    auto rows = connector->executeQuery("SELECT depth FROM PersonGeneration WHERE person_id = ?", {personId});
+    return rows.empty() ? -1 : std::stoi(rows[0].at("depth"));
+}
+
+std::vector<Person> DatabaseManager::getPeopleInGeneration(int generation) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getPeopleInGeneration");
+    return queryLine(R"(
+        WITH line(person_id, step) AS (
+            SELECT person_id, 0 FROM PersonGeneration WHERE generation = CAST(? AS INTEGER)
+        )
+    )", {std::to_string(generation)});
+}
+
+std::vector<Person> DatabaseManager::getPeopleAtDepth(int depth) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getPeopleAtDepth");
+    return queryLine(R"(
+        WITH line(person_id, step) AS (
+            SELECT person_id, 0 FROM PersonGeneration WHERE depth = CAST(? AS INTEGER)
+        )
+    )", {std::to_string(depth)});
+}
+
+std::vector<Person> DatabaseManager::getLineageInGeneration(const std::string& personId, bool ancestors,
+                                                            int generation, GenerationOrigin origin) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getLineageInGeneration");
+    // The generation index picks the slice; the walk only confirms who in
+    // it is related. Generations need not fall by one per parent (a
+    // parent can be reached from the root along a shorter path than
+    // their child), so the walk is not cut short.
+    const std::string base = origin == GenerationOrigin::PERSON
+        ? "(SELECT generation FROM PersonGeneration WHERE person_id = ?1)"
+        : "0";
+    return queryLine(R"(
+        WITH RECURSIVE walk(person_id) AS (
+            SELECT ?1
+            UNION
+            )" + parentLinkSteps("walk", ancestors) + R"(
+        ),
+        line(person_id, step) AS (
+            SELECT person_id, 0 FROM PersonGeneration
+            WHERE generation = CAST(?2 AS INTEGER) + )" + base + R"(
+              AND person_id <> ?1 AND person_id IN (SELECT person_id FROM walk)
+        )
+    )", {personId, std::to_string(generation)});
+}
+
+bool DatabaseManager::linkGenerations(const std::string& person1Id, const std::string& person2Id, int difference) {
+    return linkGenerations({{person1Id, person2Id, difference}});
+}
+
+// Each new link offers either end a label from the other; the labels
+// then spread from there together
+bool DatabaseManager::linkGenerations(const std::vector<GenerationLink>& links) {
+    GenerationUpdate update(*this);
+    if (update.root.empty()) {
+        return true;
+    }
+    std::vector<GenerationUpdate::Step> ends;
+    for (const auto& link : links) {
+        ends.emplace_back(link.person1Id, 0);
+        ends.emplace_back(link.person2Id, 0);
+    }
+    update.load(ends);
+    for (const auto& link : links) {
+        auto first = update.labels[link.person1Id];
+        auto second = update.labels[link.person2Id];
+        if (first) {
+            update.offer(link.person2Id, {first->first + 1, first->second + link.difference});
+        }
+        if (second) {
+            update.offer(link.person1Id, {second->first + 1, second->second - link.difference});
+        }
+    }
+    update.propagate();
+    return update.write();
+}
+
+bool DatabaseManager::unlinkGenerations(const std::vector<std::string>& people) {
+    GenerationUpdate update(*this);
+    if (update.root.empty()) {
+        return true;
+    }
+    update.repair(people);
+    return update.write();
+}
+
+int DatabaseManager::rebuildGenerations() {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "rebuildGenerations");
+    GenerationUpdate update(*this);
+    update.stored = false;
+    std::vector<std::string> people;
+    for (auto* shard : allConnectors()) {
+        for (const auto& row : shard->executeQuery("SELECT person_id FROM Person")) {
+            people.push_back(row.at("person_id"));
+            update.steps[people.back()];
+        }
+    }
+
+    // Depths in topological order; people on a parent-child cycle keep the
+    // depth reached before it
+    std::unordered_map<std::string, std::vector<std::string>> children;
+    std::unordered_map<std::string, int> parentsLeft;
+    for (const auto& relationship : getAllRelationships()) {
+        const std::string& first = relationship.getPerson1Id();
+        const std::string& second = relationship.getPerson2Id();
+        if (first == second || !update.steps.count(first) || !update.steps.count(second)) {
+            continue;
+        }
+        bool parentChild = relationship.getType() == RelationType::PARENT_CHILD;
+        update.steps[first].emplace_back(second, parentChild ? 1 : 0);
+        update.steps[second].emplace_back(first, parentChild ? -1 : 0);
+        if (parentChild) {
+            children[first].push_back(second);
+            parentsLeft[second]++;
+        }
+    }
+    std::unordered_map<std::string, int> depths;
+    std::deque<std::string> ready;
+    for (const auto& id : people) {
+        if (!parentsLeft.count(id)) {
+            ready.push_back(id);
+        }
+    }
+    while (!ready.empty()) {
+        std::string id = ready.front();
+        ready.pop_front();
+        for (const auto& child : children[id]) {
+            depths[child] = std::max(depths[child], depths[id] + 1);
+            if (--parentsLeft[child] == 0) {
+                ready.push_back(child);
+            }
+        }
+    }
+
+    if (update.steps.count(update.root)) {
+        update.labels[update.root] = GenerationUpdate::Label(0, 0);
+        update.pending.push({{0, 0}, update.root});
+        update.propagate();
+    }
+
+    int connected = 0;
+    bool ok = runAtomically([&]() {
+        if (!connector->executeCommand("DELETE FROM PersonGeneration")) {
+            return false;
+        }
+        for (const auto& id : people) {
+            auto label = update.labels.count(id) ? update.labels[id] : std::nullopt;
+            connected += label ? 1 : 0;
+            if (!connector->executeCommand(R"(
+                    INSERT INTO PersonGeneration (person_id, depth, hops, generation)
+                    VALUES (?, ?, NULLIF(?, ''), NULLIF(?, ''))
+                )", {id, std::to_string(depths[id]), label ? std::to_string(label->first) : "",
+                     label ? std::to_string(label->second) : ""})) {
+                return false;
+            }
+        }
+        return true;
+    });
+    return ok ? connected : -1;
+}
+
+// Trees stored before generations were kept get them on first open
+int DatabaseManager::backfillGenerations() {
+    const std::string step = "generations";
+    if (isMigrated(step)) {
+        return 0;
+    }
+    int people = 0;
+    for (auto* shard : allConnectors()) {
+        if (!shard->executeQuery("SELECT 1 FROM Person LIMIT 1").empty()) {
+            people = rebuildGenerations();
+            break;
+        }
+    }
+    return people >= 0 && markMigrated(step) ? people : -1;
+}
+
+std::string DatabaseManager::placeId(SQLiteConnector& target, const std::string& place) {
+    std::vector<std::string> parts = placeParts(place);
+    if (parts.empty()) {
+        return "";
+    }
+    const std::string lookup = "SELECT place_id FROM Place WHERE full_name = ?";
+    std::string fullName = joinPlaceParts(parts.begin(), parts.end());
+    auto rows = target.executeQuery(lookup, {fullName});
+    if (!rows.empty()) {
+        return rows[0].at("place_id");
+    }
+
+    // New place: the places containing it first, outermost last
+    std::string parentId = placeId(target, joinPlaceParts(parts.begin() + 1, parts.end()));
+    if (!target.executeCommand("INSERT INTO Place (name, parent_id, full_name) VALUES (?, NULLIF(?, ''), ?)",
+                               {parts.front(), parentId, fullName})) {
+        throw std::runtime_error("Cannot add place: " + fullName);
+    }
+    std::string id = target.executeQuery(lookup, {fullName}).at(0).at("place_id");
+    target.executeCommand(R"(
+        INSERT INTO PlaceAncestor (place_id, ancestor_id)
+        SELECT ?, ? UNION ALL
+        SELECT ?, ancestor_id FROM PlaceAncestor WHERE place_id = ?
+    )", {id, id, id, parentId});
+    return id;
+}
+
+int DatabaseManager::normalizePlaces(SQLiteConnector& target) {
+    auto places = target.executeQuery(R"(
+        SELECT birth_place AS place FROM Person WHERE birth_place <> ''
+        UNION
+        SELECT death_place FROM Person WHERE death_place <> ''
+    )");
+    if (places.empty()) {
+        return 0;
+    }
+
+    target.beginTransaction();
+    try {
+        target.executeCommand(
+            "CREATE TEMP TABLE IF NOT EXISTS PlaceText (text TEXT PRIMARY KEY, place_id INTEGER)");
+        target.executeCommand("DELETE FROM PlaceText");
+        for (const auto& row : places) {
+            target.executeCommand("INSERT INTO PlaceText (text, place_id) VALUES (?, NULLIF(?, ''))",
+                                  {row.at("place"), placeId(target, row.at("place"))});
+        }
+        // The PlaceCount triggers count each person as the IDs are set
+        target.executeCommand(R"(
+            UPDATE Person
+            SET birth_place_id = (SELECT place_id FROM PlaceText WHERE text = Person.birth_place),
+                birth_place = NULL
+            WHERE birth_place <> ''
+        )");
+        target.executeCommand(R"(
+            UPDATE Person
+            SET death_place_id = (SELECT place_id FROM PlaceText WHERE text = Person.death_place),
+                death_place = NULL
+            WHERE death_place <> ''
+        )");
+        target.executeCommand("DELETE FROM PlaceText");
+        target.commit();
+    } catch (...) {
+        target.rollback();
+        throw;
+    }
+    return static_cast<int>(places.size());
+}
+
+int DatabaseManager::backfillPlaces() {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "backfillPlaces");
+    int places = 0;
+    for (auto* shard : allConnectors()) {
+        places += normalizePlaces(*shard);
+    }
+    return places;
+}
+
+std::vector<PlaceCount> DatabaseManager::getPlaceCounts(const std::string& place) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "getPlaceCounts");
+    std::string sql = R"(
+        SELECT p.full_name AS place, c.decade,
+               SUM(CASE c.event WHEN 'B' THEN c.people ELSE 0 END) AS births,
+               SUM(CASE c.event WHEN 'D' THEN c.people ELSE 0 END) AS deaths
+        FROM PlaceCount c JOIN Place p ON p.place_id = c.place_id
+        WHERE c.people > 0
+    )";
+    std::vector<std::string> params;
+    std::vector<std::string> parts = placeParts(place);
+    if (!parts.empty()) {
+        sql += R"( AND c.place_id IN (
+            SELECT a.place_id FROM PlaceAncestor a JOIN Place w ON w.place_id = a.ancestor_id
+            WHERE w.full_name = ?))";
+        params.push_back(joinPlaceParts(parts.begin(), parts.end()));
+    }
+    sql += " GROUP BY c.place_id, c.decade";
+
+    // Each shard has its own dictionary; places are matched by name
+    std::map<std::pair<std::string, int>, PlaceCount> counts;
+    for (auto* shard : allConnectors()) {
+        for (const auto& row : shard->executeQuery(sql, params)) {
+            int decade = std::stoi(row.at("decade"));
+            PlaceCount& count = counts[{row.at("place"), decade}];
+            count.place = row.at("place");
+            count.decade = decade;
+            count.births += std::stoi(row.at("births"));
+            count.deaths += std::stoi(row.at("deaths"));
+        }
+    }
+    std::vector<PlaceCount> result;
+    result.reserve(counts.size());
+    for (auto& entry : counts) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+// Sharding
+int DatabaseManager::addShard(const std::string& path, const std::string& surnameFrom,
+                              const std::string& surnameTo) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "addShard");
+    // The new file would not be part of the open transaction
+    if (connector->inTransaction()) {
+        throw std::logic_error("Cannot add a shard inside a transaction");
+    }
+    if (path == mainPath) {
+        throw std::invalid_argument("The main database cannot be its own shard");
+    }
+    if (!connector->executeCommand("INSERT INTO Shard (path, surname_from, surname_to) VALUES (?, ?, ?)",
+                                   {path, surnameFrom, surnameTo})) {
+        throw std::runtime_error("Cannot register shard (already registered?): " + path);
+    }
+
+    ShardInfo info;
+    info.id = std::stoi(connector->executeQuery("SELECT shard_id FROM Shard WHERE path = ?",
+                                                {path}).at(0).at("shard_id"));
+    info.path = path;
+    info.surnameFrom = surnameFrom;
+    info.surnameTo = surnameTo;
+    try {
+        openShard(info);
+    } catch (...) {
+        connector->executeCommand("DELETE FROM Shard WHERE shard_id = ?", {std::to_string(info.id)});
+        throw;
+    }
+
+    // People in the range still stored in the main file move over
+    std::vector<std::string> inRange;
+    for (const auto& row : connector->executeQuery("SELECT person_id, last_name FROM Person")) {
+        if (inSurnameRange(row.at("last_name"), info)) {
+            inRange.push_back(row.at("person_id"));
+        }
+    }
+    bool ok = runAtomically([&]() {
+        for (const auto& id : inRange) {
+            if (!movePerson(id, info.id)) {
+                return false;
+            }
+        }
+        return true;
+    });
+    if (!ok) {
+        throw std::runtime_error("Moving people to shard " + path + " failed");
+    }
+    return static_cast<int>(inRange.size());
+}
+
+int DatabaseManager::moveBranchToShard(const std::string& personId, int shardId, bool includeSpouses) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "moveBranchToShard");
+    shardConnector(shardId);  // validates the ID
+    auto branch = collectBranch(personId, includeSpouses);
+    int moved = 0;
+    bool ok = runAtomically([&]() {
+        for (const auto& id : branch) {
+            if (shardOf(id) == shardId) {
+                continue;
+            }
+            if (!movePerson(id, shardId)) {
+                return false;
+            }
+            moved++;
+        }
+        return true;
+    });
+    return ok ? moved : 0;
+}
+
+std::vector<ShardInfo> DatabaseManager::getShards() const {
+    ShardInfo main;
+    main.path = mainPath;
+    std::vector<ShardInfo> result = {main};
+    for (const auto& shard : shards) {
+        result.push_back(shard.info);
+    }
+    return result;
+}
+
+int DatabaseManager::countPeople(int shardId) {
+    Metrics::Scope scope(Metrics::Layer::DATABASE, "countPeople");
+    auto rows = shardConnector(shardId).executeQuery("SELECT COUNT(*) AS n FROM Person");
+    return rows.empty() ? 0 : std::stoi(rows[0].at("n"));
+}
+
+int DatabaseManager::shardOf(const std::string& personId) {
+    if (!isSharded()) {
+        return 0;
+    }
+    auto rows = connector->executeQuery("SELECT shard_id FROM PersonShard WHERE person_id = ?", {personId});
+    return rows.empty() ? 0 : std::stoi(rows[0].at("shard_id"));
+}
+
+int DatabaseManager::shardForSurname(const std::string& lastName) const {
+    for (const auto& shard : shards) {
+        if (inSurnameRange(lastName, shard.info)) {
+            return shard.info.id;
+        }
+    }
+    return 0;
+}
+
+SQLiteConnector& DatabaseManager::shardConnector(int shardId) {
+    if (shardId == 0) {
+        return *connector;
+    }
+    for (auto& shard : shards) {
+        if (shard.info.id == shardId) {
+            return *shard.connector;
+        }
+    }
+    throw std::out_of_range("Unknown shard: " + std::to_string(shardId));
+}
+
+SQLiteConnector& DatabaseManager::connectorFor(const std::string& personId) {
+    return shardConnector(shardOf(personId));
+}
+
+std::vector<SQLiteConnector*> DatabaseManager::allConnectors() {
+    std::vector<SQLiteConnector*> result = {connector.get()};
+    for (auto& shard : shards) {
+        result.push_back(shard.connector.get());
+    }
+    return result;
+}
+
+void DatabaseManager::openShard(const ShardInfo& info) {
+    Shard shard;
+    shard.info = info;
+    shard.connector = std::make_unique<SQLiteConnector>(info.path);
+    shards.push_back(std::move(shard));
+}
+
+bool DatabaseManager::movePerson(const std::string& personId, int shardId) {
+    int source = shardOf(personId);
+    SQLiteConnector& from = shardConnector(source);
+    SQLiteConnector& to = shardConnector(shardId);
+
+    auto rows = from.executeQuery("SELECT * FROM PersonView WHERE person_id = ?", {personId});
+    if (rows.empty()) {
+        return false;
+    }
+    Person person = createPersonFromRow(rows[0]);
+    // Parent links stay in the main file
+    auto relationships = getRelationshipsForPerson(personId);
+    relationships.erase(std::remove_if(relationships.begin(), relationships.end(), [](const Relationship& r) {
+        return r.getType() == RelationType::PARENT_CHILD;
+    }), relationships.end());
+
+    if (!insertPerson(to, person)) {
+        return false;
+    }
+    for (const auto& relationship : relationships) {
+        if (!insertRelationship(to, relationship, true)) {
+            return false;
+        }
+    }
+
+    from.executeCommand("DELETE FROM PersonPhonetic WHERE person_id = ?", {personId});
+    if (!from.executeCommand("DELETE FROM Person WHERE person_id = ?", {personId})) {
+        return false;
+    }
+    // The source keeps copies still needed by the other endpoint
+    for (const auto& relationship : relationships) {
+        const std::string& other = relationship.getPerson1Id() == personId
+            ? relationship.getPerson2Id() : relationship.getPerson1Id();
+        if (other == personId || shardOf(other) != source) {
+            from.executeCommand("DELETE FROM Relationship WHERE relationship_id = ?", {relationship.getId()});
+        }
+    }
+
+    if (shardId == 0) {
+        return connector->executeCommand("DELETE FROM PersonShard WHERE person_id = ?", {personId});
+    }
+    return connector->executeCommand("INSERT OR REPLACE INTO PersonShard (person_id, shard_id) VALUES (?, ?)",
+                                     {personId, std::to_string(shardId)});
+}
+
+std::vector<std::string> DatabaseManager::collectBranch(const std::string& personId, bool includeSpouses) {
+    std::vector<std::string> branch;
+    if (!getPerson(personId)) {
+        return branch;
+    }
+
+    std::set<std::string> seen = {personId};
+    std::deque<std::string> pending = {personId};
+    while (!pending.empty()) {
+        std::string id = pending.front();
+        pending.pop_front();
+        branch.push_back(id);
+        for (const auto& relationship : getRelationshipsForPerson(id)) {
+            if (relationship.getType() == RelationType::PARENT_CHILD &&
+                relationship.getPerson1Id() == id &&
+                seen.insert(relationship.getPerson2Id()).second) {
+                pending.push_back(relationship.getPerson2Id());
+            }
+        }
+    }
+
+    if (includeSpouses) {
+        size_t members = branch.size();
+        for (size_t i = 0; i < members; i++) {
+            for (const auto& relationship : getRelationshipsForPerson(branch[i])) {
+                if (relationship.getType() != RelationType::SPOUSE) continue;
+                const std::string& other = relationship.getPerson1Id() == branch[i]
+                    ? relationship.getPerson2Id() : relationship.getPerson1Id();
+                if (seen.insert(other).second) {
+                    branch.push_back(other);
+                }
+            }
+        }
+    }
+    return branch;
+}
@@ -1,58 +1,251 @@
 
 
 #include "database/SQLiteConnector.hpp"
+#include "database/SlowQueryLog.hpp"
+#include "utils/Metrics.hpp"
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 #include <iostream>
 
-SQLiteConnector::SQLiteConnector(const std::string& path) : dbPath(path) {
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc) {
-        throw std::runtime_error("Cannot open database: " + std::string(sqlite3_errmsg(db)));
+namespace {
+
+const int BUSY_TIMEOUT_MS = 5000;
+const size_t STATEMENT_CACHE_LIMIT = 256;
+
+bool isInMemoryPath(const std::string& path) {
+    return path.empty() || path == ":memory:" || path.find("mode=memory") != std::string::npos;
+}
+
+// Returns a cached statement to its reusable state when leaving scope
+class StatementReset {
+private:
+    sqlite3_stmt* stmt;
+public:
+    explicit StatementReset(sqlite3_stmt* stmt) : stmt(stmt) {}
+    ~StatementReset() {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+};
+
+// Splits a statement's time into prepare (cache lookup, compile, bind)
+// and step when instrumentation or the slow query log is enabled
+class StatementTimer {
+private:
+    using Clock = std::chrono::steady_clock;
+    bool recordMetrics;
+    bool active;
+    Clock::time_point start;
+    Clock::time_point prepared;
+
+    static uint64_t nanos(Clock::duration duration) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+public:
+    StatementTimer()
+        : recordMetrics(Metrics::enabled()), active(recordMetrics || SlowQueryLog::enabled()) {
+        if (active) start = Clock::now();
+    }
+    void prepareDone() {
+        if (active) prepared = Clock::now();
+    }
+    // Total time of the statement, 0 when not measured
+    uint64_t finish(uint64_t rows, bool cached) {
+        if (!active) {
+            return 0;
+        }
+        Clock::time_point end = Clock::now();
+        if (recordMetrics) {
+            Metrics::recordStatement(nanos(prepared - start), nanos(end - prepared), rows, cached);
+        }
+        return nanos(end - start);
+    }
+};
+
+} // namespace
+
+SQLiteConnector::SQLiteConnector(const std::string& path)
+    : db(nullptr),
+      dbPath(path),
+      useReaderConnections(!isInMemoryPath(path)),
+      transactionOwner(std::thread::id()),
+      transactionDepth(0),
+      readers(std::make_shared<ReaderPool>()) {
+    writer.handle = openConnection(dbPath, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    db = writer.handle;
+    if (useReaderConnections) {
+        // WAL lets the read-only connections run alongside the writer
+        runQuery(writer, "PRAGMA journal_mode=WAL", {});
     }
+    // The upkeep triggers pass changes down a line one generation at a
+    // time; the scratch tables their updates use stay in memory
+    runQuery(writer, "PRAGMA recursive_triggers=ON", {});
+    runQuery(writer, "PRAGMA temp_store=MEMORY", {});
     initializeDatabase();
 }
 
 SQLiteConnector::~SQLiteConnector() {
-    if (db) {
-        sqlite3_close(db);
+    // Readers close with the pool, once no exiting thread holds it
+    readers.reset();
+    closeConnection(writer);
+}
+
+SQLiteConnector::ReaderPool::~ReaderPool() {
+    for (auto& entry : connections) {
+        closeConnection(*entry.second);
     }
 }
 
-bool SQLiteConnector::executeCommand(const std::string& sql, const std::vector<std::string>& params) {
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-    checkError(rc, "Preparing statement");
+thread_local SQLiteConnector::ThreadReaders SQLiteConnector::threadReaders;
+
+SQLiteConnector::ThreadReaders::~ThreadReaders() {
+    for (auto& weak : pools) {
+        auto pool = weak.lock();
+        if (!pool) {
+            continue;
+        }
+        std::unique_ptr<Connection> reader;
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            auto found = pool->connections.find(std::this_thread::get_id());
+            if (found != pool->connections.end()) {
+                reader = std::move(found->second);
+                pool->connections.erase(found);
+            }
+        }
+        if (reader) {
+            closeConnection(*reader);
+        }
+    }
+}
+
+sqlite3* SQLiteConnector::openConnection(const std::string& path, int flags) {
+    sqlite3* handle = nullptr;
+    int rc = sqlite3_open_v2(path.c_str(), &handle, flags | SQLITE_OPEN_FULLMUTEX, nullptr);
+    if (rc != SQLITE_OK) {
+        std::string error = handle ? sqlite3_errmsg(handle) : "out of memory";
+        sqlite3_close(handle);
+        throw std::runtime_error("Cannot open database: " + error);
+    }
+    sqlite3_busy_timeout(handle, BUSY_TIMEOUT_MS);
+    return handle;
+}
+
+void SQLiteConnector::closeConnection(Connection& connection) {
+    for (auto& entry : connection.statements) {
+        sqlite3_finalize(entry.second);
+    }
+    connection.statements.clear();
+    if (connection.handle) {
+        sqlite3_close(connection.handle);
+        connection.handle = nullptr;
+    }
+}
+
+SQLiteConnector::Connection& SQLiteConnector::connectionForRead() {
+    if (!useReaderConnections || transactionOwner.load() == std::this_thread::get_id()) {
+        return writer;
+    }
+
+    std::lock_guard<std::mutex> lock(readers->mutex);
+    auto& reader = readers->connections[std::this_thread::get_id()];
+    if (!reader) {
+        auto opened = std::make_unique<Connection>();
+        opened->handle = openConnection(dbPath, SQLITE_OPEN_READONLY);
+        reader = std::move(opened);
+        auto& pools = threadReaders.pools;
+        pools.erase(std::remove_if(pools.begin(), pools.end(),
+                                   [](const std::weak_ptr<ReaderPool>& pool) { return pool.expired(); }),
+                    pools.end());
+        pools.push_back(readers);
+    }
+    return *reader;
+}
+
+sqlite3_stmt* SQLiteConnector::prepare(Connection& connection,
+                                       const std::string& sql,
+                                       const std::vector<std::string>& params,
+                                       bool* cached) {
+    sqlite3_stmt* stmt = nullptr;
+    auto existing = connection.statements.find(sql);
+    if (cached) {
+        *cached = existing != connection.statements.end();
+    }
+    if (existing != connection.statements.end()) {
+        stmt = existing->second;
+    } else {
+        // Generated SQL (variable-length IN lists) could grow the cache
+        // without bound; start over once it is full
+        if (connection.statements.size() >= STATEMENT_CACHE_LIMIT) {
+            for (auto& entry : connection.statements) {
+                sqlite3_finalize(entry.second);
+            }
+            connection.statements.clear();
+        }
+        int rc = sqlite3_prepare_v2(connection.handle, sql.c_str(), -1, &stmt, nullptr);
+        checkError(connection.handle, rc, "Preparing statement");
+        connection.statements[sql] = stmt;
+    }
 
     // Bind parameters
     for (size_t i = 0; i < params.size(); i++) {
-        rc = sqlite3_bind_text(stmt, i + 1, params[i].c_str(), -1, SQLITE_STATIC);
-        checkError(rc, "Binding parameter");
+        int rc = sqlite3_bind_text(stmt, i + 1, params[i].c_str(), -1, SQLITE_STATIC);
+        if (rc != SQLITE_OK) {
+            sqlite3_clear_bindings(stmt);
+        }
+        checkError(connection.handle, rc, "Binding parameter");
     }
+    return stmt;
+}
 
-    // Execute
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+bool SQLiteConnector::executeCommand(const std::string& sql, const std::vector<std::string>& params) {
+    std::lock_guard<std::recursive_mutex> lock(writerMutex);
+
+    StatementTimer timer;
+    bool cached = false;
+    sqlite3_stmt* stmt = prepare(writer, sql, params, &cached);
+    StatementReset reset(stmt);
+    timer.prepareDone();
 
+    // Execute
+    int rc = sqlite3_step(stmt);
+    timer.finish(0, cached);
     return (rc == SQLITE_DONE);
 }
 
+int SQLiteConnector::changes() {
+    std::lock_guard<std::recursive_mutex> lock(writerMutex);
+    return sqlite3_changes(db);
+}
+
 std::vector<std::map<std::string, std::string>> SQLiteConnector::executeQuery(
     const std::string& sql, 
     const std::vector<std::string>& params
 ) {
-    std::vector<std::map<std::string, std::string>> results;
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-    checkError(rc, "Preparing query");
-
-    // Bind parameters
-    for (size_t i = 0; i < params.size(); i++) {
-        rc = sqlite3_bind_text(stmt, i + 1, params[i].c_str(), -1, SQLITE_STATIC);
-        checkError(rc, "Binding parameter");
+    Connection& connection = connectionForRead();
+    if (&connection == &writer) {
+        std::lock_guard<std::recursive_mutex> lock(writerMutex);
+        return runQuery(connection, sql, params);
     }
+    return runQuery(connection, sql, params);
+}
+
+std::vector<std::map<std::string, std::string>> SQLiteConnector::runQuery(
+    Connection& connection,
+    const std::string& sql,
+    const std::vector<std::string>& params
+) {
+    std::vector<std::map<std::string, std::string>> results;
+    StatementTimer timer;
+    bool cached = false;
+    sqlite3_stmt* stmt = prepare(connection, sql, params, &cached);
+    StatementReset reset(stmt);
+    timer.prepareDone();
 
     // Fetch results
+    int rc;
     while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         std::map<std::string, std::string> row;
         int columns = sqlite3_column_count(stmt);
@@ -66,22 +259,200 @@ std::vector<std::map<std::string, std::string>> SQLiteConnector::executeQuery(
         results.push_back(row);
     }
 
-    sqlite3_finalize(stmt);
+    uint64_t elapsed = timer.finish(results.size(), cached);
+    if (elapsed > 0 && SlowQueryLog::enabled() && elapsed >= SlowQueryLog::thresholdNanos()) {
+        SlowQuery query;
+        query.sql = sql;
+        query.params = params;
+        query.elapsedNanos = elapsed;
+        query.rows = results.size();
+        query.plan = explainQueryPlan(connection.handle, sql);
+        SlowQueryLog::record(query);
+    }
     return results;
 }
 
+std::vector<std::string> SQLiteConnector::explainQueryPlan(sqlite3* handle, const std::string& sql) {
+    // Prepared outside the statement cache: this runs rarely
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, ("EXPLAIN QUERY PLAN " + sql).c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return {"(plan unavailable: " + std::string(sqlite3_errmsg(handle)) + ")"};
+    }
+
+    // Rows are (id, parent, notused, detail); indent children under parents
+    std::vector<std::string> plan;
+    std::map<int, size_t> depth;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int id = sqlite3_column_int(stmt, 0);
+        int parent = sqlite3_column_int(stmt, 1);
+        const char* detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        auto parentDepth = depth.find(parent);
+        size_t level = parentDepth == depth.end() ? 0 : parentDepth->second + 1;
+        depth[id] = level;
+        plan.push_back(std::string(level * 2, ' ') + (detail ? detail : ""));
+    }
+    sqlite3_finalize(stmt);
+    return plan;
+}
+
 void SQLiteConnector::beginTransaction() {
-    executeCommand("BEGIN TRANSACTION");
+    // Held until the matching commit/rollback so other threads cannot
+    // slip statements into this transaction
+    writerMutex.lock();
+    try {
+        if (transactionDepth == 0) {
+            if (!executeCommand("BEGIN IMMEDIATE TRANSACTION")) {
+                throw std::runtime_error("Begin transaction failed: " + std::string(sqlite3_errmsg(db)));
+            }
+            transactionOwner.store(std::this_thread::get_id());
+        } else {
+            executeCommand("SAVEPOINT sp_" + std::to_string(transactionDepth));
+        }
+        transactionDepth++;
+    } catch (...) {
+        writerMutex.unlock();
+        throw;
+    }
 }
 
 void SQLiteConnector::commit() {
-    executeCommand("COMMIT");
+    std::lock_guard<std::recursive_mutex> lock(writerMutex);
+    if (transactionDepth == 0) {
+        return;
+    }
+    transactionDepth--;
+    bool committed;
+    std::string error;
+    if (transactionDepth == 0) {
+        committed = executeCommand("COMMIT");
+        if (!committed) {
+            // Whatever the failure, the transaction is over: undo what is
+            // left of it so the next one starts clean
+            error = sqlite3_errmsg(db);
+            if (!sqlite3_get_autocommit(db)) {
+                executeCommand("ROLLBACK");
+            }
+        }
+        transactionOwner.store(std::thread::id());
+    } else {
+        std::string savepoint = "sp_" + std::to_string(transactionDepth);
+        committed = executeCommand("RELEASE " + savepoint);
+        if (!committed) {
+            error = sqlite3_errmsg(db);
+            executeCommand("ROLLBACK TO " + savepoint);
+            executeCommand("RELEASE " + savepoint);
+        }
+    }
+    writerMutex.unlock();
+    if (!committed) {
+        throw std::runtime_error("Commit failed: " + error);
+    }
 }
 
 void SQLiteConnector::rollback() {
-    executeCommand("ROLLBACK");
+    std::lock_guard<std::recursive_mutex> lock(writerMutex);
+    if (transactionDepth == 0) {
+        return;
+    }
+    transactionDepth--;
+    if (transactionDepth == 0) {
+        executeCommand("ROLLBACK");
+        transactionOwner.store(std::thread::id());
+    } else {
+        std::string savepoint = "sp_" + std::to_string(transactionDepth);
+        executeCommand("ROLLBACK TO " + savepoint);
+        executeCommand("RELEASE " + savepoint);
+    }
+    writerMutex.unlock();
+}
+
+bool SQLiteConnector::inTransaction() const {
+    // Only the owner sees its own depth change, so the pair is consistent
+    // for the calling thread
+    return transactionOwner.load() == std::this_thread::get_id() && transactionDepth.load() > 0;
+}
+
+namespace {
+
+// A trigger adjusting PlaceCount for the people in `rows`: each entry is
+// a row alias (NEW or OLD) and whether its events are added or removed.
+// Only dates starting with a four-digit year are counted.
+std::string placeCountTrigger(const std::string& name, const std::string& event, const std::string& when,
+                              const std::vector<std::pair<std::string, std::string>>& rows) {
+    std::string body;
+    for (const auto& row : rows) {
+        const std::string& alias = row.first;
+        const std::string& sign = row.second;
+        for (const auto& kind : {std::make_pair("B", "birth"), std::make_pair("D", "death")}) {
+            std::string date = alias + ".date_of_" + kind.second;
+            std::string place = alias + "." + kind.second + "_place_id";
+            body += R"(
+                INSERT INTO PlaceCount (place_id, event, decade, people)
+                SELECT ancestor_id, ')" + std::string(kind.first) + "', CAST(substr(" + date +
+                    ", 1, 4) AS INTEGER) / 10 * 10, " + sign + R"(1
+                FROM PlaceAncestor
+                WHERE place_id = )" + place + " AND " + date + R"( GLOB '[0-9][0-9][0-9][0-9]*'
+                ON CONFLICT (place_id, event, decade) DO UPDATE SET people = people )" + sign + " 1;";
+        }
+    }
+    return "CREATE TRIGGER IF NOT EXISTS person_place_count_" + name + " " + event + " " + when +
+           " BEGIN" + body + "\n            END";
+}
+
+// Statements setting the PersonLine rows of the people matching
+// `children` ("= NEW.child_id", or "IN (...)" for several) from their
+// current parents, who may be fewer than before. The lines themselves
+// come from the parents' rows, and the PersonLine triggers pass changes
+// further down. Sharded trees keep these rows in DatabaseManager, as the
+// parents' genders are in the shard files.
+std::string directLineSql(const std::string& children) {
+    return R"(
+                INSERT INTO PersonLine (person_id, father_id, mother_id, paternal_line, maternal_line)
+                SELECT child, father, mother,
+                       COALESCE((SELECT paternal_line FROM PersonLine WHERE person_id = father), father, child),
+                       COALESCE((SELECT maternal_line FROM PersonLine WHERE person_id = mother), mother, child)
+                FROM (SELECT c.child_id AS child,
+                             MIN(CASE WHEN p.gender = 'M' THEN p.person_id END) AS father,
+                             MIN(CASE WHEN p.gender = 'F' THEN p.person_id END) AS mother
+                      FROM FamilyChild c JOIN Family f ON f.family_id = c.family_id
+                      JOIN Person p ON p.person_id IN (f.partner1_id, f.partner2_id)
+                      WHERE c.child_id )" + children + R"(
+                      GROUP BY c.child_id)
+                WHERE (father IS NOT NULL OR mother IS NOT NULL) AND NOT EXISTS (SELECT 1 FROM Shard)
+                ON CONFLICT (person_id) DO UPDATE SET
+                    father_id = excluded.father_id, mother_id = excluded.mother_id,
+                    paternal_line = excluded.paternal_line, maternal_line = excluded.maternal_line
+                WHERE father_id IS NOT excluded.father_id OR mother_id IS NOT excluded.mother_id;
+                DELETE FROM PersonLine
+                WHERE person_id )" + children + R"( AND NOT EXISTS (SELECT 1 FROM Shard) AND NOT EXISTS (
+                    SELECT 1 FROM FamilyChild c JOIN Family f ON f.family_id = c.family_id
+                    JOIN Person p ON p.person_id IN (f.partner1_id, f.partner2_id)
+                    WHERE c.child_id = PersonLine.person_id AND p.gender IN ('M', 'F'));)";
+}
+
+// A statement setting the depth of the people matching `children` from
+// their parents' depths; the PersonGeneration trigger passes changes on
+std::string depthSql(const std::string& children) {
+    return R"(
+                UPDATE PersonGeneration SET depth = (
+                    SELECT COALESCE(MAX(g.depth) + 1, 0)
+                    FROM FamilyChild c JOIN Family f ON f.family_id = c.family_id
+                    JOIN PersonGeneration g ON g.person_id IN (f.partner1_id, f.partner2_id)
+                    WHERE c.child_id = PersonGeneration.person_id)
+                WHERE person_id )" + children + ";";
 }
 
+// The trigger bringing a child's depth and lines up to date after their
+// families changed
+std::string childUpkeepTrigger(const std::string& name, const std::string& event, const std::string& child,
+                               const std::string& when) {
+    return "CREATE TRIGGER IF NOT EXISTS " + name + " " + event + when + " BEGIN" + depthSql("= " + child) +
+           directLineSql("= " + child) + "\n            END";
+}
+
+} // namespace
+
 bool SQLiteConnector::initializeDatabase() {
     // Create tables one by one to better handle errors
     const std::vector<std::string> initQueries = {
@@ -94,8 +465,10 @@ bool SQLiteConnector::initializeDatabase() {
                 gender TEXT CHECK(gender IN ('M', 'F', 'O')),
                 date_of_birth TEXT NOT NULL,
                 date_of_death TEXT,
-                birth_place TEXT,
-                death_place TEXT
+                birth_place TEXT,       -- free text from before the place
+                death_place TEXT,       -- dictionary; moved into Place on open
+                birth_place_id INTEGER REFERENCES Place(place_id),
+                death_place_id INTEGER REFERENCES Place(place_id)
             )
         )",
         
@@ -111,12 +484,408 @@ bool SQLiteConnector::initializeDatabase() {
                 FOREIGN KEY (person1_id) REFERENCES Person(person_id),
                 FOREIGN KEY (person2_id) REFERENCES Person(person_id)
             )
+        )",
+
+        // Phonetic name keys, one row per (algorithm, code) of each name part
+        R"(
+            CREATE TABLE IF NOT EXISTS PersonPhonetic (
+                algorithm TEXT NOT NULL,
+                code TEXT NOT NULL,
+                person_id TEXT NOT NULL,
+                name_part TEXT NOT NULL CHECK(name_part IN ('F', 'L')),
+                PRIMARY KEY (algorithm, code, person_id, name_part)
+            ) WITHOUT ROWID
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_phonetic_person ON PersonPhonetic(person_id)",
+
+        // Relationship lookups go through either endpoint
+        "CREATE INDEX IF NOT EXISTS idx_relationship_person1 ON Relationship(person1_id)",
+        "CREATE INDEX IF NOT EXISTS idx_relationship_person2 ON Relationship(person2_id)",
+
+        // Shard list and routing table; see DatabaseManager. Only the
+        // main file's copies are used.
+        R"(
+            CREATE TABLE IF NOT EXISTS Shard (
+                shard_id INTEGER PRIMARY KEY,
+                path TEXT NOT NULL UNIQUE,
+                surname_from TEXT NOT NULL DEFAULT '',
+                surname_to TEXT NOT NULL DEFAULT ''
+            )
+        )",
+        R"(
+            CREATE TABLE IF NOT EXISTS PersonShard (
+                person_id TEXT PRIMARY KEY,
+                shard_id INTEGER NOT NULL
+            ) WITHOUT ROWID
+        )",
+
+        // Direct lines: each person's father and mother and the founder of
+        // each line, the earliest ancestor reached through fathers only
+        // (paternal) or mothers only (maternal). People without a male or
+        // female parent have no row and found their own lines. Kept by
+        // DatabaseManager; only the main file's copy is used.
+        R"(
+            CREATE TABLE IF NOT EXISTS PersonLine (
+                person_id TEXT PRIMARY KEY,
+                father_id TEXT,
+                mother_id TEXT,
+                paternal_line TEXT NOT NULL,
+                maternal_line TEXT NOT NULL
+            ) WITHOUT ROWID
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_line_father ON PersonLine(father_id)",
+        "CREATE INDEX IF NOT EXISTS idx_line_mother ON PersonLine(mother_id)",
+        "CREATE INDEX IF NOT EXISTS idx_line_paternal ON PersonLine(paternal_line)",
+        "CREATE INDEX IF NOT EXISTS idx_line_maternal ON PersonLine(maternal_line)",
+
+        // Family units (as in GEDCOM): a couple, or a single parent, with
+        // their children. These tables are where parent-child links are
+        // stored; see ParentLink below. Couples joined by a Spouse
+        // relationship are married and have a family even without
+        // children; ended is set once every such relationship has an end
+        // date. partner1_id sorts before partner2_id, which is '' for a
+        // single parent. A child with more than two parents is in several
+        // families. Only the main file's copies are used.
+        R"(
+            CREATE TABLE IF NOT EXISTS Family (
+                family_id INTEGER PRIMARY KEY,
+                partner1_id TEXT NOT NULL,
+                partner2_id TEXT NOT NULL DEFAULT '',
+                married INTEGER NOT NULL DEFAULT 0,
+                ended INTEGER NOT NULL DEFAULT 0,
+                UNIQUE (partner1_id, partner2_id)
+            )
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_family_partner2 ON Family(partner2_id) WHERE partner2_id <> ''",
+        R"(
+            CREATE TABLE IF NOT EXISTS FamilyChild (
+                child_id TEXT NOT NULL,
+                family_id INTEGER NOT NULL,
+                PRIMARY KEY (child_id, family_id)
+            ) WITHOUT ROWID
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_family_child_family ON FamilyChild(family_id)",
+
+        // Generations: depth is the longest run of parents above a person
+        // (0 without parents); generation counts from the root person
+        // (parents -1, children +1, spouses and siblings alike) along the
+        // fewest links, with hops the number of links. People not
+        // connected to the root have no generation. Every person has a
+        // row. Depths are kept by the triggers below, generations by
+        // DatabaseManager; only the main file's copies of this table and
+        // TreeSettings are used.
+        R"(
+            CREATE TABLE IF NOT EXISTS PersonGeneration (
+                person_id TEXT PRIMARY KEY,
+                depth INTEGER NOT NULL DEFAULT 0,
+                hops INTEGER,
+                generation INTEGER
+            ) WITHOUT ROWID
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_generation_depth ON PersonGeneration(depth)",
+        "CREATE INDEX IF NOT EXISTS idx_generation_generation ON PersonGeneration(generation)",
+        R"(
+            CREATE TABLE IF NOT EXISTS TreeSettings (
+                key TEXT PRIMARY KEY,
+                value TEXT NOT NULL
+            ) WITHOUT ROWID
+        )",
+
+        // Identity lookups (same name and birth date) when merging trees
+        R"(
+            CREATE INDEX IF NOT EXISTS idx_person_identity ON Person(
+                last_name COLLATE NOCASE, first_name COLLATE NOCASE, date_of_birth
+            )
+        )"
+    };
+
+    // Place dictionary. A place is stored once and points at the place
+    // containing it ("Salem, Essex, Massachusetts" is inside "Essex,
+    // Massachusetts"); full_name is the text people see. PlaceAncestor
+    // lists each place with itself and everything containing it, and
+    // PlaceCount holds births ('B') and deaths ('D') per place and decade,
+    // counting everyone within the place. The triggers keep the counts in
+    // step with Person, so place reports never scan people.
+    const std::vector<std::string> placeQueries = {
+        R"(
+            CREATE TABLE IF NOT EXISTS Place (
+                place_id INTEGER PRIMARY KEY,
+                name TEXT NOT NULL,
+                parent_id INTEGER REFERENCES Place(place_id),
+                full_name TEXT NOT NULL UNIQUE
+            )
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_place_parent ON Place(parent_id)",
+        R"(
+            CREATE TABLE IF NOT EXISTS PlaceAncestor (
+                place_id INTEGER NOT NULL,
+                ancestor_id INTEGER NOT NULL,
+                PRIMARY KEY (place_id, ancestor_id)
+            ) WITHOUT ROWID
+        )",
+        R"(
+            CREATE TABLE IF NOT EXISTS PlaceCount (
+                place_id INTEGER NOT NULL,
+                event TEXT NOT NULL CHECK(event IN ('B', 'D')),
+                decade INTEGER NOT NULL,
+                people INTEGER NOT NULL,
+                PRIMARY KEY (place_id, event, decade)
+            ) WITHOUT ROWID
+        )",
+        // Finds text left to move into the dictionary without a scan
+        "CREATE INDEX IF NOT EXISTS idx_person_birth_place_text ON Person(birth_place) WHERE birth_place <> ''",
+        "CREATE INDEX IF NOT EXISTS idx_person_death_place_text ON Person(death_place) WHERE death_place <> ''",
+        placeCountTrigger("insert", "AFTER INSERT ON Person", "", {{"NEW", "+"}}),
+        placeCountTrigger("delete", "AFTER DELETE ON Person", "", {{"OLD", "-"}}),
+        placeCountTrigger("update",
+            "AFTER UPDATE OF date_of_birth, date_of_death, birth_place_id, death_place_id ON Person",
+            R"(
+                WHEN OLD.date_of_birth IS NOT NEW.date_of_birth
+                  OR OLD.date_of_death IS NOT NEW.date_of_death
+                  OR OLD.birth_place_id IS NOT NEW.birth_place_id
+                  OR OLD.death_place_id IS NOT NEW.death_place_id
+            )", {{"OLD", "-"}, {"NEW", "+"}}),
+
+        // People with their place names; every read of people goes here
+        R"(
+            CREATE VIEW IF NOT EXISTS PersonView AS
+            SELECT p.person_id, p.first_name, p.last_name, p.gender,
+                   p.date_of_birth, p.date_of_death,
+                   COALESCE(b.full_name, p.birth_place) AS birth_place,
+                   COALESCE(d.full_name, p.death_place) AS death_place
+            FROM Person p
+            LEFT JOIN Place b ON b.place_id = p.birth_place_id
+            LEFT JOIN Place d ON d.place_id = p.death_place_id
+        )"
+    };
+
+    // Parent-child links, one row per parent and child. Writes go through
+    // the view too: a new link moves the child from a single parent's
+    // family into the couple's, and a removed one back, so the family
+    // tables are the only copy. Families without children or a marriage
+    // are dropped as they empty.
+    const std::vector<std::string> familyQueries = {
+        R"(
+            CREATE VIEW IF NOT EXISTS ParentLink AS
+            SELECT f.partner1_id AS parent_id, c.child_id, c.family_id
+            FROM FamilyChild c JOIN Family f ON f.family_id = c.family_id
+            UNION ALL
+            SELECT f.partner2_id, c.child_id, c.family_id
+            FROM FamilyChild c JOIN Family f ON f.family_id = c.family_id
+            WHERE f.partner2_id <> ''
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS parent_link_insert INSTEAD OF INSERT ON ParentLink BEGIN
+                SELECT RAISE(ABORT, 'parent link exists') FROM ParentLink
+                WHERE parent_id = NEW.parent_id AND child_id = NEW.child_id;
+                -- The child's single-parent family becomes a couple's;
+                -- otherwise the parent's own takes the child
+                INSERT OR IGNORE INTO Family (partner1_id, partner2_id)
+                SELECT COALESCE(MIN(f.partner1_id, NEW.parent_id), NEW.parent_id),
+                       COALESCE(MAX(f.partner1_id, NEW.parent_id), '')
+                FROM (SELECT 1) LEFT JOIN Family f ON f.family_id = (
+                    SELECT MIN(c.family_id) FROM FamilyChild c JOIN Family s ON s.family_id = c.family_id
+                    WHERE c.child_id = NEW.child_id AND s.partner2_id = '');
+                UPDATE FamilyChild SET family_id = (
+                    SELECT g.family_id FROM Family f JOIN Family g
+                      ON g.partner1_id = MIN(f.partner1_id, NEW.parent_id)
+                     AND g.partner2_id = MAX(f.partner1_id, NEW.parent_id)
+                    WHERE f.family_id = FamilyChild.family_id)
+                WHERE child_id = NEW.child_id AND family_id = (
+                    SELECT MIN(c.family_id) FROM FamilyChild c JOIN Family f ON f.family_id = c.family_id
+                    WHERE c.child_id = NEW.child_id AND f.partner2_id = '');
+                INSERT INTO FamilyChild (child_id, family_id)
+                SELECT NEW.child_id, family_id FROM Family
+                WHERE partner1_id = NEW.parent_id AND partner2_id = ''
+                  AND NOT EXISTS (SELECT 1 FROM ParentLink
+                                  WHERE parent_id = NEW.parent_id AND child_id = NEW.child_id);
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS parent_link_delete INSTEAD OF DELETE ON ParentLink BEGIN
+                -- A couple's child stays with the other partner. The link
+                -- is looked up again, as an earlier row of the same DELETE
+                -- may have moved the child.
+                INSERT OR IGNORE INTO Family (partner1_id, partner2_id)
+                SELECT CASE WHEN partner1_id = OLD.parent_id THEN partner2_id ELSE partner1_id END, ''
+                FROM Family WHERE partner2_id <> '' AND family_id = (
+                    SELECT family_id FROM ParentLink
+                    WHERE parent_id = OLD.parent_id AND child_id = OLD.child_id);
+                UPDATE FamilyChild SET family_id = (
+                    SELECT g.family_id FROM Family f JOIN Family g
+                      ON g.partner1_id = CASE WHEN f.partner1_id = OLD.parent_id
+                                              THEN f.partner2_id ELSE f.partner1_id END
+                     AND g.partner2_id = ''
+                    WHERE f.family_id = FamilyChild.family_id)
+                WHERE child_id = OLD.child_id
+                  AND family_id = (SELECT family_id FROM ParentLink
+                                   WHERE parent_id = OLD.parent_id AND child_id = OLD.child_id)
+                  AND EXISTS (SELECT 1 FROM Family WHERE family_id = FamilyChild.family_id AND partner2_id <> '');
+                DELETE FROM FamilyChild
+                WHERE child_id = OLD.child_id
+                  AND family_id = (SELECT family_id FROM ParentLink
+                                   WHERE parent_id = OLD.parent_id AND child_id = OLD.child_id);
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS family_child_update AFTER UPDATE OF family_id ON FamilyChild BEGIN
+                DELETE FROM Family
+                WHERE family_id = OLD.family_id AND married = 0
+                  AND NOT EXISTS (SELECT 1 FROM FamilyChild WHERE family_id = OLD.family_id);
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS family_child_delete AFTER DELETE ON FamilyChild BEGIN
+                DELETE FROM Family
+                WHERE family_id = OLD.family_id AND married = 0
+                  AND NOT EXISTS (SELECT 1 FROM FamilyChild WHERE family_id = OLD.family_id);
+            END
+        )"
+    };
+
+    // Direct lines and depths follow the links as they change, one child
+    // at a time, and changes pass down to descendants through the
+    // PersonLine and PersonGeneration triggers (recursive triggers are on
+    // for the writer). Depths stop at 900, short of SQLite's limit on
+    // nested triggers; only a parent-child cycle goes that deep. Deleting
+    // a person from an unsharded tree takes their links, families and
+    // derived rows with them.
+    const std::vector<std::string> upkeepQueries = {
+        // A new link only adds a parent: the child's depth and lines
+        // follow that parent's alone, without regrouping the families
+        R"(
+            CREATE TRIGGER IF NOT EXISTS parent_link_upkeep INSTEAD OF INSERT ON ParentLink BEGIN
+                UPDATE PersonGeneration SET depth = (
+                    SELECT depth + 1 FROM PersonGeneration WHERE person_id = NEW.parent_id)
+                WHERE person_id = NEW.child_id
+                  AND depth < (SELECT depth + 1 FROM PersonGeneration WHERE person_id = NEW.parent_id);
+                INSERT INTO PersonLine (person_id, father_id, mother_id, paternal_line, maternal_line)
+                SELECT NEW.child_id, father, mother,
+                       COALESCE((SELECT paternal_line FROM PersonLine WHERE person_id = father), father, NEW.child_id),
+                       COALESCE((SELECT maternal_line FROM PersonLine WHERE person_id = mother), mother, NEW.child_id)
+                FROM (SELECT CASE WHEN gender = 'M' THEN person_id END AS father,
+                             CASE WHEN gender = 'F' THEN person_id END AS mother
+                      FROM Person WHERE person_id = NEW.parent_id AND gender IN ('M', 'F'))
+                WHERE NOT EXISTS (SELECT 1 FROM Shard)
+                ON CONFLICT (person_id) DO UPDATE SET
+                    father_id = CASE WHEN COALESCE(excluded.father_id < father_id, excluded.father_id IS NOT NULL)
+                                     THEN excluded.father_id ELSE father_id END,
+                    paternal_line = CASE WHEN COALESCE(excluded.father_id < father_id, excluded.father_id IS NOT NULL)
+                                         THEN excluded.paternal_line ELSE paternal_line END,
+                    mother_id = CASE WHEN COALESCE(excluded.mother_id < mother_id, excluded.mother_id IS NOT NULL)
+                                     THEN excluded.mother_id ELSE mother_id END,
+                    maternal_line = CASE WHEN COALESCE(excluded.mother_id < mother_id, excluded.mother_id IS NOT NULL)
+                                         THEN excluded.maternal_line ELSE maternal_line END
+                WHERE COALESCE(excluded.father_id < father_id, excluded.father_id IS NOT NULL)
+                   OR COALESCE(excluded.mother_id < mother_id, excluded.mother_id IS NOT NULL);
+            END
+        )",
+        // Other moves take the child from a couple's family to one
+        // partner's, and deletes take them out of a family
+        childUpkeepTrigger("family_child_upkeep_update", "AFTER UPDATE OF family_id ON FamilyChild", "NEW.child_id",
+                           " WHEN EXISTS (SELECT 1 FROM Family WHERE family_id = NEW.family_id AND partner2_id = '')"),
+        // A deleted person's own rows are already gone
+        childUpkeepTrigger("family_child_upkeep_delete", "AFTER DELETE ON FamilyChild", "OLD.child_id",
+                           " WHEN EXISTS (SELECT 1 FROM PersonGeneration WHERE person_id = OLD.child_id)"),
+        R"(
+            CREATE TRIGGER IF NOT EXISTS person_line_gender AFTER UPDATE OF gender ON Person
+            WHEN OLD.gender IS NOT NEW.gender BEGIN)" +
+            directLineSql("IN (SELECT child_id FROM ParentLink WHERE parent_id = NEW.person_id)") + R"(
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS person_line_insert AFTER INSERT ON PersonLine
+            WHEN EXISTS (SELECT 1 FROM PersonLine WHERE father_id = NEW.person_id)
+              OR EXISTS (SELECT 1 FROM PersonLine WHERE mother_id = NEW.person_id) BEGIN
+                UPDATE PersonLine SET paternal_line = NEW.paternal_line
+                WHERE father_id = NEW.person_id AND paternal_line IS NOT NEW.paternal_line;
+                UPDATE PersonLine SET maternal_line = NEW.maternal_line
+                WHERE mother_id = NEW.person_id AND maternal_line IS NOT NEW.maternal_line;
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS person_line_paternal AFTER UPDATE OF paternal_line ON PersonLine
+            WHEN OLD.paternal_line IS NOT NEW.paternal_line
+             AND EXISTS (SELECT 1 FROM PersonLine WHERE father_id = NEW.person_id) BEGIN
+                UPDATE PersonLine SET paternal_line = NEW.paternal_line
+                WHERE father_id = NEW.person_id AND paternal_line IS NOT NEW.paternal_line;
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS person_line_maternal AFTER UPDATE OF maternal_line ON PersonLine
+            WHEN OLD.maternal_line IS NOT NEW.maternal_line
+             AND EXISTS (SELECT 1 FROM PersonLine WHERE mother_id = NEW.person_id) BEGIN
+                UPDATE PersonLine SET maternal_line = NEW.maternal_line
+                WHERE mother_id = NEW.person_id AND maternal_line IS NOT NEW.maternal_line;
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS person_line_delete AFTER DELETE ON PersonLine
+            WHEN EXISTS (SELECT 1 FROM PersonLine WHERE father_id = OLD.person_id)
+              OR EXISTS (SELECT 1 FROM PersonLine WHERE mother_id = OLD.person_id) BEGIN
+                UPDATE PersonLine SET paternal_line = OLD.person_id
+                WHERE father_id = OLD.person_id AND paternal_line IS NOT OLD.person_id;
+                UPDATE PersonLine SET maternal_line = OLD.person_id
+                WHERE mother_id = OLD.person_id AND maternal_line IS NOT OLD.person_id;
+            END
+        )",
+        // Only parents pass a changed depth on
+        R"(
+            CREATE TRIGGER IF NOT EXISTS generation_depth AFTER UPDATE OF depth ON PersonGeneration
+            WHEN OLD.depth IS NOT NEW.depth AND NEW.depth < 900
+             AND (EXISTS (SELECT 1 FROM Family WHERE partner1_id = NEW.person_id)
+                  OR EXISTS (SELECT 1 FROM Family WHERE partner2_id = NEW.person_id AND partner2_id <> '')) BEGIN)" +
+            depthSql("IN (SELECT child_id FROM ParentLink WHERE parent_id = NEW.person_id)") + R"(
+            END
+        )",
+        R"(
+            CREATE TRIGGER IF NOT EXISTS person_delete AFTER DELETE ON Person
+            WHEN NOT EXISTS (SELECT 1 FROM Shard) BEGIN
+                DELETE FROM PersonGeneration WHERE person_id = OLD.person_id;
+                DELETE FROM PersonLine WHERE person_id = OLD.person_id;
+                -- As ParentLink deletes do, family by family: a couple's
+                -- children stay with the other partner
+                INSERT OR IGNORE INTO Family (partner1_id, partner2_id)
+                SELECT partner2_id, '' FROM Family
+                WHERE partner1_id = OLD.person_id AND partner2_id <> ''
+                  AND EXISTS (SELECT 1 FROM FamilyChild WHERE family_id = Family.family_id)
+                UNION ALL
+                SELECT partner1_id, '' FROM Family
+                WHERE partner2_id = OLD.person_id AND partner2_id <> ''
+                  AND EXISTS (SELECT 1 FROM FamilyChild WHERE family_id = Family.family_id);
+                UPDATE FamilyChild SET family_id = (
+                    SELECT g.family_id FROM Family f JOIN Family g
+                      ON g.partner1_id = CASE WHEN f.partner1_id = OLD.person_id
+                                              THEN f.partner2_id ELSE f.partner1_id END
+                     AND g.partner2_id = ''
+                    WHERE f.family_id = FamilyChild.family_id)
+                WHERE family_id IN (
+                    SELECT family_id FROM Family WHERE partner1_id = OLD.person_id AND partner2_id <> ''
+                    UNION ALL
+                    SELECT family_id FROM Family WHERE partner2_id = OLD.person_id AND partner2_id <> '');
+                DELETE FROM FamilyChild WHERE family_id IN (
+                    SELECT family_id FROM Family WHERE partner1_id = OLD.person_id AND partner2_id = '');
+                DELETE FROM FamilyChild WHERE child_id = OLD.person_id;
+                DELETE FROM Family WHERE partner1_id = OLD.person_id;
+                DELETE FROM Family WHERE partner2_id = OLD.person_id AND partner2_id <> '';
+            END
         )"
     };
 
     try {
         beginTransaction();
-        
+
+        // FamilyChild used to hold one family per child, derived from
+        // Parent-Child relationships; DatabaseManager moves those links
+        // into the new table
+        if (!executeQuery("SELECT 1 FROM pragma_table_info('FamilyChild') WHERE name = 'child_id' AND pk = 1 "
+                          "AND NOT EXISTS (SELECT 1 FROM pragma_table_info('FamilyChild') WHERE pk = 2)").empty() &&
+            !executeCommand("DROP TABLE FamilyChild")) {
+            rollback();
+            std::cerr << "Failed to replace the FamilyChild table" << std::endl;
+            return false;
+        }
+
         for (const auto& query : initQueries) {
             if (!executeCommand(query)) {
                 rollback();
@@ -124,7 +893,39 @@ bool SQLiteConnector::initializeDatabase() {
                 return false;
             }
         }
-        
+
+        // Files from before the place dictionary lack the ID columns
+        if (executeQuery("SELECT 1 FROM pragma_table_info('Person') WHERE name = 'birth_place_id'").empty()) {
+            for (const char* column : {"birth_place_id", "death_place_id"}) {
+                std::string query = std::string("ALTER TABLE Person ADD COLUMN ") + column +
+                                    " INTEGER REFERENCES Place(place_id)";
+                if (!executeCommand(query)) {
+                    rollback();
+                    std::cerr << "Failed to execute query: " << query << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        if (executeQuery("SELECT 1 FROM pragma_table_info('Family') WHERE name = 'ended'").empty()) {
+            const std::string query = "ALTER TABLE Family ADD COLUMN ended INTEGER NOT NULL DEFAULT 0";
+            if (!executeCommand(query)) {
+                rollback();
+                std::cerr << "Failed to execute query: " << query << std::endl;
+                return false;
+            }
+        }
+
+        for (const auto* queries : {&placeQueries, &familyQueries, &upkeepQueries}) {
+            for (const auto& query : *queries) {
+                if (!executeCommand(query)) {
+                    rollback();
+                    std::cerr << "Failed to execute query: " << query << std::endl;
+                    return false;
+                }
+            }
+        }
+
         commit();
         return true;
     } catch (const std::exception& e) {
@@ -134,9 +935,9 @@ bool SQLiteConnector::initializeDatabase() {
     }
 }
 
-void SQLiteConnector::checkError(int result, const std::string& operation) {
+void SQLiteConnector::checkError(sqlite3* handle, int result, const std::string& operation) {
     if (result != SQLITE_OK) {
-        std::string error = sqlite3_errmsg(db);
+        std::string error = sqlite3_errmsg(handle);
         throw std::runtime_error(operation + " failed: " + error);
     }
 }
\ No newline at end of file
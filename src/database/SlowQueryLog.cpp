@@ -0,0 +1,183 @@
+#include "database/SlowQueryLog.hpp"
+#include "utils/JsonFormatter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const size_t MAX_LOGGED_PARAM = 200;
+
+std::mutex logMutex;
+SlowQueryLogOptions current;
+std::ofstream logFile;
+size_t logBytes = 0;
+
+std::string upper(std::string text) {
+    for (auto& c : text) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+// SQL on one line, for grepping the log
+std::string collapseWhitespace(const std::string& sql) {
+    std::string result;
+    bool space = false;
+    for (char c : sql) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = !result.empty();
+        } else {
+            if (space) result += ' ';
+            result += c;
+            space = false;
+        }
+    }
+    return result;
+}
+
+std::string timestamp() {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    std::ostringstream out;
+    out << buffer << "." << std::setw(3) << std::setfill('0') << millis << "Z";
+    return out.str();
+}
+
+bool openLog() {
+    logFile.close();
+    logFile.clear();
+    logFile.open(current.path, std::ios::app);
+    if (!logFile) {
+        return false;
+    }
+    std::ifstream existing(current.path, std::ios::ate | std::ios::binary);
+    logBytes = existing ? static_cast<size_t>(existing.tellg()) : 0;
+    return true;
+}
+
+// PATH -> PATH.1 -> ... -> PATH.keepFiles, dropping the oldest. Logging
+// stops if the new file cannot be opened.
+void rotate() {
+    logFile.close();
+    if (current.keepFiles > 0) {
+        for (int i = current.keepFiles - 1; i >= 1; i--) {
+            std::rename((current.path + "." + std::to_string(i)).c_str(),
+                        (current.path + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(current.path.c_str(), (current.path + ".1").c_str());
+    } else {
+        std::remove(current.path.c_str());
+    }
+    openLog();
+}
+
+} // namespace
+
+std::atomic<bool> SlowQueryLog::enabledFlag{false};
+std::atomic<uint64_t> SlowQueryLog::threshold{0};
+
+void SlowQueryLog::enable(const SlowQueryLogOptions& options) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    current = options;
+    if (!openLog()) {
+        enabledFlag.store(false, std::memory_order_relaxed);
+        throw std::runtime_error("Cannot open slow query log: " + options.path);
+    }
+    threshold.store(static_cast<uint64_t>(std::max(options.thresholdMillis, 0.0) * 1e6),
+                    std::memory_order_relaxed);
+    enabledFlag.store(true, std::memory_order_relaxed);
+}
+
+void SlowQueryLog::disable() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    enabledFlag.store(false, std::memory_order_relaxed);
+    logFile.close();
+}
+
+SlowQueryLogOptions SlowQueryLog::options() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    return current;
+}
+
+std::vector<std::string> SlowQueryLog::fullScans(const std::string& sql, const std::vector<std::string>& plan) {
+    // Plans name tables by alias when there is one
+    static const std::regex tableReference(R"(\b(Person|Relationship)\b(?:\s+(?:AS\s+)?([A-Za-z_]\w*))?)",
+                                           std::regex::icase);
+    static const std::set<std::string> keywords = {
+        "WHERE", "JOIN", "INNER", "LEFT", "CROSS", "NATURAL", "ON", "USING", "SET", "ORDER",
+        "GROUP", "LIMIT", "UNION", "EXCEPT", "INTERSECT", "VALUES", "SELECT", "DEFAULT", "INDEXED", "NOT"
+    };
+    std::map<std::string, std::string> tables;  // upper-case name or alias -> table
+    for (std::sregex_iterator it(sql.begin(), sql.end(), tableReference), end; it != end; ++it) {
+        std::string table = upper((*it)[1]) == "PERSON" ? "Person" : "Relationship";
+        tables[upper(table)] = table;
+        if ((*it)[2].matched && !keywords.count(upper((*it)[2]))) {
+            tables[upper((*it)[2])] = table;
+        }
+    }
+
+    static const std::regex scan(R"(^\s*SCAN (?:TABLE )?(\w+)(?: AS (\w+))?)");
+    std::vector<std::string> scanned;
+    for (const auto& line : plan) {
+        std::smatch match;
+        if (!std::regex_search(line, match, scan)) continue;
+        for (size_t group = 1; group <= 2; group++) {
+            auto table = tables.find(upper(match[group]));
+            if (match[group].matched && table != tables.end()) {
+                if (std::find(scanned.begin(), scanned.end(), table->second) == scanned.end()) {
+                    scanned.push_back(table->second);
+                }
+                break;
+            }
+        }
+    }
+    return scanned;
+}
+
+void SlowQueryLog::record(const SlowQuery& query) {
+    std::ostringstream entry;
+    entry << timestamp() << " slow query: " << std::fixed << std::setprecision(3)
+          << query.elapsedNanos / 1e6 << " ms, " << query.rows << " rows\n"
+          << "  sql: " << collapseWhitespace(query.sql) << "\n"
+          << "  params: [";
+    for (size_t i = 0; i < query.params.size(); i++) {
+        const std::string& param = query.params[i];
+        entry << (i ? ", " : "")
+              << JsonFormatter::quote(param.size() > MAX_LOGGED_PARAM
+                                          ? param.substr(0, MAX_LOGGED_PARAM) + "..." : param);
+    }
+    entry << "]\n  plan:\n";
+    for (const auto& line : query.plan) {
+        entry << "    " << line << "\n";
+    }
+    for (const auto& table : fullScans(query.sql, query.plan)) {
+        entry << "  WARNING: full scan of " << table << "\n";
+    }
+    std::string text = entry.str();
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (!enabled() || !logFile.is_open()) {
+        return;
+    }
+    if (logBytes > 0 && logBytes + text.size() > current.maxBytes) {
+        rotate();
+    }
+    logFile << text << std::flush;
+    logBytes += text.size();
+}
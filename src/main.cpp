@@ -1,13 +1,133 @@
 #include "ui/FamilyTreeUI.hpp"
+#include "ui/BatchRunner.hpp"
+#include "services/QueryServer.hpp"
+#include "database/SlowQueryLog.hpp"
+#include "utils/Metrics.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <string>
+
+namespace {
+
+QueryServer* activeServer = nullptr;
+
+void handleStopSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage:\n"
+              << "  " << program << " [--db PATH]\n"
+              << "      Interactive menu\n"
+              << "  " << program << " [--db PATH] --batch [FILE|-] [--batch-size N] [--stop-on-error]\n"
+              << "      Run a command script (stdin when FILE is - or omitted) and\n"
+              << "      print one JSON result per command\n"
+              << "  " << program << " [--db PATH] --serve SOCKET [--workers N] [--commit-window MS]\n"
+              << "      Serve \"ID COMMAND ARGS...\" request lines on a Unix socket;\n"
+              << "      mutations arriving within MS (default 0) share one commit\n"
+              << "\nOptions:\n"
+              << "  --stats  collect per-query statistics from the start; batch and\n"
+              << "           server modes print them as JSON to stderr on exit\n"
+              << "  --slow-query-log FILE  log queries slower than --slow-query-ms\n"
+              << "                         (default 100) with their query plans\n"
+              << "\nBatch commands:\n" << CommandProcessor::help();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string dbPath = "family_tree.db";
+    bool batchMode = false;
+    std::string scriptPath = "-";
+    BatchOptions batchOptions;
+    ServerOptions serverOptions;
+    bool printStats = false;
+    SlowQueryLogOptions slowQueryOptions;
+    bool slowQueryLog = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--db" && i + 1 < argc) {
+            dbPath = argv[++i];
+        } else if (arg == "--batch") {
+            batchMode = true;
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0) {
+                scriptPath = argv[++i];
+            }
+        } else if (arg == "--batch-size" && i + 1 < argc) {
+            batchOptions.transactionSize = std::stoul(argv[++i]);
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serverOptions.socketPath = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            serverOptions.workerThreads = std::stoul(argv[++i]);
+        } else if (arg == "--commit-window" && i + 1 < argc) {
+            serverOptions.commitWindow = std::chrono::milliseconds(std::stoul(argv[++i]));
+        } else if (arg == "--stop-on-error") {
+            batchOptions.stopOnError = true;
+        } else if (arg == "--slow-query-log" && i + 1 < argc) {
+            slowQueryOptions.path = argv[++i];
+            slowQueryLog = true;
+        } else if (arg == "--slow-query-ms" && i + 1 < argc) {
+            slowQueryOptions.thresholdMillis = std::stod(argv[++i]);
+        } else if (arg == "--stats") {
+            Metrics::setEnabled(true);
+            printStats = true;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 2;
+        }
+    }
 
-int main() {
     try {
-        FamilyTreeUI ui;
+        if (slowQueryLog) {
+            SlowQueryLog::enable(slowQueryOptions);
+        }
+
+        if (!serverOptions.socketPath.empty()) {
+            FamilyTree tree(dbPath);
+            QueryServer server(tree, serverOptions);
+            activeServer = &server;
+            std::signal(SIGINT, handleStopSignal);
+            std::signal(SIGTERM, handleStopSignal);
+            std::cerr << "Serving " << dbPath << " on " << serverOptions.socketPath << std::endl;
+            server.run();
+            activeServer = nullptr;
+            if (printStats) {
+                std::cerr << Metrics::toJson() << std::endl;
+            }
+            return 0;
+        }
+
+        if (batchMode) {
+            FamilyTree tree(dbPath);
+            BatchRunner runner(tree, batchOptions);
+            int failures = 0;
+            if (scriptPath == "-") {
+                failures = runner.run(std::cin, std::cout);
+            } else {
+                std::ifstream script(scriptPath);
+                if (!script) {
+                    std::cerr << "Cannot open script: " << scriptPath << std::endl;
+                    return 2;
+                }
+                failures = runner.run(script, std::cout);
+            }
+            if (printStats) {
+                std::cerr << Metrics::toJson() << std::endl;
+            }
+            return failures == 0 ? 0 : 1;
+        }
+
+        FamilyTreeUI ui(dbPath);
         ui.start();
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
         return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -1,6 +1,11 @@
 #include "models/FamilyTree.hpp"
+#include "services/RelationshipTimeline.hpp"
+#include "utils/CancellationToken.hpp"
+#include "utils/Metrics.hpp"
 #include <algorithm>
 #include <climits>
+#include <mutex>
+#include <shared_mutex>
 #include <set>
 
 // Constructor
@@ -9,140 +14,295 @@ FamilyTree::FamilyTree(const std::string& dbPath)
 
 // Person management
 bool FamilyTree::addPerson(const Person& person) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "addPerson");
+    WriteLock lock(treeMutex);
+    // Drops cached "no parents"/"no children" answers for a reused ID
+    cache.invalidate({person.getId()});
+    revision++;
     return dbManager->addPerson(person);
 }
 
 bool FamilyTree::updatePerson(const Person& person) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "updatePerson");
+    WriteLock lock(treeMutex);
+    cache.invalidate({person.getId()});
+    revision++;
     return dbManager->updatePerson(person);
 }
 
 bool FamilyTree::deletePerson(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "deletePerson");
+    WriteLock lock(treeMutex);
+
     // First check if person exists
     auto person = dbManager->getPerson(personId);
     if (!person) {
         return false;
     }
+    cache.invalidate({personId});
+    revision++;
 
-    // Begin transaction
-    dbManager->beginTransaction();
-    try {
-        // Delete all relationships
-        auto relationships = dbManager->getRelationshipsForPerson(personId);
-        for (const auto& rel : relationships) {
-            dbManager->deleteRelationship(rel.getId());
-        }
+    // Relationships go with the person
+    return dbManager->deletePerson(personId);
+}
 
-        // Delete the person
-        bool success = dbManager->deletePerson(personId);
-        if (success) {
-            dbManager->commit();
-            return true;
-        }
-        dbManager->rollback();
-        return false;
-    }
-    catch (...) {
-        dbManager->rollback();
-        throw;
-    }
+int FamilyTree::deleteBranch(const std::string& personId, bool includeSpouses) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "deleteBranch");
+    WriteLock lock(treeMutex);
+    auto removed = dbManager->deleteBranch(personId, includeSpouses);
+    // Every cached result mentioning a removed person depends on it
+    cache.invalidate(removed);
+    revision++;
+    return static_cast<int>(removed.size());
+}
+
+int FamilyTree::addShard(const std::string& path, const std::string& surnameFrom,
+                         const std::string& surnameTo) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "addShard");
+    WriteLock lock(treeMutex);
+    return dbManager->addShard(path, surnameFrom, surnameTo);
+}
+
+int FamilyTree::moveBranchToShard(const std::string& personId, int shardId, bool includeSpouses) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "moveBranchToShard");
+    WriteLock lock(treeMutex);
+    return dbManager->moveBranchToShard(personId, shardId, includeSpouses);
+}
+
+std::vector<ShardInfo> FamilyTree::getShards() {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getShards");
+    ReadLock lock(treeMutex);
+    return dbManager->getShards();
+}
+
+int FamilyTree::countPeople(int shardId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "countPeople");
+    ReadLock lock(treeMutex);
+    return dbManager->countPeople(shardId);
+}
+
+std::vector<PlaceCount> FamilyTree::getPlaceCounts(const std::string& place) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getPlaceCounts");
+    ReadLock lock(treeMutex);
+    return dbManager->getPlaceCounts(place);
+}
+
+std::vector<Person> FamilyTree::getLineAncestors(const std::string& personId, DirectLine line) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getLineAncestors");
+    ReadLock lock(treeMutex);
+    return dbManager->getLineAncestors(personId, line);
+}
+
+std::vector<Person> FamilyTree::getLineDescendants(const std::string& personId, DirectLine line) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getLineDescendants");
+    ReadLock lock(treeMutex);
+    return dbManager->getLineDescendants(personId, line);
+}
+
+std::vector<Person> FamilyTree::getLineMembers(const std::string& personId, DirectLine line) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getLineMembers");
+    ReadLock lock(treeMutex);
+    return dbManager->getLineMembers(personId, line);
+}
+
+MergeSummary FamilyTree::mergeDatabase(const std::string& otherDbPath, const MergeOptions& options) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "mergeDatabase");
+    WriteLock lock(treeMutex);
+    MergeSummary summary = dbManager->mergeDatabase(otherDbPath, options);
+    // Matched people may have gained relatives anywhere in the tree
+    cache.clear();
+    revision++;
+    return summary;
 }
 
 std::optional<Person> FamilyTree::getPerson(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getPerson");
+    ReadLock lock(treeMutex);
     return dbManager->getPerson(personId);
 }
 
+std::vector<Person> FamilyTree::getAllPeople() {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getAllPeople");
+    ReadLock lock(treeMutex);
+    return dbManager->getAllPeople();
+}
+
 // Relationship management
 bool FamilyTree::addRelationship(const std::string& person1Id,
                                 const std::string& person2Id,
-                                RelationType type) {
+                                RelationType type,
+                                const std::string& startDate,
+                                const std::string& endDate,
+                                std::string* relationshipId) {
+    // Validation and insert form one step: no other writer can add a
+    // conflicting relationship in between
+    Metrics::Scope scope(Metrics::Layer::TREE, "addRelationship");
+    WriteLock lock(treeMutex);
+
     // Validate both persons exist
-    if (!dbManager->getPerson(person1Id) || !dbManager->getPerson(person2Id)) {
+    if (!dbManager->hasPeople({person1Id, person2Id})) {
         return false;
     }
 
-    // Validate relationship
-    if (!validateRelationship(person1Id, person2Id, type)) {
+    // Generate unique ID for relationship; a couple may marry again
+    const std::string baseId = person1Id + "_" + person2Id + "_" + Relationship::relationTypeToString(type);
+    std::string newId = baseId;
+    if (type == RelationType::SPOUSE) {
+        Relationship marriage(baseId, person1Id, person2Id, type);
+        marriage.setStartDate(startDate);
+        marriage.setEndDate(endDate);
+        std::vector<std::string> taken;
+        if (!isFreeToMarry(marriage, &taken)) {
+            return false;
+        }
+        for (int number = 2; std::find(taken.begin(), taken.end(), newId) != taken.end(); number++) {
+            newId = baseId + "_" + std::to_string(number);
+        }
+    } else if (!validateRelationship(person1Id, person2Id, type)) {
         return false;
     }
 
-    // Generate unique ID for relationship
-    std::string relationshipId = person1Id + "_" + person2Id + "_" +
-                                Relationship::relationTypeToString(type);
+    Relationship newRelationship(newId, person1Id, person2Id, type);
+    newRelationship.setStartDate(startDate);
+    newRelationship.setEndDate(endDate);
+    cache.invalidate({person1Id, person2Id});
+    revision++;
+    if (!dbManager->addRelationship(newRelationship)) {
+        return false;
+    }
+    if (relationshipId) {
+        *relationshipId = newId;
+    }
+    return true;
+}
 
-    Relationship newRelationship(relationshipId, person1Id, person2Id, type);
-    return dbManager->addRelationship(newRelationship);
+bool FamilyTree::setRelationshipDates(const std::string& relationshipId,
+                                      const std::string& startDate,
+                                      const std::string& endDate) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "setRelationshipDates");
+    WriteLock lock(treeMutex);
+    auto stored = dbManager->getRelationship(relationshipId);
+    if (!stored) {
+        return false;
+    }
+    Relationship relationship(relationshipId, stored->getPerson1Id(), stored->getPerson2Id(), stored->getType());
+    relationship.setStartDate(startDate);
+    relationship.setEndDate(endDate);
+    // The current spouse is the one without an end date
+    cache.invalidate({relationship.getPerson1Id(), relationship.getPerson2Id()});
+    revision++;
+    return dbManager->updateRelationship(relationship);
 }
 
 bool FamilyTree::removeRelationship(const std::string& relationshipId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "removeRelationship");
+    WriteLock lock(treeMutex);
+    auto relationship = dbManager->getRelationship(relationshipId);
+    if (relationship) {
+        cache.invalidate({relationship->getPerson1Id(), relationship->getPerson2Id()});
+        revision++;
+    }
     return dbManager->deleteRelationship(relationshipId);
 }
 
+std::vector<Relationship> FamilyTree::getAllRelationships() {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getAllRelationships");
+    ReadLock lock(treeMutex);
+    return dbManager->getAllRelationships();
+}
+
 // Tree navigation
 std::vector<Person> FamilyTree::getParents(const std::string& personId) {
-    std::vector<Person> parents;
-    auto relationships = dbManager->getRelationshipsForPerson(personId);
-
-    for (const auto& rel : relationships) {
-        if (rel.getType() == RelationType::PARENT_CHILD &&
-            rel.getPerson2Id() == personId) {
-            auto parent = dbManager->getPerson(rel.getPerson1Id());
-            if (parent) {
-                parents.push_back(*parent);
-            }
-        }
+    Metrics::Scope scope(Metrics::Layer::TREE, "getParents");
+    ReadLock lock(treeMutex);
+    if (auto cached = cache.lookup(CachedQuery::PARENTS, personId)) {
+        return *cached;
     }
+
+    auto parents = dbManager->getParents(personId);
+    cache.store(CachedQuery::PARENTS, personId, 0, parents, dependenciesOf(personId, parents));
     return parents;
 }
 
 std::vector<Person> FamilyTree::getChildren(const std::string& personId) {
-    std::vector<Person> children;
-    auto relationships = dbManager->getRelationshipsForPerson(personId);
-
-    for (const auto& rel : relationships) {
-        if (rel.getType() == RelationType::PARENT_CHILD &&
-            rel.getPerson1Id() == personId) {
-            auto child = dbManager->getPerson(rel.getPerson2Id());
-            if (child) {
-                children.push_back(*child);
-            }
-        }
+    Metrics::Scope scope(Metrics::Layer::TREE, "getChildren");
+    ReadLock lock(treeMutex);
+    if (auto cached = cache.lookup(CachedQuery::CHILDREN, personId)) {
+        return *cached;
     }
+
+    auto children = dbManager->getChildren(personId);
+    cache.store(CachedQuery::CHILDREN, personId, 0, children, dependenciesOf(personId, children));
     return children;
 }
 
 std::optional<Person> FamilyTree::getSpouse(const std::string& personId) {
-    auto relationships = dbManager->getRelationshipsForPerson(personId);
-    for (const auto& rel : relationships) {
-        if (rel.getType() == RelationType::SPOUSE && rel.getEndDate().empty()) {
-            std::string spouseId = (rel.getPerson1Id() == personId) ?
-                                  rel.getPerson2Id() : rel.getPerson1Id();
-            return dbManager->getPerson(spouseId);
-        }
+    Metrics::Scope scope(Metrics::Layer::TREE, "getSpouse");
+    ReadLock lock(treeMutex);
+    if (auto cached = cache.lookup(CachedQuery::SPOUSE, personId)) {
+        if (cached->empty()) return std::nullopt;
+        return cached->front();
+    }
+
+    std::vector<Person> spouse;
+    if (auto person = dbManager->getSpouse(personId)) {
+        spouse.push_back(*person);
     }
-    return std::nullopt;
+    cache.store(CachedQuery::SPOUSE, personId, 0, spouse, dependenciesOf(personId, spouse));
+    if (spouse.empty()) return std::nullopt;
+    return spouse.front();
 }
 
-std::vector<Person> FamilyTree::getSiblings(const std::string& personId) {
-    std::vector<Person> siblings;
+std::vector<Person> FamilyTree::getSiblings(const std::string& personId, SiblingKind kind) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getSiblings");
+    ReadLock lock(treeMutex);
+    const int key = static_cast<int>(kind);
+    if (auto cached = cache.lookup(CachedQuery::SIBLINGS, personId, key)) {
+        return *cached;
+    }
+
+    auto siblings = dbManager->getSiblings(personId, kind);
     auto parents = getParents(personId);
 
+    // A new child of either parent changes the answer
+    auto dependencies = dependenciesOf(personId, siblings);
     for (const auto& parent : parents) {
-        auto children = getChildren(parent.getId());
-        for (const auto& child : children) {
-            if (child.getId() != personId &&
-                std::find_if(siblings.begin(), siblings.end(),
-                    [&](const Person& p) { return p.getId() == child.getId(); }) == siblings.end()) {
-                siblings.push_back(child);
-            }
-        }
+        dependencies.push_back(parent.getId());
     }
+    cache.store(CachedQuery::SIBLINGS, personId, key, siblings, dependencies);
     return siblings;
 }
 
+std::vector<Person> FamilyTree::getPartners(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getPartners");
+    ReadLock lock(treeMutex);
+    return dbManager->getPartners(personId);
+}
+
+std::vector<FamilyUnit> FamilyTree::getFamilies(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getFamilies");
+    ReadLock lock(treeMutex);
+    return dbManager->getFamilies(personId);
+}
+
+std::optional<FamilyUnit> FamilyTree::getParentFamily(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getParentFamily");
+    ReadLock lock(treeMutex);
+    return dbManager->getParentFamily(personId);
+}
+
 // Tree queries
 std::vector<Person> FamilyTree::getAncestors(const std::string& personId, int generations) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getAncestors");
+    ReadLock lock(treeMutex);
+    if (auto cached = cache.lookup(CachedQuery::ANCESTORS, personId, generations)) {
+        return *cached;
+    }
+
     std::vector<Person> ancestors;
     getAncestorsRecursive(personId, ancestors, 0, generations);
+    cache.store(CachedQuery::ANCESTORS, personId, generations, ancestors,
+                dependenciesOf(personId, ancestors));
     return ancestors;
 }
 
@@ -150,6 +310,7 @@ void FamilyTree::getAncestorsRecursive(const std::string& personId,
                                      std::vector<Person>& ancestors,
                                      int currentGen,
                                      int maxGen) {
+    CancellationToken::checkCurrent();
     if (maxGen != -1 && currentGen >= maxGen) {
         return;
     }
@@ -162,8 +323,16 @@ void FamilyTree::getAncestorsRecursive(const std::string& personId,
 }
 
 std::vector<Person> FamilyTree::getDescendants(const std::string& personId, int generations) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getDescendants");
+    ReadLock lock(treeMutex);
+    if (auto cached = cache.lookup(CachedQuery::DESCENDANTS, personId, generations)) {
+        return *cached;
+    }
+
     std::vector<Person> descendants;
     getDescendantsRecursive(personId, descendants, 0, generations);
+    cache.store(CachedQuery::DESCENDANTS, personId, generations, descendants,
+                dependenciesOf(personId, descendants));
     return descendants;
 }
 
@@ -171,6 +340,7 @@ void FamilyTree::getDescendantsRecursive(const std::string& personId,
                                        std::vector<Person>& descendants,
                                        int currentGen,
                                        int maxGen) {
+    CancellationToken::checkCurrent();
     if (maxGen != -1 && currentGen >= maxGen) {
         return;
     }
@@ -182,8 +352,24 @@ void FamilyTree::getDescendantsRecursive(const std::string& personId,
     }
 }
 
+PersonPage FamilyTree::getAncestorsPage(const std::string& personId, int generations,
+                                        size_t offset, size_t limit) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getAncestorsPage");
+    ReadLock lock(treeMutex);
+    return dbManager->getLineagePage(personId, true, generations, offset, limit);
+}
+
+PersonPage FamilyTree::getDescendantsPage(const std::string& personId, int generations,
+                                          size_t offset, size_t limit) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getDescendantsPage");
+    ReadLock lock(treeMutex);
+    return dbManager->getLineagePage(personId, false, generations, offset, limit);
+}
+
 std::vector<Person> FamilyTree::findCommonAncestors(const std::string& person1Id,
                                                    const std::string& person2Id) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "findCommonAncestors");
+    ReadLock lock(treeMutex);
     auto ancestors1 = getAncestors(person1Id);
     auto ancestors2 = getAncestors(person2Id);
     std::vector<Person> common;
@@ -199,6 +385,8 @@ std::vector<Person> FamilyTree::findCommonAncestors(const std::string& person1Id
 
 int FamilyTree::calculateGenerationGap(const std::string& person1Id,
                                      const std::string& person2Id) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "calculateGenerationGap");
+    ReadLock lock(treeMutex);
     auto commonAncestors = findCommonAncestors(person1Id, person2Id);
     if (commonAncestors.empty()) {
         return -1;  // No common ancestors
@@ -206,6 +394,7 @@ int FamilyTree::calculateGenerationGap(const std::string& person1Id,
 
     int minGap = INT_MAX;
     for (const auto& ancestor : commonAncestors) {
+        CancellationToken::checkCurrent();
         int gen1 = 0, gen2 = 0;
         auto current1 = person1Id;
         auto current2 = person2Id;
@@ -232,19 +421,60 @@ int FamilyTree::calculateGenerationGap(const std::string& person1Id,
     return minGap;
 }
 
-std::vector<Person> FamilyTree::searchByName(const std::string& name) {
-    return dbManager->searchPeople(name);
+namespace {
+
+// Phonetic algorithms of a search mode; empty for substring search
+std::vector<PhoneticAlgorithm> algorithmsFor(NameSearchMode mode) {
+    switch (mode) {
+        case NameSearchMode::SOUNDEX:
+            return {PhoneticAlgorithm::SOUNDEX};
+        case NameSearchMode::DAITCH_MOKOTOFF:
+            return {PhoneticAlgorithm::DAITCH_MOKOTOFF};
+        case NameSearchMode::DOUBLE_METAPHONE:
+            return {PhoneticAlgorithm::DOUBLE_METAPHONE};
+        case NameSearchMode::PHONETIC:
+            return PhoneticEncoder::allAlgorithms();
+        default:
+            return {};
+    }
+}
+
+} // namespace
+
+std::vector<Person> FamilyTree::searchByName(const std::string& name, NameSearchMode mode) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "searchByName");
+    ReadLock lock(treeMutex);
+    if (mode == NameSearchMode::SUBSTRING) {
+        return dbManager->searchPeople(name);
+    }
+    return dbManager->searchPeoplePhonetic(name, algorithmsFor(mode));
+}
+
+PersonPage FamilyTree::searchByNamePage(const std::string& name, NameSearchMode mode,
+                                        size_t offset, size_t limit) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "searchByNamePage");
+    ReadLock lock(treeMutex);
+    if (mode == NameSearchMode::SUBSTRING) {
+        return dbManager->searchPeoplePage(name, offset, limit);
+    }
+    return dbManager->searchPeoplePhoneticPage(name, algorithmsFor(mode), offset, limit);
 }
 
 std::vector<Person> FamilyTree::searchByDateRange(const std::string& startDate,
                                                 const std::string& endDate) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "searchByDateRange");
+    ReadLock lock(treeMutex);
     // Implementation needed in DatabaseManager
     return std::vector<Person>();
 }
 
 bool FamilyTree::validateRelationship(const std::string& person1Id,
                                     const std::string& person2Id,
-                                    RelationType type) {
+                                    RelationType type,
+                                    const std::string& startDate,
+                                    const std::string& endDate) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "validateRelationship");
+    ReadLock lock(treeMutex);
     if (person1Id == person2Id) {
         return false;
     }
@@ -254,9 +484,10 @@ bool FamilyTree::validateRelationship(const std::string& person1Id,
             return !isAncestor(person2Id, person1Id);
 
         case RelationType::SPOUSE: {
-            auto spouse1 = getSpouse(person1Id);
-            auto spouse2 = getSpouse(person2Id);
-            return !spouse1 && !spouse2;
+            Relationship marriage(person1Id + "_" + person2Id, person1Id, person2Id, type);
+            marriage.setStartDate(startDate);
+            marriage.setEndDate(endDate);
+            return isFreeToMarry(marriage);
         }
 
         case RelationType::SIBLING:
@@ -267,16 +498,145 @@ bool FamilyTree::validateRelationship(const std::string& person1Id,
     }
 }
 
+bool FamilyTree::isFreeToMarry(const Relationship& marriage, std::vector<std::string>* person1Ids) {
+    const std::string& person1Id = marriage.getPerson1Id();
+    const std::string& person2Id = marriage.getPerson2Id();
+    std::vector<Relationship> marriages;
+    for (const auto& personId : {person1Id, person2Id}) {
+        for (auto& relationship : dbManager->getRelationshipsForPerson(personId)) {
+            if (person1Ids && personId == person1Id) {
+                person1Ids->push_back(relationship.getId());
+            }
+            if (relationship.getType() == RelationType::SPOUSE) {
+                marriages.push_back(std::move(relationship));
+            }
+        }
+    }
+    if (marriages.empty()) {
+        return true;
+    }
+
+    // Marriages overlap when the times they were in force do (see
+    // RelationshipTimeline); each other's included, so a couple can only
+    // remarry after their marriage ended
+    std::map<std::string, std::optional<Person>> people;
+    auto person = [&](const std::string& id) -> const std::optional<Person>& {
+        auto found = people.find(id);
+        return found != people.end() ? found->second : people.emplace(id, getPerson(id)).first->second;
+    };
+    if (!person(person1Id) || !person(person2Id)) {
+        return false;
+    }
+    auto span = RelationshipTimeline::marriageSpan(marriage, *person(person1Id), *person(person2Id));
+    if (!span) {
+        return true;  // never in force
+    }
+    for (const auto& other : marriages) {
+        const auto& first = person(other.getPerson1Id());
+        const auto& second = person(other.getPerson2Id());
+        auto otherSpan = first && second ? RelationshipTimeline::marriageSpan(other, *first, *second)
+                                         : std::nullopt;
+        if (otherSpan && otherSpan->first <= span->second && otherSpan->second >= span->first) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void FamilyTree::setRootPerson(const std::string& personId) {
-    if (getPerson(personId)) {
-        rootPersonId = personId;
-    } else {
+    Metrics::Scope scope(Metrics::Layer::TREE, "setRootPerson");
+    WriteLock lock(treeMutex);
+    if (!getPerson(personId)) {
         throw std::invalid_argument("Person does not exist");
     }
+    dbManager->setRootPerson(personId);
 }
 
 std::string FamilyTree::getRootPerson() const {
-    return rootPersonId;
+    ReadLock lock(treeMutex);
+    return dbManager->getRootPerson();
+}
+
+std::optional<int> FamilyTree::getGeneration(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getGeneration");
+    ReadLock lock(treeMutex);
+    return dbManager->getGeneration(personId);
+}
+
+int FamilyTree::getDepth(const std::string& personId) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getDepth");
+    ReadLock lock(treeMutex);
+    return dbManager->getDepth(personId);
+}
+
+std::vector<Person> FamilyTree::getPeopleInGeneration(int generation) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getPeopleInGeneration");
+    ReadLock lock(treeMutex);
+    return dbManager->getPeopleInGeneration(generation);
+}
+
+std::vector<Person> FamilyTree::getPeopleAtDepth(int depth) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getPeopleAtDepth");
+    ReadLock lock(treeMutex);
+    return dbManager->getPeopleAtDepth(depth);
+}
+
+std::vector<Person> FamilyTree::getAncestorsInGeneration(const std::string& personId, int generation,
+                                                     GenerationOrigin origin) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getAncestorsInGeneration");
+    ReadLock lock(treeMutex);
+    return dbManager->getLineageInGeneration(personId, true, generation, origin);
+}
+
+std::vector<Person> FamilyTree::getDescendantsInGeneration(const std::string& personId, int generation,
+                                                       GenerationOrigin origin) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "getDescendantsInGeneration");
+    ReadLock lock(treeMutex);
+    return dbManager->getLineageInGeneration(personId, false, generation, origin);
+}
+
+void FamilyTree::beginTransaction() {
+    treeMutex.lock();
+    try {
+        dbManager->beginTransaction();
+    } catch (...) {
+        treeMutex.unlock();
+        throw;
+    }
+}
+
+void FamilyTree::commit() {
+    try {
+        dbManager->commit();
+    } catch (...) {
+        // The failed commit rolled the transaction back
+        cache.clear();
+        revision++;
+        treeMutex.unlock();
+        throw;
+    }
+    treeMutex.unlock();
+}
+
+void FamilyTree::rollback() {
+    // Results computed inside the transaction may reflect undone writes
+    cache.clear();
+    revision++;
+    dbManager->rollback();
+    treeMutex.unlock();
+}
+
+QueryCacheStats FamilyTree::getCacheStats() const {
+    return cache.getStats();
+}
+
+void FamilyTree::setCacheBudget(size_t bytes) {
+    Metrics::Scope scope(Metrics::Layer::TREE, "setCacheBudget");
+    WriteLock lock(treeMutex);
+    cache.setBudget(bytes);
+    if (bytes == 0) {
+        cache.clear();
+    }
 }
 
 bool FamilyTree::isAncestor(const std::string& ancestorId, const std::string& descendantId) {
@@ -289,4 +649,15 @@ bool FamilyTree::isSibling(const std::string& person1Id, const std::string& pers
     auto siblings = getSiblings(person1Id);
     return std::find_if(siblings.begin(), siblings.end(),
         [&](const Person& p) { return p.getId() == person2Id; }) != siblings.end();
+}
+
+std::vector<std::string> FamilyTree::dependenciesOf(const std::string& personId,
+                                                    const std::vector<Person>& people) {
+    std::vector<std::string> dependencies;
+    dependencies.reserve(people.size() + 1);
+    dependencies.push_back(personId);
+    for (const auto& person : people) {
+        dependencies.push_back(person.getId());
+    }
+    return dependencies;
 }
\ No newline at end of file
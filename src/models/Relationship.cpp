@@ -84,4 +84,17 @@ std::string Relationship::relationTypeToString(RelationType type) {
         default:
             return "Unknown";
     }
+}
+
+RelationType Relationship::relationTypeFromString(const std::string& type) {
+    if (type == "Parent-Child" || type == "PARENT_CHILD") {
+        return RelationType::PARENT_CHILD;
+    }
+    if (type == "Spouse" || type == "SPOUSE") {
+        return RelationType::SPOUSE;
+    }
+    if (type == "Sibling" || type == "SIBLING") {
+        return RelationType::SIBLING;
+    }
+    throw std::invalid_argument("Unknown relationship type: " + type);
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "services/AsyncFamilyTree.hpp"
+
+AsyncFamilyTree::AsyncFamilyTree(FamilyTree& tree, size_t threadCount)
+    : tree(tree), pool(threadCount) {}
+
+// Person management
+std::future<bool> AsyncFamilyTree::addPerson(const Person& person, CancellationToken token) {
+    return submit([person](FamilyTree& t) { return t.addPerson(person); }, token);
+}
+
+std::future<bool> AsyncFamilyTree::updatePerson(const Person& person, CancellationToken token) {
+    return submit([person](FamilyTree& t) { return t.updatePerson(person); }, token);
+}
+
+std::future<bool> AsyncFamilyTree::deletePerson(const std::string& personId, CancellationToken token) {
+    return submit([personId](FamilyTree& t) { return t.deletePerson(personId); }, token);
+}
+
+std::future<std::optional<Person>> AsyncFamilyTree::getPerson(const std::string& personId,
+                                                              CancellationToken token) {
+    return submit([personId](FamilyTree& t) { return t.getPerson(personId); }, token);
+}
+
+// Relationship management
+std::future<bool> AsyncFamilyTree::addRelationship(const std::string& person1Id,
+                                                   const std::string& person2Id,
+                                                   RelationType type,
+                                                   const std::string& startDate,
+                                                   const std::string& endDate,
+                                                   CancellationToken token) {
+    return submit([person1Id, person2Id, type, startDate, endDate](FamilyTree& t) {
+        return t.addRelationship(person1Id, person2Id, type, startDate, endDate);
+    }, token);
+}
+
+std::future<bool> AsyncFamilyTree::removeRelationship(const std::string& relationshipId,
+                                                      CancellationToken token) {
+    return submit([relationshipId](FamilyTree& t) { return t.removeRelationship(relationshipId); }, token);
+}
+
+// Tree navigation
+std::future<std::vector<Person>> AsyncFamilyTree::getParents(const std::string& personId,
+                                                             CancellationToken token) {
+    return submit([personId](FamilyTree& t) { return t.getParents(personId); }, token);
+}
+
+std::future<std::vector<Person>> AsyncFamilyTree::getChildren(const std::string& personId,
+                                                              CancellationToken token) {
+    return submit([personId](FamilyTree& t) { return t.getChildren(personId); }, token);
+}
+
+std::future<std::optional<Person>> AsyncFamilyTree::getSpouse(const std::string& personId,
+                                                              CancellationToken token) {
+    return submit([personId](FamilyTree& t) { return t.getSpouse(personId); }, token);
+}
+
+std::future<std::vector<Person>> AsyncFamilyTree::getSiblings(const std::string& personId,
+                                                              CancellationToken token) {
+    return submit([personId](FamilyTree& t) { return t.getSiblings(personId); }, token);
+}
+
+// Tree queries
+std::future<std::vector<Person>> AsyncFamilyTree::getAncestors(const std::string& personId,
+                                                               int generations,
+                                                               CancellationToken token) {
+    return submit([personId, generations](FamilyTree& t) {
+        return t.getAncestors(personId, generations);
+    }, token);
+}
+
+std::future<std::vector<Person>> AsyncFamilyTree::getDescendants(const std::string& personId,
+                                                                 int generations,
+                                                                 CancellationToken token) {
+    return submit([personId, generations](FamilyTree& t) {
+        return t.getDescendants(personId, generations);
+    }, token);
+}
+
+std::future<std::vector<Person>> AsyncFamilyTree::findCommonAncestors(const std::string& person1Id,
+                                                                      const std::string& person2Id,
+                                                                      CancellationToken token) {
+    return submit([person1Id, person2Id](FamilyTree& t) {
+        return t.findCommonAncestors(person1Id, person2Id);
+    }, token);
+}
+
+std::future<int> AsyncFamilyTree::calculateGenerationGap(const std::string& person1Id,
+                                                         const std::string& person2Id,
+                                                         CancellationToken token) {
+    return submit([person1Id, person2Id](FamilyTree& t) {
+        return t.calculateGenerationGap(person1Id, person2Id);
+    }, token);
+}
+
+// Search functionality
+std::future<std::vector<Person>> AsyncFamilyTree::searchByName(const std::string& name,
+                                                               NameSearchMode mode,
+                                                               CancellationToken token) {
+    return submit([name, mode](FamilyTree& t) { return t.searchByName(name, mode); }, token);
+}
+
+std::future<std::vector<Person>> AsyncFamilyTree::searchByDateRange(const std::string& startDate,
+                                                                    const std::string& endDate,
+                                                                    CancellationToken token) {
+    return submit([startDate, endDate](FamilyTree& t) {
+        return t.searchByDateRange(startDate, endDate);
+    }, token);
+}
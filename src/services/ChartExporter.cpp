@@ -0,0 +1,554 @@
+#include "services/ChartExporter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+struct ChartExporter::Graph {
+    struct Entry {
+        std::string id;
+        std::string name;
+        std::string years;     // "1900-1970", "b. 1900" or empty
+        std::string birthDate;
+        char gender = 'O';
+        std::vector<uint32_t> parents;   // father first
+        std::vector<uint32_t> children;  // by birth date
+        std::vector<uint32_t> spouses;
+    };
+    std::vector<Entry> people;
+    std::unordered_map<std::string, uint32_t> index;
+};
+
+// One chart tree: descendants (tree children are the person's children) or
+// ancestors (tree children are the person's parents). Nodes are stored in
+// breadth-first order, so a node's children are contiguous.
+struct ChartExporter::Layout {
+    struct Node {
+        uint32_t person = 0;
+        int32_t parent = -1;
+        uint32_t firstChild = 0;
+        uint32_t childCount = 0;
+        uint32_t number = 0;     // position among its siblings
+        int depth = 0;
+        bool repeat = false;     // drawn elsewhere already; not expanded
+
+        // Buchheim-Walker state
+        double prelim = 0;
+        double mod = 0;
+        double change = 0;
+        double shift = 0;
+        int32_t thread = -1;
+        uint32_t ancestor = 0;
+        double x = 0;
+    };
+
+    bool ancestors = false;
+    std::vector<Node> nodes;
+    int maxDepth = 0;
+
+    // Buchheim et al., "Improving Walker's Algorithm to Run in Linear Time"
+    void firstWalk(uint32_t v);
+    uint32_t apportion(uint32_t v, uint32_t defaultAncestor);
+    void moveSubtree(uint32_t wm, uint32_t wp, double amount);
+    void executeShifts(uint32_t v);
+    void secondWalk(uint32_t v, double m);
+
+    int32_t leftSibling(uint32_t v) const {
+        return nodes[v].number > 0 ? static_cast<int32_t>(v) - 1 : -1;
+    }
+    uint32_t leftmostSibling(uint32_t v) const {
+        return nodes[v].parent < 0 ? v : nodes[nodes[v].parent].firstChild;
+    }
+    int32_t nextLeft(uint32_t v) const {
+        return nodes[v].childCount > 0 ? static_cast<int32_t>(nodes[v].firstChild) : nodes[v].thread;
+    }
+    int32_t nextRight(uint32_t v) const {
+        return nodes[v].childCount > 0
+            ? static_cast<int32_t>(nodes[v].firstChild + nodes[v].childCount - 1)
+            : nodes[v].thread;
+    }
+};
+
+namespace {
+
+// Horizontal distance between neighbouring boxes, in layout units
+const double SIBLING_DISTANCE = 1.0;
+
+// Drawing geometry (SVG user units)
+const double BOX_WIDTH = 160;
+const double BOX_HEIGHT = 50;
+const double H_SPACING = 180;
+const double V_SPACING = 90;
+const double MARGIN = 20;
+const size_t MAX_LABEL = 28;
+
+const size_t NODES_PER_CHECK = 4096;
+
+int yearOf(const std::string& date) {
+    if (date.size() < 4 || !std::all_of(date.begin(), date.begin() + 4,
+                                        [](unsigned char c) { return std::isdigit(c); })) {
+        return 0;
+    }
+    return std::atoi(date.substr(0, 4).c_str());
+}
+
+std::string truncate(const std::string& text) {
+    return text.size() > MAX_LABEL ? text.substr(0, MAX_LABEL - 3) + "..." : text;
+}
+
+std::string escapeXml(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '&': result += "&amp;"; break;
+            case '<': result += "&lt;"; break;
+            case '>': result += "&gt;"; break;
+            case '"': result += "&quot;"; break;
+            case '\'': result += "&apos;"; break;
+            default: result += c;
+        }
+    }
+    return result;
+}
+
+std::string escapeDot(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+const char* fillColor(char gender) {
+    switch (gender) {
+        case 'M': return "#dbe9f7";
+        case 'F': return "#f7dbe6";
+        default: return "#ececec";
+    }
+}
+
+} // namespace
+
+void ChartExporter::Layout::firstWalk(uint32_t v) {
+    Node& node = nodes[v];
+    int32_t left = leftSibling(v);
+    if (node.childCount == 0) {
+        node.prelim = left >= 0 ? nodes[left].prelim + SIBLING_DISTANCE : 0;
+        return;
+    }
+
+    uint32_t defaultAncestor = node.firstChild;
+    for (uint32_t w = node.firstChild; w < node.firstChild + node.childCount; w++) {
+        firstWalk(w);
+        defaultAncestor = apportion(w, defaultAncestor);
+    }
+    executeShifts(v);
+
+    double midpoint = (nodes[node.firstChild].prelim +
+                       nodes[node.firstChild + node.childCount - 1].prelim) / 2;
+    if (left >= 0) {
+        node.prelim = nodes[left].prelim + SIBLING_DISTANCE;
+        node.mod = node.prelim - midpoint;
+    } else {
+        node.prelim = midpoint;
+    }
+}
+
+uint32_t ChartExporter::Layout::apportion(uint32_t v, uint32_t defaultAncestor) {
+    int32_t w = leftSibling(v);
+    if (w < 0) {
+        return defaultAncestor;
+    }
+
+    // Inner/outer contours of the right (p) and left (m) subtrees
+    int32_t vip = static_cast<int32_t>(v);
+    int32_t vop = static_cast<int32_t>(v);
+    int32_t vim = w;
+    int32_t vom = static_cast<int32_t>(leftmostSibling(v));
+    double sip = nodes[vip].mod;
+    double sop = nodes[vop].mod;
+    double sim = nodes[vim].mod;
+    double som = nodes[vom].mod;
+
+    while (nextRight(vim) >= 0 && nextLeft(vip) >= 0) {
+        vim = nextRight(vim);
+        vip = nextLeft(vip);
+        vom = nextLeft(vom);
+        vop = nextRight(vop);
+        nodes[vop].ancestor = v;
+
+        double shift = (nodes[vim].prelim + sim) - (nodes[vip].prelim + sip) + SIBLING_DISTANCE;
+        if (shift > 0) {
+            uint32_t ancestor = nodes[vim].ancestor;
+            // The greatest uncommon ancestor of vim, if it is a sibling of v
+            if (nodes[ancestor].parent != nodes[v].parent) {
+                ancestor = defaultAncestor;
+            }
+            moveSubtree(ancestor, v, shift);
+            sip += shift;
+            sop += shift;
+        }
+        sim += nodes[vim].mod;
+        sip += nodes[vip].mod;
+        som += nodes[vom].mod;
+        sop += nodes[vop].mod;
+    }
+
+    if (nextRight(vim) >= 0 && nextRight(vop) < 0) {
+        nodes[vop].thread = nextRight(vim);
+        nodes[vop].mod += sim - sop;
+    }
+    if (nextLeft(vip) >= 0 && nextLeft(vom) < 0) {
+        nodes[vom].thread = nextLeft(vip);
+        nodes[vom].mod += sip - som;
+        defaultAncestor = v;
+    }
+    return defaultAncestor;
+}
+
+void ChartExporter::Layout::moveSubtree(uint32_t wm, uint32_t wp, double amount) {
+    double subtrees = static_cast<double>(nodes[wp].number) - nodes[wm].number;
+    nodes[wp].change -= amount / subtrees;
+    nodes[wp].shift += amount;
+    nodes[wm].change += amount / subtrees;
+    nodes[wp].prelim += amount;
+    nodes[wp].mod += amount;
+}
+
+void ChartExporter::Layout::executeShifts(uint32_t v) {
+    double shift = 0;
+    double change = 0;
+    const Node& node = nodes[v];
+    for (uint32_t i = node.childCount; i-- > 0;) {
+        Node& w = nodes[node.firstChild + i];
+        w.prelim += shift;
+        w.mod += shift;
+        change += w.change;
+        shift += w.shift + change;
+    }
+}
+
+void ChartExporter::Layout::secondWalk(uint32_t v, double m) {
+    Node& node = nodes[v];
+    node.x = node.prelim + m;
+    for (uint32_t w = node.firstChild; w < node.firstChild + node.childCount; w++) {
+        secondWalk(w, m + node.mod);
+    }
+}
+
+ChartExporter::ChartExporter(FamilyTree& tree) : tree(tree) {}
+
+void ChartExporter::buildLayout(const Graph& graph, uint32_t root, bool ancestors, int generations,
+                                Layout& layout, const CancellationToken& token) {
+    layout.ancestors = ancestors;
+    layout.nodes.clear();
+    layout.nodes.emplace_back();
+    layout.nodes[0].person = root;
+
+    // Breadth first, so each person is expanded at its shallowest position
+    std::vector<bool> seen(graph.people.size(), false);
+    seen[root] = true;
+    for (uint32_t v = 0; v < layout.nodes.size(); v++) {
+        if (v % NODES_PER_CHECK == 0) {
+            token.throwIfCancelled();
+        }
+        Layout::Node node = layout.nodes[v];
+        layout.maxDepth = std::max(layout.maxDepth, node.depth);
+        if (node.repeat || (generations >= 0 && node.depth >= generations)) {
+            continue;
+        }
+        const auto& entry = graph.people[node.person];
+        const auto& next = ancestors ? entry.parents : entry.children;
+        layout.nodes[v].firstChild = static_cast<uint32_t>(layout.nodes.size());
+        layout.nodes[v].childCount = static_cast<uint32_t>(next.size());
+        for (size_t i = 0; i < next.size(); i++) {
+            Layout::Node child;
+            child.person = next[i];
+            child.parent = static_cast<int32_t>(v);
+            child.number = static_cast<uint32_t>(i);
+            child.depth = node.depth + 1;
+            child.repeat = seen[next[i]];
+            seen[next[i]] = true;
+            layout.nodes.push_back(child);
+        }
+    }
+
+    for (uint32_t v = 0; v < layout.nodes.size(); v++) {
+        layout.nodes[v].ancestor = v;
+    }
+    layout.firstWalk(0);
+    layout.secondWalk(0, -layout.nodes[0].prelim);
+    token.throwIfCancelled();
+}
+
+ChartSummary ChartExporter::write(const std::string& rootId, const ChartOptions& options, std::ostream& out,
+                                  CancellationToken token) {
+    // Snapshot of the tree as an adjacency list
+    Graph graph;
+    for (const auto& person : tree.getAllPeople()) {
+        Graph::Entry entry;
+        entry.id = person.getId();
+        entry.name = person.getFullName();
+        entry.birthDate = person.getDateOfBirth();
+        entry.gender = person.getGender().empty() ? 'O' : person.getGender()[0];
+        int born = yearOf(person.getDateOfBirth());
+        int died = yearOf(person.getDateOfDeath());
+        if (born && died) {
+            entry.years = std::to_string(born) + "-" + std::to_string(died);
+        } else if (born) {
+            entry.years = "b. " + std::to_string(born);
+        } else if (died) {
+            entry.years = "d. " + std::to_string(died);
+        }
+        graph.index.emplace(entry.id, static_cast<uint32_t>(graph.people.size()));
+        graph.people.push_back(std::move(entry));
+    }
+    token.throwIfCancelled();
+
+    auto root = graph.index.find(rootId);
+    if (root == graph.index.end()) {
+        throw std::invalid_argument("Person not found: " + rootId);
+    }
+
+    for (const auto& relationship : tree.getAllRelationships()) {
+        auto first = graph.index.find(relationship.getPerson1Id());
+        auto second = graph.index.find(relationship.getPerson2Id());
+        if (first == graph.index.end() || second == graph.index.end()) continue;
+        switch (relationship.getType()) {
+            case RelationType::PARENT_CHILD:
+                graph.people[first->second].children.push_back(second->second);
+                graph.people[second->second].parents.push_back(first->second);
+                break;
+            case RelationType::SPOUSE:
+                graph.people[first->second].spouses.push_back(second->second);
+                graph.people[second->second].spouses.push_back(first->second);
+                break;
+            default:
+                break;
+        }
+    }
+    for (auto& entry : graph.people) {
+        std::sort(entry.children.begin(), entry.children.end(), [&](uint32_t a, uint32_t b) {
+            const auto& left = graph.people[a];
+            const auto& right = graph.people[b];
+            return std::tie(left.birthDate, left.id) < std::tie(right.birthDate, right.id);
+        });
+        std::stable_sort(entry.parents.begin(), entry.parents.end(), [&](uint32_t a, uint32_t b) {
+            return (graph.people[a].gender == 'M') > (graph.people[b].gender == 'M');
+        });
+    }
+    token.throwIfCancelled();
+
+    Layout ancestorLayout;
+    Layout descendantLayout;
+    std::vector<const Layout*> layouts;
+    if (options.type != ChartType::DESCENDANTS) {
+        buildLayout(graph, root->second, true, options.generations, ancestorLayout, token);
+        layouts.push_back(&ancestorLayout);
+    }
+    if (options.type != ChartType::PEDIGREE) {
+        buildLayout(graph, root->second, false, options.generations, descendantLayout, token);
+        layouts.push_back(&descendantLayout);
+    }
+
+    ChartSummary summary;
+    std::vector<bool> drawn(graph.people.size(), false);
+    for (const Layout* layout : layouts) {
+        for (const auto& node : layout->nodes) {
+            if (!drawn[node.person]) {
+                drawn[node.person] = true;
+                summary.people++;
+            }
+        }
+        summary.boxes += layout->nodes.size();
+        (layout->ancestors ? summary.ancestorGenerations : summary.descendantGenerations) = layout->maxDepth;
+    }
+    if (layouts.size() == 2) {
+        summary.boxes--;  // the root person is drawn once
+    }
+
+    if (options.format == ChartFormat::SVG) {
+        writeSvg(graph, layouts, options, summary, out);
+    } else {
+        writeDot(graph, layouts, options, out);
+    }
+    return summary;
+}
+
+void ChartExporter::writeSvg(const Graph& graph, const std::vector<const Layout*>& layouts,
+                             const ChartOptions& options, ChartSummary& summary, std::ostream& out) {
+    // Both halves of an hourglass have the root at x = 0
+    double minX = std::numeric_limits<double>::max();
+    double maxX = std::numeric_limits<double>::lowest();
+    int minLevel = 0;
+    int maxLevel = 0;
+    for (const Layout* layout : layouts) {
+        for (const auto& node : layout->nodes) {
+            minX = std::min(minX, node.x);
+            maxX = std::max(maxX, node.x);
+        }
+        if (layout->ancestors) {
+            minLevel = -layout->maxDepth;
+        } else {
+            maxLevel = layout->maxDepth;
+        }
+    }
+
+    auto left = [&](const Layout::Node& node) { return MARGIN + (node.x - minX) * H_SPACING; };
+    auto top = [&](const Layout* layout, const Layout::Node& node) {
+        int level = layout->ancestors ? -node.depth : node.depth;
+        return MARGIN + (level - minLevel) * V_SPACING;
+    };
+
+    summary.width = 2 * MARGIN + (maxX - minX) * H_SPACING + BOX_WIDTH;
+    summary.height = 2 * MARGIN + (maxLevel - minLevel) * V_SPACING + BOX_HEIGHT;
+
+    out << std::fixed << std::setprecision(1)
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << summary.width
+        << "\" height=\"" << summary.height << "\" viewBox=\"0 0 " << summary.width << " "
+        << summary.height << "\">\n"
+        << "<style>\n"
+        << "rect{stroke:#333;stroke-width:1}\n"
+        << "rect.root{stroke-width:2.5}\n"
+        << "rect.repeat{stroke-dasharray:4 3;fill-opacity:0.5}\n"
+        << "path{fill:none;stroke:#666;stroke-width:1}\n"
+        << "text{font:11px sans-serif;text-anchor:middle}\n"
+        << "text.name{font-weight:bold}\n"
+        << "</style>\n";
+
+    // Lines first so boxes are drawn over them
+    out << "<g id=\"lines\">\n";
+    for (const Layout* layout : layouts) {
+        for (const auto& node : layout->nodes) {
+            if (node.parent < 0) continue;
+            const auto& parent = layout->nodes[node.parent];
+            double upperX = left(layout->ancestors ? node : parent) + BOX_WIDTH / 2;
+            double upperY = top(layout, layout->ancestors ? node : parent) + BOX_HEIGHT;
+            double lowerX = left(layout->ancestors ? parent : node) + BOX_WIDTH / 2;
+            double lowerY = top(layout, layout->ancestors ? parent : node);
+            double middleY = (upperY + lowerY) / 2;
+            out << "<path d=\"M" << upperX << " " << upperY << "V" << middleY << "H" << lowerX
+                << "V" << lowerY << "\"/>\n";
+        }
+    }
+    out << "</g>\n<g id=\"boxes\">\n";
+
+    for (const Layout* layout : layouts) {
+        bool skipRoot = layouts.size() == 2 && layout->ancestors;
+        for (const auto& node : layout->nodes) {
+            if (skipRoot && node.parent < 0) continue;
+            const auto& person = graph.people[node.person];
+            double x = left(node);
+            double y = top(layout, node);
+            out << "<g><title>" << escapeXml(person.id) << "</title><rect";
+            if (node.parent < 0) {
+                out << " class=\"root\"";
+            } else if (node.repeat) {
+                out << " class=\"repeat\"";
+            }
+            out << " x=\"" << x << "\" y=\"" << y << "\" width=\"" << BOX_WIDTH << "\" height=\""
+                << BOX_HEIGHT << "\" rx=\"6\" fill=\"" << fillColor(person.gender) << "\"/>"
+                << "<text class=\"name\" x=\"" << x + BOX_WIDTH / 2 << "\" y=\"" << y + 16 << "\">"
+                << escapeXml(truncate(person.name)) << "</text>";
+            if (!person.years.empty()) {
+                out << "<text x=\"" << x + BOX_WIDTH / 2 << "\" y=\"" << y + 30 << "\">"
+                    << escapeXml(person.years) << "</text>";
+            }
+            if (options.includeSpouses && !layout->ancestors && !person.spouses.empty()) {
+                std::string spouses;
+                for (uint32_t spouse : person.spouses) {
+                    spouses += (spouses.empty() ? "m. " : ", ") + graph.people[spouse].name;
+                }
+                out << "<text x=\"" << x + BOX_WIDTH / 2 << "\" y=\"" << y + 44 << "\">"
+                    << escapeXml(truncate(spouses)) << "</text>";
+            }
+            out << "</g>\n";
+        }
+    }
+    out << "</g>\n</svg>\n";
+}
+
+void ChartExporter::writeDot(const Graph& graph, const std::vector<const Layout*>& layouts,
+                             const ChartOptions& options, std::ostream& out) {
+    int maxLevel = 0;
+    for (const Layout* layout : layouts) {
+        if (!layout->ancestors) maxLevel = layout->maxDepth;
+    }
+    bool hourglass = layouts.size() == 2;
+    // Node names; an hourglass draws the root once, from the descendant half
+    auto name = [&](const Layout* layout, uint32_t v) {
+        if (hourglass && layout->ancestors && v == 0) return std::string("d0");
+        return std::string(layout->ancestors ? "a" : "d") + std::to_string(v);
+    };
+
+    // Positions in points, y growing upwards
+    const double pointsPerUnit = 72.0 / 96.0;
+    out << std::fixed << std::setprecision(1)
+        << "digraph family_tree {\n"
+        << "  graph [splines=ortho, nodesep=0.3, ranksep=0.5];\n"
+        << "  node [shape=box, style=\"rounded,filled\", fontname=\"sans-serif\", fontsize=10, "
+        << "width=" << BOX_WIDTH / 96.0 << ", height=" << BOX_HEIGHT / 96.0 << ", fixedsize=true];\n";
+
+    for (const Layout* layout : layouts) {
+        for (uint32_t v = 0; v < layout->nodes.size(); v++) {
+            const auto& node = layout->nodes[v];
+            if (hourglass && layout->ancestors && v == 0) continue;
+            const auto& person = graph.people[node.person];
+            int level = layout->ancestors ? -node.depth : node.depth;
+            // Lines joined with DOT's "\n" escape
+            std::string label = escapeDot(truncate(person.name));
+            if (!person.years.empty()) label += "\\n" + escapeDot(person.years);
+            if (options.includeSpouses && !layout->ancestors && !person.spouses.empty()) {
+                std::string spouses;
+                for (uint32_t spouse : person.spouses) {
+                    spouses += (spouses.empty() ? "m. " : ", ") + graph.people[spouse].name;
+                }
+                label += "\\n" + escapeDot(truncate(spouses));
+            }
+            out << "  " << name(layout, v) << " [label=\"" << label
+                << "\", tooltip=\"" << escapeDot(person.id) << "\", fillcolor=\"" << fillColor(person.gender)
+                << "\", pos=\"" << node.x * H_SPACING * pointsPerUnit << ","
+                << (maxLevel - level) * V_SPACING * pointsPerUnit << "!\"";
+            if (node.parent < 0) {
+                out << ", penwidth=2.5";
+            } else if (node.repeat) {
+                out << ", style=\"rounded,filled,dashed\"";
+            }
+            out << "];\n";
+        }
+    }
+
+    // Edges point from parent to child
+    for (const Layout* layout : layouts) {
+        for (uint32_t v = 0; v < layout->nodes.size(); v++) {
+            const auto& node = layout->nodes[v];
+            if (node.parent < 0) continue;
+            std::string self = name(layout, v);
+            std::string other = name(layout, static_cast<uint32_t>(node.parent));
+            out << "  " << (layout->ancestors ? self : other) << " -> "
+                << (layout->ancestors ? other : self) << ";\n";
+        }
+    }
+    out << "}\n";
+}
+
+ChartType ChartExporter::parseType(const std::string& type) {
+    if (type == "pedigree" || type == "ancestors") return ChartType::PEDIGREE;
+    if (type == "descendants") return ChartType::DESCENDANTS;
+    if (type == "hourglass") return ChartType::HOURGLASS;
+    throw std::invalid_argument("Unknown chart type: " + type + " (use pedigree, descendants or hourglass)");
+}
+
+ChartFormat ChartExporter::parseFormat(const std::string& format) {
+    if (format == "svg") return ChartFormat::SVG;
+    if (format == "dot") return ChartFormat::DOT;
+    throw std::invalid_argument("Unknown chart format: " + format + " (use svg or dot)");
+}
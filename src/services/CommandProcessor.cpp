@@ -0,0 +1,732 @@
+#include "services/CommandProcessor.hpp"
+#include "services/ChartExporter.hpp"
+#include "services/DuplicateDetector.hpp"
+#include "services/KinshipCalculator.hpp"
+#include "database/SlowQueryLog.hpp"
+#include "utils/JsonFormatter.hpp"
+#include "utils/Metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+CommandProcessor::CommandProcessor(FamilyTree& tree) : tree(tree), relationshipCalculator(tree), lifespanIndex(tree),
+      relationshipTimeline(tree) {}
+
+const std::map<std::string, CommandProcessor::CommandSpec>& CommandProcessor::commands() {
+    static const std::map<std::string, CommandSpec> table = {
+        {"add-person", {&CommandProcessor::addPerson, 5, 8, true,
+            "add-person ID FIRST LAST GENDER DOB [DOD] [BIRTH_PLACE] [DEATH_PLACE]"}},
+        {"update-person", {&CommandProcessor::updatePerson, 5, 8, true,
+            "update-person ID FIRST LAST GENDER DOB [DOD] [BIRTH_PLACE] [DEATH_PLACE]"}},
+        {"delete-person", {&CommandProcessor::deletePerson, 1, 1, true, "delete-person ID"}},
+        {"delete-branch", {&CommandProcessor::deleteBranch, 1, 2, true, "delete-branch ID [with-spouses]"}},
+        {"link", {&CommandProcessor::link, 3, 5, true, "link ID1 ID2 parent|spouse|sibling [FROM [TO]]"}},
+        {"link-dates", {&CommandProcessor::linkDates, 2, 3, true, "link-dates RELATIONSHIP_ID FROM [TO]"}},
+        {"unlink", {&CommandProcessor::unlink, 1, 1, true, "unlink RELATIONSHIP_ID"}},
+        {"get", {&CommandProcessor::get, 1, 1, false, "get ID"}},
+        {"parents", {&CommandProcessor::parents, 1, 1, false, "parents ID"}},
+        {"children", {&CommandProcessor::children, 1, 1, false, "children ID"}},
+        {"spouse", {&CommandProcessor::spouse, 1, 2, false, "spouse ID [DATE]"}},
+        {"siblings", {&CommandProcessor::siblings, 1, 2, false, "siblings ID [full|half]"}},
+        {"family", {&CommandProcessor::family, 1, 1, false, "family ID"}},
+        {"ancestors", {&CommandProcessor::ancestors, 1, 2, false, "ancestors ID [GENERATIONS]"}},
+        {"descendants", {&CommandProcessor::descendants, 1, 2, false, "descendants ID [GENERATIONS]"}},
+        {"common-ancestors", {&CommandProcessor::commonAncestors, 2, 2, false, "common-ancestors ID1 ID2"}},
+        {"gap", {&CommandProcessor::generationGap, 2, 2, false, "gap ID1 ID2"}},
+        {"path", {&CommandProcessor::path, 2, 7, false,
+            "path ID1 ID2 [MAX_HOPS] [parent=W] [child=W] [spouse=W] [sibling=W]"}},
+        {"alive", {&CommandProcessor::alive, 1, 2, false, "alive DATE [TO_DATE]"}},
+        {"contemporaries", {&CommandProcessor::contemporaries, 1, 2, false, "contemporaries ID [relatives]"}},
+        {"living-family", {&CommandProcessor::livingFamily, 2, 2, false, "living-family ID DATE"}},
+        {"household", {&CommandProcessor::household, 2, 2, false, "household ID DATE"}},
+        {"marriages", {&CommandProcessor::marriages, 1, 1, false, "marriages DATE"}},
+        {"line", {&CommandProcessor::directLine, 2, 3, false,
+            "line ID paternal|maternal [ancestors|descendants|members]"}},
+        {"root", {&CommandProcessor::root, 0, 1, true, "root [ID]"}},
+        {"generation", {&CommandProcessor::generation, 1, 1, false, "generation ID"}},
+        {"generation-list", {&CommandProcessor::generationList, 1, 2, false, "generation-list N [depth]"}},
+        {"generation-slice", {&CommandProcessor::generationSlice, 3, 4, false,
+            "generation-slice ID ancestors|descendants GENERATION [root]"}},
+        {"search", {&CommandProcessor::search, 1, 2, false,
+            "search NAME [substring|phonetic|soundex|dm|metaphone]"}},
+        {"export", {&CommandProcessor::exportTree, 0, 0, false, "export"}},
+        {"chart", {&CommandProcessor::chart, 4, 6, false,
+            "chart ID pedigree|descendants|hourglass svg|dot FILE [GENERATIONS] [no-spouses]"}},
+        {"cache-stats", {&CommandProcessor::cacheStats, 0, 0, false, "cache-stats"}},
+        {"stats", {&CommandProcessor::stats, 0, 1, false, "stats [on|off|reset]"}},
+        {"slow-log", {&CommandProcessor::slowLog, 0, 2, false, "slow-log [off|THRESHOLD_MS [FILE]]"}},
+        {"merge", {&CommandProcessor::merge, 1, 4, true,
+            "merge DB_FILE [no-match] [map=FILE] [prefix=PREFIX]"}},
+        {"duplicates", {&CommandProcessor::duplicates, 0, 2, false, "duplicates [MIN_SCORE] [LIMIT]"}},
+        {"place-stats", {&CommandProcessor::placeStats, 0, 1, false, "place-stats [PLACE]"}},
+        {"inbreeding", {&CommandProcessor::inbreeding, 0, 1, false, "inbreeding [ID]"}},
+        {"kinship", {&CommandProcessor::kinship, 2, 2, false, "kinship ID1 ID2"}},
+        {"kinship-matrix", {&CommandProcessor::kinshipMatrix, 2, 2, false,
+            "kinship-matrix COHORT_FILE CSV_FILE"}},
+        {"shards", {&CommandProcessor::listShards, 0, 0, false, "shards"}},
+        {"shard-add", {&CommandProcessor::addShard, 1, 3, true, "shard-add DB_FILE [SURNAME_FROM] [SURNAME_TO]"}},
+        {"shard-move-branch", {&CommandProcessor::moveBranchToShard, 2, 3, true,
+            "shard-move-branch ID SHARD_ID [with-spouses]"}}
+    };
+    return table;
+}
+
+CommandResult CommandProcessor::execute(const std::string& line) {
+    return execute(tokenize(line));
+}
+
+CommandResult CommandProcessor::execute(const std::vector<std::string>& tokens) {
+    CommandResult result;
+    if (tokens.empty()) {
+        result.error = "Empty command";
+        return result;
+    }
+
+    result.command = tokens[0];
+    auto it = commands().find(tokens[0]);
+    if (it == commands().end()) {
+        result.error = "Unknown command: " + tokens[0];
+        return result;
+    }
+
+    const CommandSpec& spec = it->second;
+    result.mutating = spec.mutating;
+    std::vector<std::string> args(tokens.begin() + 1, tokens.end());
+    if (args.size() < spec.minArgs || args.size() > spec.maxArgs) {
+        result.error = std::string("Usage: ") + spec.usage;
+        return result;
+    }
+
+    try {
+        result.payload = (this->*spec.handler)(args);
+        result.ok = true;
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+std::vector<std::string> CommandProcessor::tokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        if (std::isspace(static_cast<unsigned char>(line[i]))) {
+            i++;
+            continue;
+        }
+        if (line[i] == '#' && tokens.empty()) {
+            break;
+        }
+
+        std::string token;
+        if (line[i] == '"') {
+            i++;
+            while (i < line.size() && line[i] != '"') {
+                if (line[i] == '\\' && i + 1 < line.size()) {
+                    i++;
+                }
+                token += line[i++];
+            }
+            i++;  // closing quote
+        } else {
+            while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) {
+                token += line[i++];
+            }
+        }
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+bool CommandProcessor::isMutating(const std::string& command) {
+    auto it = commands().find(command);
+    return it != commands().end() && it->second.mutating;
+}
+
+bool CommandProcessor::runsOutsideTransaction(const std::string& command) {
+    return command == "merge" || command == "shard-add";
+}
+
+std::string CommandProcessor::help() {
+    std::string text;
+    for (const auto& entry : commands()) {
+        text += std::string("  ") + entry.second.usage + "\n";
+    }
+    return text;
+}
+
+// Command handlers
+std::string CommandProcessor::addPerson(const std::vector<std::string>& args) {
+    if (!tree.addPerson(personFromArgs(args))) {
+        throw std::runtime_error("Failed to add person " + args[0]);
+    }
+    return "null";
+}
+
+std::string CommandProcessor::updatePerson(const std::vector<std::string>& args) {
+    if (!tree.getPerson(args[0])) {
+        throw std::runtime_error("Person not found: " + args[0]);
+    }
+    if (!tree.updatePerson(personFromArgs(args))) {
+        throw std::runtime_error("Failed to update person " + args[0]);
+    }
+    return "null";
+}
+
+std::string CommandProcessor::deletePerson(const std::vector<std::string>& args) {
+    if (!tree.deletePerson(args[0])) {
+        throw std::runtime_error("Failed to delete person " + args[0]);
+    }
+    return "null";
+}
+
+std::string CommandProcessor::deleteBranch(const std::vector<std::string>& args) {
+    bool includeSpouses = false;
+    if (args.size() > 1) {
+        if (args[1] != "with-spouses") {
+            throw std::invalid_argument("Unknown option: " + args[1]);
+        }
+        includeSpouses = true;
+    }
+    int removed = tree.deleteBranch(args[0], includeSpouses);
+    if (removed == 0) {
+        throw std::runtime_error("Person not found: " + args[0]);
+    }
+    return std::to_string(removed);
+}
+
+std::string CommandProcessor::link(const std::vector<std::string>& args) {
+    RelationType type = parseRelationType(args[2]);
+    std::string relationshipId;
+    if (!tree.addRelationship(args[0], args[1], type, args.size() > 3 ? args[3] : "",
+                              args.size() > 4 ? args[4] : "", &relationshipId)) {
+        throw std::runtime_error("Failed to link " + args[0] + " and " + args[1]);
+    }
+    return JsonFormatter::quote(relationshipId);
+}
+
+std::string CommandProcessor::linkDates(const std::vector<std::string>& args) {
+    if (!tree.setRelationshipDates(args[0], args[1], args.size() > 2 ? args[2] : "")) {
+        throw std::runtime_error("Relationship not found: " + args[0]);
+    }
+    return "null";
+}
+
+std::string CommandProcessor::unlink(const std::vector<std::string>& args) {
+    if (!tree.removeRelationship(args[0])) {
+        throw std::runtime_error("Failed to remove relationship " + args[0]);
+    }
+    return "null";
+}
+
+std::string CommandProcessor::get(const std::vector<std::string>& args) {
+    return JsonFormatter::person(tree.getPerson(args[0]));
+}
+
+std::string CommandProcessor::parents(const std::vector<std::string>& args) {
+    return JsonFormatter::people(tree.getParents(args[0]));
+}
+
+std::string CommandProcessor::children(const std::vector<std::string>& args) {
+    return JsonFormatter::people(tree.getChildren(args[0]));
+}
+
+std::string CommandProcessor::spouse(const std::vector<std::string>& args) {
+    if (args.size() > 1) {
+        return JsonFormatter::person(relationshipTimeline.spouseOn(args[0], args[1]));
+    }
+    return JsonFormatter::person(tree.getSpouse(args[0]));
+}
+
+std::string CommandProcessor::siblings(const std::vector<std::string>& args) {
+    SiblingKind kind = SiblingKind::ALL;
+    if (args.size() > 1) {
+        if (args[1] == "full") {
+            kind = SiblingKind::FULL;
+        } else if (args[1] == "half") {
+            kind = SiblingKind::HALF;
+        } else {
+            throw std::invalid_argument("Unknown option: " + args[1]);
+        }
+    }
+    return JsonFormatter::people(tree.getSiblings(args[0], kind));
+}
+
+std::string CommandProcessor::family(const std::vector<std::string>& args) {
+    if (!tree.getPerson(args[0])) {
+        throw std::runtime_error("Person not found: " + args[0]);
+    }
+    auto toJson = [](const FamilyUnit& unit) {
+        std::string children;
+        for (const auto& id : unit.childIds) {
+            children += (children.empty() ? "" : ",") + JsonFormatter::quote(id);
+        }
+        return "{\"partner1\":" + JsonFormatter::quote(unit.partner1Id) +
+               ",\"partner2\":" + (unit.partner2Id.empty() ? "null" : JsonFormatter::quote(unit.partner2Id)) +
+               ",\"married\":" + (unit.married ? "true" : "false") +
+               ",\"children\":[" + children + "]}";
+    };
+    auto parents = tree.getParentFamily(args[0]);
+    std::string families;
+    for (const auto& unit : tree.getFamilies(args[0])) {
+        families += (families.empty() ? "" : ",") + toJson(unit);
+    }
+    return "{\"id\":" + JsonFormatter::quote(args[0]) +
+           ",\"parents\":" + (parents ? toJson(*parents) : "null") +
+           ",\"families\":[" + families + "]}";
+}
+
+std::string CommandProcessor::ancestors(const std::vector<std::string>& args) {
+    int generations = args.size() > 1 ? parseInt(args[1]) : -1;
+    return JsonFormatter::people(tree.getAncestors(args[0], generations));
+}
+
+std::string CommandProcessor::descendants(const std::vector<std::string>& args) {
+    int generations = args.size() > 1 ? parseInt(args[1]) : -1;
+    return JsonFormatter::people(tree.getDescendants(args[0], generations));
+}
+
+std::string CommandProcessor::commonAncestors(const std::vector<std::string>& args) {
+    return JsonFormatter::people(tree.findCommonAncestors(args[0], args[1]));
+}
+
+std::string CommandProcessor::generationGap(const std::vector<std::string>& args) {
+    return std::to_string(tree.calculateGenerationGap(args[0], args[1]));
+}
+
+std::string CommandProcessor::path(const std::vector<std::string>& args) {
+    PathOptions options;
+    for (size_t i = 2; i < args.size(); i++) {
+        size_t equals = args[i].find('=');
+        if (equals == std::string::npos) {
+            options.maxHops = parseInt(args[i]);
+            continue;
+        }
+        std::string kind = args[i].substr(0, equals);
+        double weight = parseDouble(args[i].substr(equals + 1));
+        if (kind == "parent") {
+            options.parentWeight = weight;
+        } else if (kind == "child") {
+            options.childWeight = weight;
+        } else if (kind == "spouse") {
+            options.spouseWeight = weight;
+        } else if (kind == "sibling") {
+            options.siblingWeight = weight;
+        } else {
+            throw std::invalid_argument("Unknown step kind: " + kind);
+        }
+    }
+
+    RelationshipPath found = relationshipCalculator.shortestPath(args[0], args[1], options);
+    if (!found.found()) {
+        return "{\"found\":false}";
+    }
+    std::string people;
+    for (const auto& id : found.people) {
+        people += (people.empty() ? "" : ",") + JsonFormatter::quote(id);
+    }
+    std::string steps;
+    for (PathEdge edge : found.edges) {
+        steps += (steps.empty() ? "" : ",") + JsonFormatter::quote(RelationshipCalculator::edgeToString(edge));
+    }
+    return "{\"found\":true,\"cost\":" + std::to_string(found.cost) +
+           ",\"people\":[" + people + "],\"steps\":[" + steps + "]}";
+}
+
+std::string CommandProcessor::alive(const std::vector<std::string>& args) {
+    return JsonFormatter::people(lifespanIndex.aliveDuring(args[0], args.size() > 1 ? args[1] : args[0]));
+}
+
+std::string CommandProcessor::contemporaries(const std::vector<std::string>& args) {
+    if (args.size() > 1 && args[1] != "relatives") {
+        throw std::invalid_argument("Unknown option: " + args[1]);
+    }
+    return JsonFormatter::people(lifespanIndex.contemporaries(args[0], args.size() > 1));
+}
+
+std::string CommandProcessor::livingFamily(const std::vector<std::string>& args) {
+    return JsonFormatter::people(relationshipTimeline.livingFamilyOn(args[0], args[1]));
+}
+
+std::string CommandProcessor::household(const std::vector<std::string>& args) {
+    return JsonFormatter::people(relationshipTimeline.householdOn(args[0], args[1]));
+}
+
+std::string CommandProcessor::marriages(const std::vector<std::string>& args) {
+    return JsonFormatter::relationships(relationshipTimeline.marriagesOn(args[0]));
+}
+
+std::string CommandProcessor::directLine(const std::vector<std::string>& args) {
+    DirectLine line = parseDirectLine(args[1]);
+    std::string view = args.size() > 2 ? args[2] : "ancestors";
+    if (view == "ancestors") return JsonFormatter::people(tree.getLineAncestors(args[0], line));
+    if (view == "descendants") return JsonFormatter::people(tree.getLineDescendants(args[0], line));
+    if (view == "members") return JsonFormatter::people(tree.getLineMembers(args[0], line));
+    throw std::invalid_argument("Unknown option: " + view);
+}
+
+std::string CommandProcessor::root(const std::vector<std::string>& args) {
+    if (!args.empty()) {
+        tree.setRootPerson(args[0]);
+    }
+    std::string id = tree.getRootPerson();
+    return id.empty() ? "null" : JsonFormatter::quote(id);
+}
+
+std::string CommandProcessor::generation(const std::vector<std::string>& args) {
+    int depth = tree.getDepth(args[0]);
+    if (depth < 0) {
+        throw std::runtime_error("Person not found: " + args[0]);
+    }
+    auto generation = tree.getGeneration(args[0]);
+    return "{\"id\":" + JsonFormatter::quote(args[0]) +
+           ",\"generation\":" + (generation ? std::to_string(*generation) : "null") +
+           ",\"depth\":" + std::to_string(depth) + "}";
+}
+
+std::string CommandProcessor::generationList(const std::vector<std::string>& args) {
+    int number = parseInt(args[0]);
+    if (args.size() > 1) {
+        if (args[1] != "depth") {
+            throw std::invalid_argument("Unknown option: " + args[1]);
+        }
+        return JsonFormatter::people(tree.getPeopleAtDepth(number));
+    }
+    return JsonFormatter::people(tree.getPeopleInGeneration(number));
+}
+
+std::string CommandProcessor::generationSlice(const std::vector<std::string>& args) {
+    int generation = parseInt(args[2]);
+    GenerationOrigin origin = GenerationOrigin::PERSON;
+    if (args.size() > 3) {
+        if (args[3] != "root") {
+            throw std::invalid_argument("Unknown option: " + args[3]);
+        }
+        origin = GenerationOrigin::ROOT;
+    }
+    if (args[1] == "ancestors") {
+        return JsonFormatter::people(tree.getAncestorsInGeneration(args[0], generation, origin));
+    }
+    if (args[1] == "descendants") {
+        return JsonFormatter::people(tree.getDescendantsInGeneration(args[0], generation, origin));
+    }
+    throw std::invalid_argument("Unknown option: " + args[1]);
+}
+
+std::string CommandProcessor::search(const std::vector<std::string>& args) {
+    NameSearchMode mode = args.size() > 1 ? parseSearchMode(args[1]) : NameSearchMode::SUBSTRING;
+    return JsonFormatter::people(tree.searchByName(args[0], mode));
+}
+
+std::string CommandProcessor::exportTree(const std::vector<std::string>&) {
+    return "{\"people\":" + JsonFormatter::people(tree.getAllPeople()) +
+           ",\"relationships\":" + JsonFormatter::relationships(tree.getAllRelationships()) + "}";
+}
+
+std::string CommandProcessor::chart(const std::vector<std::string>& args) {
+    ChartOptions options;
+    options.type = ChartExporter::parseType(args[1]);
+    options.format = ChartExporter::parseFormat(args[2]);
+    for (size_t i = 4; i < args.size(); i++) {
+        if (args[i] == "no-spouses") {
+            options.includeSpouses = false;
+        } else {
+            options.generations = parseInt(args[i]);
+        }
+    }
+
+    std::ofstream out(args[3], std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Cannot write chart: " + args[3]);
+    }
+    ChartSummary summary = ChartExporter(tree).write(args[0], options, out);
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Writing chart failed: " + args[3]);
+    }
+    return "{\"file\":" + JsonFormatter::quote(args[3]) +
+           ",\"boxes\":" + std::to_string(summary.boxes) +
+           ",\"people\":" + std::to_string(summary.people) +
+           ",\"ancestor_generations\":" + std::to_string(summary.ancestorGenerations) +
+           ",\"descendant_generations\":" + std::to_string(summary.descendantGenerations) + "}";
+}
+
+std::string CommandProcessor::cacheStats(const std::vector<std::string>&) {
+    QueryCacheStats stats = tree.getCacheStats();
+    return "{\"hits\":" + std::to_string(stats.hits) +
+           ",\"misses\":" + std::to_string(stats.misses) +
+           ",\"hit_rate\":" + std::to_string(stats.hitRate()) +
+           ",\"evictions\":" + std::to_string(stats.evictions) +
+           ",\"invalidations\":" + std::to_string(stats.invalidations) +
+           ",\"entries\":" + std::to_string(stats.entries) +
+           ",\"bytes\":" + std::to_string(stats.bytes) +
+           ",\"budget_bytes\":" + std::to_string(stats.budgetBytes) + "}";
+}
+
+std::string CommandProcessor::stats(const std::vector<std::string>& args) {
+    if (!args.empty()) {
+        if (args[0] == "on") {
+            Metrics::setEnabled(true);
+        } else if (args[0] == "off") {
+            Metrics::setEnabled(false);
+        } else if (args[0] == "reset") {
+            Metrics::reset();
+        } else {
+            throw std::invalid_argument("Unknown option: " + args[0]);
+        }
+    }
+    return Metrics::toJson();
+}
+
+std::string CommandProcessor::slowLog(const std::vector<std::string>& args) {
+    if (!args.empty()) {
+        if (args[0] == "off") {
+            SlowQueryLog::disable();
+        } else {
+            SlowQueryLogOptions options = SlowQueryLog::options();
+            options.thresholdMillis = parseDouble(args[0]);
+            if (args.size() > 1) options.path = args[1];
+            SlowQueryLog::enable(options);
+        }
+    }
+    SlowQueryLogOptions options = SlowQueryLog::options();
+    return "{\"enabled\":" + std::string(SlowQueryLog::enabled() ? "true" : "false") +
+           ",\"threshold_ms\":" + std::to_string(options.thresholdMillis) +
+           ",\"path\":" + JsonFormatter::quote(options.path) + "}";
+}
+
+std::string CommandProcessor::merge(const std::vector<std::string>& args) {
+    MergeOptions options;
+    for (size_t i = 1; i < args.size(); i++) {
+        const std::string& option = args[i];
+        if (option == "no-match") {
+            options.matchByIdentity = false;
+        } else if (option.compare(0, 4, "map=") == 0) {
+            // One "INCOMING_ID EXISTING_ID" pair per line
+            std::ifstream mapFile(option.substr(4));
+            if (!mapFile) {
+                throw std::runtime_error("Cannot open identity map: " + option.substr(4));
+            }
+            std::string line;
+            while (std::getline(mapFile, line)) {
+                auto ids = tokenize(line);
+                if (ids.empty()) continue;
+                if (ids.size() != 2) {
+                    throw std::invalid_argument("Bad identity map line: " + line);
+                }
+                options.identityMap[ids[0]] = ids[1];
+            }
+        } else if (option.compare(0, 7, "prefix=") == 0) {
+            options.conflictPrefix = option.substr(7);
+        } else {
+            throw std::invalid_argument("Unknown option: " + option);
+        }
+    }
+
+    MergeSummary summary = tree.mergeDatabase(args[0], options);
+    std::string conflicts;
+    for (const auto& conflict : summary.conflicts) {
+        if (!conflicts.empty()) conflicts += ",";
+        conflicts += "{\"incoming_id\":" + JsonFormatter::quote(conflict.incomingId) +
+                     ",\"assigned_id\":" +
+                     (conflict.assignedId.empty() ? "null" : JsonFormatter::quote(conflict.assignedId)) +
+                     ",\"reason\":" + JsonFormatter::quote(conflict.reason) + "}";
+    }
+    return "{\"incoming_people\":" + std::to_string(summary.incomingPeople) +
+           ",\"people_added\":" + std::to_string(summary.peopleAdded) +
+           ",\"people_matched\":" + std::to_string(summary.peopleMatched) +
+           ",\"incoming_relationships\":" + std::to_string(summary.incomingRelationships) +
+           ",\"relationships_added\":" + std::to_string(summary.relationshipsAdded) +
+           ",\"relationships_skipped\":" + std::to_string(summary.relationshipsSkipped) +
+           ",\"conflicts\":[" + conflicts + "]}";
+}
+
+std::string CommandProcessor::duplicates(const std::vector<std::string>& args) {
+    DuplicateOptions options;
+    if (args.size() > 0) options.minScore = parseDouble(args[0]);
+    if (args.size() > 1) options.maxResults = static_cast<size_t>(std::max(parseInt(args[1]), 0));
+
+    std::string json = "[";
+    for (const auto& candidate : DuplicateDetector(tree).findDuplicates(options)) {
+        if (json.size() > 1) json += ",";
+        json += "{\"person1\":" + JsonFormatter::quote(candidate.person1Id) +
+                ",\"person2\":" + JsonFormatter::quote(candidate.person2Id) +
+                ",\"score\":" + std::to_string(candidate.score) +
+                ",\"name\":" + std::to_string(candidate.nameScore) +
+                ",\"dates\":" + std::to_string(candidate.dateScore) +
+                ",\"places\":" + std::to_string(candidate.placeScore) +
+                ",\"relatives\":" + std::to_string(candidate.relativeScore) + "}";
+    }
+    return json + "]";
+}
+
+std::string CommandProcessor::placeStats(const std::vector<std::string>& args) {
+    std::string json = "[";
+    for (const auto& count : tree.getPlaceCounts(args.empty() ? "" : args[0])) {
+        if (json.size() > 1) json += ",";
+        json += "{\"place\":" + JsonFormatter::quote(count.place) +
+                ",\"decade\":" + std::to_string(count.decade) +
+                ",\"births\":" + std::to_string(count.births) +
+                ",\"deaths\":" + std::to_string(count.deaths) + "}";
+    }
+    return json + "]";
+}
+
+std::string CommandProcessor::inbreeding(const std::vector<std::string>& args) {
+    KinshipCalculator calculator(tree);
+    if (!args.empty()) {
+        return "{\"id\":" + JsonFormatter::quote(args[0]) +
+               ",\"inbreeding\":" + std::to_string(calculator.inbreedingCoefficient(args[0])) + "}";
+    }
+
+    // Everyone inbred, most inbred first
+    std::vector<std::pair<std::string, double>> inbred;
+    for (const auto& entry : calculator.inbreedingCoefficients()) {
+        if (entry.second > 0) inbred.emplace_back(entry);
+    }
+    std::sort(inbred.begin(), inbred.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    std::string json = "[";
+    for (const auto& entry : inbred) {
+        if (json.size() > 1) json += ",";
+        json += "{\"id\":" + JsonFormatter::quote(entry.first) +
+                ",\"inbreeding\":" + std::to_string(entry.second) + "}";
+    }
+    return json + "]";
+}
+
+std::string CommandProcessor::kinship(const std::vector<std::string>& args) {
+    double value = KinshipCalculator(tree).kinship({{args[0], args[1]}}).front();
+    return "{\"person1\":" + JsonFormatter::quote(args[0]) +
+           ",\"person2\":" + JsonFormatter::quote(args[1]) +
+           ",\"kinship\":" + std::to_string(value) + "}";
+}
+
+std::string CommandProcessor::kinshipMatrix(const std::vector<std::string>& args) {
+    std::ifstream in(args[0]);
+    if (!in) {
+        throw std::runtime_error("Cannot read cohort: " + args[0]);
+    }
+    std::vector<std::string> cohort;
+    std::string id;
+    while (in >> id) {
+        cohort.push_back(id);
+    }
+    KinshipMatrix matrix = KinshipCalculator(tree).kinshipMatrix(cohort);
+
+    std::ofstream out(args[1], std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Cannot write kinship matrix: " + args[1]);
+    }
+    out << "id";
+    for (const auto& column : matrix.ids) {
+        out << "," << column;
+    }
+    out << "\n";
+    char value[32];
+    for (size_t row = 0; row < matrix.ids.size(); row++) {
+        out << matrix.ids[row];
+        for (size_t column = 0; column < matrix.ids.size(); column++) {
+            std::snprintf(value, sizeof(value), ",%.10g", matrix.at(row, column));
+            out << value;
+        }
+        out << "\n";
+    }
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Writing kinship matrix failed: " + args[1]);
+    }
+    return "{\"file\":" + JsonFormatter::quote(args[1]) +
+           ",\"people\":" + std::to_string(matrix.ids.size()) + "}";
+}
+
+std::string CommandProcessor::listShards(const std::vector<std::string>&) {
+    std::string json = "[";
+    for (const auto& shard : tree.getShards()) {
+        if (json.size() > 1) json += ",";
+        json += "{\"id\":" + std::to_string(shard.id) +
+                ",\"path\":" + JsonFormatter::quote(shard.path) +
+                ",\"surname_from\":" + JsonFormatter::quote(shard.surnameFrom) +
+                ",\"surname_to\":" + JsonFormatter::quote(shard.surnameTo) +
+                ",\"people\":" + std::to_string(tree.countPeople(shard.id)) + "}";
+    }
+    return json + "]";
+}
+
+std::string CommandProcessor::addShard(const std::vector<std::string>& args) {
+    int moved = tree.addShard(args[0], args.size() > 1 ? args[1] : "", args.size() > 2 ? args[2] : "");
+    return std::to_string(moved);
+}
+
+std::string CommandProcessor::moveBranchToShard(const std::vector<std::string>& args) {
+    bool includeSpouses = false;
+    if (args.size() > 2) {
+        if (args[2] != "with-spouses") {
+            throw std::invalid_argument("Unknown option: " + args[2]);
+        }
+        includeSpouses = true;
+    }
+    if (!tree.getPerson(args[0])) {
+        throw std::runtime_error("Person not found: " + args[0]);
+    }
+    return std::to_string(tree.moveBranchToShard(args[0], parseInt(args[1]), includeSpouses));
+}
+
+// Helper methods
+Person CommandProcessor::personFromArgs(const std::vector<std::string>& args) {
+    Person person(args[0], args[1], args[2], args[3], args[4]);
+    if (args.size() > 5 && !args[5].empty()) person.setDateOfDeath(args[5]);
+    if (args.size() > 6 && !args[6].empty()) person.setBirthPlace(args[6]);
+    if (args.size() > 7 && !args[7].empty()) person.setDeathPlace(args[7]);
+    return person;
+}
+
+RelationType CommandProcessor::parseRelationType(const std::string& type) {
+    if (type == "parent" || type == "parent-child") return RelationType::PARENT_CHILD;
+    if (type == "spouse") return RelationType::SPOUSE;
+    if (type == "sibling") return RelationType::SIBLING;
+    return Relationship::relationTypeFromString(type);
+}
+
+NameSearchMode CommandProcessor::parseSearchMode(const std::string& mode) {
+    if (mode == "substring") return NameSearchMode::SUBSTRING;
+    if (mode == "phonetic") return NameSearchMode::PHONETIC;
+    if (mode == "soundex") return NameSearchMode::SOUNDEX;
+    if (mode == "dm") return NameSearchMode::DAITCH_MOKOTOFF;
+    if (mode == "metaphone") return NameSearchMode::DOUBLE_METAPHONE;
+    throw std::invalid_argument("Unknown search mode: " + mode);
+}
+
+DirectLine CommandProcessor::parseDirectLine(const std::string& line) {
+    if (line == "paternal") return DirectLine::PATERNAL;
+    if (line == "maternal") return DirectLine::MATERNAL;
+    throw std::invalid_argument("Unknown line: " + line);
+}
+
+int CommandProcessor::parseInt(const std::string& value) {
+    try {
+        size_t used = 0;
+        int number = std::stoi(value, &used);
+        if (used == value.size()) {
+            return number;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Not a number: " + value);
+}
+
+double CommandProcessor::parseDouble(const std::string& value) {
+    try {
+        size_t used = 0;
+        double number = std::stod(value, &used);
+        if (used == value.size()) {
+            return number;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Not a number: " + value);
+}
@@ -0,0 +1,351 @@
+#include "services/DuplicateDetector.hpp"
+#include "utils/PhoneticEncoder.hpp"
+#include "utils/ThreadPool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <exception>
+#include <future>
+#include <memory>
+#include <unordered_map>
+
+struct DuplicateDetector::Record {
+    std::string id;
+    std::string firstName;   // lower case
+    std::string lastName;    // lower case
+    char gender = 0;
+    std::string dateOfBirth;
+    std::string dateOfDeath;
+    int birthYear = 0;       // 0 when unknown
+    int deathYear = 0;
+    std::string birthPlace;  // lower case
+    std::string surnameKey;  // Soundex of the last name
+    std::vector<uint32_t> relatives;  // sorted record indexes
+};
+
+namespace {
+
+// Score weights; they sum to 1
+const double NAME_WEIGHT = 0.45;
+const double DATE_WEIGHT = 0.25;
+const double PLACE_WEIGHT = 0.10;
+const double RELATIVE_WEIGHT = 0.20;
+const double UNKNOWN = 0.5;  // score of a comparison with a missing value
+
+const size_t PAIRS_PER_CHECK = 1024;
+
+std::string lower(const std::string& text) {
+    std::string result = text;
+    for (auto& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+// Leading "YYYY" of a date, 0 when absent
+int yearOf(const std::string& date) {
+    if (date.size() < 4 || !std::all_of(date.begin(), date.begin() + 4,
+                                        [](unsigned char c) { return std::isdigit(c); })) {
+        return 0;
+    }
+    return std::atoi(date.substr(0, 4).c_str());
+}
+
+double jaroWinklerLower(const std::string& a, const std::string& b) {
+    if (a.empty() && b.empty()) return 1.0;
+    if (a.empty() || b.empty()) return 0.0;
+    if (a == b) return 1.0;
+
+    const size_t range = std::max<size_t>(std::max(a.size(), b.size()) / 2, 1) - 1;
+    // Names are short: keep the match flags on the stack when they fit
+    char stackA[64] = {};
+    char stackB[64] = {};
+    std::vector<char> heapA, heapB;
+    char* matchedA = stackA;
+    char* matchedB = stackB;
+    if (a.size() > sizeof(stackA)) {
+        heapA.assign(a.size(), 0);
+        matchedA = heapA.data();
+    }
+    if (b.size() > sizeof(stackB)) {
+        heapB.assign(b.size(), 0);
+        matchedB = heapB.data();
+    }
+
+    size_t matches = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        size_t from = i > range ? i - range : 0;
+        size_t to = std::min(i + range + 1, b.size());
+        for (size_t j = from; j < to; j++) {
+            if (!matchedB[j] && a[i] == b[j]) {
+                matchedA[i] = matchedB[j] = 1;
+                matches++;
+                break;
+            }
+        }
+    }
+    if (matches == 0) return 0.0;
+
+    size_t transpositions = 0;
+    for (size_t i = 0, j = 0; i < a.size(); i++) {
+        if (!matchedA[i]) continue;
+        while (!matchedB[j]) j++;
+        if (a[i] != b[j]) transpositions++;
+        j++;
+    }
+
+    double m = static_cast<double>(matches);
+    double jaro = (m / a.size() + m / b.size() + (m - transpositions / 2.0) / m) / 3.0;
+
+    size_t prefix = 0;
+    while (prefix < 4 && prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) {
+        prefix++;
+    }
+    return jaro + prefix * 0.1 * (1.0 - jaro);
+}
+
+double compareDates(const std::string& a, int yearA, const std::string& b, int yearB) {
+    if (yearA == 0 || yearB == 0) return UNKNOWN;
+    if (a == b) return 1.0;
+    int diff = std::abs(yearA - yearB);
+    if (diff == 0) return 0.8;
+    if (diff == 1) return 0.6;
+    if (diff <= 3) return 0.3;
+    return 0.0;
+}
+
+} // namespace
+
+DuplicateDetector::DuplicateDetector(FamilyTree& tree) : tree(tree) {}
+
+double DuplicateDetector::jaroWinkler(const std::string& a, const std::string& b) {
+    return jaroWinklerLower(lower(a), lower(b));
+}
+
+std::vector<DuplicateCandidate> DuplicateDetector::findDuplicates(const DuplicateOptions& options,
+                                                                  CancellationToken token) {
+    // Snapshot the tree
+    std::vector<Record> records;
+    std::unordered_map<std::string, uint32_t> indexOf;
+    {
+        auto people = tree.getAllPeople();
+        records.reserve(people.size());
+        indexOf.reserve(people.size());
+        for (const auto& person : people) {
+            Record record;
+            record.id = person.getId();
+            record.firstName = lower(person.getFirstName());
+            record.lastName = lower(person.getLastName());
+            record.gender = person.getGender().empty() ? 0 : person.getGender()[0];
+            record.dateOfBirth = person.getDateOfBirth();
+            record.dateOfDeath = person.getDateOfDeath();
+            record.birthYear = yearOf(record.dateOfBirth);
+            record.deathYear = yearOf(record.dateOfDeath);
+            record.birthPlace = lower(person.getBirthPlace());
+            record.surnameKey = PhoneticEncoder::soundex(record.lastName);
+            indexOf.emplace(record.id, static_cast<uint32_t>(records.size()));
+            records.push_back(std::move(record));
+        }
+    }
+    for (const auto& relationship : tree.getAllRelationships()) {
+        auto first = indexOf.find(relationship.getPerson1Id());
+        auto second = indexOf.find(relationship.getPerson2Id());
+        if (first == indexOf.end() || second == indexOf.end()) continue;
+        records[first->second].relatives.push_back(second->second);
+        records[second->second].relatives.push_back(first->second);
+    }
+    for (auto& record : records) {
+        std::sort(record.relatives.begin(), record.relatives.end());
+    }
+    token.throwIfCancelled();
+
+    auto pairs = candidatePairs(records, options, token);
+
+    // Score in parallel, one chunk of pairs per task
+    ThreadPool pool(options.threads);
+    size_t chunkSize = std::max<size_t>(pairs.size() / (pool.size() * 4) + 1, PAIRS_PER_CHECK);
+    std::vector<std::vector<DuplicateCandidate>> chunkResults((pairs.size() + chunkSize - 1) / chunkSize);
+    std::vector<std::future<void>> pending;
+
+    for (size_t chunk = 0; chunk < chunkResults.size(); chunk++) {
+        auto task = std::make_shared<std::packaged_task<void()>>([&, chunk]() {
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(begin + chunkSize, pairs.size());
+            for (size_t i = begin; i < end; i++) {
+                if ((i - begin) % PAIRS_PER_CHECK == 0) {
+                    token.throwIfCancelled();
+                }
+                const Record& a = records[pairs[i].first];
+                const Record& b = records[pairs[i].second];
+                DuplicateCandidate candidate = score(a, b, records);
+                if (candidate.score >= options.minScore) {
+                    chunkResults[chunk].push_back(std::move(candidate));
+                }
+            }
+        });
+        pending.push_back(task->get_future());
+        pool.submit([task]() { (*task)(); });
+    }
+    // Wait for every task before rethrowing: they reference locals
+    std::exception_ptr failure;
+    for (auto& future : pending) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    std::vector<DuplicateCandidate> candidates;
+    for (auto& chunk : chunkResults) {
+        candidates.insert(candidates.end(),
+                          std::make_move_iterator(chunk.begin()),
+                          std::make_move_iterator(chunk.end()));
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const DuplicateCandidate& x, const DuplicateCandidate& y) {
+                  if (x.score != y.score) return x.score > y.score;
+                  if (x.person1Id != y.person1Id) return x.person1Id < y.person1Id;
+                  return x.person2Id < y.person2Id;
+              });
+    if (options.maxResults > 0 && candidates.size() > options.maxResults) {
+        candidates.resize(options.maxResults);
+    }
+    return candidates;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> DuplicateDetector::candidatePairs(
+    const std::vector<Record>& records,
+    const DuplicateOptions& options,
+    const CancellationToken& token) {
+    const int bucket = std::max(options.birthYearBucket, 1);
+
+    // (blocking key, record) for every key of every record. Two bucket
+    // grids offset by half a bucket keep close birth years together.
+    std::vector<std::pair<std::string, uint32_t>> keys;
+    keys.reserve(records.size() * 3);
+    for (uint32_t i = 0; i < records.size(); i++) {
+        const Record& record = records[i];
+        if (record.surnameKey.empty()) continue;
+        if (record.birthYear == 0) {
+            keys.emplace_back("Y|" + record.surnameKey + "|?", i);
+        } else {
+            keys.emplace_back("Y|" + record.surnameKey + "|" + std::to_string(record.birthYear / bucket), i);
+            keys.emplace_back("H|" + record.surnameKey + "|" +
+                              std::to_string((record.birthYear + bucket / 2) / bucket), i);
+        }
+        if (!record.birthPlace.empty()) {
+            keys.emplace_back("P|" + record.surnameKey + "|" + record.birthPlace, i);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    token.throwIfCancelled();
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    auto addPair = [&](uint32_t a, uint32_t b) {
+        pairs.emplace_back(std::min(a, b), std::max(a, b));
+    };
+
+    std::vector<uint32_t> block;
+    for (size_t start = 0; start < keys.size();) {
+        size_t end = start;
+        block.clear();
+        while (end < keys.size() && keys[end].first == keys[start].first) {
+            block.push_back(keys[end].second);
+            end++;
+        }
+        start = end;
+        if (block.size() < 2) continue;
+
+        if (block.size() <= options.maxBlockSize) {
+            for (size_t i = 0; i < block.size(); i++) {
+                for (size_t j = i + 1; j < block.size(); j++) {
+                    addPair(block[i], block[j]);
+                }
+            }
+        } else {
+            // Sorted neighbourhood: compare each member with the next few
+            std::sort(block.begin(), block.end(), [&](uint32_t a, uint32_t b) {
+                if (records[a].firstName != records[b].firstName) {
+                    return records[a].firstName < records[b].firstName;
+                }
+                return records[a].dateOfBirth < records[b].dateOfBirth;
+            });
+            for (size_t i = 0; i < block.size(); i++) {
+                for (size_t j = i + 1; j < block.size() && j <= i + options.window; j++) {
+                    addPair(block[i], block[j]);
+                }
+            }
+            token.throwIfCancelled();
+        }
+    }
+
+    // A pair may share several blocks
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    return pairs;
+}
+
+DuplicateCandidate DuplicateDetector::score(const Record& a, const Record& b,
+                                            const std::vector<Record>& records) {
+    DuplicateCandidate candidate;
+    candidate.person1Id = a.id;
+    candidate.person2Id = b.id;
+
+    // Different genders, or a recorded relationship between the two,
+    // rule the pair out
+    uint32_t indexB = static_cast<uint32_t>(&b - records.data());
+    if ((a.gender && b.gender && a.gender != b.gender) ||
+        std::binary_search(a.relatives.begin(), a.relatives.end(), indexB)) {
+        return candidate;
+    }
+
+    candidate.nameScore = 0.5 * jaroWinklerLower(a.firstName, b.firstName) +
+                          0.5 * jaroWinklerLower(a.lastName, b.lastName);
+
+    double birth = compareDates(a.dateOfBirth, a.birthYear, b.dateOfBirth, b.birthYear);
+    if (a.deathYear && b.deathYear) {
+        double death = compareDates(a.dateOfDeath, a.deathYear, b.dateOfDeath, b.deathYear);
+        candidate.dateScore = 0.7 * birth + 0.3 * death;
+    } else {
+        candidate.dateScore = birth;
+    }
+
+    if (a.birthPlace.empty() || b.birthPlace.empty()) {
+        candidate.placeScore = UNKNOWN;
+    } else {
+        candidate.placeScore = std::max(0.0, (jaroWinklerLower(a.birthPlace, b.birthPlace) - 0.7) / 0.3);
+    }
+
+    // Relatives in common: the same person, or likely copies of each
+    // other (similar name, same birth year) as imported trees bring along
+    if (a.relatives.empty() || b.relatives.empty()) {
+        candidate.relativeScore = UNKNOWN;
+    } else {
+        size_t shared = 0;
+        for (uint32_t x : a.relatives) {
+            const Record& relativeA = records[x];
+            for (uint32_t y : b.relatives) {
+                const Record& relativeB = records[y];
+                if (x == y || (relativeA.birthYear == relativeB.birthYear &&
+                               relativeA.surnameKey == relativeB.surnameKey &&
+                               jaroWinklerLower(relativeA.firstName, relativeB.firstName) >= 0.85)) {
+                    shared++;
+                    break;
+                }
+            }
+        }
+        candidate.relativeScore = static_cast<double>(shared) /
+                                  std::min(a.relatives.size(), b.relatives.size());
+        candidate.relativeScore = std::min(candidate.relativeScore, 1.0);
+    }
+
+    candidate.score = NAME_WEIGHT * candidate.nameScore +
+                      DATE_WEIGHT * candidate.dateScore +
+                      PLACE_WEIGHT * candidate.placeScore +
+                      RELATIVE_WEIGHT * candidate.relativeScore;
+    return candidate;
+}
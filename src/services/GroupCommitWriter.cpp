@@ -0,0 +1,155 @@
+#include "services/GroupCommitWriter.hpp"
+#include <vector>
+
+GroupCommitWriter::GroupCommitWriter(FamilyTree& tree, GroupCommitOptions options)
+    : tree(tree), options(options), stopping(false) {
+    if (this->options.maxBatchSize == 0) {
+        this->options.maxBatchSize = 1;
+    }
+    committer = std::thread(&GroupCommitWriter::commitLoop, this);
+}
+
+GroupCommitWriter::~GroupCommitWriter() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    committer.join();
+}
+
+std::future<bool> GroupCommitWriter::addPerson(const Person& person) {
+    return submit([person](FamilyTree& t) { return t.addPerson(person); });
+}
+
+std::future<bool> GroupCommitWriter::updatePerson(const Person& person) {
+    return submit([person](FamilyTree& t) { return t.updatePerson(person); });
+}
+
+std::future<bool> GroupCommitWriter::deletePerson(const std::string& personId) {
+    return submit([personId](FamilyTree& t) { return t.deletePerson(personId); });
+}
+
+std::future<bool> GroupCommitWriter::addRelationship(const std::string& person1Id,
+                                                     const std::string& person2Id,
+                                                     RelationType type) {
+    return submit([person1Id, person2Id, type](FamilyTree& t) {
+        return t.addRelationship(person1Id, person2Id, type);
+    });
+}
+
+std::future<bool> GroupCommitWriter::removeRelationship(const std::string& relationshipId) {
+    return submit([relationshipId](FamilyTree& t) { return t.removeRelationship(relationshipId); });
+}
+
+std::future<bool> GroupCommitWriter::submit(std::function<bool(FamilyTree&)> mutation) {
+    PendingMutation pending{std::move(mutation), std::promise<bool>(),
+                            options.durability == CommitDurability::ON_RETURN};
+    auto future = pending.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(pending));
+    }
+    queueCondition.notify_one();
+    return future;
+}
+
+void GroupCommitWriter::flush() {
+    PendingMutation marker{[](FamilyTree&) { return true; }, std::promise<bool>(), true};
+    auto future = marker.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(marker));
+    }
+    queueCondition.notify_one();
+    future.wait();
+}
+
+GroupCommitStats GroupCommitWriter::getStats() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return stats;
+}
+
+void GroupCommitWriter::commitLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        queueCondition.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        applyBatch(lock);
+    }
+}
+
+void GroupCommitWriter::applyBatch(std::unique_lock<std::mutex>& lock) {
+    auto deadline = std::chrono::steady_clock::now() + options.window;
+    std::vector<std::pair<std::promise<bool>, bool>> awaitingCommit;
+    size_t applied = 0;
+    uint64_t failed = 0;
+
+    lock.unlock();
+    tree.beginTransaction();
+    lock.lock();
+
+    while (applied < options.maxBatchSize) {
+        if (queue.empty()) {
+            // Keep the batch open for late arrivals until the window closes
+            if (stopping || !queueCondition.wait_until(lock, deadline, [this]() { return !queue.empty(); })) {
+                break;
+            }
+        }
+
+        PendingMutation pending = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        bool ok = false;
+        std::exception_ptr error;
+        tree.beginTransaction();  // savepoint isolating this mutation
+        try {
+            ok = pending.apply(tree);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (ok) {
+            tree.commit();
+        } else {
+            tree.rollback();
+            failed++;
+        }
+
+        if (error) {
+            pending.done.set_exception(error);
+        } else if (pending.waitForCommit) {
+            awaitingCommit.emplace_back(std::move(pending.done), ok);
+        } else {
+            pending.done.set_value(ok);
+        }
+        applied++;
+        lock.lock();
+    }
+
+    lock.unlock();
+    std::exception_ptr commitError;
+    try {
+        tree.commit();
+    } catch (...) {
+        commitError = std::current_exception();
+    }
+
+    // Counted before anyone waiting on the batch hears of it
+    lock.lock();
+    stats.mutations += applied;
+    stats.failed += commitError ? applied : failed;  // a failed commit undoes the whole batch
+    stats.batches++;
+    lock.unlock();
+
+    for (auto& entry : awaitingCommit) {
+        if (commitError) {
+            entry.first.set_exception(commitError);
+        } else {
+            entry.first.set_value(entry.second);
+        }
+    }
+    lock.lock();
+}
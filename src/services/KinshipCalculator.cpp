@@ -0,0 +1,414 @@
+#include "services/KinshipCalculator.hpp"
+#include "utils/ThreadPool.hpp"
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <unordered_set>
+
+struct KinshipCalculator::Pedigree {
+    std::vector<std::string> ids;   // parents before children
+    std::vector<int32_t> sire;      // index of the father (or first parent), -1 when unknown
+    std::vector<int32_t> dam;       // index of the mother (or second parent), -1 when unknown
+    // People of depth k (founders 0, otherwise one more than their deepest
+    // parent) are ids[levels[k], levels[k + 1])
+    std::vector<uint32_t> levels;
+    std::unordered_map<std::string, uint32_t> index;
+};
+
+namespace {
+
+// Columns computed together; one cache line of doubles, so each row
+// update in the column passes is a single vector operation
+const size_t BLOCK = 8;
+
+// People or columns handled between cancellation checks
+const size_t WORK_PER_CHECK = 1024;
+
+// Runs task(0) .. task(count - 1) on the pool and waits for all of them.
+// Rethrows the first failure once every task has finished, since tasks
+// reference the caller's locals.
+void runParallel(ThreadPool& pool, size_t count, const std::function<void(size_t)>& task) {
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < count; i++) {
+        auto work = std::make_shared<std::packaged_task<void()>>([&task, i]() { task(i); });
+        pending.push_back(work->get_future());
+        pool.submit([work]() { (*work)(); });
+    }
+    std::exception_ptr failure;
+    for (auto& future : pending) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+} // namespace
+
+KinshipCalculator::KinshipCalculator(FamilyTree& tree, const KinshipOptions& options)
+    : tree(tree), options(options) {}
+
+KinshipCalculator::Pedigree KinshipCalculator::snapshot(const std::vector<std::string>& ids,
+                                                        const CancellationToken& token) {
+    std::vector<Person> people = tree.getAllPeople();
+    std::unordered_map<std::string, uint32_t> indexOf;
+    indexOf.reserve(people.size());
+    for (uint32_t i = 0; i < people.size(); i++) {
+        indexOf.emplace(people[i].getId(), i);
+    }
+
+    // Father first when genders tell; otherwise in the order recorded.
+    // Parents beyond the second are ignored.
+    std::vector<int32_t> father(people.size(), -1);
+    std::vector<int32_t> mother(people.size(), -1);
+    std::vector<std::vector<uint32_t>> children(people.size());
+    for (const auto& relationship : tree.getAllRelationships()) {
+        if (relationship.getType() != RelationType::PARENT_CHILD) continue;
+        auto parent = indexOf.find(relationship.getPerson1Id());
+        auto child = indexOf.find(relationship.getPerson2Id());
+        if (parent == indexOf.end() || child == indexOf.end()) continue;
+
+        uint32_t p = parent->second;
+        uint32_t c = child->second;
+        int32_t& preferred = people[p].getGender() == "F" ? mother[c] : father[c];
+        int32_t& other = &preferred == &father[c] ? mother[c] : father[c];
+        if (preferred < 0) {
+            preferred = static_cast<int32_t>(p);
+        } else if (other < 0) {
+            other = static_cast<int32_t>(p);
+        } else {
+            continue;
+        }
+        children[p].push_back(c);
+    }
+    token.throwIfCancelled();
+
+    // The requested people and their ancestors
+    std::vector<char> selected(people.size(), ids.empty() ? 1 : 0);
+    std::vector<uint32_t> pending;
+    for (const auto& id : ids) {
+        auto it = indexOf.find(id);
+        if (it == indexOf.end()) {
+            throw std::invalid_argument("Person not found: " + id);
+        }
+        if (!selected[it->second]) {
+            selected[it->second] = 1;
+            pending.push_back(it->second);
+        }
+    }
+    while (!pending.empty()) {
+        uint32_t person = pending.back();
+        pending.pop_back();
+        for (int32_t parent : {father[person], mother[person]}) {
+            if (parent >= 0 && !selected[parent]) {
+                selected[parent] = 1;
+                pending.push_back(static_cast<uint32_t>(parent));
+            }
+        }
+    }
+
+    // Kahn's algorithm, assigning depths on the way
+    std::vector<uint32_t> depth(people.size(), 0);
+    std::vector<uint8_t> unresolved(people.size(), 0);
+    std::deque<uint32_t> ready;
+    size_t selectedCount = 0;
+    for (uint32_t i = 0; i < people.size(); i++) {
+        if (!selected[i]) continue;
+        selectedCount++;
+        unresolved[i] = static_cast<uint8_t>((father[i] >= 0) + (mother[i] >= 0));
+        if (unresolved[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    std::vector<uint32_t> order;
+    order.reserve(selectedCount);
+    while (!ready.empty()) {
+        uint32_t person = ready.front();
+        ready.pop_front();
+        order.push_back(person);
+        for (uint32_t child : children[person]) {
+            if (!selected[child]) continue;
+            depth[child] = std::max(depth[child], depth[person] + 1);
+            if (--unresolved[child] == 0) {
+                ready.push_back(child);
+            }
+        }
+    }
+    if (order.size() != selectedCount) {
+        throw std::runtime_error("Parent-Child relationships form a cycle");
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+
+    Pedigree pedigree;
+    std::vector<int32_t> position(people.size(), -1);
+    for (uint32_t i = 0; i < order.size(); i++) {
+        position[order[i]] = static_cast<int32_t>(i);
+    }
+    pedigree.ids.reserve(order.size());
+    pedigree.sire.reserve(order.size());
+    pedigree.dam.reserve(order.size());
+    pedigree.index.reserve(order.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        uint32_t person = order[i];
+        pedigree.ids.push_back(people[person].getId());
+        pedigree.sire.push_back(father[person] >= 0 ? position[father[person]] : -1);
+        pedigree.dam.push_back(mother[person] >= 0 ? position[mother[person]] : -1);
+        pedigree.index.emplace(pedigree.ids.back(), i);
+        if (i == 0 || depth[person] != depth[order[i - 1]]) {
+            pedigree.levels.push_back(i);
+        }
+    }
+    pedigree.levels.push_back(static_cast<uint32_t>(order.size()));
+    return pedigree;
+}
+
+std::vector<double> KinshipCalculator::inbreeding(const Pedigree& pedigree,
+                                                  const CancellationToken& token) const {
+    const size_t n = pedigree.ids.size();
+    std::vector<double> f(n, 0.0);
+    // Within-family (Mendelian sampling) variance of each person:
+    // 1/2 - (F_sire + F_dam) / 4, with F = -1 for an unknown parent
+    std::vector<double> variance(n, 1.0);
+    if (pedigree.levels.size() <= 2) {
+        return f;  // founders only
+    }
+
+    ThreadPool pool(options.threads);
+    struct Workspace {
+        std::vector<double> contribution;  // L of Meuwissen & Luo; all zero between people
+        std::vector<uint32_t> ancestors;   // max-heap of people with nonzero L
+    };
+    std::vector<Workspace> workspaces(pool.size());
+
+    // A_ii = sum over i and its ancestors k of L_k^2 * variance_k, where
+    // L_k is the expected share of k's genes in i. Visiting ancestors from
+    // the youngest (highest index) down completes each L_k before use.
+    auto inbreedingOf = [&](uint32_t person, Workspace& workspace) {
+        if (pedigree.sire[person] < 0 || pedigree.dam[person] < 0) {
+            return 0.0;
+        }
+        auto& l = workspace.contribution;
+        auto& heap = workspace.ancestors;
+        double relationship = 0.0;
+        l[person] = 1.0;
+        heap.push_back(person);
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end());
+            uint32_t k = heap.back();
+            heap.pop_back();
+            double half = 0.5 * l[k];
+            for (int32_t parent : {pedigree.sire[k], pedigree.dam[k]}) {
+                if (parent < 0) continue;
+                if (l[parent] == 0.0) {
+                    heap.push_back(static_cast<uint32_t>(parent));
+                    std::push_heap(heap.begin(), heap.end());
+                }
+                l[parent] += half;
+            }
+            relationship += l[k] * l[k] * variance[k];
+            l[k] = 0.0;
+        }
+        return relationship - 1.0;
+    };
+
+    // Everyone in a level depends only on earlier levels
+    for (size_t level = 0; level + 1 < pedigree.levels.size(); level++) {
+        const uint32_t begin = pedigree.levels[level];
+        const uint32_t end = pedigree.levels[level + 1];
+        for (uint32_t i = begin; i < end; i++) {
+            double sireF = pedigree.sire[i] >= 0 ? f[pedigree.sire[i]] : -1.0;
+            double damF = pedigree.dam[i] >= 0 ? f[pedigree.dam[i]] : -1.0;
+            variance[i] = 0.5 - 0.25 * (sireF + damF);
+        }
+        if (level == 0) continue;  // founders
+
+        size_t tasks = std::min<size_t>(workspaces.size(), (end - begin + WORK_PER_CHECK - 1) / WORK_PER_CHECK);
+        size_t chunk = (end - begin + tasks - 1) / tasks;
+        runParallel(pool, tasks, [&](size_t task) {
+            Workspace& workspace = workspaces[task];
+            if (workspace.contribution.empty()) {
+                workspace.contribution.assign(n, 0.0);
+            }
+            uint32_t from = static_cast<uint32_t>(begin + task * chunk);
+            uint32_t to = static_cast<uint32_t>(std::min<size_t>(from + chunk, end));
+            for (uint32_t i = from; i < to; i++) {
+                if ((i - from) % WORK_PER_CHECK == 0) {
+                    token.throwIfCancelled();
+                }
+                f[i] = inbreedingOf(i, workspace);
+            }
+        });
+    }
+    return f;
+}
+
+void KinshipCalculator::kinshipColumns(const Pedigree& pedigree, const std::vector<double>& inbreeding,
+                                       const std::vector<uint32_t>& columns,
+                                       const std::vector<uint32_t>& rows,
+                                       std::vector<double>& result,
+                                       const CancellationToken& token) const {
+    const size_t n = pedigree.ids.size();
+    result.assign(rows.size() * columns.size(), 0.0);
+    if (columns.empty() || rows.empty()) {
+        return;
+    }
+
+    std::vector<double> variance(n);
+    for (size_t i = 0; i < n; i++) {
+        double sireF = pedigree.sire[i] >= 0 ? inbreeding[pedigree.sire[i]] : -1.0;
+        double damF = pedigree.dam[i] >= 0 ? inbreeding[pedigree.dam[i]] : -1.0;
+        variance[i] = 0.5 - 0.25 * (sireF + damF);
+    }
+    const uint32_t lastRow = *std::max_element(rows.begin(), rows.end());
+
+    // With people in topological order, A = T D T' where T = (I - P)^-1,
+    // P holds 1/2 at each (child, parent) and D is the variance. A block of
+    // columns A e_j is T' applied backwards, scaled by D, then T applied
+    // forwards. Row i of the block is work[i * BLOCK, (i + 1) * BLOCK).
+    const size_t blocks = (columns.size() + BLOCK - 1) / BLOCK;
+    ThreadPool pool(options.threads);
+    const size_t tasks = std::min(pool.size(), blocks);
+    runParallel(pool, tasks, [&](size_t task) {
+        std::vector<double> work(n * BLOCK);
+        for (size_t block = task; block < blocks; block += tasks) {
+            token.throwIfCancelled();
+            const size_t first = block * BLOCK;
+            const size_t width = std::min(BLOCK, columns.size() - first);
+            std::fill(work.begin(), work.end(), 0.0);
+            uint32_t lastColumn = 0;
+            for (size_t b = 0; b < width; b++) {
+                work[columns[first + b] * BLOCK + b] = 1.0;
+                lastColumn = std::max(lastColumn, columns[first + b]);
+            }
+
+            // Backwards: only the columns' ancestors become nonzero
+            for (int64_t i = lastColumn; i >= 0; i--) {
+                const double* row = &work[i * BLOCK];
+                for (int32_t parent : {pedigree.sire[i], pedigree.dam[i]}) {
+                    if (parent < 0) continue;
+                    double* target = &work[parent * BLOCK];
+                    for (size_t b = 0; b < BLOCK; b++) {
+                        target[b] += 0.5 * row[b];
+                    }
+                }
+            }
+            for (size_t i = 0; i <= lastColumn; i++) {
+                double* row = &work[i * BLOCK];
+                for (size_t b = 0; b < BLOCK; b++) {
+                    row[b] *= variance[i];
+                }
+            }
+            // Forwards, as far as the last person asked about
+            for (size_t i = 0; i <= lastRow; i++) {
+                double* row = &work[i * BLOCK];
+                for (int32_t parent : {pedigree.sire[i], pedigree.dam[i]}) {
+                    if (parent < 0) continue;
+                    const double* source = &work[parent * BLOCK];
+                    for (size_t b = 0; b < BLOCK; b++) {
+                        row[b] += 0.5 * source[b];
+                    }
+                }
+            }
+
+            // Kinship is half the additive relationship
+            for (size_t r = 0; r < rows.size(); r++) {
+                const double* row = &work[rows[r] * BLOCK];
+                for (size_t b = 0; b < width; b++) {
+                    result[r * columns.size() + first + b] = 0.5 * row[b];
+                }
+            }
+        }
+    });
+}
+
+std::unordered_map<std::string, double> KinshipCalculator::inbreedingCoefficients(CancellationToken token) {
+    Pedigree pedigree = snapshot({}, token);
+    std::vector<double> f = inbreeding(pedigree, token);
+    std::unordered_map<std::string, double> result;
+    result.reserve(f.size());
+    for (size_t i = 0; i < f.size(); i++) {
+        result.emplace(pedigree.ids[i], f[i]);
+    }
+    return result;
+}
+
+double KinshipCalculator::inbreedingCoefficient(const std::string& personId, CancellationToken token) {
+    Pedigree pedigree = snapshot({personId}, token);
+    return inbreeding(pedigree, token)[pedigree.index.at(personId)];
+}
+
+std::vector<double> KinshipCalculator::kinship(const std::vector<std::pair<std::string, std::string>>& pairs,
+                                               CancellationToken token) {
+    if (pairs.empty()) {
+        return {};
+    }
+    std::vector<std::string> ids;
+    for (const auto& pair : pairs) {
+        ids.push_back(pair.first);
+        ids.push_back(pair.second);
+    }
+    Pedigree pedigree = snapshot(ids, token);
+    std::vector<double> f = inbreeding(pedigree, token);
+
+    // Kinship is symmetric: compute columns for the side with fewer people
+    std::vector<uint32_t> firsts, seconds;
+    for (const auto& pair : pairs) {
+        firsts.push_back(pedigree.index.at(pair.first));
+        seconds.push_back(pedigree.index.at(pair.second));
+    }
+    auto distinct = [](std::vector<uint32_t> values) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        return values;
+    };
+    std::vector<uint32_t> columns = distinct(firsts);
+    std::vector<uint32_t> rows = distinct(seconds);
+    bool swapped = rows.size() < columns.size();
+    if (swapped) {
+        std::swap(columns, rows);
+        std::swap(firsts, seconds);
+    }
+
+    std::vector<double> values;
+    kinshipColumns(pedigree, f, columns, rows, values, token);
+    std::vector<double> result;
+    result.reserve(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        size_t column = std::lower_bound(columns.begin(), columns.end(), firsts[i]) - columns.begin();
+        size_t row = std::lower_bound(rows.begin(), rows.end(), seconds[i]) - rows.begin();
+        result.push_back(values[row * columns.size() + column]);
+    }
+    return result;
+}
+
+KinshipMatrix KinshipCalculator::kinshipMatrix(const std::vector<std::string>& cohort, CancellationToken token) {
+    KinshipMatrix matrix;
+    std::unordered_set<std::string> seen;
+    for (const auto& id : cohort) {
+        if (seen.insert(id).second) {
+            matrix.ids.push_back(id);
+        }
+    }
+    if (matrix.ids.empty()) {
+        return matrix;
+    }
+    Pedigree pedigree = snapshot(matrix.ids, token);
+    std::vector<double> f = inbreeding(pedigree, token);
+
+    std::vector<uint32_t> members;
+    members.reserve(matrix.ids.size());
+    for (const auto& id : matrix.ids) {
+        members.push_back(pedigree.index.at(id));
+    }
+    kinshipColumns(pedigree, f, members, members, matrix.values, token);
+    return matrix;
+}
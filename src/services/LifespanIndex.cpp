@@ -0,0 +1,125 @@
+#include "services/LifespanIndex.hpp"
+#include "utils/DateFormatter.hpp"
+#include "utils/IntervalTree.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+struct LifespanIndex::Snapshot {
+    uint64_t revision = 0;
+    std::vector<Person> people;     // by first possible day of birth, then ID
+    std::unordered_map<std::string, uint32_t> index;
+    IntervalTree lifespans;         // day numbers, parallel to people
+};
+
+LifespanIndex::LifespanIndex(FamilyTree& tree, const LifespanOptions& options)
+    : tree(tree), options(options) {}
+
+LifespanIndex::~LifespanIndex() = default;
+
+std::shared_ptr<const LifespanIndex::Snapshot> LifespanIndex::currentSnapshot() {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    // Read the revision first: a write racing with the snapshot leaves it
+    // looking stale, never fresh
+    uint64_t revision = tree.getRevision();
+    if (snapshot && snapshot->revision == revision) {
+        return snapshot;
+    }
+
+    auto built = std::make_shared<Snapshot>();
+    built->revision = revision;
+    const auto maxLifespanDays = static_cast<int32_t>(options.maxLifespanYears * 365.2425);
+    struct Entry {
+        int32_t start;
+        int32_t end;
+        Person person;
+    };
+    std::vector<Entry> entries;
+    for (auto& person : tree.getAllPeople()) {
+        auto start = DateFormatter::toDayNumber(person.getDateOfBirth());
+        if (!start) continue;
+        auto death = DateFormatter::toDayNumber(person.getDateOfDeath(), true);
+        int32_t end = death ? std::max(*death, *start) : *start + maxLifespanDays;
+        entries.push_back({*start, end, std::move(person)});
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.start != b.start ? a.start < b.start : a.person.getId() < b.person.getId();
+    });
+
+    built->people.reserve(entries.size());
+    std::vector<int32_t> starts, ends;
+    starts.reserve(entries.size());
+    ends.reserve(entries.size());
+    for (auto& entry : entries) {
+        built->index.emplace(entry.person.getId(), static_cast<uint32_t>(built->people.size()));
+        starts.push_back(entry.start);
+        ends.push_back(entry.end);
+        built->people.push_back(std::move(entry.person));
+    }
+    built->lifespans = IntervalTree(std::move(starts), std::move(ends));
+
+    snapshot = built;
+    return snapshot;
+}
+
+std::vector<Person> LifespanIndex::aliveDuring(const std::string& from, const std::string& to) {
+    auto first = DateFormatter::toDayNumber(from);
+    auto last = DateFormatter::toDayNumber(to, true);
+    if (!first || !last) {
+        throw std::invalid_argument("Invalid date: " + (first ? to : from));
+    }
+
+    std::shared_ptr<const Snapshot> current = currentSnapshot();
+    std::vector<uint32_t> matches;
+    current->lifespans.query(*first, *last, matches);
+    std::sort(matches.begin(), matches.end());
+
+    std::vector<Person> people;
+    people.reserve(matches.size());
+    for (uint32_t match : matches) {
+        people.push_back(current->people[match]);
+    }
+    return people;
+}
+
+std::vector<Person> LifespanIndex::contemporaries(const std::string& personId, bool relativesOnly) {
+    std::shared_ptr<const Snapshot> current = currentSnapshot();
+    auto self = current->index.find(personId);
+    if (self == current->index.end()) {
+        throw std::invalid_argument(tree.getPerson(personId) ? "No readable date of birth for " + personId
+                                                             : "Person not found: " + personId);
+    }
+    const int32_t from = current->lifespans.start(self->second);
+    const int32_t to = current->lifespans.end(self->second);
+
+    std::vector<uint32_t> matches;
+    if (!relativesOnly) {
+        current->lifespans.query(from, to, matches);
+    } else {
+        // Few relatives: test each rather than search the whole index
+        std::vector<Person> relatives = tree.getAncestors(personId);
+        for (auto& group : {tree.getDescendants(personId), tree.getSiblings(personId)}) {
+            relatives.insert(relatives.end(), group.begin(), group.end());
+        }
+        if (auto spouse = tree.getSpouse(personId)) {
+            relatives.push_back(*spouse);
+        }
+        for (const auto& relative : relatives) {
+            auto found = current->index.find(relative.getId());
+            if (found != current->index.end() && current->lifespans.start(found->second) <= to &&
+                current->lifespans.end(found->second) >= from) {
+                matches.push_back(found->second);
+            }
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+    std::vector<Person> people;
+    for (uint32_t match : matches) {
+        if (match != self->second) {
+            people.push_back(current->people[match]);
+        }
+    }
+    return people;
+}
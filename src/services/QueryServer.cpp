@@ -0,0 +1,419 @@
+#include "services/QueryServer.hpp"
+#include "utils/JsonFormatter.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <memory>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+const size_t READ_CHUNK = 64 * 1024;
+const int LISTEN_BACKLOG = 64;
+const size_t MAX_PENDING_REQUESTS = 1024;  // per connection, before it is read again
+
+void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw std::runtime_error("fcntl failed: " + std::string(std::strerror(errno)));
+    }
+}
+
+std::string coalescingKey(const std::vector<std::string>& tokens) {
+    std::string key;
+    for (const auto& token : tokens) {
+        key += token;
+        key += '\x1f';
+    }
+    return key;
+}
+
+} // namespace
+
+QueryServer::QueryServer(FamilyTree& tree, ServerOptions options)
+    : tree(tree),
+      processor(tree),
+      options(options),
+      pool(options.workerThreads),
+      writer(tree, GroupCommitOptions{options.commitWindow, 512, CommitDurability::ON_RETURN}),
+      listenFd(-1),
+      running(false),
+      requestsServed(0),
+      requestsCoalesced(0) {
+    if (pipe(wakeFds) != 0) {
+        throw std::runtime_error("pipe failed: " + std::string(std::strerror(errno)));
+    }
+    setNonBlocking(wakeFds[0]);
+    setNonBlocking(wakeFds[1]);
+    openSocket();
+}
+
+QueryServer::~QueryServer() {
+    // Workers of a running stage still use the wake pipe
+    awaitStage();
+    for (auto& entry : connections) {
+        close(entry.first);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(options.socketPath.c_str());
+    }
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+}
+
+void QueryServer::openSocket() {
+    sockaddr_un address{};
+    if (options.socketPath.empty() || options.socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path: " + options.socketPath);
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        throw std::runtime_error("socket failed: " + std::string(std::strerror(errno)));
+    }
+    // A stale socket file from an earlier run would make bind fail
+    unlink(options.socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, LISTEN_BACKLOG) != 0) {
+        std::string error = std::strerror(errno);
+        close(listenFd);
+        listenFd = -1;
+        throw std::runtime_error("Cannot listen on " + options.socketPath + ": " + error);
+    }
+    setNonBlocking(listenFd);
+}
+
+void QueryServer::run() {
+    running.store(true);
+    while (running.load()) {
+        std::vector<pollfd> fds;
+        fds.push_back({listenFd, POLLIN, 0});
+        fds.push_back({wakeFds[0], POLLIN, 0});
+        for (const auto& entry : connections) {
+            const Connection& connection = entry.second;
+            // A client not reading its responses is not read from either
+            short events = 0;
+            if (!connection.closeAfterFlush && !isBacklogged(connection) &&
+                connection.input.size() <= options.maxLineBytes) {
+                events |= POLLIN;
+            }
+            if (!connection.output.empty()) events |= POLLOUT;
+            fds.push_back({entry.first, events, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("poll failed: " + std::string(std::strerror(errno)));
+        }
+
+        if (fds[1].revents & POLLIN) {
+            drainWakePipe();
+        }
+        if (fds[0].revents & POLLIN) {
+            acceptConnections();
+        }
+
+        for (size_t i = 2; i < fds.size(); i++) {
+            auto it = connections.find(fds[i].fd);
+            if (it == connections.end()) continue;
+            if ((fds[i].events & POLLIN) && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                readRequests(it->second);
+            } else if (fds[i].revents & (POLLHUP | POLLERR)) {
+                // Peer is gone; drop what it can no longer receive
+                it->second.input.clear();
+                it->second.output.clear();
+                it->second.pending.clear();
+                it->second.closeAfterFlush = true;
+            }
+        }
+
+        for (auto& entry : connections) {
+            parseRequests(entry.second);
+        }
+        runStages();
+
+        std::vector<int> closed;
+        for (auto& entry : connections) {
+            Connection& connection = entry.second;
+            deliverResponses(connection);
+            flushOutput(connection);
+            if (connection.closeAfterFlush && connection.output.empty() && connection.pending.empty() &&
+                connection.input.find('\n') == std::string::npos) {
+                closed.push_back(entry.first);
+            }
+        }
+        for (int fd : closed) {
+            closeConnection(fd);
+        }
+    }
+}
+
+void QueryServer::stop() {
+    running.store(false);
+    char byte = 1;
+    // Wakes poll(); only async-signal-safe calls here
+    ssize_t ignored = write(wakeFds[1], &byte, 1);
+    (void)ignored;
+}
+
+void QueryServer::acceptConnections() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        setNonBlocking(fd);
+        connections[fd] = Connection{fd, "", "", false};
+    }
+}
+
+void QueryServer::drainWakePipe() {
+    char buffer[64];
+    while (read(wakeFds[0], buffer, sizeof(buffer)) > 0) {}
+}
+
+void QueryServer::readRequests(Connection& connection) {
+    char buffer[READ_CHUNK];
+    while (connection.input.size() <= options.maxLineBytes) {
+        ssize_t count = read(connection.fd, buffer, sizeof(buffer));
+        if (count > 0) {
+            connection.input.append(buffer, count);
+            continue;
+        }
+        if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            connection.closeAfterFlush = true;
+        }
+        break;
+    }
+}
+
+// Requests stay unparsed in the input while the connection is backlogged
+void QueryServer::parseRequests(Connection& connection) {
+    size_t start = 0;
+    size_t newline;
+    while (!isBacklogged(connection) && (newline = connection.input.find('\n', start)) != std::string::npos) {
+        std::string line = connection.input.substr(start, newline - start);
+        start = newline + 1;
+
+        auto tokens = CommandProcessor::tokenize(line);
+        if (tokens.empty()) continue;
+
+        auto request = std::make_shared<Request>();
+        request->id = tokens[0];
+        request->tokens.assign(tokens.begin() + 1, tokens.end());
+        if (!dispatch(connection, std::move(request))) {
+            start = connection.input.size();
+        }
+    }
+    connection.input.erase(0, start);
+
+    if (connection.input.size() > options.maxLineBytes && connection.input.find('\n') == std::string::npos) {
+        auto request = std::make_shared<Request>();
+        request->response = "- err " + JsonFormatter::quote("Request line too long") + "\n";
+        request->done = true;
+        connection.pending.push_back(std::move(request));
+        connection.input.clear();
+        connection.closeAfterFlush = true;
+    }
+}
+
+bool QueryServer::isBacklogged(const Connection& connection) const {
+    return connection.pending.size() >= MAX_PENDING_REQUESTS || connection.output.size() >= options.maxOutputBytes;
+}
+
+// False once the connection asked to close; nothing after that is read
+bool QueryServer::dispatch(Connection& connection, std::shared_ptr<Request> request) {
+    connection.pending.push_back(request);
+    const std::string command = request->tokens.empty() ? "" : request->tokens[0];
+    if (command == "ping") {
+        request->response = request->id + " ok \"pong\"\n";
+        request->done = true;
+    } else if (command == "quit") {
+        request->response = request->id + " ok null\n";
+        request->done = true;
+        connection.closeAfterFlush = true;
+        return false;
+    } else if (!CommandProcessor::isMutating(command)) {
+        enqueue(StageKind::READS, std::move(request));
+    } else if (CommandProcessor::runsOutsideTransaction(command)) {
+        enqueue(StageKind::OUTSIDE_TRANSACTION, std::move(request));
+    } else {
+        enqueue(StageKind::WRITES, std::move(request));
+    }
+    return true;
+}
+
+// Joins the last stage while it has not started and runs the same kind
+void QueryServer::enqueue(StageKind kind, std::shared_ptr<Request> request) {
+    if (stages.empty() || stages.back()->started || stages.back()->kind != kind ||
+        kind == StageKind::OUTSIDE_TRANSACTION) {
+        stages.push_back(std::make_unique<Stage>());
+        stages.back()->kind = kind;
+    }
+    stages.back()->requests.push_back(std::move(request));
+}
+
+// Answers finished stages and starts the next, without waiting
+void QueryServer::runStages() {
+    while (!stages.empty()) {
+        Stage& stage = *stages.front();
+        if (!stage.started) {
+            startStage(stage);
+        }
+        if (!isFinished(stage)) {
+            return;
+        }
+        for (size_t i = 0; i < stage.requests.size(); i++) {
+            Request& request = *stage.requests[i];
+            request.response = formatResponse(request.id, stage.results[stage.slots[i]]);
+            request.done = true;
+        }
+        stages.pop_front();
+    }
+}
+
+void QueryServer::startStage(Stage& stage) {
+    stage.started = true;
+    switch (stage.kind) {
+        case StageKind::READS:
+            executeReads(stage);
+            break;
+        case StageKind::WRITES:
+            executeWrites(stage);
+            break;
+        case StageKind::OUTSIDE_TRANSACTION:
+            stage.slots.push_back(0);
+            stage.results.resize(1);
+            stage.running = 1;
+            pool.submit([this, &stage]() {
+                stage.results[0] = processor.execute(stage.requests[0]->tokens);
+                finishTask(stage);
+            });
+            break;
+    }
+}
+
+void QueryServer::executeReads(Stage& stage) {
+    // Identical lookups, from any connection, execute once
+    std::unordered_map<std::string, size_t> slotOf;
+    std::vector<const std::vector<std::string>*> lookups;
+    for (const auto& request : stage.requests) {
+        auto inserted = slotOf.emplace(coalescingKey(request->tokens), lookups.size());
+        if (inserted.second) {
+            lookups.push_back(&request->tokens);
+        } else {
+            requestsCoalesced++;
+        }
+        stage.slots.push_back(inserted.first->second);
+    }
+
+    stage.results.resize(lookups.size());
+    stage.running = lookups.size();
+    for (size_t slot = 0; slot < lookups.size(); slot++) {
+        pool.submit([this, &stage, slot, tokens = lookups[slot]]() {
+            stage.results[slot] = processor.execute(*tokens);
+            finishTask(stage);
+        });
+    }
+}
+
+void QueryServer::executeWrites(Stage& stage) {
+    // The run shares one commit; a failed commit fails every request in it
+    stage.results.resize(stage.requests.size());
+    auto committed = std::make_shared<std::vector<std::future<bool>>>();
+    for (size_t i = 0; i < stage.requests.size(); i++) {
+        stage.slots.push_back(i);
+        committed->push_back(writer.submit(
+            [this, &result = stage.results[i], &tokens = stage.requests[i]->tokens](FamilyTree&) {
+                result = processor.execute(tokens);
+                return result.ok;
+            }));
+    }
+
+    // A worker waits for the commit in place of the loop
+    stage.running = 1;
+    pool.submit([this, &stage, committed]() {
+        for (size_t i = 0; i < committed->size(); i++) {
+            try {
+                (*committed)[i].get();
+            } catch (const std::exception& e) {
+                stage.results[i].ok = false;
+                stage.results[i].error = e.what();
+            }
+        }
+        finishTask(stage);
+    });
+}
+
+void QueryServer::finishTask(Stage& stage) {
+    // The last task wakes the loop; under the lock, so that a finished
+    // stage has no worker left writing to the pipe
+    std::lock_guard<std::mutex> lock(stageMutex);
+    if (--stage.running == 0) {
+        char byte = 1;
+        ssize_t ignored = write(wakeFds[1], &byte, 1);
+        (void)ignored;
+    }
+}
+
+bool QueryServer::isFinished(Stage& stage) {
+    std::lock_guard<std::mutex> lock(stageMutex);
+    return stage.running == 0;
+}
+
+void QueryServer::awaitStage() {
+    while (!stages.empty() && stages.front()->started && !isFinished(*stages.front())) {
+        pollfd wake{wakeFds[0], POLLIN, 0};
+        poll(&wake, 1, -1);
+        drainWakePipe();
+    }
+}
+
+// Moves answered requests to the output, up to the first unanswered one
+void QueryServer::deliverResponses(Connection& connection) {
+    while (!connection.pending.empty() && connection.pending.front()->done) {
+        connection.output += connection.pending.front()->response;
+        connection.pending.pop_front();
+        requestsServed++;
+    }
+}
+
+void QueryServer::flushOutput(Connection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t written = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (written > 0) {
+            connection.output.erase(0, written);
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+        // Peer is gone; drop what it can no longer receive
+        connection.input.clear();
+        connection.output.clear();
+        connection.pending.clear();
+        connection.closeAfterFlush = true;
+        return;
+    }
+}
+
+void QueryServer::closeConnection(int fd) {
+    close(fd);
+    connections.erase(fd);
+}
+
+std::string QueryServer::formatResponse(const std::string& id, const CommandResult& result) {
+    if (result.ok) {
+        return id + " ok " + result.payload + "\n";
+    }
+    return id + " err " + JsonFormatter::quote(result.error) + "\n";
+}
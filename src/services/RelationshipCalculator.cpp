@@ -1,2 +1,264 @@
 #include "services/RelationshipCalculator.hpp"
-// Empty implementation for now
\ No newline at end of file
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+
+struct RelationshipCalculator::Graph {
+    uint64_t revision = 0;
+    std::vector<std::string> ids;
+    std::unordered_map<std::string, uint32_t> index;
+    std::vector<uint32_t> offsets;   // steps from person i: [offsets[i], offsets[i + 1])
+    std::vector<uint32_t> targets;
+    std::vector<PathEdge> kinds;
+};
+
+namespace {
+
+// Settled people between cancellation checks
+const size_t SETTLED_PER_CHECK = 1024;
+
+// Search position: total cost, then steps taken, as one ordered key
+struct Distance {
+    double cost = std::numeric_limits<double>::infinity();
+    uint32_t hops = std::numeric_limits<uint32_t>::max();
+
+    bool operator<(const Distance& other) const {
+        return cost != other.cost ? cost < other.cost : hops < other.hops;
+    }
+    Distance operator+(const Distance& other) const {
+        return {cost + other.cost, hops + other.hops};
+    }
+};
+
+struct Label {
+    Distance distance;
+    uint32_t previous = 0;   // neighbour towards this front's own end
+    PathEdge edge = PathEdge::PARENT;  // step between previous and this person, start-to-target direction
+    bool settled = false;
+};
+
+struct QueueEntry {
+    Distance distance;
+    uint32_t person;
+
+    bool operator>(const QueueEntry& other) const { return other.distance < distance; }
+};
+
+struct Front {
+    bool forward;
+    std::unordered_map<uint32_t, Label> labels;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+};
+
+PathEdge reverse(PathEdge edge) {
+    switch (edge) {
+        case PathEdge::PARENT: return PathEdge::CHILD;
+        case PathEdge::CHILD: return PathEdge::PARENT;
+        default: return edge;
+    }
+}
+
+double weightOf(PathEdge edge, const PathOptions& options) {
+    switch (edge) {
+        case PathEdge::PARENT: return options.parentWeight;
+        case PathEdge::CHILD: return options.childWeight;
+        case PathEdge::SPOUSE: return options.spouseWeight;
+        default: return options.siblingWeight;
+    }
+}
+
+} // namespace
+
+RelationshipCalculator::RelationshipCalculator(FamilyTree& tree) : tree(tree) {}
+
+RelationshipCalculator::~RelationshipCalculator() = default;
+
+std::shared_ptr<const RelationshipCalculator::Graph> RelationshipCalculator::currentGraph() {
+    std::lock_guard<std::mutex> lock(graphMutex);
+    // Read the revision first: a write racing with the snapshot leaves it
+    // looking stale, never fresh
+    uint64_t revision = tree.getRevision();
+    if (graph && graph->revision == revision) {
+        return graph;
+    }
+
+    auto snapshot = std::make_shared<Graph>();
+    snapshot->revision = revision;
+    std::vector<Relationship> relationships = tree.getAllRelationships();
+    std::vector<std::pair<uint32_t, uint32_t>> ends;
+    ends.reserve(relationships.size());
+    auto indexOf = [&](const std::string& id) {
+        auto inserted = snapshot->index.emplace(id, static_cast<uint32_t>(snapshot->ids.size()));
+        if (inserted.second) {
+            snapshot->ids.push_back(id);
+        }
+        return inserted.first->second;
+    };
+    for (const auto& relationship : relationships) {
+        ends.emplace_back(indexOf(relationship.getPerson1Id()), indexOf(relationship.getPerson2Id()));
+    }
+
+    // Every relationship is a step each way; count, then fill
+    const size_t people = snapshot->ids.size();
+    snapshot->offsets.assign(people + 1, 0);
+    for (const auto& end : ends) {
+        snapshot->offsets[end.first + 1]++;
+        snapshot->offsets[end.second + 1]++;
+    }
+    for (size_t i = 0; i < people; i++) {
+        snapshot->offsets[i + 1] += snapshot->offsets[i];
+    }
+    snapshot->targets.resize(snapshot->offsets[people]);
+    snapshot->kinds.resize(snapshot->offsets[people]);
+    std::vector<uint32_t> fill(snapshot->offsets.begin(), snapshot->offsets.end() - 1);
+    auto addStep = [&](uint32_t from, uint32_t to, PathEdge kind) {
+        snapshot->targets[fill[from]] = to;
+        snapshot->kinds[fill[from]++] = kind;
+    };
+    for (size_t i = 0; i < relationships.size(); i++) {
+        uint32_t first = ends[i].first;
+        uint32_t second = ends[i].second;
+        switch (relationships[i].getType()) {
+            case RelationType::PARENT_CHILD:
+                addStep(first, second, PathEdge::CHILD);
+                addStep(second, first, PathEdge::PARENT);
+                break;
+            case RelationType::SPOUSE:
+                addStep(first, second, PathEdge::SPOUSE);
+                addStep(second, first, PathEdge::SPOUSE);
+                break;
+            default:
+                addStep(first, second, PathEdge::SIBLING);
+                addStep(second, first, PathEdge::SIBLING);
+                break;
+        }
+    }
+
+    graph = snapshot;
+    return graph;
+}
+
+RelationshipPath RelationshipCalculator::shortestPath(const std::string& fromId, const std::string& toId,
+                                                      const PathOptions& options, CancellationToken token) {
+    std::shared_ptr<const Graph> snapshot = currentGraph();
+    auto from = snapshot->index.find(fromId);
+    auto to = snapshot->index.find(toId);
+    // People without relationships are not in the graph
+    for (const auto* id : {&fromId, &toId}) {
+        if (!snapshot->index.count(*id) && !tree.getPerson(*id)) {
+            throw std::invalid_argument("Person not found: " + *id);
+        }
+    }
+
+    RelationshipPath path;
+    if (fromId == toId) {
+        path.people.push_back(fromId);
+        return path;
+    }
+    if (from == snapshot->index.end() || to == snapshot->index.end() || options.maxHops == 0) {
+        return path;
+    }
+
+    const uint32_t maxHops = options.maxHops < 0 ? std::numeric_limits<uint32_t>::max()
+                                                 : static_cast<uint32_t>(options.maxHops);
+    Front fronts[2] = {{true, {}, {}}, {false, {}, {}}};
+    for (Front& front : fronts) {
+        uint32_t start = front.forward ? from->second : to->second;
+        Label& label = front.labels[start];
+        label.distance = {0.0, 0};
+        label.previous = start;
+        front.queue.push({label.distance, start});
+    }
+
+    Distance best;
+    uint32_t meeting = 0;
+    size_t settledCount = 0;
+    while (!fronts[0].queue.empty() && !fronts[1].queue.empty()) {
+        // Any path still to be found costs at least the two fronts' minima
+        if (!(fronts[0].queue.top().distance + fronts[1].queue.top().distance < best)) {
+            break;
+        }
+        Front& front = fronts[0].queue.size() <= fronts[1].queue.size() ? fronts[0] : fronts[1];
+        Front& other = &front == &fronts[0] ? fronts[1] : fronts[0];
+
+        QueueEntry entry = front.queue.top();
+        front.queue.pop();
+        Label& current = front.labels[entry.person];
+        if (current.settled || current.distance < entry.distance) {
+            continue;  // superseded queue entry
+        }
+        current.settled = true;
+        if (++settledCount % SETTLED_PER_CHECK == 0) {
+            token.throwIfCancelled();
+        }
+        if (entry.distance.hops >= maxHops) {
+            continue;
+        }
+
+        for (uint32_t i = snapshot->offsets[entry.person]; i < snapshot->offsets[entry.person + 1]; i++) {
+            uint32_t next = snapshot->targets[i];
+            // The step as it will appear on the path from start to target
+            PathEdge step = front.forward ? snapshot->kinds[i] : reverse(snapshot->kinds[i]);
+            double weight = weightOf(step, options);
+            if (weight < 0) continue;
+
+            Distance reached{entry.distance.cost + weight, entry.distance.hops + 1};
+            auto known = front.labels.find(next);
+            if (known != front.labels.end() && !(reached < known->second.distance)) continue;
+
+            Label& label = front.labels[next];
+            label.distance = reached;
+            label.previous = entry.person;
+            label.edge = step;
+            front.queue.push({reached, next});
+
+            auto met = other.labels.find(next);
+            if (met != other.labels.end()) {
+                Distance total = reached + met->second.distance;
+                if (total.hops <= maxHops && total < best) {
+                    best = total;
+                    meeting = next;
+                }
+            }
+        }
+    }
+    if (best.hops == std::numeric_limits<uint32_t>::max()) {
+        return path;
+    }
+
+    // Start to the meeting point, then on to the target
+    std::vector<uint32_t> people;
+    for (uint32_t person = meeting; person != from->second;) {
+        const Label& label = fronts[0].labels.at(person);
+        people.push_back(person);
+        path.edges.push_back(label.edge);
+        person = label.previous;
+    }
+    people.push_back(from->second);
+    std::reverse(people.begin(), people.end());
+    std::reverse(path.edges.begin(), path.edges.end());
+    for (uint32_t person = meeting; person != to->second;) {
+        const Label& label = fronts[1].labels.at(person);
+        path.edges.push_back(label.edge);
+        person = label.previous;
+        people.push_back(person);
+    }
+
+    for (uint32_t person : people) {
+        path.people.push_back(snapshot->ids[person]);
+    }
+    path.cost = best.cost;
+    return path;
+}
+
+std::string RelationshipCalculator::edgeToString(PathEdge edge) {
+    switch (edge) {
+        case PathEdge::PARENT: return "parent";
+        case PathEdge::CHILD: return "child";
+        case PathEdge::SPOUSE: return "spouse";
+        default: return "sibling";
+    }
+}
@@ -0,0 +1,287 @@
+#include "services/RelationshipTimeline.hpp"
+#include "utils/DateFormatter.hpp"
+#include "utils/IntervalTree.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const int32_t DISTANT_PAST = std::numeric_limits<int32_t>::min();
+const int32_t DISTANT_FUTURE = std::numeric_limits<int32_t>::max();
+
+// First and last day of a possibly partial date
+std::pair<int32_t, int32_t> readDate(const std::string& date) {
+    auto first = DateFormatter::toDayNumber(date);
+    auto last = DateFormatter::toDayNumber(date, true);
+    if (!first || !last) {
+        throw std::invalid_argument("Invalid date: " + date);
+    }
+    return {*first, *last};
+}
+
+// First and last day a person was alive, as described in the header
+std::pair<int32_t, int32_t> lifespan(const Person& person, int32_t maxLifespanDays) {
+    auto birth = DateFormatter::toDayNumber(person.getDateOfBirth());
+    auto death = DateFormatter::toDayNumber(person.getDateOfDeath(), true);
+    int32_t start = birth ? *birth : DISTANT_PAST;
+    return {start, death ? std::max(*death, start) : birth ? start + maxLifespanDays : DISTANT_FUTURE};
+}
+
+// First and last day a marriage between partners with these lifespans was
+// in force; the first is after the last when it never was
+std::pair<int32_t, int32_t> marriageDays(const Relationship& marriage, std::pair<int32_t, int32_t> first,
+                                         std::pair<int32_t, int32_t> second) {
+    auto wedding = DateFormatter::toDayNumber(marriage.getStartDate());
+    auto ending = DateFormatter::toDayNumber(marriage.getEndDate(), true);
+    return {std::max({wedding ? *wedding : DISTANT_PAST, first.first, second.first}),
+            std::min({ending ? *ending : DISTANT_FUTURE, first.second, second.second})};
+}
+
+int32_t maxLifespanDays(const LifespanOptions& options) {
+    return static_cast<int32_t>(options.maxLifespanYears * 365.2425);
+}
+
+} // namespace
+
+struct RelationshipTimeline::Snapshot {
+    uint64_t revision = 0;
+    std::vector<Person> people;
+    std::unordered_map<std::string, uint32_t> index;
+    std::vector<int32_t> born;         // lifespans, parallel to people
+    std::vector<int32_t> died;
+
+    std::vector<Relationship> marriages;                 // by start, then ID
+    std::vector<std::pair<uint32_t, uint32_t>> partners; // parallel to marriages
+    std::vector<int32_t> wedding;      // stated start day, DISTANT_FUTURE when undated
+    IntervalTree spans;                // when each marriage was in force
+    std::vector<uint32_t> offsets;     // marriages of person i: [offsets[i], offsets[i + 1])
+    std::vector<uint32_t> marriagesOf;
+
+    uint32_t find(const std::string& personId) const;
+    bool alive(uint32_t person, std::pair<int32_t, int32_t> date) const;
+    std::optional<uint32_t> spouseOf(uint32_t person, std::pair<int32_t, int32_t> date) const;
+    // Ordered by birth, people without a birth date last, then ID
+    std::vector<Person> byBirth(std::vector<uint32_t> members) const;
+};
+
+uint32_t RelationshipTimeline::Snapshot::find(const std::string& personId) const {
+    auto found = index.find(personId);
+    if (found == index.end()) {
+        throw std::invalid_argument("Person not found: " + personId);
+    }
+    return found->second;
+}
+
+bool RelationshipTimeline::Snapshot::alive(uint32_t person, std::pair<int32_t, int32_t> date) const {
+    return born[person] <= date.second && died[person] >= date.first;
+}
+
+std::optional<uint32_t> RelationshipTimeline::Snapshot::spouseOf(uint32_t person,
+                                                                 std::pair<int32_t, int32_t> date) const {
+    // Marriages are in start order, so the last match is the most recent
+    std::optional<uint32_t> latest;
+    for (uint32_t i = offsets[person]; i < offsets[person + 1]; i++) {
+        uint32_t marriage = marriagesOf[i];
+        if (spans.start(marriage) <= date.second && spans.end(marriage) >= date.first &&
+            (!latest || marriage > *latest)) {
+            latest = marriage;
+        }
+    }
+    if (!latest) {
+        return std::nullopt;
+    }
+    const auto& couple = partners[*latest];
+    return couple.first == person ? couple.second : couple.first;
+}
+
+std::vector<Person> RelationshipTimeline::Snapshot::byBirth(std::vector<uint32_t> members) const {
+    std::sort(members.begin(), members.end(), [&](uint32_t a, uint32_t b) {
+        bool aKnown = born[a] != DISTANT_PAST;
+        bool bKnown = born[b] != DISTANT_PAST;
+        if (aKnown != bKnown) return aKnown;
+        if (born[a] != born[b]) return born[a] < born[b];
+        return people[a].getId() < people[b].getId();
+    });
+    members.erase(std::unique(members.begin(), members.end()), members.end());
+    std::vector<Person> sorted;
+    sorted.reserve(members.size());
+    for (uint32_t member : members) {
+        sorted.push_back(people[member]);
+    }
+    return sorted;
+}
+
+RelationshipTimeline::RelationshipTimeline(FamilyTree& tree, const LifespanOptions& options)
+    : tree(tree), options(options) {}
+
+RelationshipTimeline::~RelationshipTimeline() = default;
+
+std::shared_ptr<const RelationshipTimeline::Snapshot> RelationshipTimeline::currentSnapshot() {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    // Read the revision first: a write racing with the snapshot leaves it
+    // looking stale, never fresh
+    uint64_t revision = tree.getRevision();
+    if (snapshot && snapshot->revision == revision) {
+        return snapshot;
+    }
+
+    auto built = std::make_shared<Snapshot>();
+    built->revision = revision;
+    built->people = tree.getAllPeople();
+    for (const auto& person : built->people) {
+        built->index.emplace(person.getId(), static_cast<uint32_t>(built->born.size()));
+        auto span = lifespan(person, maxLifespanDays(options));
+        built->born.push_back(span.first);
+        built->died.push_back(span.second);
+    }
+
+    struct Entry {
+        int32_t start;
+        int32_t end;
+        int32_t wedding;
+        uint32_t first;
+        uint32_t second;
+        Relationship relationship;
+    };
+    std::vector<Entry> entries;
+    for (auto& relationship : tree.getAllRelationships()) {
+        if (relationship.getType() != RelationType::SPOUSE) continue;
+        auto first = built->index.find(relationship.getPerson1Id());
+        auto second = built->index.find(relationship.getPerson2Id());
+        if (first == built->index.end() || second == built->index.end()) continue;
+        auto wedding = DateFormatter::toDayNumber(relationship.getStartDate());
+        auto days = marriageDays(relationship, {built->born[first->second], built->died[first->second]},
+                                 {built->born[second->second], built->died[second->second]});
+        if (days.first > days.second) continue;  // never in force
+        entries.push_back({days.first, days.second, wedding ? *wedding : DISTANT_FUTURE, first->second,
+                           second->second, std::move(relationship)});
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.start != b.start ? a.start < b.start : a.relationship.getId() < b.relationship.getId();
+    });
+
+    // Marriages of each person: count, then fill
+    const size_t people = built->people.size();
+    built->offsets.assign(people + 1, 0);
+    std::vector<int32_t> starts, ends;
+    for (auto& entry : entries) {
+        built->offsets[entry.first + 1]++;
+        built->offsets[entry.second + 1]++;
+        starts.push_back(entry.start);
+        ends.push_back(entry.end);
+        built->wedding.push_back(entry.wedding);
+        built->partners.emplace_back(entry.first, entry.second);
+        built->marriages.push_back(std::move(entry.relationship));
+    }
+    for (size_t i = 0; i < people; i++) {
+        built->offsets[i + 1] += built->offsets[i];
+    }
+    built->marriagesOf.resize(built->offsets[people]);
+    std::vector<uint32_t> fill(built->offsets.begin(), built->offsets.end() - 1);
+    for (uint32_t marriage = 0; marriage < built->partners.size(); marriage++) {
+        built->marriagesOf[fill[built->partners[marriage].first]++] = marriage;
+        built->marriagesOf[fill[built->partners[marriage].second]++] = marriage;
+    }
+    built->spans = IntervalTree(std::move(starts), std::move(ends));
+
+    snapshot = built;
+    return snapshot;
+}
+
+std::optional<Person> RelationshipTimeline::spouseOn(const std::string& personId, const std::string& date) {
+    auto day = readDate(date);
+    std::shared_ptr<const Snapshot> current = currentSnapshot();
+    auto spouse = current->spouseOf(current->find(personId), day);
+    if (!spouse) {
+        return std::nullopt;
+    }
+    return current->people[*spouse];
+}
+
+std::vector<Person> RelationshipTimeline::livingFamilyOn(const std::string& personId, const std::string& date) {
+    auto day = readDate(date);
+    std::shared_ptr<const Snapshot> current = currentSnapshot();
+    uint32_t self = current->find(personId);
+
+    std::vector<uint32_t> members;
+    for (const auto& group : {tree.getAncestors(personId), tree.getDescendants(personId),
+                              tree.getSiblings(personId)}) {
+        for (const auto& relative : group) {
+            auto found = current->index.find(relative.getId());
+            if (found != current->index.end() && found->second != self && current->alive(found->second, day)) {
+                members.push_back(found->second);
+            }
+        }
+    }
+    if (auto spouse = current->spouseOf(self, day)) {
+        members.push_back(*spouse);
+    }
+    return current->byBirth(std::move(members));
+}
+
+std::vector<Person> RelationshipTimeline::householdOn(const std::string& personId, const std::string& date) {
+    auto day = readDate(date);
+    std::shared_ptr<const Snapshot> current = currentSnapshot();
+    uint32_t self = current->find(personId);
+    std::vector<Person> household;
+    if (!current->alive(self, day)) {
+        return household;
+    }
+    household.push_back(current->people[self]);
+    auto spouse = current->spouseOf(self, day);
+    if (spouse) {
+        household.push_back(current->people[*spouse]);
+    }
+
+    std::vector<uint32_t> children;
+    for (uint32_t parent : {self, spouse.value_or(self)}) {
+        for (const auto& child : tree.getChildren(current->people[parent].getId())) {
+            auto found = current->index.find(child.getId());
+            if (found == current->index.end() || found->second == self || found->second == spouse ||
+                !current->alive(found->second, day)) {
+                continue;
+            }
+            // Children leave once they marry
+            bool married = false;
+            for (uint32_t i = current->offsets[found->second]; i < current->offsets[found->second + 1]; i++) {
+                married = married || current->wedding[current->marriagesOf[i]] <= day.second;
+            }
+            if (!married) {
+                children.push_back(found->second);
+            }
+        }
+    }
+    for (auto& child : current->byBirth(std::move(children))) {
+        household.push_back(std::move(child));
+    }
+    return household;
+}
+
+std::vector<Relationship> RelationshipTimeline::marriagesOn(const std::string& date) {
+    auto day = readDate(date);
+    std::shared_ptr<const Snapshot> current = currentSnapshot();
+    std::vector<uint32_t> matches;
+    current->spans.query(day.first, day.second, matches);
+    std::sort(matches.begin(), matches.end());
+
+    std::vector<Relationship> marriages;
+    marriages.reserve(matches.size());
+    for (uint32_t match : matches) {
+        marriages.push_back(current->marriages[match]);
+    }
+    return marriages;
+}
+
+std::optional<std::pair<int32_t, int32_t>> RelationshipTimeline::marriageSpan(const Relationship& marriage,
+                                                                             const Person& partner1,
+                                                                             const Person& partner2,
+                                                                             const LifespanOptions& options) {
+    auto days = marriageDays(marriage, lifespan(partner1, maxLifespanDays(options)),
+                             lifespan(partner2, maxLifespanDays(options)));
+    if (days.first > days.second) {
+        return std::nullopt;
+    }
+    return days;
+}
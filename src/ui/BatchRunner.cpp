@@ -0,0 +1,125 @@
+#include "ui/BatchRunner.hpp"
+#include "utils/JsonFormatter.hpp"
+#include <chrono>
+#include <string>
+
+BatchRunner::BatchRunner(FamilyTree& tree, BatchOptions options)
+    : tree(tree), processor(tree), options(options) {
+    if (this->options.transactionSize == 0) {
+        this->options.transactionSize = 1;
+    }
+}
+
+size_t BatchRunner::run(std::istream& input, std::ostream& output) {
+    using Clock = std::chrono::steady_clock;
+    auto batchStart = Clock::now();
+
+    size_t lineNumber = 0;
+    size_t executed = 0;
+    size_t failed = 0;
+    size_t transactions = 0;
+    size_t inTransaction = 0;
+    size_t transactionLine = 0;  // line of the open transaction's first command
+    size_t rolledBack = 0;
+    bool stopped = false;
+    std::string line;
+
+    // A failed commit has rolled back the whole transaction, so its
+    // commands, reported ok, are undone and count as failed
+    auto commitTransaction = [&](size_t lastLine) {
+        size_t commands = inTransaction;
+        inTransaction = 0;
+        try {
+            tree.commit();
+            transactions++;
+            return true;
+        } catch (const std::exception& e) {
+            output << "{\"rolled_back\":{\"from_line\":" << transactionLine
+                   << ",\"to_line\":" << lastLine
+                   << ",\"commands\":" << commands
+                   << ",\"error\":" << JsonFormatter::quote(e.what()) << "}}\n";
+            rolledBack += commands;
+            failed += commands;
+            return false;
+        }
+    };
+    size_t lastLine = 0;  // line of the last executed command
+
+    while (std::getline(input, line)) {
+        lineNumber++;
+        auto tokens = CommandProcessor::tokenize(line);
+        if (tokens.empty()) {
+            continue;
+        }
+
+        // Commands like merge need the connection outside a transaction
+        bool standalone = CommandProcessor::runsOutsideTransaction(tokens[0]);
+        if (standalone && inTransaction > 0 && !commitTransaction(lastLine) && options.stopOnError) {
+            stopped = true;
+            break;
+        }
+        if (inTransaction == 0 && !standalone) {
+            tree.beginTransaction();
+            transactionLine = lineNumber;
+        }
+
+        auto start = Clock::now();
+        CommandResult result = processor.execute(tokens);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        executed++;
+        lastLine = lineNumber;
+        if (standalone) {
+            transactions++;
+        } else {
+            inTransaction++;
+        }
+
+        output << "{\"line\":" << lineNumber
+               << ",\"command\":" << JsonFormatter::quote(result.command)
+               << ",\"ok\":" << (result.ok ? "true" : "false")
+               << ",\"elapsed_us\":" << elapsed.count();
+        if (result.ok) {
+            output << ",\"result\":" << result.payload << "}\n";
+        } else {
+            output << ",\"error\":" << JsonFormatter::quote(result.error) << "}\n";
+            failed++;
+        }
+
+        if (!result.ok && options.stopOnError) {
+            if (inTransaction > 0) {
+                tree.rollback();
+                // The commands before this one were reported ok but are undone
+                size_t undone = inTransaction - 1;
+                if (undone > 0) {
+                    output << "{\"rolled_back\":{\"from_line\":" << transactionLine
+                           << ",\"to_line\":" << lineNumber - 1
+                           << ",\"commands\":" << undone << "}}\n";
+                }
+                rolledBack += undone;
+            }
+            inTransaction = 0;
+            stopped = true;
+            break;
+        }
+        if (inTransaction >= options.transactionSize && !commitTransaction(lastLine) && options.stopOnError) {
+            stopped = true;
+            break;
+        }
+    }
+
+    if (inTransaction > 0) {
+        commitTransaction(lastLine);
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - batchStart).count();
+    output << "{\"summary\":{\"commands\":" << executed
+           << ",\"failed\":" << failed
+           << ",\"transactions\":" << transactions
+           << ",\"stopped\":" << (stopped ? "true" : "false")
+           << ",\"rolled_back\":" << rolledBack
+           << ",\"elapsed_ms\":" << seconds * 1000.0
+           << ",\"commands_per_second\":" << (seconds > 0 ? executed / seconds : 0.0)
+           << "}}\n";
+    output.flush();
+    return failed;
+}
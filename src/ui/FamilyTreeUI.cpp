@@ -1,9 +1,29 @@
 #include "ui/FamilyTreeUI.hpp"
+#include "services/ChartExporter.hpp"
+#include "services/DuplicateDetector.hpp"
+#include "utils/Metrics.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <limits>
+#include <sstream>
 
-FamilyTreeUI::FamilyTreeUI() 
-    : tree(std::make_unique<FamilyTree>("family_tree.db")) {}
+namespace {
+
+// Interactive queries running longer than this are abandoned
+const std::chrono::seconds QUERY_TIMEOUT(30);
+
+// People per page in list views
+const size_t PAGE_SIZE = 10;
+
+} // namespace
+
+FamilyTreeUI::FamilyTreeUI(const std::string& dbPath)
+    : tree(std::make_unique<FamilyTree>(dbPath)),
+      asyncTree(std::make_unique<AsyncFamilyTree>(*tree)),
+      relationshipCalculator(std::make_unique<RelationshipCalculator>(*tree)),
+      lifespanIndex(std::make_unique<LifespanIndex>(*tree)) {}
 
 void FamilyTreeUI::start() {
     while (true) {
@@ -17,7 +37,9 @@ void FamilyTreeUI::showMainMenu() {
               << "1. Person Operations\n"
               << "2. Relationship Operations\n"
               << "3. Tree Queries\n"
-              << "4. Exit\n"
+              << "4. Merge Another Database\n"
+              << "5. Query Statistics\n"
+              << "6. Exit\n"
               << "Choose an option: ";
 
     switch (getIntInput("")) {
@@ -31,6 +53,12 @@ void FamilyTreeUI::showMainMenu() {
             handleTreeQueries();
             break;
         case 4:
+            mergeDatabase();
+            break;
+        case 5:
+            showStatistics();
+            break;
+        case 6:
             std::cout << "Goodbye!\n";
             exit(0);
         default:
@@ -46,7 +74,9 @@ void FamilyTreeUI::handlePersonOperations() {
                   << "2. Update Person\n"
                   << "3. Delete Person\n"
                   << "4. Search Person\n"
-                  << "5. Back to Main Menu\n"
+                  << "5. Delete Branch (person and descendants)\n"
+                  << "6. Find Duplicate Persons\n"
+                  << "7. Back to Main Menu\n"
                   << "Choose an option: ";
 
         switch (getIntInput("")) {
@@ -63,6 +93,12 @@ void FamilyTreeUI::handlePersonOperations() {
                 searchPerson();
                 break;
             case 5:
+                deleteBranch();
+                break;
+            case 6:
+                findDuplicates();
+                break;
+            case 7:
                 return;
             default:
                 displayError("Invalid option!");
@@ -220,7 +256,10 @@ void FamilyTreeUI::handleTreeQueries() {
                   << "1. View Ancestors\n"
                   << "2. View Descendants\n"
                   << "3. View Family Members\n"
-                  << "4. Back to Main Menu\n"
+                  << "4. Export Chart (SVG/DOT)\n"
+                  << "5. How Are Two People Connected?\n"
+                  << "6. Who Was Alive On a Date?\n"
+                  << "7. Back to Main Menu\n"
                   << "Choose an option: ";
 
         switch (getIntInput("")) {
@@ -234,6 +273,15 @@ void FamilyTreeUI::handleTreeQueries() {
                 viewFamilyMembers();
                 break;
             case 4:
+                exportChart();
+                break;
+            case 5:
+                findConnection();
+                break;
+            case 6:
+                viewAliveOn();
+                break;
+            case 7:
                 return;
             default:
                 displayError("Invalid option!");
@@ -297,25 +345,171 @@ void FamilyTreeUI::deletePerson() {
     waitForEnter();
 }
 
-void FamilyTreeUI::searchPerson() {
+void FamilyTreeUI::deleteBranch() {
     clearScreen();
-    std::cout << "\n=== Search Person ===\n";
+    std::cout << "\n=== Delete Branch ===\n";
     
-    std::string name = getInput("Enter name to search: ");
-    auto results = tree->searchByName(name);
+    std::string id = getInput("Enter ID of the branch's top person: ");
+    auto person = tree->getPerson(id);
     
-    if (results.empty()) {
-        std::cout << "\nNo matching persons found.\n";
+    if (!person) {
+        displayError("Person not found!");
+        return;
+    }
+
+    displayPerson(*person);
+    std::string spouses = getInput("\nAlso delete spouses of branch members? (y/N): ");
+    std::string confirm = getInput("Delete this person and ALL descendants? (y/N): ");
+    
+    if (confirm == "y" || confirm == "Y") {
+        int removed = tree->deleteBranch(id, spouses == "y" || spouses == "Y");
+        if (removed > 0) {
+            std::cout << "\nDeleted " << removed << " persons.\n";
+        } else {
+            displayError("Failed to delete branch.");
+        }
+    }
+    waitForEnter();
+}
+
+void FamilyTreeUI::mergeDatabase() {
+    clearScreen();
+    std::cout << "\n=== Merge Another Database ===\n";
+
+    std::string path = getInput("Path of the database to merge in: ");
+    std::string match = getInput("Treat people with the same name and birth date as one person? (Y/n): ");
+
+    MergeOptions options;
+    options.matchByIdentity = !(match == "n" || match == "N");
+
+    try {
+        MergeSummary summary = tree->mergeDatabase(path, options);
+        std::cout << "\nPeople: " << summary.peopleAdded << " added, "
+                  << summary.peopleMatched << " matched (of " << summary.incomingPeople << ")\n"
+                  << "Relationships: " << summary.relationshipsAdded << " added, "
+                  << summary.relationshipsSkipped << " skipped (of "
+                  << summary.incomingRelationships << ")\n";
+        if (!summary.conflicts.empty()) {
+            std::cout << "\nConflicts:\n";
+            for (const auto& conflict : summary.conflicts) {
+                std::cout << "  " << conflict.incomingId;
+                if (!conflict.assignedId.empty()) {
+                    std::cout << " -> " << conflict.assignedId;
+                }
+                std::cout << ": " << conflict.reason << "\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        displayError(e.what());
+        return;
+    }
+    waitForEnter();
+}
+
+void FamilyTreeUI::showStatistics() {
+    while (true) {
+        clearScreen();
+        std::cout << "\n=== Query Statistics (collection " << (Metrics::enabled() ? "on" : "off") << ") ===\n";
+
+        Metrics::SqlTotals sql = Metrics::sqlTotals();
+        std::cout << "SQL statements: " << sql.statements << ", rows: " << sql.rows
+                  << ", prepared statement cache: " << sql.statementCacheHits << " hits, "
+                  << sql.statementCacheMisses << " misses\n\n"
+                  << std::left << std::setw(32) << "operation" << std::right
+                  << std::setw(8) << "calls" << std::setw(10) << "sql/call"
+                  << std::setw(10) << "p50_us" << std::setw(10) << "p99_us"
+                  << std::setw(10) << "max_us" << "\n" << std::fixed << std::setprecision(1);
+        for (const auto& entry : Metrics::apis()) {
+            const ApiMetrics& api = *entry.second;
+            uint64_t calls = api.calls.load();
+            if (calls == 0) continue;
+            std::cout << std::left << std::setw(32) << entry.first << std::right
+                      << std::setw(8) << calls
+                      << std::setw(10) << static_cast<double>(api.statements.load()) / calls
+                      << std::setw(10) << api.latency.percentile(50) / 1000.0
+                      << std::setw(10) << api.latency.percentile(99) / 1000.0
+                      << std::setw(10) << api.latency.max() / 1000.0 << "\n";
+        }
+        std::cout.unsetf(std::ios::floatfield);
+
+        std::cout << "\n1. Turn collection " << (Metrics::enabled() ? "off" : "on") << "\n"
+                  << "2. Reset\n"
+                  << "3. Save as JSON\n"
+                  << "4. Back\n"
+                  << "Choose an option: ";
+
+        switch (getIntInput("")) {
+            case 1:
+                Metrics::setEnabled(!Metrics::enabled());
+                break;
+            case 2:
+                Metrics::reset();
+                break;
+            case 3: {
+                std::string path = getInput("File to write: ");
+                std::ofstream out(path);
+                if (!out) {
+                    displayError("Cannot write " + path);
+                    break;
+                }
+                out << Metrics::toJson() << "\n";
+                std::cout << "Saved to " << path << "\n";
+                waitForEnter();
+                break;
+            }
+            case 4:
+                return;
+            default:
+                displayError("Invalid option!");
+        }
+    }
+}
+
+void FamilyTreeUI::findDuplicates() {
+    clearScreen();
+    std::cout << "\n=== Find Duplicate Persons ===\n";
+
+    DuplicateOptions options;
+    options.maxResults = 20;
+    std::cout << "Comparing people...\n";
+    auto candidates = DuplicateDetector(*tree).findDuplicates(options);
+
+    if (candidates.empty()) {
+        std::cout << "No likely duplicates found.\n";
     } else {
-        std::cout << "\nFound " << results.size() << " matching persons:\n";
-        for (const auto& person : results) {
-            displayPerson(person);
-            std::cout << "------------------------\n";
+        std::cout << "\nMost likely duplicates (score: name/dates/places/relatives):\n";
+        for (const auto& candidate : candidates) {
+            auto first = tree->getPerson(candidate.person1Id);
+            auto second = tree->getPerson(candidate.person2Id);
+            if (!first || !second) continue;
+            std::cout << "\n" << static_cast<int>(candidate.score * 100) << "%  ("
+                      << static_cast<int>(candidate.nameScore * 100) << "/"
+                      << static_cast<int>(candidate.dateScore * 100) << "/"
+                      << static_cast<int>(candidate.placeScore * 100) << "/"
+                      << static_cast<int>(candidate.relativeScore * 100) << ")\n"
+                      << "  " << first->getId() << ": " << first->getFullName()
+                      << ", born " << first->getDateOfBirth() << "\n"
+                      << "  " << second->getId() << ": " << second->getFullName()
+                      << ", born " << second->getDateOfBirth() << "\n";
         }
     }
     waitForEnter();
 }
 
+void FamilyTreeUI::searchPerson() {
+    clearScreen();
+    std::cout << "\n=== Search Person ===\n";
+    
+    std::string name = getInput("Enter name to search: ");
+    std::string fuzzy = getInput("Match spelling variants (phonetic)? (y/N): ");
+    NameSearchMode mode = (fuzzy == "y" || fuzzy == "Y") ? NameSearchMode::PHONETIC
+                                                         : NameSearchMode::SUBSTRING;
+    browsePeople("Search Results for \"" + name + "\"", "No matching persons found.",
+                 [&](size_t offset, size_t limit) {
+                     return tree->searchByNamePage(name, mode, offset, limit);
+                 });
+}
+
 void FamilyTreeUI::viewRelationships() {
     clearScreen();
     std::cout << "\n=== View Relationships ===\n";
@@ -379,18 +573,9 @@ void FamilyTreeUI::viewAncestors() {
     std::string id = getInput("Enter person ID: ");
     int generations = getIntInput("Enter number of generations (-1 for all): ");
     
-    auto ancestors = tree->getAncestors(id, generations);
-    
-    if (ancestors.empty()) {
-        std::cout << "\nNo ancestors found.\n";
-    } else {
-        std::cout << "\nAncestors:\n";
-        for (const auto& ancestor : ancestors) {
-            displayPerson(ancestor);
-            std::cout << "------------------------\n";
-        }
-    }
-    waitForEnter();
+    browsePeople("Ancestors of " + id, "No ancestors found.", [&](size_t offset, size_t limit) {
+        return tree->getAncestorsPage(id, generations, offset, limit);
+    });
 }
 
 void FamilyTreeUI::viewDescendants() {
@@ -400,20 +585,126 @@ void FamilyTreeUI::viewDescendants() {
     std::string id = getInput("Enter person ID: ");
     int generations = getIntInput("Enter number of generations (-1 for all): ");
     
-    auto descendants = tree->getDescendants(id, generations);
-    
-    if (descendants.empty()) {
-        std::cout << "\nNo descendants found.\n";
+    browsePeople("Descendants of " + id, "No descendants found.", [&](size_t offset, size_t limit) {
+        return tree->getDescendantsPage(id, generations, offset, limit);
+    });
+}
+
+void FamilyTreeUI::exportChart() {
+    clearScreen();
+    std::cout << "\n=== Export Chart ===\n";
+
+    std::string id = getInput("Enter person ID: ");
+    std::cout << "1. Pedigree (ancestors)\n2. Descendants\n3. Hourglass (both)\n";
+    int type = getIntInput("Chart type: ");
+    if (type < 1 || type > 3) {
+        displayError("Invalid chart type!");
+        return;
+    }
+    int generations = getIntInput("Enter number of generations (-1 for all): ");
+    std::string path = getInput("Output file (.svg or .dot): ");
+
+    ChartOptions options;
+    options.type = type == 1 ? ChartType::PEDIGREE : type == 2 ? ChartType::DESCENDANTS : ChartType::HOURGLASS;
+    options.generations = generations;
+    bool dot = path.size() >= 4 && path.compare(path.size() - 4, 4, ".dot") == 0;
+    options.format = dot ? ChartFormat::DOT : ChartFormat::SVG;
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        displayError("Cannot write " + path);
+        return;
+    }
+    try {
+        ChartSummary summary = ChartExporter(*tree).write(id, options, out,
+                                                          CancellationToken::withTimeout(QUERY_TIMEOUT));
+        std::cout << "\nWrote " << summary.boxes << " boxes (" << summary.people << " people) to "
+                  << path << "\n";
+        if (dot) {
+            std::cout << "Render with: neato -n2 -Tsvg " << path << " -o chart.svg\n";
+        }
+    } catch (const OperationCancelled&) {
+        displayError("Chart took too long and was cancelled.");
+        return;
+    } catch (const std::exception& e) {
+        displayError(e.what());
+        return;
+    }
+    waitForEnter();
+}
+
+void FamilyTreeUI::findConnection() {
+    clearScreen();
+    std::cout << "\n=== How Are Two People Connected? ===\n";
+
+    std::string fromId = getInput("Enter first person ID: ");
+    std::string toId = getInput("Enter second person ID: ");
+    PathOptions options;
+    options.maxHops = getIntInput("Maximum number of steps (-1 for no limit): ");
+    std::string blood = getInput("Follow blood relations only (no spouses)? (y/N): ");
+    if (blood == "y" || blood == "Y") {
+        options.spouseWeight = -1;
+    }
+
+    RelationshipPath path;
+    try {
+        path = relationshipCalculator->shortestPath(fromId, toId, options,
+                                                    CancellationToken::withTimeout(QUERY_TIMEOUT));
+    } catch (const OperationCancelled&) {
+        displayError("Query took too long and was cancelled.");
+        return;
+    } catch (const std::exception& e) {
+        displayError(e.what());
+        return;
+    }
+
+    if (!path.found()) {
+        std::cout << "\nNo connection found.\n";
     } else {
-        std::cout << "\nDescendants:\n";
-        for (const auto& descendant : descendants) {
-            displayPerson(descendant);
-            std::cout << "------------------------\n";
+        std::ostringstream out;
+        out << "\nConnected in " << path.edges.size() << " steps:\n\n";
+        for (size_t i = 0; i < path.people.size(); i++) {
+            auto person = tree->getPerson(path.people[i]);
+            if (i > 0) {
+                out << "  -> " << RelationshipCalculator::edgeToString(path.edges[i - 1]) << ": ";
+            }
+            out << (person ? person->getFullName() : path.people[i]) << " (" << path.people[i] << ")\n";
         }
+        std::cout << out.str();
     }
     waitForEnter();
 }
 
+void FamilyTreeUI::viewAliveOn() {
+    clearScreen();
+    std::cout << "\n=== Who Was Alive On a Date? ===\n";
+
+    std::string from = getInput("Date (YYYY, YYYY-MM or YYYY-MM-DD): ");
+    std::string to = getInput("Until date (leave empty for a single date): ");
+    if (to.empty()) {
+        to = from;
+    }
+
+    std::vector<Person> alive;
+    try {
+        alive = lifespanIndex->aliveDuring(from, to);
+    } catch (const std::exception& e) {
+        displayError(e.what());
+        return;
+    }
+
+    std::string title = "Alive " + (to == from ? "on " + from : "between " + from + " and " + to);
+    browsePeople(title, "Nobody in the tree was alive then.", [&](size_t offset, size_t limit) {
+        PersonPage page;
+        size_t end = std::min(alive.size(), offset + limit);
+        if (offset < end) {
+            page.people.assign(alive.begin() + offset, alive.begin() + end);
+        }
+        page.hasMore = end < alive.size();
+        return page;
+    });
+}
+
 void FamilyTreeUI::viewFamilyMembers() {
     clearScreen();
     std::cout << "\n=== View Family Members ===\n";
@@ -426,35 +717,67 @@ void FamilyTreeUI::viewFamilyMembers() {
         return;
     }
 
+    // The four lookups are independent, so run them side by side
+    auto token = CancellationToken::withTimeout(QUERY_TIMEOUT);
+    auto parentsQuery = asyncTree->getParents(id, token);
+    auto siblingsQuery = asyncTree->getSiblings(id, token);
+    auto spouseQuery = asyncTree->getSpouse(id, token);
+    auto childrenQuery = asyncTree->getChildren(id, token);
+
+    // Each lookup fails on its own; its section shows the error instead
+    auto collect = [](auto& query, auto& result) -> std::string {
+        try {
+            result = query.get();
+        } catch (const OperationCancelled&) {
+            return "query took too long and was cancelled";
+        } catch (const std::exception& e) {
+            return e.what();
+        }
+        return "";
+    };
+    std::vector<Person> parents, siblings, children;
+    std::optional<Person> spouse;
+    std::string parentsError = collect(parentsQuery, parents);
+    std::string siblingsError = collect(siblingsQuery, siblings);
+    std::string spouseError = collect(spouseQuery, spouse);
+    std::string childrenError = collect(childrenQuery, children);
+
     displayPerson(*person);
     std::cout << "\nImmediate Family Members:\n";
     
     // Show parents
-    auto parents = tree->getParents(id);
     std::cout << "\nParents:\n";
+    if (!parentsError.empty()) {
+        std::cout << "Error: " << parentsError << "\n";
+    }
     for (const auto& parent : parents) {
         std::cout << "- " << parent.getFullName() << "\n";
     }
 
     // Show siblings
-    auto siblings = tree->getSiblings(id);
     std::cout << "\nSiblings:\n";
+    if (!siblingsError.empty()) {
+        std::cout << "Error: " << siblingsError << "\n";
+    }
     for (const auto& sibling : siblings) {
         std::cout << "- " << sibling.getFullName() << "\n";
     }
 
     // Show spouse
-    auto spouse = tree->getSpouse(id);
     std::cout << "\nSpouse: ";
-    if (spouse) {
+    if (!spouseError.empty()) {
+        std::cout << "Error: " << spouseError << "\n";
+    } else if (spouse) {
         std::cout << spouse->getFullName() << "\n";
     } else {
         std::cout << "None\n";
     }
 
     // Show children
-    auto children = tree->getChildren(id);
     std::cout << "\nChildren:\n";
+    if (!childrenError.empty()) {
+        std::cout << "Error: " << childrenError << "\n";
+    }
     for (const auto& child : children) {
         std::cout << "- " << child.getFullName() << "\n";
     }
@@ -462,23 +785,95 @@ void FamilyTreeUI::viewFamilyMembers() {
     waitForEnter();
 }
 
-void FamilyTreeUI::displayPerson(const Person& person) {
-    std::cout << "\nID: " << person.getId()
-              << "\nName: " << person.getFullName()
-              << "\nGender: " << person.getGender()
-              << "\nDate of Birth: " << person.getDateOfBirth();
+void FamilyTreeUI::displayPerson(const Person& person, std::ostream& out) {
+    out << "\nID: " << person.getId()
+        << "\nName: " << person.getFullName()
+        << "\nGender: " << person.getGender()
+        << "\nDate of Birth: " << person.getDateOfBirth();
     
     if (person.isDeceased()) {
-        std::cout << "\nDate of Death: " << person.getDateOfDeath();
+        out << "\nDate of Death: " << person.getDateOfDeath();
     }
     
     if (!person.getBirthPlace().empty()) {
-        std::cout << "\nBirth Place: " << person.getBirthPlace();
+        out << "\nBirth Place: " << person.getBirthPlace();
     }
     
     if (!person.getDeathPlace().empty()) {
-        std::cout << "\nDeath Place: " << person.getDeathPlace();
+        out << "\nDeath Place: " << person.getDeathPlace();
     }
     
-    std::cout << "\n";
-}
\ No newline at end of file
+    out << "\n";
+}
+
+// Each page is read when shown and drawn with a single write, so the first
+// page of a very long list appears as fast as any other
+void FamilyTreeUI::browsePeople(const std::string& title, const std::string& emptyMessage,
+                                const PageSource& fetchPage) {
+    size_t pageNumber = 0;
+    PersonPage page = fetchPage(0, PAGE_SIZE);
+    if (page.people.empty()) {
+        std::cout << "\n" << emptyMessage << "\n";
+        waitForEnter();
+        return;
+    }
+
+    std::string notice;
+    while (true) {
+        std::ostringstream screen;
+        size_t first = pageNumber * PAGE_SIZE;
+        screen << "\n=== " << title << " ===\n"
+               << "Page " << pageNumber + 1 << ", results " << first + 1 << "-"
+               << first + page.people.size() << (page.hasMore ? " (more follow)" : " (end)") << "\n";
+        for (size_t i = 0; i < page.people.size(); i++) {
+            screen << "\n#" << first + i + 1;
+            if (i < page.generations.size()) {
+                screen << " (generation " << page.generations[i] << ")";
+            }
+            displayPerson(page.people[i], screen);
+            screen << "------------------------\n";
+        }
+        if (!notice.empty()) {
+            screen << "\n" << notice << "\n";
+            notice.clear();
+        }
+        screen << "\n" << (page.hasMore ? "[n]ext  " : "") << (pageNumber > 0 ? "[p]revious  " : "")
+               << "[j]ump N  [q]uit: ";
+
+        clearScreen();
+        std::cout << screen.str() << std::flush;
+
+        std::string command;
+        std::getline(std::cin, command);
+        size_t target = pageNumber;
+        if (command == "n" && page.hasMore) {
+            target = pageNumber + 1;
+        } else if (command == "p" && pageNumber > 0) {
+            target = pageNumber - 1;
+        } else if (!command.empty() && command[0] == 'j') {
+            try {
+                int requested = std::stoi(command.substr(1));
+                if (requested < 1) throw std::out_of_range("page");
+                target = static_cast<size_t>(requested - 1);
+            } catch (const std::exception&) {
+                notice = "Usage: j PAGE (pages start at 1)";
+                continue;
+            }
+        } else if (command == "q" || !std::cin) {
+            return;
+        } else {
+            continue;
+        }
+        if (target == pageNumber) {
+            continue;
+        }
+
+        PersonPage next = fetchPage(target * PAGE_SIZE, PAGE_SIZE);
+        if (next.people.empty()) {
+            notice = "Page " + std::to_string(target + 1) + " is past the end of the list.";
+            continue;
+        }
+        page = std::move(next);
+        pageNumber = target;
+    }
+}
@@ -0,0 +1,66 @@
+#include "utils/CancellationToken.hpp"
+
+namespace {
+
+thread_local const CancellationToken* currentToken = nullptr;
+
+} // namespace
+
+CancellationToken CancellationToken::create() {
+    CancellationToken token;
+    token.state = std::make_shared<State>();
+    return token;
+}
+
+CancellationToken CancellationToken::withTimeout(std::chrono::milliseconds timeout) {
+    return withDeadline(std::chrono::steady_clock::now() + timeout);
+}
+
+CancellationToken CancellationToken::withDeadline(std::chrono::steady_clock::time_point deadline) {
+    CancellationToken token = create();
+    token.state->hasDeadline = true;
+    token.state->deadline = deadline;
+    return token;
+}
+
+void CancellationToken::cancel() {
+    if (state) {
+        state->cancelled.store(true);
+    }
+}
+
+bool CancellationToken::isCancelled() const {
+    if (!state) {
+        return false;
+    }
+    if (state->cancelled.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return state->hasDeadline && std::chrono::steady_clock::now() >= state->deadline;
+}
+
+void CancellationToken::throwIfCancelled() const {
+    if (!state) {
+        return;
+    }
+    if (state->cancelled.load()) {
+        throw OperationCancelled("Operation cancelled");
+    }
+    if (state->hasDeadline && std::chrono::steady_clock::now() >= state->deadline) {
+        throw OperationCancelled("Operation deadline exceeded");
+    }
+}
+
+CancellationToken::Scope::Scope(const CancellationToken& token) : previous(currentToken) {
+    currentToken = &token;
+}
+
+CancellationToken::Scope::~Scope() {
+    currentToken = previous;
+}
+
+void CancellationToken::checkCurrent() {
+    if (currentToken) {
+        currentToken->throwIfCancelled();
+    }
+}
@@ -1,2 +1,79 @@
 #include "utils/DateFormatter.hpp"
-// Empty implementation for now
\ No newline at end of file
+#include <cctype>
+#include <cstdio>
+
+namespace {
+
+bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int daysInMonth(int year, int month) {
+    static const int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeapYear(year) ? 29 : DAYS[month - 1];
+}
+
+// Howard Hinnant's days_from_civil (proleptic Gregorian calendar)
+int32_t daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - era * 400;
+    const int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Reads exactly `digits` digits at text[position]
+bool readNumber(const std::string& text, size_t position, size_t digits, int& value) {
+    if (position + digits > text.size()) return false;
+    value = 0;
+    for (size_t i = position; i < position + digits; i++) {
+        if (!std::isdigit(static_cast<unsigned char>(text[i]))) return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+std::optional<int32_t> DateFormatter::toDayNumber(const std::string& date, bool roundUp) {
+    int year = 0;
+    int month = roundUp ? 12 : 1;
+    int day = 1;
+    if (!readNumber(date, 0, 4, year)) {
+        return std::nullopt;
+    }
+    if (date.size() > 4) {
+        if (date[4] != '-' || !readNumber(date, 5, 2, month) || month < 1 || month > 12) {
+            return std::nullopt;
+        }
+    }
+    day = roundUp ? daysInMonth(year, month) : 1;
+    if (date.size() > 7) {
+        if (date.size() != 10 || date[7] != '-' || !readNumber(date, 8, 2, day) ||
+            day < 1 || day > daysInMonth(year, month)) {
+            return std::nullopt;
+        }
+    } else if (date.size() != 4 && date.size() != 7) {
+        return std::nullopt;
+    }
+    return daysFromCivil(year, month, day);
+}
+
+std::string DateFormatter::fromDayNumber(int32_t day) {
+    // Inverse of daysFromCivil
+    const int32_t shifted = day + 719468;
+    const int era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+    const int dayOfEra = shifted - era * 146097;
+    const int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const int monthIndex = (5 * dayOfYear + 2) / 153;
+    const int dayOfMonth = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    const int month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    const int year = yearOfEra + era * 400 + (month <= 2);
+
+    // Room for any three ints, which is what the compiler checks against
+    char text[sizeof("-2147483648-2147483648-2147483648")];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d", year, month, dayOfMonth);
+    return text;
+}
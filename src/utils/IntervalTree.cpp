@@ -0,0 +1,74 @@
+#include "utils/IntervalTree.hpp"
+#include <algorithm>
+#include <numeric>
+
+IntervalTree::IntervalTree(std::vector<int32_t> starts, std::vector<int32_t> ends)
+    : starts(std::move(starts)), ends(std::move(ends)) {
+    std::vector<uint32_t> everyone(this->starts.size());
+    std::iota(everyone.begin(), everyone.end(), 0);
+    std::stable_sort(everyone.begin(), everyone.end(),
+                     [&](uint32_t a, uint32_t b) { return this->starts[a] < this->starts[b]; });
+    root = build(everyone);
+}
+
+// members are in ascending start order
+int32_t IntervalTree::build(const std::vector<uint32_t>& members) {
+    if (members.empty()) {
+        return -1;
+    }
+    // The median start is inside its own interval, so no node is empty,
+    // and at most half the members fall on either side
+    const int32_t center = starts[members[members.size() / 2]];
+    std::vector<uint32_t> before, after;
+    const auto nodeIndex = static_cast<int32_t>(nodes.size());
+    nodes.emplace_back();
+    nodes[nodeIndex].center = center;
+    nodes[nodeIndex].begin = static_cast<uint32_t>(byStart.size());
+    for (uint32_t member : members) {
+        if (ends[member] < center) {
+            before.push_back(member);
+        } else if (starts[member] > center) {
+            after.push_back(member);
+        } else {
+            byStart.push_back(member);
+        }
+    }
+    nodes[nodeIndex].count = static_cast<uint32_t>(byStart.size()) - nodes[nodeIndex].begin;
+    byEnd.insert(byEnd.end(), byStart.begin() + nodes[nodeIndex].begin, byStart.end());
+    std::sort(byEnd.begin() + nodes[nodeIndex].begin, byEnd.end(),
+              [&](uint32_t a, uint32_t b) { return ends[a] > ends[b]; });
+
+    int32_t left = build(before);
+    int32_t right = build(after);
+    nodes[nodeIndex].left = left;
+    nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+void IntervalTree::query(int32_t from, int32_t to, std::vector<uint32_t>& matches) const {
+    std::vector<int32_t> pending;
+    if (root >= 0) {
+        pending.push_back(root);
+    }
+    while (!pending.empty()) {
+        const Node& node = nodes[pending.back()];
+        pending.pop_back();
+        const uint32_t end = node.begin + node.count;
+        if (to < node.center) {
+            // Everything here ends after the range; take those starting in time
+            for (uint32_t i = node.begin; i < end && starts[byStart[i]] <= to; i++) {
+                matches.push_back(byStart[i]);
+            }
+            if (node.left >= 0) pending.push_back(node.left);
+        } else if (from > node.center) {
+            for (uint32_t i = node.begin; i < end && ends[byEnd[i]] >= from; i++) {
+                matches.push_back(byEnd[i]);
+            }
+            if (node.right >= 0) pending.push_back(node.right);
+        } else {
+            matches.insert(matches.end(), byStart.begin() + node.begin, byStart.begin() + end);
+            if (node.left >= 0) pending.push_back(node.left);
+            if (node.right >= 0) pending.push_back(node.right);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#include "utils/JsonFormatter.hpp"
+#include <cstdio>
+
+std::string JsonFormatter::escape(const std::string& value) {
+    std::string result;
+    result.reserve(value.size());
+    for (char ch : value) {
+        switch (ch) {
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+                    result += buffer;
+                } else {
+                    result += ch;
+                }
+        }
+    }
+    return result;
+}
+
+std::string JsonFormatter::quote(const std::string& value) {
+    return "\"" + escape(value) + "\"";
+}
+
+std::string JsonFormatter::person(const Person& person) {
+    return "{\"id\":" + quote(person.getId()) +
+           ",\"first_name\":" + quote(person.getFirstName()) +
+           ",\"last_name\":" + quote(person.getLastName()) +
+           ",\"gender\":" + quote(person.getGender()) +
+           ",\"date_of_birth\":" + quote(person.getDateOfBirth()) +
+           ",\"date_of_death\":" + quote(person.getDateOfDeath()) +
+           ",\"birth_place\":" + quote(person.getBirthPlace()) +
+           ",\"death_place\":" + quote(person.getDeathPlace()) + "}";
+}
+
+std::string JsonFormatter::person(const std::optional<Person>& person) {
+    return person ? JsonFormatter::person(*person) : "null";
+}
+
+std::string JsonFormatter::people(const std::vector<Person>& people) {
+    std::string result = "[";
+    for (size_t i = 0; i < people.size(); i++) {
+        if (i > 0) result += ",";
+        result += person(people[i]);
+    }
+    return result + "]";
+}
+
+std::string JsonFormatter::relationship(const Relationship& relationship) {
+    return "{\"id\":" + quote(relationship.getId()) +
+           ",\"person1_id\":" + quote(relationship.getPerson1Id()) +
+           ",\"person2_id\":" + quote(relationship.getPerson2Id()) +
+           ",\"type\":" + quote(Relationship::relationTypeToString(relationship.getType())) +
+           ",\"start_date\":" + quote(relationship.getStartDate()) +
+           ",\"end_date\":" + quote(relationship.getEndDate()) + "}";
+}
+
+std::string JsonFormatter::relationships(const std::vector<Relationship>& relationships) {
+    std::string result = "[";
+    for (size_t i = 0; i < relationships.size(); i++) {
+        if (i > 0) result += ",";
+        result += relationship(relationships[i]);
+    }
+    return result + "]";
+}
@@ -0,0 +1,260 @@
+#include "utils/Metrics.hpp"
+#include "utils/JsonFormatter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+struct SqlCounters {
+    std::atomic<uint64_t> statements{0};
+    std::atomic<uint64_t> rows{0};
+    std::atomic<uint64_t> prepareNanos{0};
+    std::atomic<uint64_t> stepNanos{0};
+    std::atomic<uint64_t> statementCacheHits{0};
+    std::atomic<uint64_t> statementCacheMisses{0};
+};
+
+SqlCounters sqlCounters;
+
+std::mutex registryMutex;
+
+std::map<std::string, std::unique_ptr<ApiMetrics>>& registry() {
+    static std::map<std::string, std::unique_ptr<ApiMetrics>> apis;
+    return apis;
+}
+
+const size_t LAYERS = 2;
+
+// Outermost scope per layer on this thread
+thread_local Metrics::Scope* activeScopes[LAYERS] = {nullptr, nullptr};
+
+// Registry entries by name literal, so lookups skip the registry lock
+thread_local std::unordered_map<const char*, ApiMetrics*> knownApis[LAYERS];
+
+void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t get(const std::atomic<uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+// LatencyHistogram
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t nanos) {
+    if (nanos < 32) {
+        return static_cast<size_t>(nanos);
+    }
+    int highestBit = 63 - __builtin_clzll(nanos);  // at least 5
+    int shift = highestBit - 4;
+    uint64_t subBucket = nanos >> shift;            // in [16, 32)
+    return 32 + static_cast<size_t>(shift - 1) * 16 + static_cast<size_t>(subBucket - 16);
+}
+
+uint64_t LatencyHistogram::bucketMidpoint(size_t bucket) {
+    if (bucket < 32) {
+        return bucket;
+    }
+    size_t offset = bucket - 32;
+    int shift = static_cast<int>(offset / 16) + 1;
+    uint64_t lower = static_cast<uint64_t>(offset % 16 + 16) << shift;
+    return lower + (uint64_t(1) << shift) / 2;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    add(counts[bucketOf(nanos)], 1);
+    add(total, 1);
+    add(sumNanos, nanos);
+    uint64_t previous = maxNanos.load(std::memory_order_relaxed);
+    while (nanos > previous &&
+           !maxNanos.compare_exchange_weak(previous, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sumNanos.store(0, std::memory_order_relaxed);
+    maxNanos.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::meanNanos() const {
+    uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(get(sumNanos)) / n;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(percent / 100.0 * n));
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += get(counts[bucket]);
+        if (seen >= target) {
+            return std::min(bucketMidpoint(bucket), max());
+        }
+    }
+    return max();
+}
+
+// Metrics
+std::atomic<bool> Metrics::enabledFlag{false};
+
+Metrics::Scope::Scope(Layer layer, const char* name) : layer(layer) {
+    if (!Metrics::enabled()) {
+        return;
+    }
+    Scope*& active = activeScopes[static_cast<size_t>(layer)];
+    if (active) {
+        return;  // nested call of the same layer: part of the outer operation
+    }
+    metrics = &Metrics::api(layer, name);
+    active = this;
+    start = std::chrono::steady_clock::now();
+}
+
+Metrics::Scope::~Scope() {
+    if (!metrics) {
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    add(metrics->calls, 1);
+    add(metrics->statements, statements);
+    add(metrics->rows, rows);
+    add(metrics->prepareNanos, prepareNanos);
+    add(metrics->stepNanos, stepNanos);
+    metrics->latency.record(static_cast<uint64_t>(elapsed));
+    activeScopes[static_cast<size_t>(layer)] = nullptr;
+}
+
+void Metrics::setEnabled(bool enabled) {
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+void Metrics::reset() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    // Entries stay registered: threads cache pointers to them
+    for (auto& entry : registry()) {
+        ApiMetrics& metrics = *entry.second;
+        metrics.calls.store(0, std::memory_order_relaxed);
+        metrics.statements.store(0, std::memory_order_relaxed);
+        metrics.rows.store(0, std::memory_order_relaxed);
+        metrics.prepareNanos.store(0, std::memory_order_relaxed);
+        metrics.stepNanos.store(0, std::memory_order_relaxed);
+        metrics.latency.reset();
+    }
+    for (auto* counter : {&sqlCounters.statements, &sqlCounters.rows, &sqlCounters.prepareNanos,
+                          &sqlCounters.stepNanos, &sqlCounters.statementCacheHits,
+                          &sqlCounters.statementCacheMisses}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+}
+
+ApiMetrics& Metrics::api(Layer layer, const char* name) {
+    auto& known = knownApis[static_cast<size_t>(layer)];
+    auto cached = known.find(name);
+    if (cached != known.end()) {
+        return *cached->second;
+    }
+
+    std::string key = std::string(layer == Layer::TREE ? "tree." : "db.") + name;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto& entry = registry()[key];
+    if (!entry) {
+        entry = std::make_unique<ApiMetrics>();
+    }
+    known[name] = entry.get();
+    return *entry;
+}
+
+void Metrics::recordStatement(uint64_t prepareNanos, uint64_t stepNanos, uint64_t rows, bool cached) {
+    add(sqlCounters.statements, 1);
+    add(sqlCounters.rows, rows);
+    add(sqlCounters.prepareNanos, prepareNanos);
+    add(sqlCounters.stepNanos, stepNanos);
+    add(cached ? sqlCounters.statementCacheHits : sqlCounters.statementCacheMisses, 1);
+
+    for (Scope* scope : activeScopes) {
+        if (scope) {
+            scope->statements++;
+            scope->rows += rows;
+            scope->prepareNanos += prepareNanos;
+            scope->stepNanos += stepNanos;
+        }
+    }
+}
+
+Metrics::SqlTotals Metrics::sqlTotals() {
+    SqlTotals totals;
+    totals.statements = get(sqlCounters.statements);
+    totals.rows = get(sqlCounters.rows);
+    totals.prepareNanos = get(sqlCounters.prepareNanos);
+    totals.stepNanos = get(sqlCounters.stepNanos);
+    totals.statementCacheHits = get(sqlCounters.statementCacheHits);
+    totals.statementCacheMisses = get(sqlCounters.statementCacheMisses);
+    return totals;
+}
+
+std::map<std::string, const ApiMetrics*> Metrics::apis() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::map<std::string, const ApiMetrics*> result;
+    for (const auto& entry : registry()) {
+        result[entry.first] = entry.second.get();
+    }
+    return result;
+}
+
+std::string Metrics::toJson() {
+    auto micros = [](double nanos) { return nanos / 1000.0; };
+    auto millis = [](uint64_t nanos) { return nanos / 1e6; };
+
+    SqlTotals sql = sqlTotals();
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3)
+         << "{\"enabled\":" << (enabled() ? "true" : "false")
+         << ",\"sql\":{\"statements\":" << sql.statements
+         << ",\"rows\":" << sql.rows
+         << ",\"prepare_ms\":" << millis(sql.prepareNanos)
+         << ",\"step_ms\":" << millis(sql.stepNanos)
+         << ",\"statement_cache_hits\":" << sql.statementCacheHits
+         << ",\"statement_cache_misses\":" << sql.statementCacheMisses << "}"
+         << ",\"apis\":{";
+
+    bool first = true;
+    for (const auto& entry : apis()) {
+        const ApiMetrics& api = *entry.second;
+        uint64_t calls = get(api.calls);
+        if (calls == 0) continue;
+        json << (first ? "" : ",") << JsonFormatter::quote(entry.first)
+             << ":{\"calls\":" << calls
+             << ",\"statements\":" << get(api.statements)
+             << ",\"statements_per_call\":" << static_cast<double>(get(api.statements)) / calls
+             << ",\"rows\":" << get(api.rows)
+             << ",\"prepare_ms\":" << millis(get(api.prepareNanos))
+             << ",\"step_ms\":" << millis(get(api.stepNanos))
+             << ",\"latency_us\":{\"mean\":" << micros(api.latency.meanNanos())
+             << ",\"p50\":" << micros(api.latency.percentile(50))
+             << ",\"p90\":" << micros(api.latency.percentile(90))
+             << ",\"p99\":" << micros(api.latency.percentile(99))
+             << ",\"p999\":" << micros(api.latency.percentile(99.9))
+             << ",\"max\":" << micros(api.latency.max()) << "}}";
+        first = false;
+    }
+    json << "}}";
+    return json.str();
+}
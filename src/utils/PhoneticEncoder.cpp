@@ -0,0 +1,693 @@
+#include "utils/PhoneticEncoder.hpp"
+#include <algorithm>
+#include <cctype>
+#include <initializer_list>
+
+namespace {
+
+bool isVowel(char c) {
+    return c == 'A' || c == 'E' || c == 'I' || c == 'O' || c == 'U' || c == 'Y';
+}
+
+char soundexDigit(char c) {
+    switch (c) {
+        case 'B': case 'F': case 'P': case 'V':
+            return '1';
+        case 'C': case 'G': case 'J': case 'K':
+        case 'Q': case 'S': case 'X': case 'Z':
+            return '2';
+        case 'D': case 'T':
+            return '3';
+        case 'L':
+            return '4';
+        case 'M': case 'N':
+            return '5';
+        case 'R':
+            return '6';
+        default:
+            return '0';
+    }
+}
+
+// Daitch-Mokotoff coding chart. Columns hold the code used at the start
+// of a name, before a vowel, and in any other position. "|" separates
+// alternative codes, an empty string means "not coded".
+struct DMRule {
+    const char* pattern;
+    const char* atStart;
+    const char* beforeVowel;
+    const char* otherwise;
+};
+
+const DMRule DM_RULES[] = {
+    {"SCHTSCH", "2", "4", "4"}, {"SCHTSH", "2", "4", "4"}, {"SCHTCH", "2", "4", "4"},
+    {"SHTSCH", "2", "4", "4"}, {"ZHDZH", "2", "4", "4"},
+    {"SHTCH", "2", "4", "4"}, {"SHTSH", "2", "4", "4"}, {"STSCH", "2", "4", "4"},
+    {"TTSCH", "4", "4", "4"}, {"ZDZH", "2", "4", "4"},
+    {"SCHT", "2", "43", "43"}, {"SCHD", "2", "43", "43"}, {"SHCH", "2", "4", "4"},
+    {"STCH", "2", "4", "4"}, {"STRZ", "2", "4", "4"}, {"STRS", "2", "4", "4"},
+    {"STSH", "2", "4", "4"}, {"SZCZ", "2", "4", "4"}, {"SZCS", "2", "4", "4"},
+    {"TTCH", "4", "4", "4"}, {"TSCH", "4", "4", "4"}, {"TTSZ", "4", "4", "4"},
+    {"ZSCH", "4", "4", "4"},
+    {"CHS", "5", "54", "54"}, {"CSZ", "4", "4", "4"}, {"CZS", "4", "4", "4"},
+    {"DRZ", "4", "4", "4"}, {"DRS", "4", "4", "4"}, {"DSH", "4", "4", "4"},
+    {"DSZ", "4", "4", "4"}, {"DZH", "4", "4", "4"}, {"DZS", "4", "4", "4"},
+    {"SCH", "4", "4", "4"}, {"SHT", "2", "43", "43"}, {"SZT", "2", "43", "43"},
+    {"SHD", "2", "43", "43"}, {"SZD", "2", "43", "43"}, {"TCH", "4", "4", "4"},
+    {"TRZ", "4", "4", "4"}, {"TRS", "4", "4", "4"}, {"TSH", "4", "4", "4"},
+    {"TTS", "4", "4", "4"}, {"TTZ", "4", "4", "4"}, {"TZS", "4", "4", "4"},
+    {"TSZ", "4", "4", "4"}, {"ZDZ", "2", "4", "4"}, {"ZHD", "2", "43", "43"},
+    {"ZSH", "4", "4", "4"},
+    {"AI", "0", "1", ""}, {"AJ", "0", "1", ""}, {"AY", "0", "1", ""}, {"AU", "0", "7", ""},
+    {"CH", "5|4", "5|4", "5|4"}, {"CK", "5|45", "5|45", "5|45"}, {"CZ", "4", "4", "4"},
+    {"CS", "4", "4", "4"}, {"DS", "4", "4", "4"}, {"DZ", "4", "4", "4"}, {"DT", "3", "3", "3"},
+    {"EI", "0", "1", ""}, {"EJ", "0", "1", ""}, {"EY", "0", "1", ""}, {"EU", "1", "1", ""},
+    {"FB", "7", "7", "7"}, {"IA", "1", "", ""}, {"IE", "1", "", ""}, {"IO", "1", "", ""},
+    {"IU", "1", "", ""}, {"KS", "5", "54", "54"}, {"KH", "5", "5", "5"},
+    {"MN", "", "66", "66"}, {"NM", "", "66", "66"},
+    {"OI", "0", "1", ""}, {"OJ", "0", "1", ""}, {"OY", "0", "1", ""},
+    {"PF", "7", "7", "7"}, {"PH", "7", "7", "7"}, {"RZ", "94|4", "94|4", "94|4"},
+    {"RS", "94|4", "94|4", "94|4"}, {"SH", "4", "4", "4"}, {"SC", "2", "4", "4"},
+    {"ST", "2", "43", "43"}, {"SZ", "4", "4", "4"}, {"SD", "2", "43", "43"},
+    {"TH", "3", "3", "3"}, {"TS", "4", "4", "4"}, {"TC", "4", "4", "4"}, {"TZ", "4", "4", "4"},
+    {"UI", "0", "1", ""}, {"UJ", "0", "1", ""}, {"UY", "0", "1", ""}, {"UE", "0", "", ""},
+    {"ZD", "2", "43", "43"}, {"ZH", "4", "4", "4"}, {"ZS", "4", "4", "4"},
+    {"A", "0", "", ""}, {"B", "7", "7", "7"}, {"C", "5|4", "5|4", "5|4"}, {"D", "3", "3", "3"},
+    {"E", "0", "", ""}, {"F", "7", "7", "7"}, {"G", "5", "5", "5"}, {"H", "5", "5", ""},
+    {"I", "0", "", ""}, {"J", "1|4", "|4", "|4"}, {"K", "5", "5", "5"}, {"L", "8", "8", "8"},
+    {"M", "6", "6", "6"}, {"N", "6", "6", "6"}, {"O", "0", "", ""}, {"P", "7", "7", "7"},
+    {"Q", "5", "5", "5"}, {"R", "9", "9", "9"}, {"S", "4", "4", "4"}, {"T", "3", "3", "3"},
+    {"U", "0", "", ""}, {"V", "7", "7", "7"}, {"W", "7", "7", "7"}, {"X", "5", "54", "54"},
+    {"Y", "1", "", ""}, {"Z", "4", "4", "4"}
+};
+
+const size_t DM_CODE_LENGTH = 6;
+const size_t DM_MAX_BRANCHES = 32;
+
+std::vector<std::string> splitAlternatives(const std::string& codes) {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (true) {
+        size_t bar = codes.find('|', start);
+        result.push_back(codes.substr(start, bar == std::string::npos ? std::string::npos : bar - start));
+        if (bar == std::string::npos) break;
+        start = bar + 1;
+    }
+    return result;
+}
+
+// Double Metaphone over an upper-cased word. This follows the rule set of
+// Lawrence Philips' reference implementation for the letter groups that
+// occur in European surnames; the rarer Romance/Germanic exceptions of the
+// original are folded into the general rules.
+class MetaphoneEncoder {
+private:
+    const std::string& word;
+    long length;
+    std::string primary;
+    std::string alternate;
+    bool slavoGermanic;
+
+    char at(long pos) const {
+        return (pos >= 0 && pos < length) ? word[pos] : '\0';
+    }
+
+    bool matches(long pos, size_t len, std::initializer_list<const char*> options) const {
+        if (pos < 0 || pos >= length) return false;
+        std::string part = word.substr(pos, len);
+        for (const char* option : options) {
+            if (part == option) return true;
+        }
+        return false;
+    }
+
+    void add(const char* main) {
+        primary += main;
+        alternate += main;
+    }
+
+    void add(const char* main, const char* alt) {
+        primary += main;
+        alternate += alt;
+    }
+
+    long encodeC(long i);
+    long encodeG(long i);
+    long encodeS(long i);
+
+public:
+    explicit MetaphoneEncoder(const std::string& w)
+        : word(w), length(static_cast<long>(w.size())) {
+        slavoGermanic = w.find('W') != std::string::npos || w.find('K') != std::string::npos ||
+                        w.find("CZ") != std::string::npos || w.find("WITZ") != std::string::npos;
+    }
+
+    std::pair<std::string, std::string> encode();
+};
+
+long MetaphoneEncoder::encodeC(long i) {
+    if (i > 1 && !isVowel(at(i - 2)) && matches(i - 1, 3, {"ACH"}) && at(i + 2) != 'I' &&
+        (at(i + 2) != 'E' || matches(i - 2, 6, {"BACHER", "MACHER"}))) {
+        add("K");
+        return i + 2;
+    }
+    if (i == 0 && matches(i, 6, {"CAESAR"})) {
+        add("S");
+        return i + 2;
+    }
+    if (matches(i, 4, {"CHIA"})) {
+        add("K");
+        return i + 2;
+    }
+    if (matches(i, 2, {"CH"})) {
+        if (i > 0 && matches(i, 4, {"CHAE"})) {
+            add("K", "X");
+        } else if (i == 0 && (matches(i + 1, 5, {"HARAC", "HARIS"}) ||
+                              matches(i + 1, 3, {"HOR", "HYM", "HIA", "HEM"})) &&
+                   !matches(0, 5, {"CHORE"})) {
+            add("K");
+        } else if (matches(0, 4, {"VAN ", "VON "}) || matches(0, 3, {"SCH"}) ||
+                   matches(i - 2, 6, {"ORCHES", "ARCHIT", "ORCHID"}) ||
+                   matches(i + 2, 1, {"T", "S"}) ||
+                   ((matches(i - 1, 1, {"A", "O", "U", "E"}) || i == 0) &&
+                    matches(i + 2, 1, {"L", "R", "N", "M", "B", "H", "F", "V", "W", " "}))) {
+            add("K");
+        } else if (i > 0) {
+            if (matches(0, 2, {"MC"})) {
+                add("K");
+            } else {
+                add("X", "K");
+            }
+        } else {
+            add("X");
+        }
+        return i + 2;
+    }
+    if (matches(i, 2, {"CZ"}) && !matches(i - 2, 4, {"WICZ"})) {
+        add("S", "X");
+        return i + 2;
+    }
+    if (matches(i + 1, 3, {"CIA"})) {
+        add("X");
+        return i + 3;
+    }
+    if (matches(i, 2, {"CC"}) && !(i == 1 && at(0) == 'M')) {
+        if (matches(i + 2, 1, {"I", "E", "H"}) && !matches(i + 2, 2, {"HU"})) {
+            if ((i == 1 && at(0) == 'A') || matches(i - 1, 5, {"UCCEE", "UCCES"})) {
+                add("KS");
+            } else {
+                add("X");
+            }
+            return i + 3;
+        }
+        add("K");
+        return i + 2;
+    }
+    if (matches(i, 2, {"CK", "CG", "CQ"})) {
+        add("K");
+        return i + 2;
+    }
+    if (matches(i, 2, {"CI", "CE", "CY"})) {
+        if (matches(i, 3, {"CIO", "CIE", "CIA"})) {
+            add("S", "X");
+        } else {
+            add("S");
+        }
+        return i + 2;
+    }
+    add("K");
+    if (matches(i + 1, 2, {" C", " Q", " G"})) return i + 3;
+    if (matches(i + 1, 1, {"C", "K", "Q"}) && !matches(i + 1, 2, {"CE", "CI"})) return i + 2;
+    return i + 1;
+}
+
+long MetaphoneEncoder::encodeG(long i) {
+    if (at(i + 1) == 'H') {
+        if (i > 0 && !isVowel(at(i - 1))) {
+            add("K");
+            return i + 2;
+        }
+        if (i == 0) {
+            add(at(i + 2) == 'I' ? "J" : "K");
+            return i + 2;
+        }
+        if ((i > 1 && matches(i - 2, 1, {"B", "H", "D"})) ||
+            (i > 2 && matches(i - 3, 1, {"B", "H", "D"})) ||
+            (i > 3 && matches(i - 4, 1, {"B", "H"}))) {
+            return i + 2;
+        }
+        if (i > 2 && at(i - 1) == 'U' && matches(i - 3, 1, {"C", "G", "L", "R", "T"})) {
+            add("F");
+        } else if (at(i - 1) != 'I') {
+            add("K");
+        }
+        return i + 2;
+    }
+    if (at(i + 1) == 'N') {
+        if (i == 1 && isVowel(at(0)) && !slavoGermanic) {
+            add("KN", "N");
+        } else if (!matches(i + 2, 2, {"EY"}) && !slavoGermanic) {
+            add("N", "KN");
+        } else {
+            add("KN");
+        }
+        return i + 2;
+    }
+    if (matches(i + 1, 2, {"LI"}) && !slavoGermanic) {
+        add("KL", "L");
+        return i + 2;
+    }
+    if (i == 0 && (at(1) == 'Y' ||
+                   matches(1, 2, {"ES", "EP", "EB", "EL", "EY", "IB", "IL", "IN", "IE", "EI", "ER"}))) {
+        add("K", "J");
+        return i + 2;
+    }
+    if ((matches(i + 1, 2, {"ER"}) || at(i + 1) == 'Y') &&
+        !matches(0, 6, {"DANGER", "RANGER", "MANGER"}) &&
+        !matches(i - 1, 1, {"E", "I"}) && !matches(i - 1, 3, {"RGY", "OGY"})) {
+        add("K", "J");
+        return i + 2;
+    }
+    if (matches(i + 1, 1, {"E", "I", "Y"}) || matches(i - 1, 4, {"AGGI", "OGGI"})) {
+        if (matches(0, 4, {"VAN ", "VON "}) || matches(0, 3, {"SCH"}) || matches(i + 1, 2, {"ET"})) {
+            add("K");
+        } else if (matches(i + 1, 4, {"IER "}) || (matches(i + 1, 3, {"IER"}) && i + 4 == length)) {
+            add("J");
+        } else {
+            add("J", "K");
+        }
+        return i + 2;
+    }
+    add("K");
+    return at(i + 1) == 'G' ? i + 2 : i + 1;
+}
+
+long MetaphoneEncoder::encodeS(long i) {
+    if (matches(i - 1, 3, {"ISL", "YSL"})) {
+        return i + 1;
+    }
+    if (i == 0 && matches(i, 5, {"SUGAR"})) {
+        add("X", "S");
+        return i + 1;
+    }
+    if (matches(i, 2, {"SH"})) {
+        add(matches(i + 1, 4, {"HEIM", "HOEK", "HOLM", "HOLZ"}) ? "S" : "X");
+        return i + 2;
+    }
+    if (matches(i, 3, {"SIO", "SIA"})) {
+        if (slavoGermanic) {
+            add("S");
+        } else {
+            add("S", "X");
+        }
+        return i + 3;
+    }
+    if ((i == 0 && matches(i + 1, 1, {"M", "N", "L", "W"})) || matches(i + 1, 1, {"Z"})) {
+        add("S", "X");
+        return matches(i + 1, 1, {"Z"}) ? i + 2 : i + 1;
+    }
+    if (matches(i, 2, {"SC"})) {
+        if (at(i + 2) == 'H') {
+            if (matches(i + 3, 2, {"OO", "ER", "EN", "UY", "ED", "EM"})) {
+                if (matches(i + 3, 2, {"ER", "EN"})) {
+                    add("X", "SK");
+                } else {
+                    add("SK");
+                }
+            } else if (i == 0 && !isVowel(at(3)) && at(3) != 'W') {
+                add("X", "S");
+            } else {
+                add("X");
+            }
+            return i + 3;
+        }
+        add(matches(i + 2, 1, {"I", "E", "Y"}) ? "S" : "SK");
+        return i + 3;
+    }
+    if (i == length - 1 && matches(i - 2, 2, {"AI", "OI"})) {
+        add("", "S");
+    } else {
+        add("S");
+    }
+    return matches(i + 1, 1, {"S", "Z"}) ? i + 2 : i + 1;
+}
+
+std::pair<std::string, std::string> MetaphoneEncoder::encode() {
+    long i = 0;
+    if (matches(0, 2, {"GN", "KN", "PN", "WR", "PS"})) {
+        i = 1;
+    }
+    if (at(0) == 'X') {
+        add("S");
+        i = 1;
+    }
+
+    while ((primary.size() < 4 || alternate.size() < 4) && i < length) {
+        char c = word[i];
+        switch (c) {
+            case 'A': case 'E': case 'I': case 'O': case 'U': case 'Y':
+                if (i == 0) add("A");
+                i++;
+                break;
+            case 'B':
+                add("P");
+                i += at(i + 1) == 'B' ? 2 : 1;
+                break;
+            case 'C':
+                i = encodeC(i);
+                break;
+            case 'D':
+                if (matches(i, 2, {"DG"})) {
+                    if (matches(i + 2, 1, {"I", "E", "Y"})) {
+                        add("J");
+                        i += 3;
+                    } else {
+                        add("TK");
+                        i += 2;
+                    }
+                } else {
+                    add("T");
+                    i += matches(i, 2, {"DT", "DD"}) ? 2 : 1;
+                }
+                break;
+            case 'F':
+                add("F");
+                i += at(i + 1) == 'F' ? 2 : 1;
+                break;
+            case 'G':
+                i = encodeG(i);
+                break;
+            case 'H':
+                if ((i == 0 || isVowel(at(i - 1))) && isVowel(at(i + 1))) {
+                    add("H");
+                    i += 2;
+                } else {
+                    i++;
+                }
+                break;
+            case 'J':
+                if (matches(i, 4, {"JOSE"}) || matches(0, 4, {"SAN "})) {
+                    if ((i == 0 && at(i + 4) == ' ') || matches(0, 4, {"SAN "})) {
+                        add("H");
+                    } else {
+                        add("J", "H");
+                    }
+                } else if (i == 0) {
+                    add("J", "A");
+                } else if (isVowel(at(i - 1)) && !slavoGermanic && (at(i + 1) == 'A' || at(i + 1) == 'O')) {
+                    add("J", "H");
+                } else if (i == length - 1) {
+                    add("J", "");
+                } else if (!matches(i + 1, 1, {"L", "T", "K", "S", "N", "M", "B", "Z"}) &&
+                           !matches(i - 1, 1, {"S", "K", "L"})) {
+                    add("J");
+                }
+                i += at(i + 1) == 'J' ? 2 : 1;
+                break;
+            case 'K':
+                add("K");
+                i += at(i + 1) == 'K' ? 2 : 1;
+                break;
+            case 'L':
+                if (at(i + 1) == 'L') {
+                    if ((i == length - 3 && matches(i - 1, 4, {"ILLO", "ILLA", "ALLE"})) ||
+                        ((matches(length - 2, 2, {"AS", "OS"}) || matches(length - 1, 1, {"A", "O"})) &&
+                         matches(i - 1, 4, {"ALLE"}))) {
+                        add("L", "");
+                    } else {
+                        add("L");
+                    }
+                    i += 2;
+                } else {
+                    add("L");
+                    i++;
+                }
+                break;
+            case 'M':
+                add("M");
+                if ((matches(i - 1, 3, {"UMB"}) && (i + 1 == length - 1 || matches(i + 2, 2, {"ER"}))) ||
+                    at(i + 1) == 'M') {
+                    i += 2;
+                } else {
+                    i++;
+                }
+                break;
+            case 'N':
+                add("N");
+                i += at(i + 1) == 'N' ? 2 : 1;
+                break;
+            case 'P':
+                if (at(i + 1) == 'H') {
+                    add("F");
+                    i += 2;
+                } else {
+                    add("P");
+                    i += matches(i + 1, 1, {"P", "B"}) ? 2 : 1;
+                }
+                break;
+            case 'Q':
+                add("K");
+                i += at(i + 1) == 'Q' ? 2 : 1;
+                break;
+            case 'R':
+                if (i == length - 1 && !slavoGermanic && matches(i - 2, 2, {"IE"}) &&
+                    !matches(i - 4, 2, {"ME", "MA"})) {
+                    add("", "R");
+                } else {
+                    add("R");
+                }
+                i += at(i + 1) == 'R' ? 2 : 1;
+                break;
+            case 'S':
+                i = encodeS(i);
+                break;
+            case 'T':
+                if (matches(i, 4, {"TION"}) || matches(i, 3, {"TIA", "TCH"})) {
+                    add("X");
+                    i += 3;
+                } else if (matches(i, 2, {"TH"}) || matches(i, 3, {"TTH"})) {
+                    if (matches(i + 2, 2, {"OM", "AM"}) || matches(0, 4, {"VAN ", "VON "}) ||
+                        matches(0, 3, {"SCH"})) {
+                        add("T");
+                    } else {
+                        add("0", "T");
+                    }
+                    i += 2;
+                } else {
+                    add("T");
+                    i += matches(i + 1, 1, {"T", "D"}) ? 2 : 1;
+                }
+                break;
+            case 'V':
+                add("F");
+                i += at(i + 1) == 'V' ? 2 : 1;
+                break;
+            case 'W':
+                if (matches(i, 2, {"WR"})) {
+                    add("R");
+                    i += 2;
+                    break;
+                }
+                if (i == 0 && (isVowel(at(1)) || matches(i, 2, {"WH"}))) {
+                    if (isVowel(at(1))) {
+                        add("A", "F");
+                    } else {
+                        add("A");
+                    }
+                }
+                if ((i == length - 1 && isVowel(at(i - 1))) ||
+                    matches(i - 1, 5, {"EWSKI", "EWSKY", "OWSKI", "OWSKY"}) || matches(0, 3, {"SCH"})) {
+                    add("", "F");
+                    i++;
+                } else if (matches(i, 4, {"WICZ", "WITZ"})) {
+                    add("TS", "FX");
+                    i += 4;
+                } else {
+                    i++;
+                }
+                break;
+            case 'X':
+                if (!(i == length - 1 && (matches(i - 3, 3, {"IAU", "EAU"}) || matches(i - 2, 2, {"AU", "OU"})))) {
+                    add("KS");
+                }
+                i += matches(i + 1, 1, {"C", "X"}) ? 2 : 1;
+                break;
+            case 'Z':
+                if (at(i + 1) == 'H') {
+                    add("J");
+                    i += 2;
+                    break;
+                }
+                if (matches(i + 1, 2, {"ZO", "ZI", "ZA"}) || (slavoGermanic && i > 0 && at(i - 1) != 'T')) {
+                    add("S", "TS");
+                } else {
+                    add("S");
+                }
+                i += at(i + 1) == 'Z' ? 2 : 1;
+                break;
+            default:
+                i++;
+                break;
+        }
+    }
+
+    return {primary.substr(0, 4), alternate.substr(0, 4)};
+}
+
+} // namespace
+
+std::string PhoneticEncoder::normalize(const std::string& name, bool keepSpaces) {
+    std::string result;
+    result.reserve(name.size());
+    for (char ch : name) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (std::isalpha(c)) {
+            result += static_cast<char>(std::toupper(c));
+        } else if (keepSpaces && (c == ' ' || c == '-') && !result.empty() && result.back() != ' ') {
+            result += ' ';
+        }
+    }
+    while (!result.empty() && result.back() == ' ') {
+        result.pop_back();
+    }
+    return result;
+}
+
+std::string PhoneticEncoder::soundex(const std::string& name) {
+    std::string word = normalize(name, false);
+    if (word.empty()) {
+        return "";
+    }
+
+    std::string code(1, word[0]);
+    char last = soundexDigit(word[0]);
+    for (size_t i = 1; i < word.size() && code.size() < 4; i++) {
+        char c = word[i];
+        char digit = soundexDigit(c);
+        if (digit != '0' && digit != last) {
+            code += digit;
+        }
+        // H and W do not separate letters with the same code; vowels do
+        if (c != 'H' && c != 'W') {
+            last = digit;
+        }
+    }
+    code.resize(4, '0');
+    return code;
+}
+
+std::vector<std::string> PhoneticEncoder::daitchMokotoff(const std::string& name) {
+    std::string word = normalize(name, false);
+    if (word.empty()) {
+        return {};
+    }
+
+    struct Branch {
+        std::string code;
+        std::string last;
+    };
+    std::vector<Branch> branches = {{"", ""}};
+
+    size_t i = 0;
+    while (i < word.size()) {
+        const DMRule* rule = nullptr;
+        size_t ruleLength = 0;
+        for (const auto& candidate : DM_RULES) {
+            size_t len = std::char_traits<char>::length(candidate.pattern);
+            if (len > ruleLength && word.compare(i, len, candidate.pattern) == 0) {
+                rule = &candidate;
+                ruleLength = len;
+            }
+        }
+        if (!rule) {
+            i++;
+            continue;
+        }
+
+        char next = i + ruleLength < word.size() ? word[i + ruleLength] : '\0';
+        bool nextIsVowel = next == 'A' || next == 'E' || next == 'I' || next == 'O' || next == 'U';
+        const char* column = (i == 0) ? rule->atStart
+                           : nextIsVowel ? rule->beforeVowel
+                           : rule->otherwise;
+        auto alternatives = splitAlternatives(column);
+
+        std::vector<Branch> nextBranches;
+        for (const auto& branch : branches) {
+            for (const auto& code : alternatives) {
+                Branch extended = branch;
+                // Adjacent letter groups with the same code are coded once
+                if (!code.empty() && code != branch.last) {
+                    extended.code += code;
+                }
+                extended.last = code;
+                nextBranches.push_back(extended);
+                if (nextBranches.size() >= DM_MAX_BRANCHES) break;
+            }
+        }
+        branches.swap(nextBranches);
+        i += ruleLength;
+    }
+
+    std::vector<std::string> codes;
+    for (auto& branch : branches) {
+        std::string code = branch.code.substr(0, DM_CODE_LENGTH);
+        code.resize(DM_CODE_LENGTH, '0');
+        if (std::find(codes.begin(), codes.end(), code) == codes.end()) {
+            codes.push_back(code);
+        }
+    }
+    return codes;
+}
+
+std::pair<std::string, std::string> PhoneticEncoder::doubleMetaphone(const std::string& name) {
+    std::string word = normalize(name, true);
+    if (word.empty()) {
+        return {"", ""};
+    }
+    MetaphoneEncoder encoder(word);
+    return encoder.encode();
+}
+
+std::vector<std::string> PhoneticEncoder::encode(const std::string& name, PhoneticAlgorithm algorithm) {
+    std::vector<std::string> codes;
+    switch (algorithm) {
+        case PhoneticAlgorithm::SOUNDEX:
+            codes.push_back(soundex(name));
+            break;
+        case PhoneticAlgorithm::DAITCH_MOKOTOFF:
+            codes = daitchMokotoff(name);
+            break;
+        case PhoneticAlgorithm::DOUBLE_METAPHONE: {
+            auto keys = doubleMetaphone(name);
+            codes.push_back(keys.first);
+            if (keys.second != keys.first) {
+                codes.push_back(keys.second);
+            }
+            break;
+        }
+    }
+    codes.erase(std::remove(codes.begin(), codes.end(), std::string()), codes.end());
+    return codes;
+}
+
+std::string PhoneticEncoder::algorithmToString(PhoneticAlgorithm algorithm) {
+    switch (algorithm) {
+        case PhoneticAlgorithm::SOUNDEX:
+            return "SOUNDEX";
+        case PhoneticAlgorithm::DAITCH_MOKOTOFF:
+            return "DM";
+        case PhoneticAlgorithm::DOUBLE_METAPHONE:
+            return "DMETAPHONE";
+        default:
+            return "Unknown";
+    }
+}
+
+const std::vector<PhoneticAlgorithm>& PhoneticEncoder::allAlgorithms() {
+    static const std::vector<PhoneticAlgorithm> algorithms = {
+        PhoneticAlgorithm::SOUNDEX,
+        PhoneticAlgorithm::DAITCH_MOKOTOFF,
+        PhoneticAlgorithm::DOUBLE_METAPHONE
+    };
+    return algorithms;
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "utils/QueryCache.hpp"
+
+QueryCache::QueryCache(size_t budgetBytes) : budgetBytes(budgetBytes), usedBytes(0) {}
+
+std::string QueryCache::makeKey(CachedQuery query, const std::string& personId, int generations) {
+    return std::to_string(static_cast<int>(query)) + ":" + std::to_string(generations) + ":" + personId;
+}
+
+size_t QueryCache::estimateBytes(const Entry& entry) {
+    size_t bytes = sizeof(Entry) + entry.key.capacity() * 2;  // the index holds a copy
+    for (const auto& person : entry.result) {
+        bytes += sizeof(Person) + person.getId().size() + person.getFirstName().size() +
+                 person.getLastName().size() + person.getDateOfBirth().size() +
+                 person.getDateOfDeath().size() + person.getBirthPlace().size() +
+                 person.getDeathPlace().size();
+    }
+    for (const auto& dependency : entry.dependencies) {
+        bytes += sizeof(std::string) + dependency.capacity() + entry.key.size();
+    }
+    return bytes;
+}
+
+std::optional<std::vector<Person>> QueryCache::lookup(CachedQuery query,
+                                                      const std::string& personId,
+                                                      int generations) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = index.find(makeKey(query, personId, generations));
+    if (it == index.end()) {
+        stats.misses++;
+        return std::nullopt;
+    }
+    stats.hits++;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->result;
+}
+
+void QueryCache::store(CachedQuery query,
+                       const std::string& personId,
+                       int generations,
+                       const std::vector<Person>& result,
+                       const std::vector<std::string>& dependencies) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (budgetBytes == 0) {
+        return;
+    }
+
+    std::string key = makeKey(query, personId, generations);
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        erase(existing->second);
+    }
+
+    lru.push_front(Entry{key, result, dependencies, 0});
+    auto entry = lru.begin();
+    entry->bytes = estimateBytes(*entry);
+    if (entry->bytes > budgetBytes) {
+        lru.pop_front();
+        return;
+    }
+
+    index[key] = entry;
+    for (const auto& dependency : entry->dependencies) {
+        dependents[dependency].insert(key);
+    }
+    usedBytes += entry->bytes;
+    evictToBudget();
+}
+
+void QueryCache::invalidate(const std::vector<std::string>& personIds) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (const auto& personId : personIds) {
+        auto it = dependents.find(personId);
+        if (it == dependents.end()) continue;
+
+        // erase() edits the dependents map, so work on a copy
+        std::unordered_set<std::string> keys = it->second;
+        for (const auto& key : keys) {
+            auto entry = index.find(key);
+            if (entry != index.end()) {
+                erase(entry->second);
+                stats.invalidations++;
+            }
+        }
+    }
+}
+
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    stats.invalidations += lru.size();
+    lru.clear();
+    index.clear();
+    dependents.clear();
+    usedBytes = 0;
+}
+
+void QueryCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    budgetBytes = bytes;
+    evictToBudget();
+}
+
+QueryCacheStats QueryCache::getStats() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    QueryCacheStats result = stats;
+    result.entries = lru.size();
+    result.bytes = usedBytes;
+    result.budgetBytes = budgetBytes;
+    return result;
+}
+
+void QueryCache::erase(std::list<Entry>::iterator entry) {
+    for (const auto& dependency : entry->dependencies) {
+        auto it = dependents.find(dependency);
+        if (it == dependents.end()) continue;
+        it->second.erase(entry->key);
+        if (it->second.empty()) {
+            dependents.erase(it);
+        }
+    }
+    usedBytes -= entry->bytes;
+    index.erase(entry->key);
+    lru.erase(entry);
+}
+
+void QueryCache::evictToBudget() {
+    while (usedBytes > budgetBytes && !lru.empty()) {
+        erase(std::prev(lru.end()));
+        stats.evictions++;
+    }
+}
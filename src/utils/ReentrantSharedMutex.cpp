@@ -0,0 +1,57 @@
+#include "utils/ReentrantSharedMutex.hpp"
+#include <stdexcept>
+#include <unordered_map>
+
+ReentrantSharedMutex::ReentrantSharedMutex() : owner(std::thread::id()), ownerDepth(0) {}
+
+int& ReentrantSharedMutex::readDepth() {
+    thread_local std::unordered_map<const ReentrantSharedMutex*, int> depths;
+    return depths[this];
+}
+
+void ReentrantSharedMutex::lock() {
+    if (ownedByCurrentThread()) {
+        ownerDepth++;
+        return;
+    }
+    if (readDepth() > 0) {
+        throw std::logic_error("Cannot upgrade a shared lock to an exclusive lock");
+    }
+    mutex.lock();
+    owner.store(std::this_thread::get_id());
+    ownerDepth = 1;
+}
+
+void ReentrantSharedMutex::unlock() {
+    if (--ownerDepth == 0) {
+        owner.store(std::thread::id());
+        mutex.unlock();
+    }
+}
+
+void ReentrantSharedMutex::lock_shared() {
+    // The exclusive owner already excludes everyone else
+    if (ownedByCurrentThread()) {
+        ownerDepth++;
+        return;
+    }
+    int& depth = readDepth();
+    if (depth++ == 0) {
+        mutex.lock_shared();
+    }
+}
+
+void ReentrantSharedMutex::unlock_shared() {
+    if (ownedByCurrentThread()) {
+        unlock();
+        return;
+    }
+    int& depth = readDepth();
+    if (--depth == 0) {
+        mutex.unlock_shared();
+    }
+}
+
+bool ReentrantSharedMutex::ownedByCurrentThread() const {
+    return owner.load() == std::this_thread::get_id();
+}
@@ -0,0 +1,145 @@
+#include "TestHarness.hpp"
+#include "services/ChartExporter.hpp"
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+void addPerson(FamilyTree& tree, const std::string& id, const std::string& first, const std::string& last,
+               const std::string& gender, const std::string& born, const std::string& died = "") {
+    Person person(id, first, last, gender, born);
+    person.setDateOfDeath(died);
+    CHECK(tree.addPerson(person));
+}
+
+// Grandparents G1 and G2; their daughter P, married to S, with children
+// C1 and C2; C1's son GC. Names carry characters SVG and DOT must escape.
+void buildFamily(FamilyTree& tree) {
+    addPerson(tree, "G1", "Old & <Grand>", "Pa", "M", "1850-01-01", "1920-05-05");
+    addPerson(tree, "G2", "Ma", "Grand", "F", "1852-01-01");
+    addPerson(tree, "P", "Anne \"Nan\"", "O'Brien", "F", "1880-01-01");
+    addPerson(tree, "S", "Sam", "Back\\slash", "M", "1878-01-01");
+    addPerson(tree, "C1", "Carl", "O'Brien", "M", "1905-01-01");
+    addPerson(tree, "C2", "Maximiliana Theodora", "Wilhelmina", "F", "1907-01-01");
+    addPerson(tree, "GC", "Gus", "O'Brien", "M", "1930-01-01");
+    CHECK(tree.addRelationship("G1", "P", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("G2", "P", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("P", "S", RelationType::SPOUSE));
+    CHECK(tree.addRelationship("P", "C1", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("P", "C2", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("C1", "GC", RelationType::PARENT_CHILD));
+}
+
+bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+// Attribute of the box drawn for personId (its first box)
+double boxAttribute(const std::string& svg, const std::string& personId, const std::string& attribute) {
+    size_t box = svg.find("<title>" + personId + "</title><rect");
+    if (box == std::string::npos) {
+        return -1;
+    }
+    size_t value = svg.find(" " + attribute + "=\"", box) + attribute.size() + 3;
+    return std::atof(svg.c_str() + value);
+}
+
+} // namespace
+
+TEST_CASE(drawsDescendantsAsSvg) {
+    test::TempDatabase db("chart_descendants");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    ChartExporter exporter(tree);
+
+    std::ostringstream out;
+    ChartOptions options;
+    ChartSummary summary = exporter.write("P", options, out);
+    const std::string svg = out.str();
+    CHECK_EQ(summary.boxes, 4u);
+    CHECK_EQ(summary.people, 4u);
+    CHECK_EQ(summary.descendantGenerations, 2);
+    CHECK_EQ(summary.ancestorGenerations, 0);
+    CHECK(contains(svg, "<svg xmlns=\"http://www.w3.org/2000/svg\""));
+    CHECK(contains(svg, "</svg>\n"));
+
+    // One row per generation, parents centred over their children
+    CHECK_EQ(boxAttribute(svg, "P", "y"), 20.0);
+    CHECK_EQ(boxAttribute(svg, "C1", "y"), 110.0);
+    CHECK_EQ(boxAttribute(svg, "GC", "y"), 200.0);
+    CHECK_EQ(boxAttribute(svg, "C2", "x") - boxAttribute(svg, "C1", "x"), 180.0);
+    CHECK_EQ(boxAttribute(svg, "P", "x"), (boxAttribute(svg, "C1", "x") + boxAttribute(svg, "C2", "x")) / 2);
+    CHECK_EQ(boxAttribute(svg, "GC", "x"), boxAttribute(svg, "C1", "x"));
+    CHECK_EQ(summary.width, 2 * 20 + 180 + 160.0);
+    CHECK_EQ(summary.height, 2 * 20 + 2 * 90 + 50.0);
+
+    // Escaping, truncation to 28 characters, spouses
+    CHECK(contains(svg, ">Anne &quot;Nan&quot; O&apos;Brien</text>"));
+    CHECK(contains(svg, ">Maximiliana Theodora Wilh...</text>"));
+    CHECK(contains(svg, ">m. Sam Back\\slash</text>"));
+    CHECK(contains(svg, "<rect class=\"root\""));
+    CHECK(!contains(svg, "Grand"));
+
+    CHECK_THROWS(exporter.write("missing", options, out), std::invalid_argument);
+}
+
+TEST_CASE(limitsPedigreeGenerations) {
+    test::TempDatabase db("chart_pedigree");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    ChartExporter exporter(tree);
+
+    std::ostringstream out;
+    ChartOptions options;
+    options.type = ChartType::PEDIGREE;
+    options.generations = 1;
+    ChartSummary summary = exporter.write("GC", options, out);
+    const std::string svg = out.str();
+    CHECK_EQ(summary.boxes, 2u);
+    CHECK_EQ(summary.ancestorGenerations, 1);
+    CHECK(boxAttribute(svg, "C1", "y") < boxAttribute(svg, "GC", "y"));  // ancestors above
+    CHECK_EQ(boxAttribute(svg, "P", "y"), -1.0);
+
+    std::ostringstream all;
+    options.generations = -1;
+    summary = exporter.write("GC", options, all);
+    CHECK_EQ(summary.ancestorGenerations, 3);
+    CHECK(contains(all.str(), ">Old &amp; &lt;Grand&gt; Pa</text>"));
+    CHECK(contains(all.str(), ">1850-1920</text>"));
+    CHECK(contains(all.str(), ">b. 1852</text>"));
+}
+
+TEST_CASE(writesHourglassAsDot) {
+    test::TempDatabase db("chart_dot");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    ChartExporter exporter(tree);
+
+    std::ostringstream out;
+    ChartOptions options;
+    options.type = ChartType::HOURGLASS;
+    options.format = ChartFormat::DOT;
+    ChartSummary summary = exporter.write("P", options, out);
+    const std::string dot = out.str();
+    CHECK_EQ(summary.boxes, 6u);  // the root is drawn once
+    CHECK_EQ(summary.ancestorGenerations, 1);
+    CHECK_EQ(summary.descendantGenerations, 2);
+    CHECK(contains(dot, "digraph family_tree {\n"));
+    CHECK(contains(dot, "  d0 [label=\"Anne \\\"Nan\\\" O'Brien\\nb. 1880\\nm. Sam Back\\\\slash\""));
+    CHECK(!contains(dot, "  a0 "));
+    // Edges run from parent to child in both halves
+    CHECK(contains(dot, "  a1 -> d0;\n"));
+    CHECK(contains(dot, "  a2 -> d0;\n"));
+    CHECK(contains(dot, "  d0 -> d1;\n"));
+    CHECK(contains(dot, "  d1 -> d3;\n"));
+    CHECK(contains(dot, "label=\"Maximiliana Theodora Wilh...\\nb. 1907\""));
+    CHECK(contains(dot, "label=\"Old & <Grand> Pa\\n1850-1920\""));
+
+    CHECK(ChartExporter::parseType("ancestors") == ChartType::PEDIGREE);
+    CHECK(ChartExporter::parseFormat("dot") == ChartFormat::DOT);
+    CHECK_THROWS(ChartExporter::parseFormat("png"), std::invalid_argument);
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,654 @@
+#include "TestHarness.hpp"
+#include "models/FamilyTree.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace {
+
+std::set<std::string> ids(const std::vector<Person>& people) {
+    std::set<std::string> result;
+    for (const auto& person : people) {
+        result.insert(person.getId());
+    }
+    return result;
+}
+
+std::vector<std::string> idList(const std::vector<Person>& people) {
+    std::vector<std::string> result;
+    for (const auto& person : people) {
+        result.push_back(person.getId());
+    }
+    return result;
+}
+
+// Three generations:
+//
+//   A + B
+//   ├── C + E
+//   │   ├── F
+//   │   └── G
+//   └── D + H
+//       └── I
+void buildFamily(FamilyTree& tree) {
+    const std::vector<Person> people = {
+        Person("A", "Johann", "Meyer", "M", "1900-01-01"),
+        Person("B", "Anna", "Schmidt", "F", "1902-03-04"),
+        Person("C", "Karl", "Meyer", "M", "1925-06-07"),
+        Person("D", "Maria", "Meyer", "F", "1927-08-09"),
+        Person("E", "Emma", "Weber", "F", "1926-02-02"),
+        Person("H", "Otto", "Fischer", "M", "1924-11-11"),
+        Person("F", "Peter", "Meyer", "M", "1950-01-01"),
+        Person("G", "Sophie", "Meyer", "F", "1952-05-05"),
+        Person("I", "Paul", "Fischer", "M", "1955-09-09"),
+    };
+    for (const auto& person : people) {
+        CHECK(tree.addPerson(person));
+    }
+    CHECK(tree.addRelationship("A", "B", RelationType::SPOUSE));
+    CHECK(tree.addRelationship("C", "E", RelationType::SPOUSE));
+    CHECK(tree.addRelationship("H", "D", RelationType::SPOUSE));
+    for (const char* child : {"C", "D"}) {
+        CHECK(tree.addRelationship("A", child, RelationType::PARENT_CHILD));
+        CHECK(tree.addRelationship("B", child, RelationType::PARENT_CHILD));
+    }
+    for (const char* child : {"F", "G"}) {
+        CHECK(tree.addRelationship("C", child, RelationType::PARENT_CHILD));
+        CHECK(tree.addRelationship("E", child, RelationType::PARENT_CHILD));
+    }
+    CHECK(tree.addRelationship("D", "I", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("H", "I", RelationType::PARENT_CHILD));
+}
+
+} // namespace
+
+TEST_CASE(storesAndUpdatesPeople) {
+    test::TempDatabase db("people");
+    FamilyTree tree(db.path());
+    Person anna("P1", "Anna", "Meyer", "F", "1900-05-01");
+    anna.setBirthPlace("Bremen");
+    CHECK(tree.addPerson(anna));
+    CHECK(!tree.addPerson(anna));
+
+    auto stored = tree.getPerson("P1");
+    CHECK(stored.has_value());
+    if (!stored) return;
+    CHECK_EQ(stored->getFullName(), "Anna Meyer");
+    CHECK_EQ(stored->getBirthPlace(), "Bremen");
+
+    stored->setDateOfDeath("1970-01-01");
+    stored->setDeathPlace("Berlin");
+    CHECK(tree.updatePerson(*stored));
+    auto updated = tree.getPerson("P1");
+    CHECK(updated && updated->isDeceased());
+    CHECK(updated && updated->getDeathPlace() == "Berlin");
+
+    CHECK(!tree.getPerson("missing"));
+    CHECK(!tree.updatePerson(Person("missing", "Anna", "Meyer", "F", "1900-05-01")));
+    CHECK(tree.searchByName("Meyer", NameSearchMode::SOUNDEX).size() == 1u);
+    CHECK_EQ(tree.getAllPeople().size(), 1u);
+}
+
+TEST_CASE(persistsAcrossReopen) {
+    test::TempDatabase db("reopen");
+    {
+        FamilyTree tree(db.path());
+        buildFamily(tree);
+    }
+    FamilyTree tree(db.path());
+    CHECK_EQ(tree.getAllPeople().size(), 9u);
+    CHECK(ids(tree.getChildren("A")) == std::set<std::string>({"C", "D"}));
+}
+
+TEST_CASE(navigatesImmediateFamily) {
+    test::TempDatabase db("navigation");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+
+    CHECK(ids(tree.getParents("F")) == std::set<std::string>({"C", "E"}));
+    CHECK(ids(tree.getChildren("A")) == std::set<std::string>({"C", "D"}));
+    CHECK(ids(tree.getSiblings("F")) == std::set<std::string>({"G"}));
+    CHECK(ids(tree.getSiblings("I")).empty());
+    CHECK(tree.getParents("A").empty());
+
+    auto spouse = tree.getSpouse("A");
+    CHECK(spouse && spouse->getId() == "B");
+    spouse = tree.getSpouse("D");
+    CHECK(spouse && spouse->getId() == "H");
+    CHECK(!tree.getSpouse("F"));
+}
+
+TEST_CASE(traversesAncestorsAndDescendants) {
+    test::TempDatabase db("traversal");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+
+    CHECK(ids(tree.getAncestors("F")) == std::set<std::string>({"A", "B", "C", "E"}));
+    CHECK(ids(tree.getAncestors("F", 1)) == std::set<std::string>({"C", "E"}));
+    CHECK(ids(tree.getDescendants("A")) == std::set<std::string>({"C", "D", "F", "G", "I"}));
+    CHECK(ids(tree.getDescendants("A", 1)) == std::set<std::string>({"C", "D"}));
+    CHECK(tree.getDescendants("F").empty());
+
+    CHECK(ids(tree.findCommonAncestors("F", "I")) == std::set<std::string>({"A", "B"}));
+    CHECK(tree.findCommonAncestors("F", "H").empty());
+    // Generations between the two via their closest common ancestor
+    CHECK_EQ(tree.calculateGenerationGap("F", "G"), 2);
+    CHECK_EQ(tree.calculateGenerationGap("F", "H"), -1);
+}
+
+TEST_CASE(pagesLongLists) {
+    test::TempDatabase db("paging");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+
+    PersonPage page = tree.getDescendantsPage("A", -1, 0, 3);
+    CHECK_EQ(page.people.size(), 3u);
+    CHECK(page.hasMore);
+    CHECK(ids(page.people) == std::set<std::string>({"C", "D", page.people[2].getId()}));
+    CHECK(page.generations == std::vector<int>({1, 1, 2}));
+    PersonPage rest = tree.getDescendantsPage("A", -1, 3, 3);
+    CHECK_EQ(rest.people.size(), 2u);
+    CHECK(!rest.hasMore);
+    std::vector<Person> all = page.people;
+    all.insert(all.end(), rest.people.begin(), rest.people.end());
+    CHECK(ids(all) == ids(tree.getDescendants("A")));
+
+    CHECK(ids(tree.getDescendantsPage("A", 1, 0, 10).people) == std::set<std::string>({"C", "D"}));
+    CHECK(ids(tree.getAncestorsPage("F", -1, 0, 10).people) == std::set<std::string>({"A", "B", "C", "E"}));
+    CHECK(tree.getAncestorsPage("F", -1, 4, 10).people.empty());
+
+    // Ordered by last name, then first name
+    page = tree.searchByNamePage("Meyer", NameSearchMode::SUBSTRING, 1, 2);
+    CHECK_EQ(page.people.size(), 2u);
+    CHECK(page.hasMore);
+    CHECK(page.people[0].getId() == "C" && page.people[1].getId() == "D");
+    page = tree.searchByNamePage("Maier", NameSearchMode::PHONETIC, 4, 2);
+    CHECK_EQ(page.people.size(), 1u);
+    CHECK(!page.hasMore);
+    CHECK_EQ(page.people[0].getId(), "G");
+}
+
+TEST_CASE(rejectsInvalidRelationships) {
+    test::TempDatabase db("validation");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+
+    // Cycles, second spouses and unknown people
+    CHECK(!tree.addRelationship("F", "A", RelationType::PARENT_CHILD));
+    CHECK(!tree.addRelationship("A", "E", RelationType::SPOUSE));
+    CHECK(!tree.addRelationship("A", "missing", RelationType::PARENT_CHILD));
+    CHECK(tree.validateRelationship("F", "I", RelationType::SIBLING));
+
+    size_t before = tree.getAllRelationships().size();
+    CHECK(tree.removeRelationship("C_E_Spouse"));
+    CHECK_EQ(tree.getAllRelationships().size(), before - 1);
+    CHECK(!tree.getSpouse("C"));
+    CHECK(tree.addRelationship("C", "H", RelationType::SIBLING));
+}
+
+TEST_CASE(searchesByName) {
+    test::TempDatabase db("search");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+
+    CHECK(ids(tree.searchByName("Meyer")) == std::set<std::string>({"A", "C", "D", "F", "G"}));
+    CHECK(ids(tree.searchByName("Peter Meyer")) == std::set<std::string>({"F"}));
+    CHECK(tree.searchByName("Nobody").empty());
+
+    // Spelling variants only match phonetically
+    CHECK(tree.searchByName("Maier").empty());
+    CHECK(ids(tree.searchByName("Maier", NameSearchMode::PHONETIC)) ==
+          std::set<std::string>({"A", "C", "D", "F", "G"}));
+    CHECK(ids(tree.searchByName("Fisher", NameSearchMode::PHONETIC)) == std::set<std::string>({"H", "I"}));
+}
+
+TEST_CASE(deletesPeopleAndBranches) {
+    test::TempDatabase db("delete");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+
+    // Warm the cache so deletes must invalidate it
+    CHECK_EQ(tree.getChildren("C").size(), 2u);
+    CHECK(tree.deletePerson("G"));
+    CHECK(!tree.getPerson("G"));
+    CHECK(ids(tree.getChildren("C")) == std::set<std::string>({"F"}));
+    CHECK(ids(tree.getDescendants("A")) == std::set<std::string>({"C", "D", "F", "I"}));
+
+    // A failed statement rolls the whole branch back and removes no one
+    sqlite3* handle = nullptr;
+    CHECK(sqlite3_open(db.path().c_str(), &handle) == SQLITE_OK);
+    CHECK(sqlite3_exec(handle, R"(
+        CREATE TRIGGER keep_f BEFORE DELETE ON Person WHEN OLD.person_id = 'F'
+        BEGIN SELECT RAISE(ABORT, 'kept'); END
+    )", nullptr, nullptr, nullptr) == SQLITE_OK);
+    CHECK_EQ(tree.deleteBranch("C"), 0);
+    CHECK(tree.getPerson("C"));
+    CHECK(ids(tree.getChildren("C")) == std::set<std::string>({"F"}));
+    CHECK(sqlite3_exec(handle, "DROP TRIGGER keep_f", nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(handle);
+
+    CHECK_EQ(tree.deleteBranch("C"), 2);
+    CHECK(!tree.getPerson("C"));
+    CHECK(!tree.getPerson("F"));
+    CHECK(tree.getPerson("E"));
+    CHECK_EQ(tree.deleteBranch("D", true), 3);
+    CHECK(ids(tree.getAllPeople()) == std::set<std::string>({"A", "B", "E"}));
+
+    for (const auto& relationship : tree.getAllRelationships()) {
+        CHECK(tree.getPerson(relationship.getPerson1Id()));
+        CHECK(tree.getPerson(relationship.getPerson2Id()));
+    }
+}
+
+TEST_CASE(transactionsCommitAndRollBack) {
+    test::TempDatabase db("transactions");
+    FamilyTree tree(db.path());
+
+    tree.beginTransaction();
+    CHECK(tree.addPerson(Person("P1", "Anna", "Meyer", "F", "1900-05-01")));
+    tree.beginTransaction();
+    CHECK(tree.addPerson(Person("P2", "Karl", "Meyer", "M", "1925-01-01")));
+    tree.rollback();
+    tree.commit();
+
+    CHECK(tree.getPerson("P1"));
+    CHECK(!tree.getPerson("P2"));
+
+    tree.beginTransaction();
+    CHECK(tree.addPerson(Person("P3", "Otto", "Meyer", "M", "1926-01-01")));
+    tree.rollback();
+    CHECK(!tree.getPerson("P3"));
+}
+
+TEST_CASE(cachesTraversals) {
+    test::TempDatabase db("cache");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+
+    tree.getAncestors("F");
+    QueryCacheStats before = tree.getCacheStats();
+    CHECK(ids(tree.getAncestors("F")) == std::set<std::string>({"A", "B", "C", "E"}));
+    CHECK(tree.getCacheStats().hits > before.hits);
+
+    // A new parent shows up despite the cached result
+    CHECK(tree.addPerson(Person("X", "Jakob", "Weber", "M", "1890-01-01")));
+    CHECK(tree.addRelationship("X", "E", RelationType::PARENT_CHILD));
+    CHECK(ids(tree.getAncestors("F")).count("X"));
+
+    tree.setCacheBudget(0);
+    CHECK_EQ(tree.getCacheStats().entries, 0u);
+    CHECK(ids(tree.getAncestors("F")).count("X"));
+}
+
+TEST_CASE(mergesAnotherDatabase) {
+    test::TempDatabase target("merge_target");
+    test::TempDatabase source("merge_source");
+    {
+        FamilyTree other(source.path());
+        // Same person as A under another ID, plus a new child
+        CHECK(other.addPerson(Person("Q1", "Johann", "Meyer", "M", "1900-01-01")));
+        CHECK(other.addPerson(Person("Q2", "Wilhelm", "Meyer", "M", "1929-04-04")));
+        CHECK(other.addPerson(Person("C", "Clash", "Other", "O", "1930-01-01")));
+        CHECK(other.addRelationship("Q1", "Q2", RelationType::PARENT_CHILD));
+    }
+
+    FamilyTree tree(target.path());
+    buildFamily(tree);
+    tree.setRootPerson("A");
+    MergeSummary summary = tree.mergeDatabase(source.path());
+    CHECK_EQ(summary.incomingPeople, 3);
+    CHECK_EQ(summary.peopleMatched, 1);
+    CHECK_EQ(summary.peopleAdded, 2);
+    CHECK_EQ(summary.relationshipsAdded, 1);
+    CHECK(ids(tree.getChildren("A")) == std::set<std::string>({"C", "D", "Q2"}));
+
+    // Merged people join the existing lines and generations
+    CHECK_EQ(tree.getDepth("Q2"), 1);
+    CHECK_EQ(*tree.getGeneration("Q2"), 1);
+    CHECK(ids(tree.getLineMembers("Q2", DirectLine::PATERNAL)).count("A"));
+
+    auto renamed = tree.getPerson("merged_C");
+    CHECK(renamed && renamed->getFirstName() == "Clash");
+    CHECK_EQ(tree.getDepth("merged_C"), 0);
+    CHECK(!tree.getGeneration("merged_C"));
+    CHECK(!summary.conflicts.empty());
+}
+
+TEST_CASE(reportsMergeConflictsWithoutFreeId) {
+    test::TempDatabase target("merge_taken_target");
+    test::TempDatabase source("merge_taken_source");
+    {
+        FamilyTree other(source.path());
+        CHECK(other.addPerson(Person("p1", "Incoming", "One", "F", "1950")));
+        CHECK(other.addPerson(Person("p2", "Incoming", "Two", "M", "1952")));
+    }
+
+    // Both p1 and its prefixed form are taken
+    FamilyTree tree(target.path());
+    CHECK(tree.addPerson(Person("p1", "Existing", "One", "F", "1900")));
+    CHECK(tree.addPerson(Person("merged_p1", "Existing", "Two", "M", "1901")));
+    MergeSummary summary = tree.mergeDatabase(source.path());
+    CHECK_EQ(summary.incomingPeople, 2);
+    CHECK_EQ(summary.peopleAdded, 1);
+    CHECK_EQ(tree.getPerson("p2")->getFirstName(), "Incoming");
+    CHECK_EQ(tree.getPerson("p1")->getFirstName(), "Existing");
+    bool reported = false;
+    for (const auto& conflict : summary.conflicts) {
+        reported = reported || (conflict.incomingId == "p1" && conflict.reason == "no free ID for this person");
+    }
+    CHECK(reported);
+}
+
+TEST_CASE(countsPeopleByPlace) {
+    test::TempDatabase db("places");
+    FamilyTree tree(db.path());
+    auto add = [&](const std::string& id, const std::string& born, const std::string& place) {
+        Person person(id, id, "Test", "O", born);
+        person.setBirthPlace(place);
+        CHECK(tree.addPerson(person));
+    };
+    add("P1", "1851-02-03", "Salem, Essex, Massachusetts");
+    add("P2", "1859-10-10", "Salem ,Essex,Massachusetts ");
+    add("P3", "1861-01-01", "Lynn, Essex, Massachusetts");
+    add("P4", "1855-05-05", "Boston, Suffolk, Massachusetts");
+
+    CHECK_EQ(tree.getPerson("P2")->getBirthPlace(), "Salem, Essex, Massachusetts");
+    auto counts = tree.getPlaceCounts("Essex, Massachusetts");
+    CHECK_EQ(counts.size(), 4u);  // Essex 1850s and 1860s, Lynn 1860s, Salem 1850s
+    CHECK(counts[0].place == "Essex, Massachusetts" && counts[0].decade == 1850 && counts[0].births == 2);
+    CHECK(counts[1].place == "Essex, Massachusetts" && counts[1].decade == 1860 && counts[1].births == 1);
+    CHECK(counts[3].place == "Salem, Essex, Massachusetts" && counts[3].births == 2);
+
+    // Updates and deletions move the counts along
+    Person moved = *tree.getPerson("P1");
+    moved.setBirthPlace("Boston, Suffolk, Massachusetts");
+    moved.setDateOfDeath("1901-01-01");
+    moved.setDeathPlace("Lynn, Essex, Massachusetts");
+    CHECK(tree.updatePerson(moved));
+    CHECK(tree.deletePerson("P3"));
+    counts = tree.getPlaceCounts("Massachusetts");
+    CHECK_EQ(counts.size(), 8u);  // Lynn has no births left
+    CHECK(counts[4].place == "Massachusetts" && counts[4].decade == 1850 && counts[4].births == 3);
+    CHECK(counts[5].place == "Massachusetts" && counts[5].decade == 1900 && counts[5].deaths == 1);
+    CHECK(counts[3].place == "Lynn, Essex, Massachusetts" && counts[3].births == 0);
+    CHECK_EQ(tree.getPlaceCounts("Salem, Essex, Massachusetts").at(0).births, 1);
+    CHECK(tree.getPlaceCounts("Nowhere").empty());
+    CHECK_EQ(tree.getPlaceCounts().size(), 8u);
+}
+
+// Files written before the place dictionary store place names in Person
+TEST_CASE(movesPlaceTextIntoDictionary) {
+    test::TempDatabase db("places_legacy");
+    sqlite3* handle = nullptr;
+    CHECK(sqlite3_open(db.path().c_str(), &handle) == SQLITE_OK);
+    CHECK(sqlite3_exec(handle, R"(
+        CREATE TABLE Person (
+            person_id TEXT PRIMARY KEY, first_name TEXT NOT NULL, last_name TEXT NOT NULL,
+            gender TEXT, date_of_birth TEXT NOT NULL, date_of_death TEXT,
+            birth_place TEXT, death_place TEXT);
+        INSERT INTO Person VALUES
+            ('L1', 'Ida', 'Old', 'F', '1880-01-01', '1950-01-01', 'Kiel, Germany', 'Bremen, Germany'),
+            ('L2', 'Otto', 'Old', 'M', '1885-01-01', NULL, 'Kiel, Germany', NULL),
+            ('L3', 'Emil', 'Old', 'M', '1890-01-01', NULL, NULL, NULL);
+    )", nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(handle);
+
+    FamilyTree tree(db.path());
+    CHECK_EQ(tree.getPerson("L1")->getDeathPlace(), "Bremen, Germany");
+    CHECK_EQ(tree.getPerson("L2")->getBirthPlace(), "Kiel, Germany");
+    CHECK(tree.getPerson("L3")->getBirthPlace().empty());
+    auto counts = tree.getPlaceCounts("Germany");
+    CHECK_EQ(counts.size(), 4u);
+    CHECK(counts[0].place == "Bremen, Germany" && counts[0].decade == 1950 && counts[0].deaths == 1);
+    CHECK(counts[1].place == "Germany" && counts[1].decade == 1880 && counts[1].births == 2);
+
+    // A merged tree's places join the dictionary too
+    test::TempDatabase source("places_source");
+    {
+        FamilyTree other(source.path());
+        Person incoming("N1", "Nina", "New", "F", "1882-03-03");
+        incoming.setBirthPlace("Kiel, Germany");
+        CHECK(other.addPerson(incoming));
+    }
+    tree.mergeDatabase(source.path());
+    CHECK_EQ(tree.getPerson("N1")->getBirthPlace(), "Kiel, Germany");
+    CHECK_EQ(tree.getPlaceCounts("Kiel, Germany").at(0).births, 3);
+}
+
+TEST_CASE(groupsFamilyUnits) {
+    test::TempDatabase db("families");
+    using V = std::vector<std::string>;
+    {
+        FamilyTree tree(db.path());
+        buildFamily(tree);
+        CHECK(tree.addPerson(Person("J", "Jakob", "Meyer", "M", "1940-01-01")));
+        CHECK(tree.addRelationship("A", "J", RelationType::PARENT_CHILD));
+
+        CHECK(idList(tree.getSiblings("C")) == V({"D", "J"}));
+        CHECK(idList(tree.getSiblings("C", SiblingKind::FULL)) == V({"D"}));
+        CHECK(idList(tree.getSiblings("C", SiblingKind::HALF)) == V({"J"}));
+        CHECK(idList(tree.getSiblings("J", SiblingKind::HALF)) == V({"C", "D"}));
+        CHECK(idList(tree.getPartners("D")) == V({"H"}));
+
+        auto families = tree.getFamilies("A");
+        CHECK_EQ(families.size(), 2u);
+        CHECK(families[0].partner2Id.empty() && !families[0].married && families[0].childIds == V({"J"}));
+        CHECK(families[1].partner2Id == "B" && families[1].married && families[1].childIds == V({"C", "D"}));
+        auto parents = tree.getParentFamily("I");
+        CHECK(parents && parents->partner1Id == "D" && parents->partner2Id == "H");
+        CHECK(!tree.getParentFamily("A"));
+
+        // A divorced couple keeps the family of their children
+        CHECK(tree.removeRelationship("C_E_Spouse"));
+        CHECK(!tree.getFamilies("E").at(0).married);
+        CHECK(idList(tree.getPartners("E")) == V({"C"}));
+        CHECK(tree.removeRelationship("A_J_Parent-Child"));
+        CHECK_EQ(tree.getFamilies("A").size(), 1u);
+
+        // Deleting a child leaves a marriage but not a single parent's family
+        CHECK(tree.addRelationship("A", "J", RelationType::PARENT_CHILD));
+        CHECK(tree.deletePerson("J"));
+        CHECK_EQ(tree.getFamilies("A").size(), 1u);
+        CHECK(tree.deletePerson("I"));
+        CHECK(tree.getFamilies("D").at(0).married && tree.getFamilies("D").at(0).childIds.empty());
+    }
+
+    // Files that stored parent links as Parent-Child rows (with families
+    // derived from them) move the links into families on open
+    sqlite3* handle = nullptr;
+    CHECK(sqlite3_open(db.path().c_str(), &handle) == SQLITE_OK);
+    CHECK(sqlite3_exec(handle, R"(
+        INSERT INTO Relationship (relationship_id, person1_id, person2_id, relationship_type)
+        SELECT parent_id || '_' || child_id || '_Parent-Child', parent_id, child_id, 'Parent-Child'
+        FROM ParentLink;
+        DELETE FROM FamilyChild;
+        DELETE FROM Family;
+        DELETE FROM TreeSettings WHERE key = 'migrated:parent_links';
+    )", nullptr, nullptr, nullptr) == SQLITE_OK);
+    auto storedRelationships = [&]() {
+        sqlite3_stmt* stmt = nullptr;
+        int count = -1;
+        if (sqlite3_prepare_v2(handle, "SELECT COUNT(*) FROM Relationship", -1, &stmt, nullptr) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW) {
+            count = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return count;
+    };
+    const int before = storedRelationships();
+    {
+        FamilyTree tree(db.path());
+        CHECK(idList(tree.getSiblings("F", SiblingKind::FULL)) == V({"G"}));
+        CHECK(idList(tree.getPartners("A")) == V({"B"}));
+        CHECK(tree.getFamilies("A").at(0).married);
+        auto relationships = tree.getAllRelationships();
+        CHECK_EQ(relationships.size(), static_cast<size_t>(before));
+        CHECK(std::any_of(relationships.begin(), relationships.end(),
+                          [](const Relationship& r) { return r.getId() == "C_F_Parent-Child"; }));
+    }
+    // Only the spouse rows remain as relationships
+    CHECK_EQ(storedRelationships(), 2);
+    sqlite3_close(handle);
+}
+
+TEST_CASE(followsDirectLines) {
+    test::TempDatabase db("lines");
+    {
+        FamilyTree tree(db.path());
+        buildFamily(tree);
+        using V = std::vector<std::string>;
+        CHECK(idList(tree.getLineMembers("A", DirectLine::PATERNAL)) == V({"A", "C", "D", "F", "G"}));
+        CHECK(idList(tree.getLineMembers("I", DirectLine::PATERNAL)) == V({"H", "I"}));
+        CHECK(idList(tree.getLineMembers("C", DirectLine::MATERNAL)) == V({"B", "C", "D", "I"}));
+        CHECK(idList(tree.getLineMembers("G", DirectLine::MATERNAL)) == V({"E", "F", "G"}));
+        CHECK(idList(tree.getLineAncestors("I", DirectLine::MATERNAL)) == V({"D", "B"}));
+        CHECK(idList(tree.getLineAncestors("G", DirectLine::PATERNAL)) == V({"C", "A"}));
+        CHECK(idList(tree.getLineDescendants("A", DirectLine::PATERNAL)) == V({"C", "D", "F", "G"}));
+        CHECK(tree.getLineAncestors("A", DirectLine::PATERNAL).empty());
+        CHECK(tree.getLineMembers("missing", DirectLine::PATERNAL).empty());
+
+        // C's children have no father once C is a woman, and join B's
+        // maternal line through C
+        CHECK(tree.updatePerson(Person("C", "Karl", "Meyer", "F", "1925-06-07")));
+        CHECK(idList(tree.getLineMembers("A", DirectLine::PATERNAL)) == V({"A", "C", "D"}));
+        CHECK(idList(tree.getLineMembers("B", DirectLine::MATERNAL)) == V({"B", "C", "D", "F", "G", "I"}));
+        CHECK(tree.updatePerson(Person("C", "Karl", "Meyer", "M", "1925-06-07")));
+
+        // Cutting C off makes C the founder of C's own line
+        CHECK(tree.removeRelationship("A_C_Parent-Child"));
+        CHECK(idList(tree.getLineMembers("A", DirectLine::PATERNAL)) == V({"A", "D"}));
+        CHECK(idList(tree.getLineMembers("G", DirectLine::PATERNAL)) == V({"C", "F", "G"}));
+        CHECK(tree.addRelationship("A", "C", RelationType::PARENT_CHILD));
+        CHECK(tree.deletePerson("D"));
+        CHECK(idList(tree.getLineMembers("I", DirectLine::MATERNAL)) == V({"I"}));
+        CHECK(idList(tree.getLineMembers("A", DirectLine::PATERNAL)) == V({"A", "C", "F", "G"}));
+    }
+
+    // Files written before lines were stored get them when opened
+    sqlite3* handle = nullptr;
+    CHECK(sqlite3_open(db.path().c_str(), &handle) == SQLITE_OK);
+    CHECK(sqlite3_exec(handle, "DELETE FROM PersonLine; DELETE FROM TreeSettings WHERE key = 'migrated:direct_lines'",
+                       nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(handle);
+    FamilyTree tree(db.path());
+    CHECK(idList(tree.getLineMembers("F", DirectLine::PATERNAL)) ==
+          std::vector<std::string>({"A", "C", "F", "G"}));
+    CHECK(idList(tree.getLineMembers("F", DirectLine::MATERNAL)) ==
+          std::vector<std::string>({"E", "F", "G"}));
+}
+
+TEST_CASE(tracksGenerations) {
+    test::TempDatabase db("generations");
+    using V = std::vector<std::string>;
+    {
+        FamilyTree tree(db.path());
+        buildFamily(tree);
+        CHECK_EQ(tree.getDepth("A"), 0);
+        CHECK_EQ(tree.getDepth("I"), 2);
+        CHECK_EQ(tree.getDepth("missing"), -1);
+        CHECK(idList(tree.getPeopleAtDepth(0)) == V({"A", "B", "E", "H"}));
+        CHECK(!tree.getGeneration("F"));
+        CHECK(tree.getAncestorsInGeneration("I", -1).empty());
+
+        // Spouses share a generation; in-laws are reached through them
+        tree.setRootPerson("F");
+        CHECK_EQ(*tree.getGeneration("F"), 0);
+        CHECK(idList(tree.getPeopleInGeneration(-1)) == V({"C", "D", "E", "H"}));
+        CHECK(idList(tree.getPeopleInGeneration(0)) == V({"F", "G", "I"}));
+        CHECK(idList(tree.getPeopleInGeneration(-2)) == V({"A", "B"}));
+
+        // Slices follow generations, not depths: H has no known parents
+        // (depth 0) yet is in the generation of D (depth 1)
+        CHECK(idList(tree.getAncestorsInGeneration("I", -1)) == V({"D", "H"}));
+        CHECK(idList(tree.getAncestorsInGeneration("I", -2)) == V({"A", "B"}));
+        CHECK(idList(tree.getAncestorsInGeneration("I", -1, GenerationOrigin::ROOT)) == V({"D", "H"}));
+        CHECK(idList(tree.getDescendantsInGeneration("A", 2)) == V({"F", "G", "I"}));
+        CHECK(idList(tree.getDescendantsInGeneration("D", 0, GenerationOrigin::ROOT)) == V({"I"}));
+        CHECK(tree.getDescendantsInGeneration("H", 0).empty());
+
+        tree.setRootPerson("A");
+        CHECK_EQ(*tree.getGeneration("I"), 2);
+        CHECK_EQ(*tree.getGeneration("H"), 1);
+        CHECK_THROWS(tree.setRootPerson("missing"), std::invalid_argument);
+
+        // H is still reached through I, and then neither is
+        CHECK(tree.removeRelationship("H_D_Spouse"));
+        CHECK_EQ(*tree.getGeneration("H"), 1);
+        CHECK(tree.removeRelationship("D_I_Parent-Child"));
+        CHECK(!tree.getGeneration("I") && !tree.getGeneration("H"));
+        CHECK_EQ(tree.getDepth("I"), 1);
+        CHECK(tree.addRelationship("D", "I", RelationType::PARENT_CHILD));
+        CHECK_EQ(*tree.getGeneration("H"), 1);
+        CHECK_EQ(tree.getDepth("I"), 2);
+    }
+
+    // The root is stored with the tree, and files written before
+    // generations were stored get them when opened
+    sqlite3* handle = nullptr;
+    CHECK(sqlite3_open(db.path().c_str(), &handle) == SQLITE_OK);
+    CHECK(sqlite3_exec(handle, "DELETE FROM PersonGeneration; DELETE FROM TreeSettings WHERE key = 'migrated:generations'",
+                       nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(handle);
+    FamilyTree tree(db.path());
+    CHECK_EQ(tree.getRootPerson(), "A");
+    CHECK_EQ(*tree.getGeneration("G"), 2);
+    CHECK_EQ(tree.getDepth("G"), 2);
+
+    CHECK(tree.deletePerson("A"));
+    CHECK(tree.getRootPerson().empty());
+    CHECK(!tree.getGeneration("C"));
+}
+
+TEST_CASE(releasesReadersOfExitedThreads) {
+    test::TempDatabase db("family_readers");
+    auto openFiles = [] {
+        std::error_code error;
+        std::filesystem::directory_iterator files("/proc/self/fd", error);
+        return error ? 0 : std::distance(files, std::filesystem::directory_iterator());
+    };
+    auto tree = std::make_unique<FamilyTree>(db.path());
+    CHECK(tree->addPerson(Person("A", "Ada", "Test", "F", "1900")));
+    auto readOnce = [&] {
+        std::thread reader([&] { CHECK(tree->getPerson("A").has_value()); });
+        reader.join();
+    };
+    readOnce();
+    const auto before = openFiles();
+    for (int round = 0; round < 20; round++) {
+        readOnce();
+    }
+    CHECK_EQ(openFiles(), before);
+
+    // A thread still holding a reader may outlive the tree
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool queried = false;
+    bool closed = false;
+    std::thread reader([&] {
+        CHECK(tree->getPerson("A").has_value());
+        std::unique_lock<std::mutex> lock(mutex);
+        queried = true;
+        changed.notify_all();
+        changed.wait(lock, [&] { return closed; });
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return queried; });
+    }
+    tree.reset();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+    reader.join();
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,128 @@
+#include "TestHarness.hpp"
+#include "services/GroupCommitWriter.hpp"
+#include <sqlite3.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Commits refused while set, through a commit hook on every connection
+// opened after installCommitHook is registered
+std::atomic<bool> refuseCommits(false);
+
+int commitHook(void*) {
+    return refuseCommits.load() ? 1 : 0;
+}
+
+int installCommitHook(sqlite3* handle, char**, const sqlite3_api_routines*) {
+    sqlite3_commit_hook(handle, commitHook, nullptr);
+    return SQLITE_OK;
+}
+
+Person person(const std::string& id) {
+    return Person(id, id, "Test", "F", "1900");
+}
+
+// People visible to a separate connection, i.e. committed
+int committedPeople(const std::string& path) {
+    sqlite3* handle = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+    int count = -1;
+    if (sqlite3_open(path.c_str(), &handle) == SQLITE_OK &&
+        sqlite3_prepare_v2(handle, "SELECT COUNT(*) FROM Person", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(handle);
+    return count;
+}
+
+} // namespace
+
+TEST_CASE(batchesMutations) {
+    test::TempDatabase db("group_batches");
+    FamilyTree tree(db.path());
+    GroupCommitOptions options;
+    options.window = std::chrono::milliseconds(50);
+    GroupCommitWriter writer(tree, options);
+
+    std::vector<std::future<bool>> added;
+    for (int i = 0; i < 100; i++) {
+        added.push_back(writer.addPerson(person("P" + std::to_string(i))));
+    }
+    auto duplicate = writer.addPerson(person("P0"));
+    auto linked = writer.addRelationship("P1", "P2", RelationType::PARENT_CHILD);
+    for (auto& future : added) {
+        CHECK(future.get());
+    }
+    CHECK(!duplicate.get());  // rolled back alone
+    CHECK(linked.get());
+
+    GroupCommitStats stats = writer.getStats();
+    CHECK_EQ(stats.mutations, 102u);
+    CHECK_EQ(stats.failed, 1u);
+    CHECK(stats.batches < 20);
+    CHECK_EQ(committedPeople(db.path()), 100);
+    CHECK_EQ(tree.getChildren("P1").size(), 1u);
+}
+
+TEST_CASE(completesAfterCommitOrWithinWindow) {
+    test::TempDatabase db("group_durability");
+    FamilyTree tree(db.path());
+    {
+        GroupCommitWriter writer(tree);
+        CHECK(writer.addPerson(person("A")).get());
+        CHECK_EQ(committedPeople(db.path()), 1);  // ON_RETURN: on disk when it completes
+    }
+
+    GroupCommitOptions options;
+    options.durability = CommitDurability::WITHIN_WINDOW;
+    options.window = std::chrono::milliseconds(20);
+    GroupCommitWriter writer(tree, options);
+    CHECK(writer.addPerson(person("B")).get());
+    CHECK(!writer.addPerson(person("B")).get());
+    writer.flush();
+    CHECK_EQ(committedPeople(db.path()), 2);
+    CHECK_EQ(writer.getStats().batches, 1u);
+}
+
+TEST_CASE(reportsFailedCommits) {
+    test::TempDatabase db("group_failure");
+    sqlite3_auto_extension(reinterpret_cast<void (*)()>(installCommitHook));
+    {
+        FamilyTree tree(db.path());
+        GroupCommitOptions options;
+        options.window = std::chrono::milliseconds(20);
+        GroupCommitWriter writer(tree, options);
+        CHECK(writer.addPerson(person("A")).get());
+
+        refuseCommits = true;
+        auto first = writer.addPerson(person("B"));
+        auto second = writer.addPerson(person("C"));
+        CHECK_THROWS(first.get(), std::runtime_error);
+        CHECK_THROWS(second.get(), std::runtime_error);
+        CHECK_EQ(writer.getStats().failed, 2u);
+
+        // The batch was rolled back and the writer carries on
+        refuseCommits = false;
+        CHECK(!tree.getPerson("B"));
+        CHECK(writer.addPerson(person("B")).get());
+        CHECK_EQ(committedPeople(db.path()), 2);
+
+        // Without a group commit the error reaches the caller the same way
+        refuseCommits = true;
+        tree.beginTransaction();
+        CHECK(tree.addPerson(person("D")));
+        CHECK_THROWS(tree.commit(), std::runtime_error);
+        refuseCommits = false;
+        CHECK(!tree.getPerson("D"));
+        CHECK(tree.addPerson(person("D")));
+    }
+    sqlite3_cancel_auto_extension(reinterpret_cast<void (*)()>(installCommitHook));
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,145 @@
+#include "TestHarness.hpp"
+#include "services/KinshipCalculator.hpp"
+#include <cmath>
+#include <functional>
+#include <random>
+
+namespace {
+
+bool near(double actual, double expected) {
+    return std::fabs(actual - expected) < 1e-12;
+}
+
+void addChild(FamilyTree& tree, const std::string& id, const std::string& gender,
+              const std::string& father, const std::string& mother) {
+    CHECK(tree.addPerson(Person(id, id, "Test", gender, "1900-01-01")));
+    if (!father.empty()) CHECK(tree.addRelationship(father, id, RelationType::PARENT_CHILD));
+    if (!mother.empty()) CHECK(tree.addRelationship(mother, id, RelationType::PARENT_CHILD));
+}
+
+// A and B have two children, C and D, whose child E is the product of a
+// full-sibling mating; G is E's child by D. Y is a half-sibling of C (by
+// X), and Z the child of those half-siblings.
+void buildInbredFamily(FamilyTree& tree) {
+    addChild(tree, "A", "M", "", "");
+    addChild(tree, "B", "F", "", "");
+    addChild(tree, "X", "F", "", "");
+    addChild(tree, "C", "M", "A", "B");
+    addChild(tree, "D", "F", "A", "B");
+    addChild(tree, "Y", "F", "A", "X");
+    addChild(tree, "E", "M", "C", "D");
+    addChild(tree, "Z", "F", "C", "Y");
+    // Parents recorded mother first: genders decide the roles
+    addChild(tree, "G", "M", "", "D");
+    CHECK(tree.addRelationship("E", "G", RelationType::PARENT_CHILD));
+}
+
+} // namespace
+
+TEST_CASE(inbreedingOfClassicMatings) {
+    test::TempDatabase db("kinship_classic");
+    FamilyTree tree(db.path());
+    buildInbredFamily(tree);
+    KinshipCalculator calculator(tree);
+
+    auto f = calculator.inbreedingCoefficients();
+    CHECK_EQ(f.size(), 9u);
+    CHECK(near(f["A"], 0.0));
+    CHECK(near(f["C"], 0.0));
+    CHECK(near(f["E"], 0.25));    // full siblings
+    CHECK(near(f["Z"], 0.125));   // half siblings
+    CHECK(near(f["G"], 0.375));   // parent and offspring of full siblings
+    CHECK(near(calculator.inbreedingCoefficient("G"), 0.375));
+    CHECK_THROWS(calculator.inbreedingCoefficient("missing"), std::invalid_argument);
+}
+
+TEST_CASE(kinshipOfPairs) {
+    test::TempDatabase db("kinship_pairs");
+    FamilyTree tree(db.path());
+    buildInbredFamily(tree);
+    KinshipCalculator calculator(tree);
+
+    auto values = calculator.kinship({{"A", "B"}, {"C", "D"}, {"A", "C"}, {"A", "A"},
+                                      {"E", "E"}, {"D", "E"}, {"E", "D"}, {"C", "Y"}});
+    CHECK_EQ(values.size(), 8u);
+    CHECK(near(values[0], 0.0));
+    CHECK(near(values[1], 0.25));
+    CHECK(near(values[2], 0.25));
+    CHECK(near(values[3], 0.5));
+    CHECK(near(values[4], 0.625));
+    CHECK(near(values[5], 0.375));
+    CHECK(near(values[6], 0.375));
+    CHECK(near(values[7], 0.125));
+    CHECK(calculator.kinship({}).empty());
+    CHECK_THROWS(calculator.kinship({{"A", "missing"}}), std::invalid_argument);
+}
+
+// Cohort matrices against the recursive definition on a random, heavily
+// inbred pedigree. 203 people: not a multiple of the column block width.
+TEST_CASE(kinshipMatrixMatchesRecursion) {
+    test::TempDatabase db("kinship_matrix");
+    FamilyTree tree(db.path());
+    const int people = 203;
+    std::vector<int> fathers(people, -1), mothers(people, -1);
+    std::mt19937 random(5);
+    tree.beginTransaction();
+    for (int i = 0; i < people; i++) {
+        std::string gender = i % 2 == 0 ? "M" : "F";
+        std::string father, mother;
+        if (i >= 10) {
+            fathers[i] = std::uniform_int_distribution<int>(0, (i - 1) / 2)(random) * 2;
+            mothers[i] = std::uniform_int_distribution<int>(0, (i - 2) / 2)(random) * 2 + 1;
+            if (i % 7 == 0) mothers[i] = -1;
+            father = "P" + std::to_string(fathers[i]);
+            if (mothers[i] >= 0) mother = "P" + std::to_string(mothers[i]);
+        }
+        addChild(tree, "P" + std::to_string(i), gender, father, mother);
+    }
+    tree.commit();
+
+    std::vector<double> memo(people * people, -1.0);
+    std::function<double(int, int)> expected = [&](int a, int b) -> double {
+        if (a < 0 || b < 0) return 0.0;
+        double& value = memo[a * people + b];
+        if (value >= 0) return value;
+        if (a == b) {
+            value = 0.5 * (1.0 + expected(fathers[a], mothers[a]));
+        } else {
+            int later = std::max(a, b);
+            int other = std::min(a, b);
+            value = 0.5 * (expected(fathers[later], other) + expected(mothers[later], other));
+        }
+        return value;
+    };
+
+    std::vector<std::string> cohort;
+    for (int i = people - 1; i >= 0; i -= 2) {
+        cohort.push_back("P" + std::to_string(i));
+    }
+    for (size_t threads : {1u, 3u}) {
+        KinshipOptions options;
+        options.threads = threads;
+        KinshipMatrix matrix = KinshipCalculator(tree, options).kinshipMatrix(cohort);
+        CHECK_EQ(matrix.ids.size(), cohort.size());
+        int mismatches = 0;
+        for (size_t r = 0; r < cohort.size(); r++) {
+            for (size_t c = 0; c < cohort.size(); c++) {
+                int a = std::stoi(cohort[r].substr(1));
+                int b = std::stoi(cohort[c].substr(1));
+                if (std::fabs(matrix.at(r, c) - expected(a, b)) > 1e-9) mismatches++;
+            }
+        }
+        CHECK_EQ(mismatches, 0);
+
+        auto f = KinshipCalculator(tree, options).inbreedingCoefficients();
+        mismatches = 0;
+        for (int i = 0; i < people; i++) {
+            if (std::fabs(f["P" + std::to_string(i)] - (2 * expected(i, i) - 1)) > 1e-9) mismatches++;
+        }
+        CHECK_EQ(mismatches, 0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,115 @@
+#include "TestHarness.hpp"
+#include "services/LifespanIndex.hpp"
+#include "utils/DateFormatter.hpp"
+#include <random>
+
+namespace {
+
+std::string ids(const std::vector<Person>& people) {
+    std::string text;
+    for (const auto& person : people) {
+        text += (text.empty() ? "" : " ") + person.getId();
+    }
+    return text;
+}
+
+void addPerson(FamilyTree& tree, const std::string& id, const std::string& born, const std::string& died = "") {
+    Person person(id, id, "Test", "O", born);
+    person.setDateOfDeath(died);
+    CHECK(tree.addPerson(person));
+}
+
+} // namespace
+
+TEST_CASE(convertsDayNumbers) {
+    CHECK_EQ(*DateFormatter::toDayNumber("1970-01-01"), 0);
+    CHECK_EQ(*DateFormatter::toDayNumber("2000-03-01") - *DateFormatter::toDayNumber("2000-02-28"), 2);
+    CHECK_EQ(*DateFormatter::toDayNumber("1900-03-01") - *DateFormatter::toDayNumber("1900-02-28"), 1);
+    CHECK_EQ(DateFormatter::fromDayNumber(*DateFormatter::toDayNumber("1066-10-14")), "1066-10-14");
+    CHECK_EQ(DateFormatter::fromDayNumber(*DateFormatter::toDayNumber("1850", true)), "1850-12-31");
+    CHECK_EQ(DateFormatter::fromDayNumber(*DateFormatter::toDayNumber("1852-02", true)), "1852-02-29");
+    CHECK_EQ(DateFormatter::fromDayNumber(*DateFormatter::toDayNumber("1852-02")), "1852-02-01");
+    CHECK(!DateFormatter::toDayNumber(""));
+    CHECK(!DateFormatter::toDayNumber("1850-13-01"));
+    CHECK(!DateFormatter::toDayNumber("1851-02-29"));
+    CHECK(!DateFormatter::toDayNumber("about 1850"));
+}
+
+TEST_CASE(findsPeopleAliveOnADate) {
+    test::TempDatabase db("lifespan_alive");
+    FamilyTree tree(db.path());
+    addPerson(tree, "A", "1800-05-01", "1860-02-10");
+    addPerson(tree, "B", "1830", "1890");
+    addPerson(tree, "C", "1855-06-15");             // no date of death
+    addPerson(tree, "E", "unknown");
+    LifespanIndex index(tree);
+
+    CHECK_EQ(ids(index.aliveOn("1840-01-01")), "A B");
+    CHECK_EQ(ids(index.aliveOn("1860")), "A B C");      // the whole year
+    CHECK_EQ(ids(index.aliveOn("1860-03")), "B C");
+    CHECK_EQ(ids(index.aliveOn("1890-12-31")), "B C");  // death year is open to its end
+    CHECK_EQ(ids(index.aliveOn("1900-01-01")), "C");
+    CHECK_EQ(ids(index.aliveOn("1965-06-14")), "C");    // 110 years at most
+    CHECK_EQ(ids(index.aliveOn("1966")), "");
+    CHECK_EQ(ids(index.aliveDuring("1700", "1801")), "A");
+    CHECK_THROWS(index.aliveOn("soon"), std::invalid_argument);
+
+    // Changes show up in the next query
+    addPerson(tree, "F", "1839", "1841");
+    CHECK_EQ(ids(index.aliveOn("1840-01-01")), "A B F");
+}
+
+TEST_CASE(findsContemporaries) {
+    test::TempDatabase db("lifespan_contemporaries");
+    FamilyTree tree(db.path());
+    addPerson(tree, "Parent", "1800", "1850");
+    addPerson(tree, "Child", "1830", "1900");
+    addPerson(tree, "Grandchild", "1860", "1930");
+    addPerson(tree, "Stranger", "1845", "1846");
+    addPerson(tree, "Later", "1905", "1950");
+    CHECK(tree.addRelationship("Parent", "Child", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("Child", "Grandchild", RelationType::PARENT_CHILD));
+    LifespanIndex index(tree);
+
+    CHECK_EQ(ids(index.contemporaries("Child")), "Parent Stranger Grandchild");
+    CHECK_EQ(ids(index.contemporaries("Child", true)), "Parent Grandchild");
+    CHECK_EQ(ids(index.contemporaries("Parent", true)), "Child");
+    CHECK_EQ(ids(index.contemporaries("Later")), "Grandchild");
+    CHECK_THROWS(index.contemporaries("missing"), std::invalid_argument);
+}
+
+// Interval tree answers against a scan of every lifespan
+TEST_CASE(matchesLinearScan) {
+    test::TempDatabase db("lifespan_random");
+    FamilyTree tree(db.path());
+    const int people = 500;
+    std::mt19937 random(5);
+    std::vector<std::pair<int32_t, int32_t>> spans;
+    const int32_t base = *DateFormatter::toDayNumber("1700-01-01");
+    tree.beginTransaction();
+    for (int i = 0; i < people; i++) {
+        int32_t start = base + std::uniform_int_distribution<int32_t>(0, 100000)(random);
+        int32_t end = start + std::uniform_int_distribution<int32_t>(0, 30000)(random);
+        spans.emplace_back(start, end);
+        addPerson(tree, "P" + std::to_string(i), DateFormatter::fromDayNumber(start), DateFormatter::fromDayNumber(end));
+    }
+    tree.commit();
+
+    LifespanIndex index(tree);
+    int mismatches = 0;
+    for (int query = 0; query < 200; query++) {
+        int32_t from = base + std::uniform_int_distribution<int32_t>(-1000, 130000)(random);
+        int32_t to = from + std::uniform_int_distribution<int32_t>(0, query % 2 ? 0 : 5000)(random);
+        size_t expected = 0;
+        for (const auto& span : spans) {
+            if (span.first <= to && span.second >= from) expected++;
+        }
+        auto found = index.aliveDuring(DateFormatter::fromDayNumber(from), DateFormatter::fromDayNumber(to));
+        if (found.size() != expected) mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,340 @@
+// Performance regression gate: runs a fixed workload against fixed
+// synthetic trees and compares throughput, latency percentiles, SQL
+// statements per call and peak memory with a committed baseline. Each
+// workload runs several times and the median of every metric counts.
+// Timings are first scaled by a reference workload timed alongside each
+// run (plain SQLite, none of the code under test), so a machine that is
+// slower as a whole for a while is not taken for a regression.
+//
+//   family_tree_perf_test --baseline test/perf_baseline.txt [--runs N]
+//   family_tree_perf_test --baseline test/perf_baseline.txt --write-baseline
+//
+// Baseline lines are "METRIC VALUE"; "tolerance KIND FRACTION" lines set
+// how much worse than the baseline a metric of that kind (the last part of
+// its name) may get before the test fails.
+
+#include "SyntheticTree.hpp"
+#include "TestHarness.hpp"
+#include "models/FamilyTree.hpp"
+#include "utils/Metrics.hpp"
+#include <sqlite3.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+namespace {
+
+struct Workload {
+    std::string name;
+    SyntheticTreeOptions tree;
+    size_t iterations;
+};
+
+// Fixed trees: wide and shallow, and narrow and deep
+std::vector<Workload> workloads() {
+    Workload wide{"wide", {}, 600};
+    wide.tree.people = 3000;
+    wide.tree.generations = 6;
+    wide.tree.branching = 3.0;
+    wide.tree.seed = 7;
+
+    Workload deep{"deep", {}, 600};
+    deep.tree.people = 3000;
+    deep.tree.generations = 14;
+    deep.tree.branching = 1.6;
+    deep.tree.seed = 11;
+    return {wide, deep};
+}
+
+const std::map<std::string, double> DEFAULT_TOLERANCES = {
+    {"ops_per_sec", 0.25},    // may drop to 75%
+    {"p50_us", 0.25},
+    {"p99_us", 0.25},
+    {"sql_per_call", 0.001},  // deterministic; only rounding slack
+    {"peak_rss_kb", 0.10},
+};
+
+const size_t DEFAULT_RUNS = 9;
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+bool higherIsBetter(const std::string& kind) {
+    return kind == "ops_per_sec";
+}
+
+bool isTiming(const std::string& kind) {
+    return kind == "ops_per_sec" || kind == "p50_us" || kind == "p99_us";
+}
+
+const std::string REFERENCE_KIND = "reference_us";
+
+// Microseconds for a fixed in-memory SQLite workload: inserts, an index
+// build and a grouped scan
+double timeReference() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    auto start = std::chrono::steady_clock::now();
+    sqlite3_exec(db, R"(
+        CREATE TABLE t (a INTEGER PRIMARY KEY, b TEXT);
+        WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 20000)
+        INSERT INTO t SELECT i, printf('%08d', i * 7919 % 100003) FROM n;
+        CREATE INDEX t_b ON t(b);
+        SELECT substr(b, 1, 3), COUNT(*) FROM t GROUP BY 1;
+    )", nullptr, nullptr, nullptr);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sqlite3_close(db);
+    return std::chrono::duration<double, std::micro>(elapsed).count();
+}
+
+std::string kindOf(const std::string& metric) {
+    return metric.substr(metric.rfind('.') + 1);
+}
+
+// Runs the workload and returns its metrics, keyed "<workload>.<api>.<kind>",
+// with the reference timed before and after it
+void runWorkload(const Workload& workload, std::map<std::string, double>& metrics) {
+    SyntheticTree synthetic = SyntheticTree::generate(workload.tree);
+    test::TempDatabase db("perf_" + workload.name);
+    double reference = timeReference();
+    Metrics::reset();
+
+    FamilyTree tree(db.path());
+    synthetic.load(tree, 1000);
+
+    std::mt19937 random(workload.tree.seed);
+    auto pick = [&](const std::vector<std::string>& ids) {
+        return ids[std::uniform_int_distribution<size_t>(0, ids.size() - 1)(random)];
+    };
+    for (size_t i = 0; i < workload.iterations; i++) {
+        const auto& pedigree =
+            synthetic.pedigrees[std::uniform_int_distribution<size_t>(0, synthetic.pedigrees.size() - 1)(random)];
+        std::string deepest = pick(pedigree.back());
+        std::string middle = pick(pedigree[pedigree.size() / 2]);
+        std::string cousin = pick(pedigree.back());
+        std::string surname = pick(synthetic.surnames);
+
+        tree.getAncestors(deepest);
+        tree.getDescendants(middle);
+        tree.getSiblings(deepest);
+        tree.calculateGenerationGap(deepest, cousin);
+        tree.searchByName(surname);
+        tree.searchByName(surname, NameSearchMode::PHONETIC);
+    }
+    for (size_t i = 0; i < workload.iterations / 4; i++) {
+        const auto& pedigree =
+            synthetic.pedigrees[std::uniform_int_distribution<size_t>(0, synthetic.pedigrees.size() - 1)(random)];
+        tree.deletePerson(pick(pedigree.back()));
+    }
+    metrics[workload.name + ".reference." + REFERENCE_KIND] = (reference + timeReference()) / 2;
+
+    for (const auto& entry : Metrics::apis()) {
+        const std::string& api = entry.first;
+        const ApiMetrics& measured = *entry.second;
+        uint64_t calls = measured.calls.load();
+        if (api.compare(0, 5, "tree.") != 0 || calls == 0) continue;
+
+        std::string prefix = workload.name + "." + api + ".";
+        double meanNanos = measured.latency.meanNanos();
+        metrics[prefix + "ops_per_sec"] = meanNanos > 0 ? 1e9 / meanNanos : 0;
+        metrics[prefix + "p50_us"] = measured.latency.percentile(50) / 1000.0;
+        metrics[prefix + "p99_us"] = measured.latency.percentile(99) / 1000.0;
+        metrics[prefix + "sql_per_call"] = static_cast<double>(measured.statements.load()) / calls;
+    }
+}
+
+long peakResidentKilobytes() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // kilobytes on Linux
+}
+
+bool readBaseline(const std::string& path, std::map<std::string, double>& values,
+                  std::map<std::string, double>& tolerances) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#') continue;
+        if (first == "tolerance") {
+            std::string kind;
+            double fraction;
+            if (fields >> kind >> fraction) tolerances[kind] = fraction;
+        } else {
+            double value;
+            if (fields >> value) values[first] = value;
+        }
+    }
+    return true;
+}
+
+bool writeBaseline(const std::string& path, const std::map<std::string, double>& values,
+                   const std::map<std::string, double>& tolerances) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "# Performance baseline for family_tree_perf_test (see test/PerfRegressionTest.cpp).\n"
+        << "# Regenerate on the reference machine with a Release build:\n"
+        << "#   family_tree_perf_test --baseline test/perf_baseline.txt --write-baseline\n"
+        << "# tolerance KIND FRACTION: how much worse than the baseline a metric may get\n";
+    for (const auto& tolerance : tolerances) {
+        out << "tolerance " << tolerance.first << " " << tolerance.second << "\n";
+    }
+    out << std::fixed << std::setprecision(3);
+    for (const auto& value : values) {
+        out << value.first << " " << value.second << "\n";
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " --baseline FILE [--write-baseline] [--tolerance-scale X] [--runs N]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string baselinePath;
+    bool write = false;
+    double toleranceScale = 1.0;
+    size_t runs = DEFAULT_RUNS;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--write-baseline") {
+            write = true;
+        } else if (arg == "--tolerance-scale" && i + 1 < argc) {
+            toleranceScale = std::stod(argv[++i]);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::stoul(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (baselinePath.empty() || runs == 0) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::map<std::string, double> baseline;
+    std::map<std::string, double> tolerances = DEFAULT_TOLERANCES;
+    bool haveBaseline = readBaseline(baselinePath, baseline, tolerances);
+    if (!haveBaseline && !write) {
+        std::cerr << "Cannot read baseline " << baselinePath << "\n";
+        return 2;
+    }
+
+    Metrics::setEnabled(true);
+    // Runs alternate between the workloads, so a slow spell on the
+    // machine does not land on one of them only
+    std::vector<std::map<std::string, double>> measuredRuns;
+    for (size_t run = 0; run < runs; run++) {
+        for (const auto& workload : workloads()) {
+            measuredRuns.emplace_back();
+            runWorkload(workload, measuredRuns.back());
+        }
+    }
+
+    // Timings are scaled to the reference's speed in the baseline (or,
+    // when writing one, its median in these runs)
+    std::map<std::string, std::vector<double>> references;
+    for (const auto& metrics : measuredRuns) {
+        for (const auto& metric : metrics) {
+            if (kindOf(metric.first) == REFERENCE_KIND) references[metric.first].push_back(metric.second);
+        }
+    }
+    std::map<std::string, std::vector<double>> samples;
+    for (const auto& metrics : measuredRuns) {
+        std::string workload;
+        double speed = 1.0;  // reference time in the baseline over this run's
+        for (const auto& metric : metrics) {
+            if (kindOf(metric.first) == REFERENCE_KIND) {
+                auto stored = baseline.find(metric.first);
+                double expected = !write && stored != baseline.end() ? stored->second : median(references[metric.first]);
+                speed = expected / metric.second;
+            }
+        }
+        for (const auto& metric : metrics) {
+            std::string kind = kindOf(metric.first);
+            double value = metric.second;
+            if (isTiming(kind)) {
+                value = higherIsBetter(kind) ? value / speed : value * speed;
+            }
+            samples[metric.first].push_back(value);
+        }
+    }
+    std::map<std::string, double> current;
+    for (const auto& sample : samples) {
+        current[sample.first] = median(sample.second);
+    }
+    current["peak_rss_kb"] = static_cast<double>(peakResidentKilobytes());
+
+    if (write) {
+        if (!writeBaseline(baselinePath, current, tolerances)) {
+            std::cerr << "Cannot write baseline " << baselinePath << "\n";
+            return 2;
+        }
+        std::cout << "Wrote " << current.size() << " metrics to " << baselinePath << "\n";
+        return 0;
+    }
+
+    int regressions = 0;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& expected : baseline) {
+        const std::string& metric = expected.first;
+        auto measured = current.find(metric);
+        if (measured == current.end()) {
+            std::cout << "[ FAIL ] " << metric << ": not measured (workload changed? regenerate the baseline)\n";
+            regressions++;
+            continue;
+        }
+        std::string kind = kindOf(metric);
+        if (kind == REFERENCE_KIND) {
+            std::cout << "[ INFO ] " << metric << ": " << measured->second << " (baseline " << expected.second
+                      << ")\n";
+            continue;
+        }
+        auto tolerance = tolerances.find(kind);
+        double allowed = (tolerance == tolerances.end() ? 0.0 : tolerance->second) * toleranceScale;
+        double base = expected.second;
+        double value = measured->second;
+
+        bool regressed = higherIsBetter(kind) ? value < base * (1.0 - allowed)
+                                              : value > base * (1.0 + allowed) + 1e-9;
+        double change = base != 0 ? (value - base) / base * 100.0 : 0.0;
+        if (regressed) {
+            regressions++;
+            std::cout << "[ FAIL ] ";
+        } else {
+            std::cout << "[  OK  ] ";
+        }
+        std::cout << metric << ": " << value << " (baseline " << base << ", "
+                  << std::showpos << change << std::noshowpos << "%)\n";
+    }
+    for (const auto& measured : current) {
+        if (!baseline.count(measured.first)) {
+            std::cout << "[ NEW  ] " << measured.first << ": " << measured.second << "\n";
+        }
+    }
+
+    std::cout << regressions << " regression(s) against " << baselinePath << "\n";
+    return regressions == 0 ? 0 : 1;
+}
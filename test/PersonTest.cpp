@@ -0,0 +1,104 @@
+#include "TestHarness.hpp"
+#include "models/Person.hpp"
+
+TEST_CASE(constructorStoresFields) {
+    Person person("P1", "Anna", "Meyer", "F", "1900-05-01");
+    CHECK_EQ(person.getId(), "P1");
+    CHECK_EQ(person.getFirstName(), "Anna");
+    CHECK_EQ(person.getLastName(), "Meyer");
+    CHECK_EQ(person.getFullName(), "Anna Meyer");
+    CHECK_EQ(person.getGender(), "F");
+    CHECK_EQ(person.getDateOfBirth(), "1900-05-01");
+    CHECK(!person.isDeceased());
+    CHECK(!person.hasParents());
+    CHECK(!person.hasChildren());
+    CHECK(!person.hasSpouse());
+}
+
+TEST_CASE(constructorRejectsUnknownGender) {
+    CHECK_THROWS(Person("P1", "Anna", "Meyer", "X", "1900-05-01"), std::invalid_argument);
+    CHECK_THROWS(Person("P1", "Anna", "Meyer", "", "1900-05-01"), std::invalid_argument);
+    Person other("P2", "Sam", "Meyer", "O", "1900-05-01");
+    CHECK_EQ(other.getGender(), "O");
+}
+
+TEST_CASE(namesCannotBeEmpty) {
+    Person person("P1", "Anna", "Meyer", "F", "1900-05-01");
+    CHECK_THROWS(person.setFirstName(""), std::invalid_argument);
+    CHECK_THROWS(person.setLastName(""), std::invalid_argument);
+    person.setFirstName("Anne");
+    person.setLastName("Maier");
+    CHECK_EQ(person.getFullName(), "Anne Maier");
+}
+
+TEST_CASE(deathDateFollowsBirthDate) {
+    Person person("P1", "Anna", "Meyer", "F", "1900-05-01");
+    CHECK_THROWS(person.setDateOfDeath("1899-12-31"), std::invalid_argument);
+    CHECK(!person.isDeceased());
+
+    person.setDateOfDeath("1970-01-01");
+    CHECK(person.isDeceased());
+    CHECK_EQ(person.getDateOfDeath(), "1970-01-01");
+
+    person.setDateOfDeath("");
+    CHECK(!person.isDeceased());
+}
+
+TEST_CASE(deathPlaceRequiresDeath) {
+    Person person("P1", "Anna", "Meyer", "F", "1900-05-01");
+    CHECK_THROWS(person.setDeathPlace("Berlin"), std::logic_error);
+    person.setDateOfDeath("1970-01-01");
+    person.setDeathPlace("Berlin");
+    CHECK_EQ(person.getDeathPlace(), "Berlin");
+}
+
+TEST_CASE(parentsAreUniqueAndAtMostTwo) {
+    Person person("P3", "Karl", "Meyer", "M", "1930-01-01");
+    CHECK_THROWS(person.addParent("P3"), std::invalid_argument);
+
+    person.addParent("P1");
+    person.addParent("P1");
+    CHECK_EQ(person.getParentCount(), 1);
+    person.addParent("P2");
+    CHECK_EQ(person.getParentCount(), 2);
+    CHECK(person.isParent("P1"));
+    CHECK(person.isParent("P2"));
+    CHECK_THROWS(person.addParent("P4"), std::logic_error);
+
+    person.removeParent("P1");
+    CHECK(!person.isParent("P1"));
+    CHECK_EQ(person.getParentCount(), 1);
+    person.removeParent("missing");
+    CHECK_EQ(person.getParentCount(), 1);
+}
+
+TEST_CASE(childrenAreUnique) {
+    Person person("P1", "Anna", "Meyer", "F", "1900-05-01");
+    CHECK_THROWS(person.addChild("P1"), std::invalid_argument);
+
+    person.addChild("P3");
+    person.addChild("P3");
+    person.addChild("P4");
+    CHECK_EQ(person.getChildCount(), 2);
+    CHECK(person.hasChildren());
+    CHECK(person.isChild("P4"));
+
+    person.removeChild("P3");
+    CHECK(!person.isChild("P3"));
+    CHECK_EQ(person.getChildCount(), 1);
+}
+
+TEST_CASE(spouseCannotBeSelf) {
+    Person person("P1", "Anna", "Meyer", "F", "1900-05-01");
+    CHECK_THROWS(person.setSpouse("P1"), std::invalid_argument);
+
+    person.setSpouse("P2");
+    CHECK(person.hasSpouse());
+    CHECK_EQ(person.getSpouseId(), "P2");
+    person.removeSpouse();
+    CHECK(!person.hasSpouse());
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,150 @@
+#include "TestHarness.hpp"
+#include "services/RelationshipCalculator.hpp"
+#include <deque>
+#include <random>
+
+namespace {
+
+std::string steps(const RelationshipPath& path) {
+    std::string text;
+    for (PathEdge edge : path.edges) {
+        text += (text.empty() ? "" : " ") + RelationshipCalculator::edgeToString(edge);
+    }
+    return text;
+}
+
+//   A + B         K
+//   ├── C + E     └── E
+//   │   └── F
+//   └── D + H
+//       └── I     J (sibling of H)
+void buildFamily(FamilyTree& tree) {
+    for (const char* id : {"A", "B", "C", "D", "E", "F", "H", "I", "J", "K", "L"}) {
+        CHECK(tree.addPerson(Person(id, id, "Test", "O", "1900-01-01")));
+    }
+    CHECK(tree.addRelationship("A", "B", RelationType::SPOUSE));
+    CHECK(tree.addRelationship("C", "E", RelationType::SPOUSE));
+    CHECK(tree.addRelationship("D", "H", RelationType::SPOUSE));
+    for (const char* child : {"C", "D"}) {
+        CHECK(tree.addRelationship("A", child, RelationType::PARENT_CHILD));
+        CHECK(tree.addRelationship("B", child, RelationType::PARENT_CHILD));
+    }
+    CHECK(tree.addRelationship("C", "F", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("D", "I", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("K", "E", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("H", "J", RelationType::SIBLING));
+}
+
+} // namespace
+
+TEST_CASE(findsShortestPaths) {
+    test::TempDatabase db("path_basic");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    RelationshipCalculator calculator(tree);
+
+    RelationshipPath path = calculator.shortestPath("F", "I");
+    CHECK(path.found());
+    CHECK(path.people == std::vector<std::string>({"F", "C", path.people[2], "D", "I"}));
+    CHECK_EQ(steps(path), "parent parent child child");
+    CHECK_EQ(path.cost, 4.0);
+
+    // In-laws through a spouse and a sibling
+    path = calculator.shortestPath("K", "J");
+    CHECK_EQ(steps(path), "child spouse parent child spouse sibling");
+    CHECK(path.people.front() == "K" && path.people.back() == "J");
+
+    path = calculator.shortestPath("A", "A");
+    CHECK(path.found() && path.edges.empty());
+    CHECK(!calculator.shortestPath("A", "L").found());
+    CHECK_THROWS(calculator.shortestPath("A", "missing"), std::invalid_argument);
+}
+
+TEST_CASE(honoursWeightsAndHopLimits) {
+    test::TempDatabase db("path_options");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    RelationshipCalculator calculator(tree);
+
+    PathOptions options;
+    options.maxHops = 3;
+    CHECK(!calculator.shortestPath("F", "I", options).found());
+    options.maxHops = 4;
+    CHECK(calculator.shortestPath("F", "I", options).found());
+
+    // Spouse links cost more than a detour through blood relatives
+    options = PathOptions();
+    options.spouseWeight = 10;
+    RelationshipPath path = calculator.shortestPath("C", "E", options);
+    CHECK_EQ(steps(path), "spouse");
+    CHECK_EQ(path.cost, 10.0);
+    CHECK(calculator.shortestPath("A", "B", options).edges.size() == 2);  // via a child
+
+    // Excluded spouse links cut the in-laws off
+    options.spouseWeight = -1;
+    CHECK(!calculator.shortestPath("K", "J", options).found());
+}
+
+TEST_CASE(followsTreeChanges) {
+    test::TempDatabase db("path_changes");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    RelationshipCalculator calculator(tree);
+
+    CHECK(!calculator.shortestPath("A", "L").found());
+    CHECK(tree.addRelationship("I", "L", RelationType::PARENT_CHILD));
+    CHECK_EQ(steps(calculator.shortestPath("A", "L")), "child child child");
+    CHECK(tree.removeRelationship("I_L_Parent-Child"));
+    CHECK(!calculator.shortestPath("A", "L").found());
+}
+
+// Step counts against breadth-first search on a random graph
+TEST_CASE(matchesBreadthFirstSearch) {
+    test::TempDatabase db("path_random");
+    FamilyTree tree(db.path());
+    const int people = 300;
+    std::vector<std::vector<int>> neighbours(people);
+    std::mt19937 random(9);
+    tree.beginTransaction();
+    for (int i = 0; i < people; i++) {
+        CHECK(tree.addPerson(Person("P" + std::to_string(i), "P", "Test", "O", "1900-01-01")));
+    }
+    for (int i = 1; i < people; i++) {
+        if (i % 11 == 0) continue;  // leave some people unconnected
+        int other = std::uniform_int_distribution<int>(0, i - 1)(random);
+        RelationType type = i % 3 == 0 ? RelationType::SIBLING : RelationType::PARENT_CHILD;
+        if (tree.addRelationship("P" + std::to_string(other), "P" + std::to_string(i), type)) {
+            neighbours[i].push_back(other);
+            neighbours[other].push_back(i);
+        }
+    }
+    tree.commit();
+
+    RelationshipCalculator calculator(tree);
+    int mismatches = 0;
+    for (int query = 0; query < 200; query++) {
+        int from = std::uniform_int_distribution<int>(0, people - 1)(random);
+        int to = std::uniform_int_distribution<int>(0, people - 1)(random);
+        std::vector<int> distance(people, -1);
+        std::deque<int> pending = {from};
+        distance[from] = 0;
+        while (!pending.empty()) {
+            int person = pending.front();
+            pending.pop_front();
+            for (int next : neighbours[person]) {
+                if (distance[next] < 0) {
+                    distance[next] = distance[person] + 1;
+                    pending.push_back(next);
+                }
+            }
+        }
+        RelationshipPath path = calculator.shortestPath("P" + std::to_string(from), "P" + std::to_string(to));
+        int found = path.found() ? static_cast<int>(path.edges.size()) : -1;
+        if (found != distance[to] || (path.found() && path.cost != distance[to])) mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
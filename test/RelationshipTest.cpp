@@ -0,0 +1,58 @@
+#include "TestHarness.hpp"
+#include "models/Relationship.hpp"
+
+TEST_CASE(constructorStoresFields) {
+    Relationship relationship("P1_P2_Spouse", "P1", "P2", RelationType::SPOUSE);
+    CHECK_EQ(relationship.getId(), "P1_P2_Spouse");
+    CHECK_EQ(relationship.getPerson1Id(), "P1");
+    CHECK_EQ(relationship.getPerson2Id(), "P2");
+    CHECK(relationship.getType() == RelationType::SPOUSE);
+    CHECK(relationship.getStartDate().empty());
+    CHECK(relationship.getEndDate().empty());
+}
+
+TEST_CASE(constructorRejectsInvalidPeople) {
+    CHECK_THROWS(Relationship("r", "", "P2", RelationType::SIBLING), std::invalid_argument);
+    CHECK_THROWS(Relationship("r", "P1", "", RelationType::SIBLING), std::invalid_argument);
+    CHECK_THROWS(Relationship("r", "P1", "P1", RelationType::PARENT_CHILD), std::invalid_argument);
+}
+
+TEST_CASE(datesOnlyForSpouses) {
+    Relationship parent("r", "P1", "P2", RelationType::PARENT_CHILD);
+    CHECK_THROWS(parent.setStartDate("1920-01-01"), std::invalid_argument);
+    CHECK_THROWS(parent.setEndDate("1950-01-01"), std::invalid_argument);
+    parent.setStartDate("");
+    CHECK(parent.isActive());
+
+    Relationship spouse("s", "P1", "P2", RelationType::SPOUSE);
+    spouse.setStartDate("1920-01-01");
+    CHECK_THROWS(spouse.setEndDate("1919-12-31"), std::invalid_argument);
+    CHECK(spouse.isActive());
+    spouse.setEndDate("1950-01-01");
+    CHECK(!spouse.isActive());
+    CHECK_EQ(spouse.getEndDate(), "1950-01-01");
+}
+
+TEST_CASE(otherPerson) {
+    Relationship relationship("r", "P1", "P2", RelationType::SIBLING);
+    CHECK(relationship.involves("P1"));
+    CHECK(relationship.involves("P2"));
+    CHECK(!relationship.involves("P3"));
+    CHECK_EQ(relationship.getOtherPerson("P1"), "P2");
+    CHECK_EQ(relationship.getOtherPerson("P2"), "P1");
+    CHECK_THROWS(relationship.getOtherPerson("P3"), std::invalid_argument);
+}
+
+TEST_CASE(typeStringsRoundTrip) {
+    for (RelationType type : {RelationType::PARENT_CHILD, RelationType::SPOUSE, RelationType::SIBLING}) {
+        CHECK(Relationship::isValidRelationType(type));
+        CHECK(Relationship::relationTypeFromString(Relationship::relationTypeToString(type)) == type);
+    }
+    CHECK_EQ(Relationship::relationTypeToString(RelationType::PARENT_CHILD), "Parent-Child");
+    CHECK(Relationship::relationTypeFromString("SPOUSE") == RelationType::SPOUSE);
+    CHECK_THROWS(Relationship::relationTypeFromString("Cousin"), std::invalid_argument);
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
@@ -0,0 +1,172 @@
+#include "TestHarness.hpp"
+#include "services/RelationshipTimeline.hpp"
+#include "utils/DateFormatter.hpp"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+std::string ids(const std::vector<Person>& people) {
+    std::string text;
+    for (const auto& person : people) {
+        text += (text.empty() ? "" : " ") + person.getId();
+    }
+    return text;
+}
+
+std::string ids(const std::vector<Relationship>& relationships) {
+    std::string text;
+    for (const auto& relationship : relationships) {
+        text += (text.empty() ? "" : " ") + relationship.getId();
+    }
+    return text;
+}
+
+void addPerson(FamilyTree& tree, const std::string& id, const std::string& born, const std::string& died = "") {
+    Person person(id, id, "Test", "O", born);
+    person.setDateOfDeath(died);
+    CHECK(tree.addPerson(person));
+}
+
+// Anna marries Bert in 1872 and, widowed, Carl in 1893. Dora and Emil are
+// Bert's children, Fritz is Carl's; Dora marries Gus in 1898 and outlives
+// him.
+void buildFamily(FamilyTree& tree) {
+    addPerson(tree, "Anna", "1850-03-02", "1920");
+    addPerson(tree, "Bert", "1845", "1890-11-30");
+    addPerson(tree, "Carl", "1850", "1930");
+    addPerson(tree, "Dora", "1875-04-10");
+    addPerson(tree, "Emil", "1880-02-01", "1881-07");
+    addPerson(tree, "Fritz", "1895-01-20");
+    addPerson(tree, "Gus", "1870", "1905-03-03");
+    CHECK(tree.addRelationship("Anna", "Bert", RelationType::SPOUSE, "1872-09-14", "1890-11-30"));
+    CHECK(tree.addRelationship("Anna", "Carl", RelationType::SPOUSE, "1893-05"));
+    CHECK(tree.addRelationship("Dora", "Gus", RelationType::SPOUSE, "1898-06-01"));
+    for (const char* child : {"Dora", "Emil"}) {
+        CHECK(tree.addRelationship("Anna", child, RelationType::PARENT_CHILD));
+        CHECK(tree.addRelationship("Bert", child, RelationType::PARENT_CHILD));
+    }
+    CHECK(tree.addRelationship("Anna", "Fritz", RelationType::PARENT_CHILD));
+    CHECK(tree.addRelationship("Carl", "Fritz", RelationType::PARENT_CHILD));
+}
+
+} // namespace
+
+TEST_CASE(findsSpousesOnADate) {
+    test::TempDatabase db("timeline_spouse");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    RelationshipTimeline timeline(tree);
+
+    CHECK(!timeline.spouseOn("Anna", "1870"));
+    CHECK_EQ(timeline.spouseOn("Anna", "1880-01-01")->getId(), "Bert");
+    CHECK(!timeline.spouseOn("Anna", "1891"));
+    CHECK_EQ(timeline.spouseOn("Dora", "1905-03-03")->getId(), "Gus");
+    CHECK(!timeline.spouseOn("Dora", "1905-03-04"));  // widowed
+    CHECK_EQ(timeline.spouseOn("Anna", "1900")->getId(), "Carl");
+    CHECK_EQ(timeline.spouseOn("Carl", "1893")->getId(), "Anna");
+    CHECK_EQ(ids(timeline.marriagesOn("1890")), "Anna_Bert_Spouse");
+    CHECK_EQ(ids(timeline.marriagesOn("1890-12")), "");
+    CHECK_EQ(ids(timeline.marriagesOn("1899")), "Anna_Carl_Spouse Dora_Gus_Spouse");
+    CHECK_THROWS(timeline.spouseOn("Anna", "soon"), std::invalid_argument);
+    CHECK_THROWS(timeline.spouseOn("missing", "1900"), std::invalid_argument);
+
+    // A divorce shows up in the next query
+    CHECK(tree.setRelationshipDates("Anna_Carl_Spouse", "1893-05", "1899-02-01"));
+    CHECK(!timeline.spouseOn("Anna", "1900"));
+    CHECK_EQ(ids(timeline.marriagesOn("1899")), "Anna_Carl_Spouse Dora_Gus_Spouse");
+    CHECK_THROWS(tree.setRelationshipDates("Anna_Carl_Spouse", "1893", "1892"), std::invalid_argument);
+    CHECK_THROWS(tree.setRelationshipDates("Anna_Fritz_Parent-Child", "1895", ""), std::invalid_argument);
+    CHECK(!tree.setRelationshipDates("missing", "", ""));
+}
+
+TEST_CASE(acceptsMarriagesThatDoNotOverlap) {
+    test::TempDatabase db("timeline_marriages");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    addPerson(tree, "Hedwig", "1852");
+
+    // Carl is married to Anna from 1893, but was free before
+    std::string id;
+    CHECK(tree.addRelationship("Carl", "Hedwig", RelationType::SPOUSE, "1875", "1885-04-01", &id));
+    CHECK_EQ(id, "Carl_Hedwig_Spouse");
+    CHECK(!tree.addRelationship("Carl", "Hedwig", RelationType::SPOUSE, "1890", "1895"));
+    CHECK(!tree.addRelationship("Hedwig", "Gus", RelationType::SPOUSE));  // undated: from their births
+
+    // Anna and Carl divorce and later marry again
+    CHECK(tree.setRelationshipDates("Anna_Carl_Spouse", "1893-05", "1899-02-01"));
+    CHECK(!tree.addRelationship("Anna", "Carl", RelationType::SPOUSE, "1898"));
+    CHECK(tree.addRelationship("Anna", "Carl", RelationType::SPOUSE, "1901-07-01", "", &id));
+    CHECK_EQ(id, "Anna_Carl_Spouse_2");
+    RelationshipTimeline timeline(tree);
+    CHECK_EQ(ids(timeline.marriagesOn("1880")), "Anna_Bert_Spouse Carl_Hedwig_Spouse");
+    CHECK_EQ(ids(timeline.marriagesOn("1910")), "Anna_Carl_Spouse_2");
+    CHECK_EQ(timeline.spouseOn("Anna", "1910")->getId(), "Carl");
+}
+
+TEST_CASE(findsHouseholdsAndLivingFamily) {
+    test::TempDatabase db("timeline_household");
+    FamilyTree tree(db.path());
+    buildFamily(tree);
+    RelationshipTimeline timeline(tree);
+
+    CHECK_EQ(ids(timeline.householdOn("Anna", "1880-06-01")), "Anna Bert Dora Emil");
+    CHECK_EQ(ids(timeline.householdOn("Anna", "1895-06-01")), "Anna Carl Dora Fritz");
+    CHECK_EQ(ids(timeline.householdOn("Anna", "1900-06-01")), "Anna Carl Fritz");  // Dora has married
+    CHECK_EQ(ids(timeline.householdOn("Carl", "1900-06-01")), "Carl Anna Fritz");
+    CHECK_EQ(ids(timeline.householdOn("Dora", "1900-06-01")), "Dora Gus");
+    CHECK_EQ(ids(timeline.householdOn("Bert", "1900-06-01")), "");
+
+    CHECK_EQ(ids(timeline.livingFamilyOn("Dora", "1900-06-01")), "Anna Gus Fritz");
+    CHECK_EQ(ids(timeline.livingFamilyOn("Dora", "1881")), "Bert Anna Emil");
+    CHECK_EQ(ids(timeline.livingFamilyOn("Fritz", "1925")), "Carl Dora");
+}
+
+// Marriages in force against a scan of every marriage
+TEST_CASE(matchesLinearScan) {
+    test::TempDatabase db("timeline_random");
+    FamilyTree tree(db.path());
+    const int people = 400;
+    std::mt19937 random(11);
+    const int32_t base = *DateFormatter::toDayNumber("1700-01-01");
+    std::vector<std::pair<int32_t, int32_t>> lifespans;
+    tree.beginTransaction();
+    for (int i = 0; i < people; i++) {
+        int32_t born = base + std::uniform_int_distribution<int32_t>(0, 60000)(random);
+        int32_t died = born + std::uniform_int_distribution<int32_t>(0, 30000)(random);
+        lifespans.emplace_back(born, died);
+        addPerson(tree, "P" + std::to_string(i), DateFormatter::fromDayNumber(born),
+                  DateFormatter::fromDayNumber(died));
+    }
+    std::vector<std::pair<int32_t, int32_t>> marriages;
+    for (int i = 0; i < people; i++) {
+        int j = std::uniform_int_distribution<int>(0, people - 1)(random);
+        int32_t start = base + std::uniform_int_distribution<int32_t>(0, 80000)(random);
+        int32_t end = start + std::uniform_int_distribution<int32_t>(0, 20000)(random);
+        bool open = i % 4 == 0;  // no end date: until a partner dies
+        if (i == j || !tree.addRelationship("P" + std::to_string(i), "P" + std::to_string(j), RelationType::SPOUSE,
+                                            DateFormatter::fromDayNumber(start),
+                                            open ? "" : DateFormatter::fromDayNumber(end))) {
+            continue;
+        }
+        marriages.emplace_back(std::max({start, lifespans[i].first, lifespans[j].first}),
+                               std::min({open ? lifespans[i].second : end, lifespans[i].second, lifespans[j].second}));
+    }
+    tree.commit();
+
+    RelationshipTimeline timeline(tree);
+    int mismatches = 0;
+    for (int query = 0; query < 200; query++) {
+        int32_t day = base + std::uniform_int_distribution<int32_t>(-1000, 100000)(random);
+        size_t expected = 0;
+        for (const auto& marriage : marriages) {
+            if (marriage.first <= day && marriage.second >= day) expected++;
+        }
+        if (timeline.marriagesOn(DateFormatter::fromDayNumber(day)).size() != expected) mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+int main(int argc, char* argv[]) {
+    return runTests(argc, argv);
+}
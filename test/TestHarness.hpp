@@ -0,0 +1,138 @@
+#ifndef TEST_HARNESS_HPP
+#define TEST_HARNESS_HPP
+
+// Minimal self-contained test runner, so the tests build and run offline
+// without a test framework. Each test file is one executable:
+//
+//     TEST_CASE(addsPerson) { CHECK(tree.addPerson(...)); }
+//     int main(int argc, char* argv[]) { return runTests(argc, argv); }
+//
+// A failed CHECK marks the test as failed and continues; an exception
+// escaping a test fails it. Pass test names as arguments to run a subset.
+
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace test {
+
+struct TestCase {
+    const char* name;
+    std::function<void()> body;
+};
+
+inline std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> body) {
+        registry().push_back({name, std::move(body)});
+    }
+};
+
+inline void fail(const char* file, int line, const std::string& message) {
+    failures()++;
+    std::cerr << file << ":" << line << ": " << message << "\n";
+}
+
+template <typename A, typename B>
+void checkEqual(const A& actual, const B& expected, const char* actualText, const char* expectedText,
+                const char* file, int line) {
+    if (!(actual == expected)) {
+        std::ostringstream message;
+        message << "CHECK_EQ(" << actualText << ", " << expectedText << ") failed: "
+                << actual << " != " << expected;
+        fail(file, line, message.str());
+    }
+}
+
+// Unique scratch database path, removed (with WAL files) before and after use
+class TempDatabase {
+private:
+    std::string databasePath;
+
+public:
+    explicit TempDatabase(const std::string& name)
+        : databasePath("test_" + name + ".db") {
+        remove();
+    }
+    ~TempDatabase() { remove(); }
+    TempDatabase(const TempDatabase&) = delete;
+    TempDatabase& operator=(const TempDatabase&) = delete;
+
+    const std::string& path() const { return databasePath; }
+
+    void remove() const {
+        for (const char* suffix : {"", "-wal", "-shm"}) {
+            std::remove((databasePath + suffix).c_str());
+        }
+    }
+};
+
+} // namespace test
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+#define TEST_CASE(name)                                                         \
+    static void name();                                                         \
+    static test::Registrar TEST_CONCAT(registrar_, name)(#name, &name);         \
+    static void name()
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) test::fail(__FILE__, __LINE__, "CHECK(" #condition ") failed"); \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                              \
+    test::checkEqual((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+
+#define CHECK_THROWS(expression, exceptionType)                                 \
+    do {                                                                        \
+        bool thrown = false;                                                    \
+        try {                                                                   \
+            expression;                                                         \
+        } catch (const exceptionType&) {                                        \
+            thrown = true;                                                      \
+        }                                                                       \
+        if (!thrown) test::fail(__FILE__, __LINE__, #expression " did not throw " #exceptionType); \
+    } while (0)
+
+inline int runTests(int argc, char* argv[]) {
+    int failedTests = 0;
+    int ran = 0;
+    for (const auto& test : test::registry()) {
+        if (argc > 1) {
+            bool selected = false;
+            for (int i = 1; i < argc; i++) {
+                selected = selected || test.name == std::string(argv[i]);
+            }
+            if (!selected) continue;
+        }
+        ran++;
+        int before = test::failures();
+        try {
+            test.body();
+        } catch (const std::exception& e) {
+            test::fail(__FILE__, __LINE__, std::string(test.name) + " threw: " + e.what());
+        }
+        bool passed = test::failures() == before;
+        failedTests += passed ? 0 : 1;
+        std::cout << (passed ? "[ PASS ] " : "[ FAIL ] ") << test.name << "\n";
+    }
+    std::cout << ran - failedTests << "/" << ran << " tests passed\n";
+    return failedTests == 0 ? 0 : 1;
+}
+
+#endif // TEST_HARNESS_HPP